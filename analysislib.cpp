@@ -4,6 +4,7 @@
 #include "powertestlib.h"
 #include "noisescanlib.h"
 #include "threscanlib.h"
+#include "trendlib.h"
 
 // List of available analyses
 const int numTotalAnal = 5;
@@ -16,6 +17,18 @@ const char* availAnal[numTotalAnal] = {
   "DCTRL Test"
 };
 
+// Number of shard files to be merged (0 = analyze the HICs)
+int numShardsToMerge = 0;
+
+// If true the pixel trends across the stages are computed
+bool pixelTrends = false;
+
+// Minutes between two polls of the DB in watch mode (0 = run once)
+int watchInterval = 0;
+
+// The metrics file written at the end of each run (0 = none)
+const char *metricsFileName = 0;
+
 #ifdef USENCURSES
 void analyzeAllIBHics(WINDOW* win)
 #else
@@ -88,6 +101,7 @@ void analyzeAllHICs(const THicType hicType)
 // Created:      02 Oct 2018  Mario Sitta
 // Updated:      09 Jan 2019  Mario Sitta
 // Updated:      16 Feb 2019  Mario Sitta   Made generic
+// Updated:      19 Oct 2026  Shards, watch mode, timing, trends and sorting
 //
 
 #ifdef USENCURSES
@@ -99,66 +113,149 @@ void analyzeAllHICs(const THicType hicType)
   printf("\n\n");
 #endif
 
+  // Merging the shard files does not need the DB
+  if (numShardsToMerge > 0) {
+    mergeAllShards(hicType);
+    return;
+  }
+
+  // Nor does sorting the pixel trees
+  if (GetPixelSortKey() != SORTKEY_NONE) {
+    sortAllPixelTrees(hicType);
+    return;
+  }
+
+  // Nor does joining the pixel data of all analyses
+  if (pixelTrends) {
+    cout << "Please wait while computing the pixel trends of all HICs" << endl;
+    PerfReset();
+    analyzeAllPixelTrends(hicType);
+    PerfReport(getLogFileName(), "Pixel trends");
+    return;
+  }
+
   // Initialize the DB connection
   // (no need to check if db is valid: if initAlpideDB fails we exit there)
   AlpideDB *db = initAlpideDB();
 
+  // In watch mode only the new activities are appended to the files
+  // and no user interaction is possible between two polls
+  if (watchInterval > 0) {
+    SetAppendMode(kTRUE);
+    setBatchMode(true);
+  }
+
   // Get the component type and Id
   int componentTypeId;
   if (hicType == HIC_IB)
-    componentTypeId = DbGetComponentTypeId (db, "Inner Barrel HIC Module");
-  else
-    componentTypeId = DbGetComponentTypeId (db, "Outer Barrel HIC Module");
-
-  // Get the list of all available HICs
-  ComponentDB *componentDB = new ComponentDB(db);
-  std::vector<ComponentDB::componentShort> componentList;  
-
-  componentDB->GetListByType(db->GetProjectId(), componentTypeId, &componentList);
-//  mvprintw(3, 2, "Found %d OB HICs - Please wait while analysing them all\n",
-//           componentList.size());
-  if (hicType == HIC_IB)
-    cout << "Found " << componentList.size() << " IB HIC" << endl;
+    componentTypeId = DbLibGetComponentTypeId (db, "Inner Barrel HIC Module");
   else
-    cout << "Found " << componentList.size() << " OB HIC" << endl;    
+    componentTypeId = DbLibGetComponentTypeId (db, "Outer Barrel HIC Module");
 
   // Ask the user which analysis to perform
   int numAna = chooseAnalysis(1);
 
-  if(numAna != 0) cout << "Please wait while analysing all HICs" << endl;
-
-  switch (numAna) {
-    case 0:
-    default:  // To refrain gcc from complaining...
+  if (numAna < 1 || numAna > numTotalAnal) {
 #ifdef USENCURSES
-      endwin();
+    endwin();
 #endif
-      exit(0);
-      break;
-    case 1:
-      analyzeAllPowerTests(componentList, db, hicType);
-      break;
-    case 2:
-      analyzeAllDigitalScans(componentList, db, hicType);
-      break;
-    case 3:
-      analyzeAllThresholdScans(componentList, db, hicType);
-      break;
-    case 4:
-      analyzeAllNoiseScans(componentList, db, hicType);
-      break;
-    case 5:
-      analyzeAllDCTRLTests(componentList, db, hicType);
-//      cout << "Sorry, not yet implemented " << endl; // !!TEMPORARY!!
-      break;
+    exit(0);
   }
 
+  Bool_t firstPoll = kTRUE;
+  do {
+    // In watch mode renew the DB connection at each poll, the previous
+    // one may have expired while sleeping
+    if (!firstPoll) {
+      DbLibDisconnect(db);
+      db = initAlpideDB();
+    }
+    firstPoll = kFALSE;
+
+    // Get the list of all available HICs
+    // (done at each poll in watch mode, new HICs may have been added)
+    std::vector<ComponentDB::componentShort> componentList;  
+
+    DbLibGetComponentList(db, componentTypeId, componentList);
+//  mvprintw(3, 2, "Found %d OB HICs - Please wait while analysing them all\n",
+//           componentList.size());
+    if (hicType == HIC_IB)
+      cout << "Found " << componentList.size() << " IB HIC" << endl;
+    else
+      cout << "Found " << componentList.size() << " OB HIC" << endl;    
+
+    // Keep only the HICs of the shard assigned to this job (if any)
+    if (GetNumberOfShards() > 1) {
+      std::vector<ComponentDB::componentShort> shardList;
+      for (unsigned int i = 0; i < componentList.size(); i++)
+        if (CheckShardNumber(componentList.at(i).ID))
+          shardList.push_back(componentList.at(i));
+      componentList.swap(shardList);
+      cout << componentList.size() << " HIC selected for this shard" << endl;
+    }
+
+    cout << "Please wait while analysing all HICs" << endl;
+
+    PerfReset();
+    SchedReset();
+    if (watchInterval > 0)
+      WatchBeginPoll();
+
+    // If some activities already in the file changed in the DB, their
+    // entries cannot be replaced in place: the file is then rewritten,
+    // copying the unchanged activities and analyzing the others again
+    ResetChangedActivities();
+    for (int pass = 0; pass < 2; pass++) {
+      switch (numAna) {
+        case 1:
+          analyzeAllPowerTests(componentList, db, hicType);
+          break;
+        case 2:
+          analyzeAllDigitalScans(componentList, db, hicType);
+          break;
+        case 3:
+          analyzeAllThresholdScans(componentList, db, hicType);
+          break;
+        case 4:
+          analyzeAllNoiseScans(componentList, db, hicType);
+          break;
+        case 5:
+          analyzeAllDCTRLTests(componentList, db, hicType);
+//          cout << "Sorry, not yet implemented " << endl; // !!TEMPORARY!!
+          break;
+      }
+
+      if (pass > 0 || GetChangedActivities() == 0) break;
+      cout << GetChangedActivities() << " activities changed in the DB, rewriting the file" << endl;
+      SetCopyMode(kTRUE);
+    }
+    SetCopyMode(kFALSE);
+
+    // Append the time breakdown of this pass to the log file
+    // and export the metrics for the batch monitoring
+    PerfReport(getLogFileName(), availAnal[numAna-1]);
+    SchedReport(getLogFileName(), availAnal[numAna-1]);
+    if (metricsFileName)
+      if (!PerfWriteMetrics(metricsFileName, availAnal[numAna-1],
+                            (hicType == HIC_IB) ? "IB" : "OB"))
+        printMessage("\nanalyzeAllHICs", "Error writing metrics file", metricsFileName, LOG_ERROR);
+
+    if (watchInterval > 0) {
+      time_t now = time(0);
+      cout << "Done at " << ctime(&now)
+           << "Next poll in " << watchInterval << " minutes" << endl;
+      sleep(watchInterval*60);
+    }
+  } while (watchInterval > 0);
+
+  DbLibDisconnect(db);
+
 //  vector<ComponentDB::compActivity> tests;
-//  redirectStdout();
+//  LogBeginCapture();
 //  for (unsigned int i = 0; i < componentList.size(); i++) {
 //    printf("i %d id %d name %s\n",i,componentList.at(i).ID,componentList.at(i).ComponentID.c_str());
 //  }
-//  restoreStdout();
+//  LogEndCapture();
 
 //  mvprintw(5, 2, "There were %d incomplete activities\n", incomplete);
 
@@ -237,6 +334,7 @@ void analyzeSingleHIC(const THicType hicType)
 //
 // Created:      20 Sep 2018  Mario Sitta
 // Updated:      16 Feb 2019  Mario Sitta   Made generic
+// Updated:      19 Oct 2026  DB access layer, several activities and analyses
 //
 
 #ifdef USENCURSES
@@ -254,11 +352,11 @@ void analyzeSingleHIC(const THicType hicType)
   // Get the component type and Id
   int componentTypeId;
   if (hicType == HIC_IB)
-    componentTypeId = DbGetComponentTypeId (db, "Inner Barrel HIC Module");
+    componentTypeId = DbLibGetComponentTypeId (db, "Inner Barrel HIC Module");
   else
-    componentTypeId = DbGetComponentTypeId (db, "Outer Barrel HIC Module");
+    componentTypeId = DbLibGetComponentTypeId (db, "Outer Barrel HIC Module");
 
-  int componentId   = DbGetComponentId     (db, componentTypeId, hicName);
+  int componentId   = DbLibGetComponentId     (db, componentTypeId, hicName);
 
   if (componentId == -1) {
 #ifdef USENCURSES
@@ -282,10 +380,10 @@ void analyzeSingleHIC(const THicType hicType)
 
   // Get the associated activities
   vector<ComponentDB::compActivity> tests;
-  redirectStdout();
-//  DbGetAllTests (db, componentId, tests, STDigital, false);
-  DbGetAllTests (db, componentId, tests, STDigital, true);
-  restoreStdout();
+  LogBeginCapture();
+//  DbLibGetAllTests (db, componentId, tests, STDigital, false);
+  DbLibGetAllTests (db, componentId, tests, STDigital, true);
+  LogEndCapture();
 
   std::vector<ComponentDB::compActivity>::iterator it;
   int nActivity = 0;
@@ -306,42 +404,83 @@ void analyzeSingleHIC(const THicType hicType)
   printf("\n There are a total of %d activities\n", nActivity);
 #endif
 
-  // Ask the user which activity to analyze
-  int numAct = chooseActivity(nActivity);
+  // Ask the user which activities to analyze
+  std::vector<int> numActs;
+  int nActs = chooseActivity(nActivity, numActs);
 
-  if (numAct == 0) {
+  if (nActs == 0) {
 #ifdef USENCURSES
     endwin();
 #endif
     exit(0);
   }
 
-  // Ask the user which analysis to perform
-  int numAna = chooseAnalysis(nActivity);
+  // Ask the user which analyses to perform
+  std::vector<int> numAnas;
+  int nAnas = chooseAnalysis(nActivity, &numAnas);
 
-  switch (numAna) {
-    case 0:
-    default:  // To refrain gcc from complaining...
+  if (nAnas == 0) {
+#ifdef USENCURSES
+    endwin();
+#endif
+    exit(0);
+  }
+
+  // A single analysis of a single activity has its own file as usual,
+  // otherwise they all go in a file for the HIC, a directory each, and
+  // are run one after the other without stopping (not concurrently: they
+  // share the tree variables, the DB connection and the current directory)
+  Bool_t hicFile = (nActs*nAnas > 1);
+  string hicFileName = hicName + "_AllAnalyses.root";
+  replace(hicFileName.begin(), hicFileName.end(), ' ', '_');
+  if (hicFile) {
+    if (!OpenHicRootFile(hicFileName)) {
+      printMessage("\nanalyzeSingleHIC","Error: error opening the ROOT file", 0, LOG_ERROR);
+      f12ToExit();
 #ifdef USENCURSES
       endwin();
 #endif
       exit(0);
-      break;
-    case 1:
-      analyzePowerTest(componentId, tests.at(numAct-1), db, hicType);
-      break;
-    case 2:
-      analyzeDigitalScan(componentId, tests.at(numAct-1), db, hicType);
-      break;
-    case 3:
-      analyzeThresholdScan(componentId, tests.at(numAct-1), db, hicType);
-      break;
-    case 4:
-      analyzeNoiseScan(componentId, tests.at(numAct-1), db, hicType);
-      break;
-    case 5:
-      analyzeDCTRLTest(componentId, tests.at(numAct-1), db, hicType);
-      break;
+    }
+    setBatchMode(true);
+    PerfReset();
+    SchedReset();
+  }
+
+  for (int iact = 0; iact < nActs; iact++) {
+    ComponentDB::compActivity act = tests.at(numActs[iact]-1);
+    for (int iana = 0; iana < nAnas; iana++) {
+      switch (numAnas[iana]) {
+        case 1:
+          analyzePowerTest(componentId, act, db, hicType);
+          break;
+        case 2:
+          analyzeDigitalScan(componentId, act, db, hicType);
+          break;
+        case 3:
+          analyzeThresholdScan(componentId, act, db, hicType);
+          break;
+        case 4:
+          analyzeNoiseScan(componentId, act, db, hicType);
+          break;
+        case 5:
+          analyzeDCTRLTest(componentId, act, db, hicType);
+          break;
+      }
+    }
+  }
+
+  if (hicFile) {
+    CloseHicRootFile();
+    PerfReport(getLogFileName(), hicName.c_str());
+    SchedReport(getLogFileName(), hicName.c_str());
+    setBatchMode(false);
+#ifdef USENCURSES
+    printw("\n ROOT file %s filled (%d analyses)\n", hicFileName.c_str(), nActs*nAnas);
+#else
+    printf("\n ROOT file %s filled (%d analyses)\n", hicFileName.c_str(), nActs*nAnas);
+#endif
+    f12ToExit();
   }
 
 #ifdef USENCURSES
@@ -350,41 +489,98 @@ void analyzeSingleHIC(const THicType hicType)
   exit(0);
 }
 
-int chooseActivity(const int nact)
+static int ParseSelection(const char *line, const int nmax, std::vector<int> &selection)
+{
+//
+// Reads a selection of numbers between 1 and nmax, as a list of numbers
+// and ranges (e.g. "1,3-5 7") or "all"
+//
+// Inputs:
+//            line      : the line typed by the user
+//            nmax      : the highest number which can be selected
+//
+// Outputs:
+//            selection : the numbers selected, in the order typed
+//
+// Return:
+//            the number of numbers selected, 0 if the line is "0"
+//            (exit) or -1 if it is not a valid selection
+//
+// Created:      19 Oct 2026
+//
+
+  selection.clear();
+
+  const char *p = line;
+  while (*p == ' ' || *p == '\t') p++;
+  if (strncmp(p, "all", 3) == 0) {
+    for (int i = 1; i <= nmax; i++)
+      selection.push_back(i);
+    return nmax;
+  }
+
+  int first, last, nread;
+  while (sscanf(p, "%d%n", &first, &nread) == 1) {
+    p += nread;
+    last = first;
+    if (*p == '-') {
+      if (sscanf(++p, "%d%n", &last, &nread) != 1) return -1;
+      p += nread;
+    }
+    if (first == 0 && last == 0 && selection.size() == 0) return 0;
+    if (first < 1 || last > nmax || first > last) return -1;
+
+    for (int i = first; i <= last; i++)
+      if (std::find(selection.begin(), selection.end(), i) == selection.end())
+        selection.push_back(i);
+
+    while (*p == ' ' || *p == '\t' || *p == ',') p++;
+  }
+
+  // Anything else left is a typo
+  if (*p != '\0' && *p != '\n') return -1;
+
+  return (selection.size() > 0) ? (int)selection.size() : -1;
+}
+
+int chooseActivity(const int nact, std::vector<int> &acts)
 {
 //
-// Choose which activity to analyze
+// Choose which activities to analyze
 //
 // Inputs:
 //            nact : the number of activities available
 //
 // Outputs:
+//            acts : the ids of the choosen activities
 //
 // Return:
-//            the id of the choosen activity
+//            the number of choosen activities (0 to exit)
 //
 // Created:      26 Sep 2018  Mario Sitta
 // Updated:      26 Feb 2018  Mario Sitta   fflush stdout
+// Updated:      19 Oct 2026  Lists, ranges and all selected
 //
 
   char line[80];
   int numAct = -1;
+  const char *prompt = "Enter the activity numbers to be analyzed (e.g. 1,3-5 or all, 0 to exit): ";
 
 #ifdef USENCURSES
-  mvprintw(5+nact+3, 1, "Enter the activity number to be analyzed (0 to exit): ");
+  mvprintw(5+nact+3, 1, "%s", prompt);
   
   echo();
 #endif
-  while(numAct < 0 || numAct > nact) {
+  while(numAct < 0) {
 #ifdef USENCURSES
-    move(5+nact+3, 55),
+    move(5+nact+3, 1+strlen(prompt)),
     getstr(line);
 #else
-    printf("\n Enter the activity number to be analyzed (0 to exit): ");
+    printf("\n %s", prompt);
     fflush(stdout);
-    fgets(line, sizeof(line), stdin);
+    if (!fgets(line, sizeof(line), stdin)) strcpy(line, "0"); // No more input: exit
 #endif
-    sscanf(line, "%d", &numAct);
+    numAct = ParseSelection(line, nact, acts);
   }
 #ifdef USENCURSES
   noecho();
@@ -393,7 +589,7 @@ int chooseActivity(const int nact)
   return numAct;
 }
 
-int chooseAnalysis(const int nact)
+int chooseAnalysis(const int nact, std::vector<int> *anas)
 {
 //
 // Choose which analysis to perform
@@ -401,17 +597,24 @@ int chooseAnalysis(const int nact)
 // Inputs:
 //            nact : the number of activities available
 //                   (only used to place correctly the text with ncurses)
+//            anas : if not 0, several analyses can be choosen
 //
 // Outputs:
+//            anas : the ids of the choosen analyses
 //
 // Return:
-//            the id of the choosen analysis
+//            the id of the choosen analysis, or the number of choosen
+//            analyses if several can be choosen (0 to exit)
 //
 // Created:      26 Sep 2018  Mario Sitta
+// Updated:      19 Oct 2026  Several analyses selected
 //
 
   char line[80];
   int numAna = -1;
+  std::vector<int> selection;
+  const char *prompt = anas ? "Enter the analysis numbers to be performed (e.g. 1,3-5 or all, 0 to exit): "
+                            : "Enter the analysis number to be performed (0 to exit): ";
 
 #ifndef USENCURSES
   printf("\n");
@@ -425,27 +628,30 @@ int chooseAnalysis(const int nact)
 #endif
   currpos += (numTotalAnal + 1);
 #ifdef USENCURSES
-  mvprintw(currpos, 1, "Enter the analysis number to be performed (0 to exit): ");
+  mvprintw(currpos, 1, "%s", prompt);
 
   echo();
 #else
   printf("\n");
 #endif
-  while(numAna < 0 || numAna > numTotalAnal) {
+  while(numAna < 0 || (!anas && numAna > 1)) {
 #ifdef USENCURSES
-    move(currpos, 56),
+    move(currpos, 1+strlen(prompt)),
     getstr(line);
 #else
-    printf(" Enter the analysis number to be performed (0 to exit): ");
-    fgets(line, sizeof(line), stdin);
+    printf(" %s", prompt);
+    fflush(stdout);
+    if (!fgets(line, sizeof(line), stdin)) strcpy(line, "0"); // No more input: exit
 #endif
-    sscanf(line, "%d", &numAna);
+    numAna = ParseSelection(line, numTotalAnal, anas ? *anas : selection);
   }
 #ifdef USENCURSES
   noecho();
 #endif
 
-  return numAna;
+  if (anas || numAna == 0) return numAna;
+
+  return selection[0];
 }
 
 #ifdef USENCURSES
@@ -522,13 +728,15 @@ AlpideDB *initAlpideDB(void)
 //
 // Return:
 //            if successful, a pointer to the opened DB
+//            (0 if the DB snapshot is used)
 //
 // Created:      02 Oct 2018  Mario Sitta
+// Updated:      19 Oct 2026  DB access layer used
 //
 
-  // Initialize the DB connection
-  AlpideDB *db = new AlpideDB(false);
-  if(!db) {
+  // Initialize the DB connection (none if a snapshot is used)
+  AlpideDB *db = DbLibConnect();
+  if(!DbLibIsOpen(db)) {
 #ifdef USENCURSES
     mvprintw(3, 1, "Error opening the DB!\n");
     f12ToExit();
@@ -542,3 +750,179 @@ AlpideDB *initAlpideDB(void)
 
   return db;
 }
+
+void mergeAllShards(const THicType hicType)
+{
+//
+// Driver routine to merge the files produced by the shard jobs
+//
+// Inputs:
+//           hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  // Ask the user which analysis was performed by the shard jobs
+  int numAna = chooseAnalysis(1);
+
+  if(numAna != 0)
+    cout << "Please wait while merging " << numShardsToMerge << " shard files" << endl;
+
+  switch (numAna) {
+    case 0:
+    default:  // To refrain gcc from complaining...
+#ifdef USENCURSES
+      endwin();
+#endif
+      exit(0);
+      break;
+    case 1:
+      mergeAllPowerTests(numShardsToMerge, hicType);
+      break;
+    case 2:
+      mergeAllDigitalScans(numShardsToMerge, hicType);
+      break;
+    case 3:
+      mergeAllThresholdScans(numShardsToMerge, hicType);
+      break;
+    case 4:
+      mergeAllNoiseScans(numShardsToMerge, hicType);
+      break;
+    case 5:
+      mergeAllDCTRLTests(numShardsToMerge, hicType);
+      break;
+  }
+
+}
+
+void setMergeShards(const int nshards)
+{
+//
+// Sets the number of shard files to be merged instead of analysing
+// the HICs (i.e. the reduce step of a sharded run)
+//
+// Inputs:
+//           nshards : the number of shards
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  numShardsToMerge = nshards;
+}
+
+void setMetricsFile(const char *filename)
+{
+//
+// Sets the name of the metrics file written at the end of each run
+// (JSON, or Prometheus text format if the name ends with ".prom")
+//
+// Inputs:
+//           filename : the metrics file name
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  metricsFileName = filename;
+}
+
+void setPixelTrends(const bool trends)
+{
+//
+// Sets the computation of the per-pixel trends across the test stages
+// from the Threshold, Digital and Noise Scan files instead of analysing
+// the HICs (see analyzeAllPixelTrends)
+//
+// Inputs:
+//           trends : true to compute the pixel trends
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  pixelTrends = trends;
+}
+
+void sortAllPixelTrees(const THicType hicType)
+{
+//
+// Driver routine to sort the pixel trees of the file of an analysis
+//
+// Inputs:
+//           hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  // Ask the user which analysis file to sort
+  int numAna = chooseAnalysis(1);
+
+  if(numAna != 0)
+    cout << "Please wait while sorting the pixel trees" << endl;
+
+  PerfReset();
+
+  switch (numAna) {
+    case 0:
+    default:  // To refrain gcc from complaining...
+#ifdef USENCURSES
+      endwin();
+#endif
+      exit(0);
+      break;
+    case 2:
+      sortAllDigitalScans(hicType);
+      break;
+    case 3:
+      sortAllThresholdScans(hicType);
+      break;
+    case 4:
+      sortAllNoiseScans(hicType);
+      break;
+    case 1:
+    case 5:
+      printMessage("\nsortAllPixelTrees","Error: this analysis has no pixel trees", 0, LOG_ERROR);
+      f12ToExit();
+      break;
+  }
+
+  PerfReport(getLogFileName(), "Pixel tree sort");
+}
+
+void setWatchInterval(const int minutes)
+{
+//
+// Sets the interval between two polls of the DB in watch mode:
+// the HIC list is periodically reloaded and only the activities
+// not yet in the file are analyzed and appended
+//
+// Inputs:
+//           minutes : the poll interval in minutes (0 = run once)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  watchInterval = minutes;
+}
@@ -11,8 +11,13 @@
 #include <string.h>
 #include <iostream>
 #include <string>
+#include <ctime>
+#include <unistd.h>
 #include "menulib.h"
 #include "hiclib.h"
+#include "iolib.h"
+#include "schedlib.h"
+#include "utillib.h"
 
 #ifdef USENCURSES
 void analyzeAllIBHics(WINDOW *win);
@@ -31,8 +36,14 @@ void analyzeSingleOBHic(void);
 void analyzeSingleHIC(const THicType hicType);
 void helpUsage(void);
 #endif
-int chooseActivity(const int nact);
-int chooseAnalysis(const int nact);
+int chooseActivity(const int nact, std::vector<int> &acts);
+int chooseAnalysis(const int nact, std::vector<int> *anas=0);
 AlpideDB *initAlpideDB(void);
+void mergeAllShards(const THicType hicType);
+void setMergeShards(const int nshards);
+void setMetricsFile(const char *filename);
+void setPixelTrends(const bool trends);
+void setWatchInterval(const int minutes);
+void sortAllPixelTrees(const THicType hicType);
 
 #endif // ANALYSISLIB_H
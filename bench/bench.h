@@ -0,0 +1,47 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Rtypes.h>
+
+#include "DBHelpers.h"
+#include "AlpideDB.h"
+#include "AlpideDBEndPoints.h"
+
+#include <string>
+#include <vector>
+
+using std::string;
+
+// Number of analyses known to the benchmark and their scan types
+#define BENCHNUMANAL 5
+
+// Number of chips on the HICs
+#define BENCHNUMCHIPSIB 9
+#define BENCHNUMCHIPSOB 14
+
+// Default pixel rows per chip in the pixel files (all the chip rows)
+#define BENCHNUMROWS 512
+
+// HIC Ids from this value on are IB HICs
+#define BENCHFIRSTIBHIC 500000
+
+extern const TScanType benchScanType[BENCHNUMANAL];
+
+// Configuration shared by the generator, the DB stub and the driver
+extern string benchDataDir;  // Root of the fake EOS tree
+extern Int_t  benchNumRows;  // Pixel rows per chip in the pixel files
+
+// Activity naming, shared by the generator and the DB stub
+Int_t  BenchActivityId(const Int_t hicid, const TScanType scantype);
+string BenchActivityName(const Int_t hicid, const TScanType scantype, const THicType hicType);
+Int_t  BenchActivityVariant(const Int_t actid);
+string BenchHicName(const Int_t hicid, const THicType hicType);
+string BenchSnapshotName(void);
+Bool_t BenchWriteSnapshot(const Int_t nhics, const THicType hicType);
+
+// The generator of fake activity directories
+Int_t  BenchChipIndex(const THicType hicType, const Int_t chip);
+Bool_t BenchGenerateActivity(const Int_t hicid, const TScanType scantype, const THicType hicType);
+Bool_t BenchGenerateAll(const Int_t nhics, const THicType hicType);
+
+#endif // BENCH_H
@@ -0,0 +1,422 @@
+#include "bench.h"
+#include "menulib.h"
+#include "digiscanlib.h"
+#include "pixmaplib.h"
+#include "sortlib.h"
+#include "utillib.h"
+
+#include <TKey.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+
+//
+// Standalone checks of some library routines, run with `make check':
+// the pixel maps across the switch from array to bitmap chunks, the
+// decoding of the ALPIDE pixel addresses, the order of the sort keys
+// and the merge of the shard files (on a fake EOS tree and DB snapshot,
+// as in the benchmark). Prints one line per check and returns the
+// number of failed checks
+//
+
+// Number of HICs and of shards of the merge check
+#define CHECKNUMHICS   7
+#define CHECKNUMSHARDS 3
+
+static Int_t checkFailed = 0;
+
+void checkResult(const char *name, const Bool_t ok)
+{
+//
+// Prints and counts the result of a check
+//
+// Inputs:
+//          name : the check
+//          ok   : whether it passed
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  printf("%-48s %s\n", name, ok ? "ok" : "FAILED");
+  if (!ok) checkFailed++;
+}
+
+Bool_t checkPixMapSize(const UInt_t npix)
+{
+//
+// Fills a pixel map with npix pixels of the first chunk, in scrambled
+// order and each twice, plus a few pixels of the last chunk, then checks
+// its content and that it is the same after a write and read back
+//
+// Inputs:
+//          npix : the number of pixels in the first chunk
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the map is correct
+//
+// Created:      19 Oct 2026
+//
+
+  TPixMap map;
+  std::set<UInt_t> expected;
+
+  // 7919 is odd, so k*7919 modulo 65536 never repeats in a chunk
+  for (Int_t pass = 0; pass < 2; pass++)
+    for (UInt_t k = 0; k < npix; k++) {
+      UInt_t pixel = (k*7919) % 65536;
+      PixMapAdd(map, pixel%PIXMAPNCOLS, pixel/PIXMAPNCOLS);
+      expected.insert(pixel);
+    }
+  for (Int_t col = 0; col < PIXMAPNCOLS; col += 100) {
+    PixMapAdd(map, col, PIXMAPNROWS-1);
+    expected.insert((PIXMAPNROWS-1)*PIXMAPNCOLS + col);
+  }
+
+  Bool_t ok = (PixMapCardinality(map) == expected.size());
+  ok &= (map.chunks.size() == 2);
+  if (ok)
+    ok &= ((map.chunks[0].bitmap.size() > 0) == (npix > PIXMAPARRAYMAX));
+  ok &= PixMapContains(map, 0, 0);
+  ok &= !PixMapContains(map, 1, PIXMAPNROWS-1);
+
+  std::vector<UInt_t> pixels;
+  PixMapGetPixels(map, pixels);
+  ok &= (pixels.size() == expected.size() &&
+         std::equal(pixels.begin(), pixels.end(), expected.begin()));
+
+  static UChar_t buffer[PIXMAPMAXBYTES];
+  Int_t length = PixMapWrite(map, buffer);
+  ok &= (length > 0 && length <= PIXMAPMAXBYTES);
+
+  TPixMap readMap;
+  ok &= PixMapRead(readMap, buffer, length);
+  std::vector<UInt_t> readPixels;
+  PixMapGetPixels(readMap, readPixels);
+  ok &= (readPixels == pixels);
+
+  return ok;
+}
+
+void checkPixMap(void)
+{
+//
+// Checks the pixel maps around the largest array chunk (PIXMAPARRAYMAX),
+// and that an empty map is written and read back as such
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const UInt_t sizes[] = {1, PIXMAPARRAYMAX-1, PIXMAPARRAYMAX, PIXMAPARRAYMAX+1, 65536};
+  for (UInt_t i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++) {
+    char name[64];
+    snprintf(name, sizeof(name), "PixMap round trip, %u pixels", sizes[i]);
+    checkResult(name, checkPixMapSize(sizes[i]));
+  }
+
+  TPixMap map;
+  UChar_t buffer[1];
+  Int_t length = PixMapWrite(map, buffer);
+  Bool_t ok = (length == 0) && PixMapRead(map, buffer, length);
+  checkResult("PixMap round trip, empty map", ok && PixMapCardinality(map) == 0);
+}
+
+void checkDecodeAlpideAddress(void)
+{
+//
+// Checks the decoding of some pixel addresses: along a double column the
+// pixels are read in a zig-zag, left, right, right, left on two rows
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  // region, double column, address, column, row
+  const Int_t known[][5] = {
+    { 0,  0,    0,    0,   0},
+    { 0,  0,    1,    1,   0},
+    { 0,  0,    2,    1,   1},
+    { 0,  0,    3,    0,   1},
+    { 0,  0,    4,    0,   2},
+    { 0,  1,    0,    2,   0},
+    { 1,  0,    5,   33,   2},
+    { 5,  3,    6,  167,   3},
+    {17,  9,  514,  563, 257},
+    {31, 15, 1022, 1023, 511},
+    {31, 15, 1023, 1022, 511}
+  };
+
+  Bool_t ok = kTRUE;
+  for (UInt_t i = 0; i < sizeof(known)/sizeof(known[0]); i++) {
+    Int_t col, row;
+    DecodeAlpideAddress(known[i][0], known[i][1], known[i][2], col, row);
+    if (col != known[i][3] || row != known[i][4]) {
+      printf("  region %d dcol %d address %d: col %d row %d, expected %d %d\n",
+             known[i][0], known[i][1], known[i][2], col, row, known[i][3], known[i][4]);
+      ok = kFALSE;
+    }
+  }
+
+  checkResult("DecodeAlpideAddress known addresses", ok);
+}
+
+void checkSortOrder(void)
+{
+//
+// Checks that SortEntryLess orders on the two keys and then on the
+// entry, and that the heads of the runs come out of the merge queue
+// in the same order, the ties going to the lower run
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  // Pseudo random keys with many ties (seeded, so always the same)
+  srand(12345);
+  std::vector<TSortEntry> entries(2000);
+  for (UInt_t i = 0; i < entries.size(); i++) {
+    entries[i].key[0] = rand() % 4;
+    entries[i].key[1] = ((ULong64_t)(rand() % 3) << 40) | (rand() % 5);
+    entries[i].entry = i;
+  }
+
+  std::vector<TSortEntry> sorted = entries;
+  std::sort(sorted.begin(), sorted.end(), SortEntryLess);
+
+  Bool_t ok = kTRUE;
+  for (UInt_t i = 1; i < sorted.size(); i++) {
+    const TSortEntry &a = sorted[i-1], &b = sorted[i];
+    if (a.key[0] > b.key[0] ||
+        (a.key[0] == b.key[0] && a.key[1] > b.key[1]) ||
+        (a.key[0] == b.key[0] && a.key[1] == b.key[1] && a.entry >= b.entry))
+      ok = kFALSE;
+    if (SortEntryLess(b, a)) ok = kFALSE;
+  }
+  ok &= !SortEntryLess(sorted[0], sorted[0]);
+  checkResult("SortEntryLess ordering", ok);
+
+  // The same entries spread over runs, as the k-way merge sees them
+  std::priority_queue<TSortHead, std::vector<TSortHead>, std::greater<TSortHead> > heads;
+  for (UInt_t i = 0; i < entries.size(); i++) {
+    TSortHead head;
+    head.key[0] = entries[i].key[0];
+    head.key[1] = entries[i].key[1];
+    head.run = entries[i].entry;
+    heads.push(head);
+  }
+
+  ok = kTRUE;
+  for (UInt_t i = 0; i < sorted.size(); i++) {
+    const TSortHead &head = heads.top();
+    if (head.key[0] != sorted[i].key[0] || head.key[1] != sorted[i].key[1] ||
+        head.run != sorted[i].entry)
+      ok = kFALSE;
+    heads.pop();
+  }
+  checkResult("TSortHead merge queue ordering", ok);
+}
+
+Long64_t checkTreeEntries(TFile *rootfile, const char *name)
+{
+//
+// Returns the number of entries of a tree of a file
+//
+// Inputs:
+//          rootfile : the file
+//          name     : the tree name
+//
+// Outputs:
+//
+// Return:
+//          the number of entries, -1 if the tree is not in the file
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *tree = (TTree*)rootfile->Get(name);
+
+  return tree ? tree->GetEntries() : -1;
+}
+
+void checkMerge(AlpideDB *&db, const THicType hicType)
+{
+//
+// Analyzes the Digital Scans of CHECKNUMHICS HICs split in CHECKNUMSHARDS
+// shards, merges the shard files and checks that every tree of the
+// merged file has as many entries as the same tree in all shards
+//
+// Inputs:
+//          db      : the DB (none, the snapshot is used)
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t firstId = (hicType == HIC_IB) ? BENCHFIRSTIBHIC : 0;
+  TString rootFileName = Form("%sHIC_DigitalScan_AllHICs.root", (hicType == HIC_IB) ? "IB" : "OB");
+
+  // Always start from no file, otherwise the user would be asked
+  remove(rootFileName.Data());
+  for (Int_t ishard = 0; ishard < CHECKNUMSHARDS; ishard++) {
+    TString shardName = ShardRootFileName(rootFileName, ishard, CHECKNUMSHARDS);
+    remove(shardName.Data());
+
+    SetShardNumber(ishard, CHECKNUMSHARDS);
+    std::vector<ComponentDB::componentShort> componentList;
+    for (Int_t ihic = 1; ihic <= CHECKNUMHICS; ihic++) {
+      ComponentDB::componentShort comp;
+      comp.ID = firstId + ihic;
+      comp.ComponentID = BenchHicName(comp.ID, hicType);
+      if (CheckShardNumber(comp.ID))
+        componentList.push_back(comp);
+    }
+
+    LogBeginCapture();
+    analyzeAllDigitalScans(componentList, db, hicType);
+    LogEndCapture();
+  }
+  SetShardNumber(0, 1);
+
+  // The trees of the shards and their total entries
+  std::map<TString, Long64_t> shardEntries;
+  Bool_t ok = kTRUE;
+  for (Int_t ishard = 0; ishard < CHECKNUMSHARDS; ishard++) {
+    TFile *shardFile = OpenRootFile(ShardRootFileName(rootFileName, ishard, CHECKNUMSHARDS));
+    if (!shardFile || shardFile->IsZombie()) {
+      ok = kFALSE;
+      delete shardFile;
+      continue;
+    }
+    TIter nextKey(shardFile->GetListOfKeys());
+    TKey *key;
+    std::set<TString> names; // A tree can have several cycles
+    while ((key = (TKey*)nextKey()))
+      if (strcmp(key->GetClassName(), "TTree") == 0)
+        names.insert(key->GetName());
+    for (std::set<TString>::iterator name = names.begin(); name != names.end(); name++)
+      shardEntries[*name] += checkTreeEntries(shardFile, name->Data());
+    CloseRootFile(shardFile);
+    delete shardFile;
+  }
+  ok &= (shardEntries.size() > 0);
+
+  LogBeginCapture();
+  mergeAllDigitalScans(CHECKNUMSHARDS, hicType);
+  LogEndCapture();
+
+  TFile *mergedFile = OpenRootFile(rootFileName);
+  if (!mergedFile || mergedFile->IsZombie()) {
+    delete mergedFile;
+    checkResult("Shard merge entry counts", kFALSE);
+    return;
+  }
+
+  Long64_t total = 0;
+  std::map<TString, Long64_t>::iterator tree;
+  for (tree = shardEntries.begin(); tree != shardEntries.end(); tree++) {
+    Long64_t merged = checkTreeEntries(mergedFile, tree->first.Data());
+    if (merged != tree->second) {
+      printf("  %s: %lld entries, expected %lld\n", tree->first.Data(), merged, tree->second);
+      ok = kFALSE;
+    }
+    total += merged;
+  }
+  ok &= (total > 0);
+
+  CloseRootFile(mergedFile);
+  delete mergedFile;
+
+  checkResult("Shard merge entry counts", ok);
+}
+
+void checkHelp(void)
+{
+//
+// Prints a usage message
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  printf("\nUsage:\n");
+  printf("   dataCompCheck [-h] [-i] [-d DIR]\n");
+  printf("             -h       prints this message\n");
+  printf("             -i       uses IB HICs instead of OB HICs in the merge check\n");
+  printf("             -d DIR   directory of the fake EOS tree (default checkdata)\n");
+}
+
+int main(int argc, char** argv)
+{
+  THicType hicType = HIC_OB;
+
+  benchDataDir = "checkdata";
+  benchNumRows = 16; // A few rows are enough to fill the trees
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-h") {
+      checkHelp();
+      exit(0);
+    } else if (arg == "-i")
+      hicType = HIC_IB;
+    else if (arg == "-d" && i+1 < argc)
+      benchDataDir = argv[++i];
+    else {
+      checkHelp();
+      exit(1);
+    }
+  }
+
+  createLogFileName(argv[0]);
+  setBatchMode(true);
+
+  checkPixMap();
+  checkDecodeAlpideAddress();
+  checkSortOrder();
+
+  if (!BenchGenerateAll(CHECKNUMHICS, hicType) ||
+      !DbLibSetSnapshotFile(BenchSnapshotName().c_str()))
+    checkResult("Fake EOS tree and DB snapshot", kFALSE);
+  else {
+    AlpideDB *db = DbLibConnect();
+    checkMerge(db, hicType);
+  }
+
+  printf("\n%d checks failed\n", checkFailed);
+
+  return checkFailed;
+}
@@ -0,0 +1,301 @@
+#include "bench.h"
+#include "utillib.h"
+
+//
+// The DB side of the benchmark: the snapshot served to the analyses
+// through the DB access layer (see dblib.cpp), and a local stand-in for
+// the EOS path and file name helpers, whose objects are linked before
+// the Alpide libraries so that they take precedence over the real ones.
+// All answers are synthetic and consistent with the files written
+// by the generator (see benchgen.cpp)
+//
+
+const TScanType benchScanType[BENCHNUMANAL] = {
+  STPower, STDigital, STThreshold, STNoise, STDctrl
+};
+
+// The names of the classification parameters of each scan type
+static const char* benchClassParams[] = {
+  "Classification Power Test",
+  "Classification Digital Scan BB 0",
+  "Classification Digital Scan BB 3",
+  "Classification Digital Scan BB 0, V -10%",
+  "Classification Digital Scan BB 0, V +10%",
+  "Classification Threshold Scan 0.0 V",
+  "Classification Threshold Scan 3.0 V",
+  "Classification Noise Occupancy 0.0 V",
+  "Classification Noise Occupancy 0.0 V, masked",
+  "Classification Noise Occupancy 3.0 V",
+  "Classification Noise Occupancy 3.0 V, masked",
+  "Classification Dctrl Measurement",
+  0
+};
+
+static const char* benchResults[4] = {
+  "GOLD", "SILVER", "BRONZE_NOBB", "PARTIAL"
+};
+
+Int_t BenchActivityId(const Int_t hicid, const TScanType scantype)
+{
+//
+// Returns the (fake) Activity Id of the test of a given HIC
+//
+// Inputs:
+//          hicid    : the HIC Id
+//          scantype : the scan type
+//
+// Outputs:
+//
+// Return:
+//          the Activity Id
+//
+// Created:      19 Oct 2026
+//
+
+  return hicid*16 + (Int_t)scantype;
+}
+
+string BenchActivityName(const Int_t hicid, const TScanType scantype, const THicType hicType)
+{
+//
+// Returns the (fake) Activity name of the test of a given HIC
+//
+// Inputs:
+//          hicid    : the HIC Id
+//          scantype : the scan type
+//          hicType  : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//          the Activity name
+//
+// Created:      19 Oct 2026
+//
+
+  char name[64];
+  snprintf(name, sizeof(name), "%s_%s_Test%02d",
+           (hicType == HIC_IB) ? "IBHIC" : "OBHIC",
+           BenchHicName(hicid, hicType).c_str(), (Int_t)scantype);
+
+  return string(name);
+}
+
+Int_t BenchActivityVariant(const Int_t actid)
+{
+//
+// Returns the file format variant of a given activity: bit 0 selects
+// comma decimals and the "on-chip" supply lines, bit 1 the reception
+// test type and the older result file layout
+//
+// Inputs:
+//          actid : the Activity Id
+//
+// Outputs:
+//
+// Return:
+//          the variant (0-3)
+//
+// Created:      19 Oct 2026
+//
+
+  return (actid/16) % 4;
+}
+
+string BenchHicName(const Int_t hicid, const THicType hicType)
+{
+//
+// Returns the (fake) name of a given HIC
+//
+// Inputs:
+//          hicid   : the HIC Id
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//          the HIC name
+//
+// Created:      19 Oct 2026
+//
+
+  char name[32];
+  snprintf(name, sizeof(name), "%s-%06d", (hicType == HIC_IB) ? "IB" : "AL", hicid);
+
+  return string(name);
+}
+
+string BenchSnapshotName(void)
+{
+//
+// Returns the name of the DB snapshot of the generated HICs
+//
+// Created:      19 Oct 2026
+//
+
+  return benchDataDir + "/snapshot.json";
+}
+
+Bool_t BenchWriteSnapshot(const Int_t nhics, const THicType hicType)
+{
+//
+// Writes the DB snapshot describing the generated HICs: every HIC
+// is fully equipped with chips from a single wafer and has exactly
+// one activity per scan type
+//
+// Inputs:
+//          nhics   : the number of HICs
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//          true if the file was successfully written
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t firstId = (hicType == HIC_IB) ? BENCHFIRSTIBHIC : 0;
+  const Int_t nchips = (hicType == HIC_IB) ? BENCHNUMCHIPSIB : BENCHNUMCHIPSOB;
+  const Int_t typeId = (hicType == HIC_IB) ? 1 : 2;
+
+  FILE *outfile = fopen(BenchSnapshotName().c_str(), "w");
+  if (!outfile) return kFALSE;
+
+  fprintf(outfile, "{\n\"version\": 1,\n\"componentTypes\": [\n");
+  fprintf(outfile, " {\"Name\": \"Inner Barrel HIC Module\", \"ID\": 1},\n");
+  fprintf(outfile, " {\"Name\": \"Outer Barrel HIC Module\", \"ID\": 2}\n],\n");
+
+  fprintf(outfile, "\"components\": [");
+  for (Int_t ihic = 1; ihic <= nhics; ihic++)
+    fprintf(outfile, "%s\n {\"ID\": %d, \"ComponentID\": \"%s\", \"Type\": %d, \"Position\": %d}",
+            (ihic > 1) ? "," : "", firstId + ihic, BenchHicName(firstId + ihic, hicType).c_str(),
+            typeId, ihic%8);
+
+  fprintf(outfile, "\n],\n\"children\": [");
+  for (Int_t ihic = 1; ihic <= nhics; ihic++) {
+    Int_t id = firstId + ihic;
+    fprintf(outfile, "%s\n {\"Parent\": %d, \"ChipsOnly\": true, \"List\": [",
+            (ihic > 1) ? "," : "", id);
+    for (Int_t i = 0; i < nchips; i++)
+      fprintf(outfile, "%s{\"Id\": %d, \"Name\": \"T%dW%02dR%02d\", \"Position\": \"%s\"}",
+              i ? ", " : "", id*100 + i, 1 + id%3, id%100, i,
+              ChipPositionTest2MAM(hicType, i).c_str());
+    fprintf(outfile, "]}");
+  }
+
+  fprintf(outfile, "\n],\n\"tests\": [");
+  for (Int_t ihic = 1; ihic <= nhics; ihic++) {
+    Int_t id = firstId + ihic;
+    for (Int_t ianal = 0; ianal < BENCHNUMANAL; ianal++) {
+      Int_t actid = BenchActivityId(id, benchScanType[ianal]);
+      fprintf(outfile, "%s\n {\"Component\": %d, \"ScanType\": %d, \"LastOnly\": true, \"List\": [",
+              (ihic > 1 || ianal > 0) ? "," : "", id, (Int_t)benchScanType[ianal]);
+      fprintf(outfile, "{\"ID\": %d, \"Name\": \"%s\", \"Result\": {\"ID\": 0, \"Name\": \"%s\"}, "
+              "\"Status\": {\"ID\": 0, \"Name\": \"CLOSED\"}, \"StartDate\": %d, \"EndDate\": %d}]}",
+              actid, BenchActivityName(id, benchScanType[ianal], hicType).c_str(),
+              benchResults[BenchActivityVariant(actid)], 1546300800 + actid*60, 1546304400 + actid*60);
+    }
+  }
+
+  fprintf(outfile, "\n],\n\"activities\": [");
+  for (Int_t ihic = 1; ihic <= nhics; ihic++) {
+    Int_t id = firstId + ihic;
+    for (Int_t ianal = 0; ianal < BENCHNUMANAL; ianal++) {
+      Int_t actid = BenchActivityId(id, benchScanType[ianal]);
+      Int_t variant = BenchActivityVariant(actid);
+      fprintf(outfile, "%s\n {\"ID\": %d, \"Name\": \"%s\", \"Type\": {\"ID\": 0, \"Name\": \"%s HIC %s Test\"}, "
+              "\"Location\": {\"ID\": %d, \"Name\": \"\"}, \"Result\": {\"ID\": 0, \"Name\": \"%s\"}, "
+              "\"Status\": {\"ID\": 0, \"Name\": \"CLOSED\"}, \"StartDate\": %d, \"EndDate\": %d,\n  \"Parameters\": [",
+              (ihic > 1 || ianal > 0) ? "," : "", actid,
+              BenchActivityName(id, benchScanType[ianal], hicType).c_str(),
+              (hicType == HIC_IB) ? "IB" : "OB", (variant & 2) ? "Reception" : "Qualification",
+              1 + id%5, benchResults[variant], 1546300800 + actid*60, 1546304400 + actid*60);
+      fprintf(outfile, "{\"Name\": \"Classification Version\", \"Value\": 2}, ");
+      fprintf(outfile, "{\"Name\": \"Number of Working Chips\", \"Value\": %d}", nchips);
+      for (Int_t i = 0; benchClassParams[i]; i++)
+        fprintf(outfile, ", {\"Name\": \"%s\", \"Value\": %d}", benchClassParams[i], CLASS_GOLD + variant);
+      fprintf(outfile, "],\n  \"Attachments\": []}");
+    }
+  }
+
+  fprintf(outfile, "\n]\n}\n");
+  fclose(outfile);
+
+  return kTRUE;
+}
+
+string GetEosPath(ActivityDB::activityLong activity, THicType hicType, bool doubleComp)
+{
+  // There are no double component activities in the fake EOS tree
+  if (doubleComp) return benchDataDir + "/double/" + activity.Name;
+
+  return benchDataDir + "/eos/" + activity.Name;
+}
+
+bool GetDctrlFileName(ActivityDB::activityLong activity, string &dataName, string &resultName)
+{
+  dataName = "DctrlMeasurement.dat";
+  resultName = "DctrlMeasurementResult.dat";
+  return true;
+}
+
+bool GetDigitalFileName(ActivityDB::activityLong activity, int chip, int voltPercent, int backBias, string &dataName, string &resultName)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "DigitalScan_V%d_BB%d_Chip%d.dat", voltPercent, backBias, chip);
+  dataName = name;
+  snprintf(name, sizeof(name), "DigitalScanResult_V%d_BB%d.dat", voltPercent, backBias);
+  resultName = name;
+  return true;
+}
+
+bool GetITHRTuneFileName(ActivityDB::activityLong activity, int chip, int backBias, string &dataName, string &resultName)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "ITHRTune_BB%d_Chip%d.dat", backBias, chip);
+  dataName = name;
+  snprintf(name, sizeof(name), "ITHRTuneResult_BB%d.dat", backBias);
+  resultName = name;
+  return true;
+}
+
+bool GetNoiseFileName(ActivityDB::activityLong activity, bool masked, int backBias, string &dataName, string &hitsName, string &resultName)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "NoisyPixels_%s_BB%d.dat", masked ? "M" : "U", backBias);
+  dataName = name;
+  snprintf(name, sizeof(name), "NoiseHits_%s_BB%d.dat", masked ? "M" : "U", backBias);
+  hitsName = name;
+  snprintf(name, sizeof(name), "NoiseOccupancyResult_%s_BB%d.dat", masked ? "M" : "U", backBias);
+  resultName = name;
+  return true;
+}
+
+bool GetPowerFileName(ActivityDB::activityLong activity, bool &ivFound, string &dataName, string &resultName)
+{
+  ivFound = true;
+  dataName = "IVCurve.dat";
+  resultName = "PowerTestResult.dat";
+  return true;
+}
+
+bool GetThresholdFileName(ActivityDB::activityLong activity, int chip, bool nominal, int backBias, string &dataName, string &resultName)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "Threshold_FitResults_%s_BB%d_Chip%d.dat", nominal ? "N" : "T", backBias, chip);
+  dataName = name;
+  snprintf(name, sizeof(name), "ThresholdScanResult_%s_BB%d.dat", nominal ? "N" : "T", backBias);
+  resultName = name;
+  return true;
+}
+
+bool GetVCASNTuneFileName(ActivityDB::activityLong activity, int chip, int backBias, string &dataName, string &resultName)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "VCASNTune_BB%d_Chip%d.dat", backBias, chip);
+  dataName = name;
+  snprintf(name, sizeof(name), "VCASNTuneResult_BB%d.dat", backBias);
+  resultName = name;
+  return true;
+}
@@ -0,0 +1,534 @@
+#include "bench.h"
+#include "utillib.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+//
+// Generator of fake activity directories, mimicking the files written
+// by the test system on EOS in all the format variants the analysis
+// routines know about (see BenchActivityVariant)
+//
+
+string benchDataDir = "benchdata";
+Int_t  benchNumRows = BENCHNUMROWS;
+
+// The number of points of the IV curve (see powertestlib.cpp)
+#define BENCHNUMIVPOINTS 41
+
+static Bool_t BenchMakeDir(const string dir);
+
+Int_t BenchChipIndex(const THicType hicType, const Int_t chip)
+{
+//
+// Converts the chip number (0 - 13 for OB) into the index used
+// in the file names and in the results files (0 - 14, 7 missing, for OB)
+//
+// Inputs:
+//          hicType : the HIC type (IB or OB)
+//          chip    : the chip number
+//
+// Outputs:
+//
+// Return:
+//          the chip index
+//
+// Created:      19 Oct 2026
+//
+
+  return GetHicChipMap(hicType)->chipId[chip];
+}
+
+static string BenchNum(const Double_t value, const Bool_t comma)
+{
+//
+// Formats a floating point number, with a comma instead of the dot
+// if requested (as done by some sites)
+//
+// Inputs:
+//          value : the number
+//          comma : if true use comma decimals
+//
+// Outputs:
+//
+// Return:
+//          the formatted number
+//
+// Created:      19 Oct 2026
+//
+
+  char num[32];
+  snprintf(num, sizeof(num), "%.3f", value);
+  if (comma)
+    for (char *c = num; *c; c++)
+      if (*c == '.') *c = ',';
+
+  return string(num);
+}
+
+static void BenchWriteGeneral(FILE *outfile, const Int_t variant, const THicType hicType)
+{
+//
+// Writes the header and the general data common to all result files:
+// variant bit 0 selects the "on-chip" supply lines, bit 1 the older
+// layout without the per-chip voltages and temperatures
+//
+// Inputs:
+//          outfile : the result file
+//          variant : the format variant
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t nchips = (hicType == HIC_IB) ? BENCHNUMCHIPSIB : BENCHNUMCHIPSOB;
+
+  fprintf(outfile, "Test result file (benchmark)\n");
+  fprintf(outfile, "Software version: bench\n\n");
+
+  fprintf(outfile, "VDDD (start): %.3f\n", 1.82 + 0.01*variant);
+  fprintf(outfile, "VDDD (end):   %.3f\n", 1.81 + 0.01*variant);
+  fprintf(outfile, "VDDA (start): %.3f\n", 1.83);
+  fprintf(outfile, "VDDA (end):   %.3f\n", 1.82);
+  fprintf(outfile, "VDDD set (start): %.3f\n", 1.90);
+  fprintf(outfile, "VDDD set (end):   %.3f\n", 1.90);
+  fprintf(outfile, "VDDA set (start): %.3f\n", 1.90);
+  fprintf(outfile, "VDDA set (end):   %.3f\n", 1.90);
+  fprintf(outfile, "IDDD (start): %.3f\n", 0.62);
+  fprintf(outfile, "IDDD (end):   %.3f\n", 0.64);
+  fprintf(outfile, "IDDA (start): %.3f\n", 0.21);
+  fprintf(outfile, "IDDA (end):   %.3f\n", 0.22);
+
+  if (variant & 1) {
+    fprintf(outfile, "Analogue Supply Voltage (on-chip, start): %.3f\n", 1.79);
+    fprintf(outfile, "Analogue Supply Voltage (on-chip, end):   %.3f\n", 1.78);
+    fprintf(outfile, "Digital Supply Voltage (on-chip, saturating at 1.7V, start): %.3f\n", 1.70);
+    fprintf(outfile, "Digital Supply Voltage (on-chip, saturating at 1.7V, end):   %.3f\n", 1.70);
+    fprintf(outfile, "Temp (on-chip, start): %.1f\n", 27.5);
+    fprintf(outfile, "Temp (on-chip, end):   %.1f\n", 28.0);
+  } else {
+    fprintf(outfile, "Analogue Supply Voltage (start): %.3f\n", 1.79);
+    fprintf(outfile, "Analogue Supply Voltage (end):   %.3f\n", 1.78);
+    fprintf(outfile, "Digital Supply Voltage (saturating at 1.7V, start): %.3f\n", 1.70);
+    fprintf(outfile, "Digital Supply Voltage (saturating at 1.7V, end):   %.3f\n", 1.70);
+    fprintf(outfile, "Temp (start): %.1f\n", 27.5);
+    fprintf(outfile, "Temp (end):   %.1f\n", 28.0);
+  }
+
+  if (variant & 2) return; // Older layout
+
+  for (Int_t i = 0; i < nchips; i++) {
+    Int_t ichip = BenchChipIndex(hicType, i);
+    fprintf(outfile, "  Analogue voltage (start) on chip %d: %.3f\n", ichip, 1.78);
+    fprintf(outfile, "  Analogue voltage (end) on chip %d: %.3f\n", ichip, 1.77);
+    fprintf(outfile, "  Digital voltage (start) on chip %d: %.3f\n", ichip, 1.76);
+    fprintf(outfile, "  Digital voltage (end) on chip %d: %.3f\n", ichip, 1.75);
+    fprintf(outfile, "  Temperature (start) on chip %d: %.1f\n", ichip, 27.0 + 0.1*i);
+    fprintf(outfile, "  Temperature (end) on chip %d: %.1f\n", ichip, 27.5 + 0.1*i);
+  }
+}
+
+static void BenchWriteRegisters(FILE *outfile, const Int_t variant, const THicType hicType)
+{
+//
+// Writes the chip register dumps at the end of the result files
+// (missing in the older layout)
+//
+// Inputs:
+//          outfile : the result file
+//          variant : the format variant
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t nchips = (hicType == HIC_IB) ? BENCHNUMCHIPSIB : BENCHNUMCHIPSOB;
+
+  if (!(variant & 2)) {
+    const char *section[2] = {"Chip registers (start)", "Chip registers (end)"};
+    for (Int_t s = 0; s < 2; s++) {
+      fprintf(outfile, "\n%s\n", section[s]);
+      fprintf(outfile, "# Chip ID  Address  Value\n");
+      for (Int_t i = 0; i < nchips; i++) {
+        Int_t chipid = 0x70 | BenchChipIndex(hicType, i);
+        fprintf(outfile, "%d        0x%x        0x%x\n", chipid, 0x600, 0x10);
+        fprintf(outfile, "%d        0x%x        0x%x\n", chipid, 0x700, 0x100 + i + s);
+      }
+    }
+  }
+
+  fprintf(outfile, "\nBoard registers\n");
+  fprintf(outfile, "0x0 0x1\n");
+}
+
+static Bool_t BenchGenDctrl(const string dir, const Int_t variant, const THicType hicType, ActivityDB::activityLong &actlong)
+{
+//
+// Writes the files of a DCTRL test
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t nchips = (hicType == HIC_IB) ? BENCHNUMCHIPSIB : BENCHNUMCHIPSOB;
+  string dataName, resultName;
+  GetDctrlFileName(actlong, dataName, resultName);
+
+  FILE *outfile = fopen((dir + "/" + dataName).c_str(), "w");
+  if (!outfile) return kFALSE;
+  for (Int_t i = 0; i < nchips; i++)
+    for (Int_t drv = 0; drv < 16; drv++)
+      fprintf(outfile, "%d %d %.4f %.4f %.4f %.4f %.4e %.4e %.4e %.4e\n",
+              BenchChipIndex(hicType, i), drv, 0.05*drv, -0.05*drv,
+              0.025*drv, -0.025*drv, 1.1e-9, 1.2e-9, 1.3e-9, 1.4e-9);
+  fclose(outfile);
+
+  outfile = fopen((dir + "/" + resultName).c_str(), "w");
+  if (!outfile) return kFALSE;
+  BenchWriteGeneral(outfile, variant, hicType);
+  fprintf(outfile, "Worst maximum amplitude: %.3f\n", 0.61);
+  fprintf(outfile, "Worst slope:             %.3f\n", 0.04);
+  fprintf(outfile, "    ratio to previous:   %.3f\n", 0.98);
+  fprintf(outfile, "Worst chi square:        %.3f\n", 1.20);
+  fprintf(outfile, "    ratio to previous:   %.3f\n", 1.01);
+  fprintf(outfile, "Worst correlation:       %.3f\n", 0.99);
+  fprintf(outfile, "Worst rise time:         %.4e\n", 1.5e-9);
+  fprintf(outfile, "Worst fall time:         %.4e\n", 1.6e-9);
+  fprintf(outfile, "\nNumber of chips: %d\n", nchips);
+  for (Int_t i = 0; i < nchips; i++) {
+    fprintf(outfile, "\nResult chip %d:\n", BenchChipIndex(hicType, i));
+    fprintf(outfile, "  positive polarity\n");
+    fprintf(outfile, "Slope p: %.4f\n", 0.040);
+    fprintf(outfile, "Intercept p: %.4f\n", 0.010);
+    fprintf(outfile, "Chi sq p: %.4f\n", 1.1);
+    fprintf(outfile, "Correlation coeff p: %.4f\n", 0.999);
+    fprintf(outfile, "Max. amplitude p: %.4f\n", 0.65);
+    fprintf(outfile, "Max. rise time p: %.4e\n", 1.2e-9);
+    fprintf(outfile, "Max. fall time p: %.4e\n", 1.3e-9);
+    fprintf(outfile, "  negative polarity\n");
+    fprintf(outfile, "Slope n: %.4f\n", 0.041);
+    fprintf(outfile, "Intercept n: %.4f\n", 0.011);
+    fprintf(outfile, "Chi sq n: %.4f\n", 1.2);
+    fprintf(outfile, "Correlation coeff n: %.4f\n", 0.998);
+    fprintf(outfile, "Max. amplitude n: %.4f\n", 0.64);
+    fprintf(outfile, "Max. rise time n: %.4e\n", 1.3e-9);
+    fprintf(outfile, "Max. fall time n: %.4e\n", 1.4e-9);
+  }
+  BenchWriteRegisters(outfile, variant, hicType);
+  fclose(outfile);
+
+  return kTRUE;
+}
+
+static Bool_t BenchGenDigital(const string dir, const Int_t variant, const THicType hicType, ActivityDB::activityLong &actlong)
+{
+//
+// Writes the files of a Digital Scan: the pixel files list all pixels
+// of the first benchNumRows rows, almost all with the 50 expected hits
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t nchips = (hicType == HIC_IB) ? BENCHNUMCHIPSIB : BENCHNUMCHIPSOB;
+  const Int_t conds[4][2] = {{100, 0}, {100, 3}, {90, 0}, {110, 0}};
+  string dataName, resultName;
+
+  for (Int_t icond = 0; icond < 4; icond++) {
+    for (Int_t i = 0; i < nchips; i++) {
+      GetDigitalFileName(actlong, BenchChipIndex(hicType, i), conds[icond][0], conds[icond][1], dataName, resultName);
+      FILE *outfile = fopen((dir + "/" + dataName).c_str(), "w");
+      if (!outfile) return kFALSE;
+      for (Int_t row = 0; row < benchNumRows; row++)
+        for (Int_t col = 0; col < 1024; col++) {
+          Int_t nhits = 50;
+          if ((row*1024 + col + i) % 997 == 0) nhits = 0;   // Dead
+          if ((row*1024 + col + i) % 1499 == 0) nhits = 51; // Noisy
+          if (nhits > 0)
+            fprintf(outfile, "%d %d %d\n", col, row, nhits);
+        }
+      fclose(outfile);
+    }
+
+    FILE *outfile = fopen((dir + "/" + resultName).c_str(), "w");
+    if (!outfile) return kFALSE;
+    BenchWriteGeneral(outfile, variant, hicType);
+    fprintf(outfile, "Bad pixels:      %d\n", 3*nchips);
+    fprintf(outfile, "Bad double cols: %d\n", variant);
+    fprintf(outfile, "Stuck pixels:    %d\n", 0);
+    fprintf(outfile, "Dead pixels:     %d\n", 2*nchips);
+    fprintf(outfile, "   Increase:     %d\n", 0);
+    BenchWriteRegisters(outfile, variant, hicType);
+    fclose(outfile);
+  }
+
+  return kTRUE;
+}
+
+static Bool_t BenchGenNoise(const string dir, const Int_t variant, const THicType hicType, ActivityDB::activityLong &actlong)
+{
+//
+// Writes the files of a Noise Scan (NoisyPixels, NoiseHits and results)
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t nchips = (hicType == HIC_IB) ? BENCHNUMCHIPSIB : BENCHNUMCHIPSOB;
+  string dataName, hitsName, resultName;
+
+  for (Int_t icond = 0; icond < 4; icond++) {
+    Bool_t masked = (icond & 1);
+    Int_t vBB = (icond < 2) ? 0 : 3;
+    GetNoiseFileName(actlong, masked, vBB, dataName, hitsName, resultName);
+
+    const Int_t nnoisy = masked ? 2 : 5*(variant+1);
+
+    FILE *pixfile = fopen((dir + "/" + dataName).c_str(), "w");
+    FILE *hitfile = fopen((dir + "/" + hitsName).c_str(), "w");
+    if (!pixfile || !hitfile) return kFALSE;
+    for (Int_t i = 0; i < nchips; i++) {
+      Int_t ichip = BenchChipIndex(hicType, i);
+      for (Int_t n = 0; n < nnoisy; n++) {
+        Int_t region = (n*7 + i) % 32;
+        Int_t dcol = (n*3) % 16;
+        Int_t addr = (n*131 + i) % 1024;
+        fprintf(pixfile, "%d %d %d %d\n", ichip, region, dcol, addr);
+        Int_t col, row;
+        DecodeAlpideAddress(region, dcol, addr, col, row);
+        fprintf(hitfile, "%d %d %d %d\n", ichip, col, row, 100 + n);
+      }
+    }
+    fclose(pixfile);
+    fclose(hitfile);
+
+    FILE *outfile = fopen((dir + "/" + resultName).c_str(), "w");
+    if (!outfile) return kFALSE;
+    BenchWriteGeneral(outfile, variant, hicType);
+    fprintf(outfile, "Noisy pixels:    %d\n", nnoisy*nchips);
+    fprintf(outfile, "Noise occupancy: %e\n", 1.0e-9*nnoisy);
+    fprintf(outfile, "\nNumber of chips: %d\n", nchips);
+    for (Int_t i = 0; i < nchips; i++) {
+      fprintf(outfile, "\nResults chip %d:\n", BenchChipIndex(hicType, i));
+      fprintf(outfile, "Noisy pixels:    %d\n", nnoisy);
+      fprintf(outfile, "Noise occupancy: %e\n", 1.0e-9*nnoisy);
+    }
+    BenchWriteRegisters(outfile, variant, hicType);
+    fclose(outfile);
+  }
+
+  return kTRUE;
+}
+
+static Bool_t BenchGenPower(const string dir, const Int_t variant, const THicType hicType, ActivityDB::activityLong &actlong)
+{
+//
+// Writes the files of a Power Test (IV curve and results)
+//
+// Created:      19 Oct 2026
+//
+
+  string dataName, resultName;
+  Bool_t ivFound;
+  GetPowerFileName(actlong, ivFound, dataName, resultName);
+
+  FILE *outfile = fopen((dir + "/" + dataName).c_str(), "w");
+  if (!outfile) return kFALSE;
+  for (Int_t i = 0; i < BENCHNUMIVPOINTS; i++)
+    fprintf(outfile, "%.2f %.4f\n", -0.1*i, -0.002*i*(variant+1));
+  fclose(outfile);
+
+  outfile = fopen((dir + "/" + resultName).c_str(), "w");
+  if (!outfile) return kFALSE;
+  BenchWriteGeneral(outfile, variant, hicType);
+  fprintf(outfile, "IDDD at switchon:  %.3f\n", 0.05);
+  fprintf(outfile, "IDDA at switchon:  %.3f\n", 0.02);
+  fprintf(outfile, "IDDD with clock:   %.3f\n", 0.30);
+  fprintf(outfile, "IDDA with clock:   %.3f\n", 0.10);
+  fprintf(outfile, "IDDD configured:   %.3f\n", 0.62);
+  fprintf(outfile, "IDDA configured:   %.3f\n", 0.21);
+  fprintf(outfile, "IBias at 0V:       %.3f\n", 0.001);
+  fprintf(outfile, "IBias at 3V:       %.3f\n", 0.004);
+  BenchWriteRegisters(outfile, variant, hicType);
+  fclose(outfile);
+
+  return kTRUE;
+}
+
+static Bool_t BenchGenThreshold(const string dir, const Int_t variant, const THicType hicType, ActivityDB::activityLong &actlong)
+{
+//
+// Writes the files of a Threshold Scan: fit results (with comma decimals
+// in variant bit 0), tuning files and results for all conditions
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t nchips = (hicType == HIC_IB) ? BENCHNUMCHIPSIB : BENCHNUMCHIPSOB;
+  const Bool_t comma = (variant & 1);
+  string dataName, resultName;
+
+  for (Int_t icond = 0; icond < 4; icond++) {
+    Bool_t nominal = (icond < 2);
+    Int_t vBB = (icond & 1) ? 3 : 0;
+
+    for (Int_t i = 0; i < nchips; i++) {
+      GetThresholdFileName(actlong, BenchChipIndex(hicType, i), nominal, vBB, dataName, resultName);
+      FILE *outfile = fopen((dir + "/" + dataName).c_str(), "w");
+      if (!outfile) return kFALSE;
+      for (Int_t row = 0; row < benchNumRows; row++)
+        for (Int_t col = 0; col < 1024; col++) {
+          Double_t thresh = 100. + ((row*1024 + col)*37 % 200)/10.;
+          Double_t noise = 5. + ((row + col)*13 % 30)/10.;
+          fprintf(outfile, "%d %d %s %s %s\n", col, row, BenchNum(thresh, comma).c_str(),
+                  BenchNum(noise, comma).c_str(), BenchNum(1.1, comma).c_str());
+        }
+      fclose(outfile);
+    }
+
+    FILE *outfile = fopen((dir + "/" + resultName).c_str(), "w");
+    if (!outfile) return kFALSE;
+    BenchWriteGeneral(outfile, variant, hicType);
+    fprintf(outfile, "8b10b errors:   %d\n", 0);
+    fprintf(outfile, "Corrupt events: %d\n", 0);
+    fprintf(outfile, "Oversized events:       %d\n", 0);
+    fprintf(outfile, "Timeouts:       %d\n", variant);
+    fprintf(outfile, "\nNumber of chips: %d\n", nchips);
+    for (Int_t i = 0; i < nchips; i++) {
+      fprintf(outfile, "\nResult chip %d:\n", BenchChipIndex(hicType, i));
+      fprintf(outfile, "Pixels without hits:      %d\n", i);
+      fprintf(outfile, "Pixels without threshold: %d\n", 2*i);
+      fprintf(outfile, "Hot pixels:               %d\n", 0);
+      fprintf(outfile, "Av. Threshold: %.2f\n", 110.0);
+      fprintf(outfile, "Threshold RMS: %.2f\n", 8.0);
+      fprintf(outfile, "Deviation:     %.2f\n", 1.0);
+      fprintf(outfile, "Av. Noise:     %.2f\n", 5.5);
+      fprintf(outfile, "Noise RMS:     %.2f\n", 1.0);
+    }
+    BenchWriteRegisters(outfile, variant, hicType);
+    fclose(outfile);
+  }
+
+  // The tuning files have the same format as the fit results
+  for (Int_t i = 0; i < nchips; i++) {
+    for (Int_t tune = 0; tune < 2; tune++) {
+      if (tune == 0)
+        GetITHRTuneFileName(actlong, BenchChipIndex(hicType, i), 0, dataName, resultName);
+      else
+        GetVCASNTuneFileName(actlong, BenchChipIndex(hicType, i), 0, dataName, resultName);
+      FILE *outfile = fopen((dir + "/" + dataName).c_str(), "w");
+      if (!outfile) return kFALSE;
+      for (Int_t row = 0; row < benchNumRows; row++)
+        for (Int_t col = 0; col < 1024; col += 8)
+          fprintf(outfile, "%d %d %s %s %s\n", col, row, BenchNum(50. + tune, comma).c_str(),
+                  BenchNum(2., comma).c_str(), BenchNum(1., comma).c_str());
+      fclose(outfile);
+    }
+  }
+
+  return kTRUE;
+}
+
+static Bool_t BenchMakeDir(const string dir)
+{
+//
+// Creates a directory if it does not exist yet
+//
+// Created:      19 Oct 2026
+//
+
+  if (mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST) return kTRUE;
+
+  return kFALSE;
+}
+
+Bool_t BenchGenerateActivity(const Int_t hicid, const TScanType scantype, const THicType hicType)
+{
+//
+// Generates the directory of the activity of a given scan type
+// for a given HIC
+//
+// Inputs:
+//          hicid    : the HIC Id
+//          scantype : the scan type
+//          hicType  : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//          true if all files were successfully written
+//
+// Created:      19 Oct 2026
+//
+
+  Int_t actid = BenchActivityId(hicid, scantype);
+  Int_t variant = BenchActivityVariant(actid);
+
+  ActivityDB::activityLong actlong;
+  actlong.ID = actid;
+  actlong.Name = BenchActivityName(hicid, scantype, hicType);
+
+  string dir = GetEosPath(actlong, hicType, false);
+  if (!BenchMakeDir(dir)) return kFALSE;
+
+  switch (scantype) {
+    case STPower:
+      return BenchGenPower(dir, variant, hicType, actlong);
+    case STDigital:
+      return BenchGenDigital(dir, variant, hicType, actlong);
+    case STThreshold:
+      return BenchGenThreshold(dir, variant, hicType, actlong);
+    case STNoise:
+      return BenchGenNoise(dir, variant, hicType, actlong);
+    case STDctrl:
+      return BenchGenDctrl(dir, variant, hicType, actlong);
+    default:
+      return kFALSE;
+  }
+}
+
+Bool_t BenchGenerateAll(const Int_t nhics, const THicType hicType)
+{
+//
+// Generates the fake EOS tree with all activities of the given
+// number of HICs, and the DB snapshot describing them
+//
+// Inputs:
+//          nhics   : the number of HICs
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//          true if all files were successfully written
+//
+// Created:      19 Oct 2026
+//
+
+  if (!BenchMakeDir(benchDataDir) || !BenchMakeDir(benchDataDir + "/eos")) {
+    printf("Cannot create directory %s/eos\n", benchDataDir.c_str());
+    return kFALSE;
+  }
+
+  const Int_t firstId = (hicType == HIC_IB) ? BENCHFIRSTIBHIC : 0;
+
+  for (Int_t ihic = 1; ihic <= nhics; ihic++)
+    for (Int_t ianal = 0; ianal < BENCHNUMANAL; ianal++)
+      if (!BenchGenerateActivity(firstId + ihic, benchScanType[ianal], hicType)) {
+        printf("Error writing activity of HIC %d\n", firstId + ihic);
+        return kFALSE;
+      }
+
+  if (!BenchWriteSnapshot(nhics, hicType)) {
+    printf("Error writing the DB snapshot %s\n", BenchSnapshotName().c_str());
+    return kFALSE;
+  }
+
+  return kTRUE;
+}
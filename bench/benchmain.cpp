@@ -0,0 +1,192 @@
+#include "bench.h"
+#include "menulib.h"
+#include "perflib.h"
+#include "dctrltestlib.h"
+#include "digiscanlib.h"
+#include "noisescanlib.h"
+#include "powertestlib.h"
+#include "threscanlib.h"
+#include "utillib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//
+// End-to-end benchmark: generates a fake EOS tree for a given number
+// of HICs and runs all analyses on it, using a DB snapshot (benchdb.cpp)
+// instead of the real DB, then prints the throughput of each analysis
+// and appends the usual timing breakdown to the log file
+//
+
+typedef void (*TBenchAnalysis)(std::vector<ComponentDB::componentShort>, AlpideDB*&, const THicType);
+
+static const char* benchAnalName[BENCHNUMANAL] = {
+  "PowerTest", "DigitalScan", "ThresholdScan", "NoiseScan", "DCTRLTest"
+};
+
+static const TBenchAnalysis benchAnalysis[BENCHNUMANAL] = {
+  analyzeAllPowerTests, analyzeAllDigitalScans, analyzeAllThresholdScans,
+  analyzeAllNoiseScans, analyzeAllDCTRLTests
+};
+
+void benchHelp(void)
+{
+//
+// Prints a usage message
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  printf("\nUsage:\n");
+  printf("   dataCompBench [-h] [-i] [-p] [-j N] [-w N] [-m MB] [-u] [-d DIR] [-r ROWS] [-n] [N1 N2 ...]\n");
+  printf("             -h       prints this message\n");
+  printf("             -i       uses IB HICs instead of OB HICs\n");
+  printf("             -p       writes packed pixel trees (one entry per chip)\n");
+  printf("             -j N     compresses the trees with N threads (0 = one per core)\n");
+  printf("             -w N     reads the Threshold Scan files with N worker threads\n");
+  printf("             -m MB    memory cap of the worker threads (default 2048)\n");
+  printf("             -u       reads the Threshold Scan files in batches with io_uring\n");
+  printf("             -d DIR   directory of the fake EOS tree (default benchdata)\n");
+  printf("             -r ROWS  pixel rows per chip in the pixel files (default 512)\n");
+  printf("             -n       does not generate the data (reuses DIR)\n");
+  printf("             N1 ...   numbers of HICs to analyze (default 10 100 1000)\n");
+}
+
+Double_t benchRun(const Int_t nhics, const Int_t ianal, AlpideDB *&db, const THicType hicType)
+{
+//
+// Runs one analysis on the first nhics HICs, starting from scratch
+//
+// Inputs:
+//          nhics   : the number of HICs
+//          ianal   : the index of the analysis
+//          db      : the DB (none, the snapshot is used)
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//          the wall time in seconds
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t firstId = (hicType == HIC_IB) ? BENCHFIRSTIBHIC : 0;
+
+  std::vector<ComponentDB::componentShort> componentList;
+  for (Int_t ihic = 1; ihic <= nhics; ihic++) {
+    ComponentDB::componentShort comp;
+    comp.ID = firstId + ihic;
+    comp.ComponentID = BenchHicName(comp.ID, hicType);
+    componentList.push_back(comp);
+  }
+
+  // Always start from an empty file, otherwise the user would be asked
+  string rootFileName = string((hicType == HIC_IB) ? "IBHIC_" : "OBHIC_")
+                      + benchAnalName[ianal] + "_AllHICs.root";
+  remove(rootFileName.c_str());
+
+  PerfReset();
+  SchedReset();
+
+  Double_t start = PerfNow();
+  LogBeginCapture();
+  benchAnalysis[ianal](componentList, db, hicType);
+  LogEndCapture();
+  Double_t elapsed = PerfNow() - start;
+
+  char title[64];
+  snprintf(title, sizeof(title), "bench %s %d HICs", benchAnalName[ianal], nhics);
+  PerfReport(getLogFileName(), title);
+  SchedReport(getLogFileName(), title);
+
+  return elapsed;
+}
+
+int main(int argc, char** argv)
+{
+  THicType hicType = HIC_OB;
+  Bool_t generate = kTRUE;
+  std::vector<Int_t> numHics;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-h") {
+      benchHelp();
+      exit(0);
+    } else if (arg == "-i")
+      hicType = HIC_IB;
+    else if (arg == "-p")
+      SetPackedPixelTrees(kTRUE);
+    else if (arg == "-j" && i+1 < argc) {
+      if (!SetRootThreads(atoi(argv[++i])))
+        printf("ROOT built without multithreading, -j ignored\n");
+    }
+    else if (arg == "-w" && i+1 < argc)
+      SchedSetThreads(atoi(argv[++i]));
+    else if (arg == "-m" && i+1 < argc)
+      SchedSetMemory(atoi(argv[++i]));
+    else if (arg == "-u") {
+      if (!IoSetBackend(IOBACKEND_URING))
+        printf("io_uring not available, -u ignored\n");
+    }
+    else if (arg == "-n")
+      generate = kFALSE;
+    else if (arg == "-d" && i+1 < argc)
+      benchDataDir = argv[++i];
+    else if (arg == "-r" && i+1 < argc)
+      benchNumRows = atoi(argv[++i]);
+    else if (atoi(argv[i]) > 0)
+      numHics.push_back(atoi(argv[i]));
+    else {
+      benchHelp();
+      exit(1);
+    }
+  }
+
+  if (numHics.size() == 0) {
+    numHics.push_back(10);
+    numHics.push_back(100);
+    numHics.push_back(1000);
+  }
+
+  Int_t maxHics = 0;
+  for (UInt_t i = 0; i < numHics.size(); i++)
+    if (numHics[i] > maxHics) maxHics = numHics[i];
+
+  createLogFileName(argv[0]);
+  setBatchMode(true);
+
+  if (generate) {
+    printf("Generating %d %s HICs in %s ...\n", maxHics,
+           (hicType == HIC_IB) ? "IB" : "OB", benchDataDir.c_str());
+    Double_t start = PerfNow();
+    if (!BenchGenerateAll(maxHics, hicType)) exit(1);
+    printf("Generated in %.1f s\n", PerfNow() - start);
+  }
+
+  if (!DbLibSetSnapshotFile(BenchSnapshotName().c_str())) {
+    printf("Cannot read the DB snapshot %s\n", BenchSnapshotName().c_str());
+    exit(1);
+  }
+  AlpideDB *db = DbLibConnect();
+
+  printf("\n%-15s %8s %12s %10s\n", "Analysis", "HICs", "Time(s)", "HICs/s");
+  for (UInt_t n = 0; n < numHics.size(); n++) {
+    for (Int_t ianal = 0; ianal < BENCHNUMANAL; ianal++) {
+      Double_t elapsed = benchRun(numHics[n], ianal, db, hicType);
+      printf("%-15s %8d %12.3f %10.1f\n", benchAnalName[ianal], numHics[n],
+             elapsed, (elapsed > 0 ? numHics[n]/elapsed : 0));
+    }
+  }
+
+  printf("\nTiming breakdown appended to %s\n", getLogFileName());
+
+  return 0;
+}
@@ -0,0 +1,445 @@
+#include "bench.h"
+#include "iolib.h"
+#include "menulib.h"
+#include "perflib.h"
+#include "dctrltestlib.h"
+#include "digiscanlib.h"
+#include "noisescanlib.h"
+#include "powertestlib.h"
+#include "threscanlib.h"
+#include "utillib.h"
+
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+//
+// Micro benchmarks of the single Fill* parsers on a fixed corpus
+// (the files of four HICs, one per format variant, see benchgen.cpp).
+// Each parser is run repeatedly over all the corpus files it reads,
+// either filling a real tree or a tree whose Fill only counts the rows,
+// so that the parsing cost can be separated from the ROOT cost.
+// The heap allocations (operator new) made by the parsers are counted
+// as well, as the allocations per parser call. The reading alone of all
+// the corpus files, many small ones, is timed with each backend of
+// IoReadFiles
+//
+
+// Number of HICs in the corpus (one per format variant)
+#define MICRONUMHICS 4
+
+// A tree whose Fill step does nothing but count the entries
+class TBenchNullTree : public TTree {
+public:
+  TBenchNullTree() : TTree("benchnull", "Null tree") { fEntries = 0; }
+  Int_t Fill() { fEntries++; return 1; }
+  void  Reset(Option_t* = "") { fEntries = 0; }
+};
+
+// The input of one call of a Fill* parser
+struct TMicroInput {
+  string path;
+  string file;
+  string hits;
+  ActivityDB::activityLong actlong;
+};
+
+// A micro benchmark: a parser of a given analysis
+struct TMicroBench {
+  const char *name;
+  TScanType   scantype;
+  Bool_t      result;
+};
+
+static const TMicroBench microBench[] = {
+  {"FillPowTestTree",           STPower,     kFALSE},
+  {"FillPowTestTreeResult",     STPower,     kTRUE },
+  {"FillDigScanTree",           STDigital,   kFALSE},
+  {"FillDigScanTreeResult",     STDigital,   kTRUE },
+  {"FillThreScanTree",          STThreshold, kFALSE},
+  {"FillThreScanTreeResult",    STThreshold, kTRUE },
+  {"FillNoiseScanTree",         STNoise,     kFALSE},
+  {"FillNoiseScanTreeResult",   STNoise,     kTRUE },
+  {"FillDctrlTestTree",         STDctrl,     kFALSE},
+  {"FillDctrlTestTreeResult",   STDctrl,     kTRUE }
+};
+
+static THicType microHicType = HIC_OB;
+
+// The number of heap allocations made so far (see operator new): the
+// worker threads of IoReadFiles allocate as well, hence atomic
+static std::atomic<Long64_t> microAllocs(0);
+
+void* operator new(size_t size)
+{
+  microAllocs.fetch_add(1, std::memory_order_relaxed);
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void microBuildInputs(const TMicroBench &bench, std::vector<TMicroInput> &inputs)
+{
+//
+// Builds the list of the corpus files read by a parser
+//
+// Inputs:
+//          bench  : the micro benchmark
+//
+// Outputs:
+//          inputs : the list of inputs, one per call of the parser
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t firstId = (microHicType == HIC_IB) ? BENCHFIRSTIBHIC : 0;
+  const Int_t nchips = (microHicType == HIC_IB) ? BENCHNUMCHIPSIB : BENCHNUMCHIPSOB;
+  const Int_t digConds[4][2] = {{100, 0}, {100, 3}, {90, 0}, {110, 0}};
+
+  inputs.clear();
+
+  for (Int_t ihic = 1; ihic <= MICRONUMHICS; ihic++) {
+    TMicroInput input;
+    DbLibReadActivity(0, BenchActivityId(firstId + ihic, bench.scantype), &input.actlong);
+    input.path = GetEosPath(input.actlong, microHicType, false);
+
+    string dataName, hitsName, resultName;
+    Bool_t ivFound;
+    switch (bench.scantype) {
+      case STPower:
+        GetPowerFileName(input.actlong, ivFound, dataName, resultName);
+        input.file = bench.result ? resultName : dataName;
+        inputs.push_back(input);
+        break;
+      case STDctrl:
+        GetDctrlFileName(input.actlong, dataName, resultName);
+        input.file = bench.result ? resultName : dataName;
+        inputs.push_back(input);
+        break;
+      case STNoise:
+        for (Int_t icond = 0; icond < 4; icond++) {
+          GetNoiseFileName(input.actlong, (icond & 1), (icond < 2) ? 0 : 3, dataName, hitsName, resultName);
+          input.file = bench.result ? resultName : dataName;
+          input.hits = hitsName;
+          inputs.push_back(input);
+        }
+        break;
+      case STDigital:
+      case STThreshold:
+        for (Int_t icond = 0; icond < 4; icond++) {
+          for (Int_t i = 0; i < nchips; i++) {
+            Int_t ichip = BenchChipIndex(microHicType, i);
+            if (bench.scantype == STDigital)
+              GetDigitalFileName(input.actlong, ichip, digConds[icond][0], digConds[icond][1], dataName, resultName);
+            else
+              GetThresholdFileName(input.actlong, ichip, (icond < 2), (icond & 1) ? 3 : 0, dataName, resultName);
+            if (!bench.result) {
+              input.file = dataName;
+              inputs.push_back(input);
+            }
+          }
+          if (bench.result) {
+            input.file = resultName;
+            inputs.push_back(input);
+          }
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+TTree* microCreateTree(const TMicroBench &bench)
+{
+//
+// Creates the real tree filled by a parser
+//
+// Inputs:
+//          bench : the micro benchmark
+//
+// Outputs:
+//
+// Return:
+//          the tree
+//
+// Created:      19 Oct 2026
+//
+
+  switch (bench.scantype) {
+    case STPower:
+      return bench.result ? CreateTreePowerTestResult("benchres", "bench")
+                          : CreateTreePowerTest("benchdata", "bench");
+    case STDigital:
+      return bench.result ? CreateTreeDigitalScanResult("benchres", "bench")
+                          : CreateTreeDigitalScan("benchdata", "bench");
+    case STThreshold:
+      return bench.result ? CreateTreeThresholdScanResult("benchres", "bench")
+                          : CreateTreeThresholdScan("benchdata", "bench");
+    case STNoise:
+      return bench.result ? CreateTreeNoiseScanResult("benchres", "bench")
+                          : CreateTreeNoiseScan("benchdata", "bench");
+    case STDctrl:
+      return bench.result ? CreateTreeDctrlTestResult("benchres", "bench")
+                          : CreateTreeDctrlTest("benchdata", "bench");
+    default:
+      return 0;
+  }
+}
+
+Bool_t microRunParser(const TMicroBench &bench, TTree *tree, const TMicroInput &input)
+{
+//
+// Runs a parser once on a given input
+//
+// Inputs:
+//          bench : the micro benchmark
+//          tree  : the tree to fill
+//          input : the input
+//
+// Outputs:
+//
+// Return:
+//          the parser return value
+//
+// Created:      19 Oct 2026
+//
+
+  switch (bench.scantype) {
+    case STPower:
+      return bench.result ? FillPowTestTreeResult(tree, input.path, input.file, input.actlong, microHicType)
+                          : FillPowTestTree(tree, input.path, input.file);
+    case STDigital:
+      return bench.result ? FillDigScanTreeResult(tree, input.path, input.file, input.actlong, microHicType)
+                          : FillDigScanTree(tree, input.path, input.file);
+    case STThreshold:
+      return bench.result ? FillThreScanTreeResult(tree, input.path, input.file, input.actlong, microHicType)
+                          : FillThreScanTree(tree, input.path, input.file);
+    case STNoise:
+      return bench.result ? FillNoiseScanTreeResult(tree, input.path, input.file, input.actlong, microHicType)
+                          : FillNoiseScanTree(tree, input.path, input.file, input.hits, microHicType);
+    case STDctrl:
+      return bench.result ? FillDctrlTestTreeResult(tree, input.path, input.file, input.actlong, microHicType)
+                          : FillDctrlTestTree(tree, input.path, input.file);
+    default:
+      return kFALSE;
+  }
+}
+
+void microBenchmark(const TMicroBench &bench, const Bool_t nullFill, const Double_t minTime)
+{
+//
+// Runs a micro benchmark: the parser is run over the whole corpus
+// until at least minTime seconds are spent, then the mean time per
+// iteration and the throughput in rows and bytes are printed
+//
+// Inputs:
+//          bench    : the micro benchmark
+//          nullFill : if true the tree Fill step is stubbed
+//          minTime  : the minimum total time in seconds
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  std::vector<TMicroInput> inputs;
+  microBuildInputs(bench, inputs);
+
+  Long64_t bytes = 0;
+  for (UInt_t i = 0; i < inputs.size(); i++) {
+    bytes += PerfFileSize((inputs[i].path + "/" + inputs[i].file).c_str());
+    if (inputs[i].hits.length() > 0)
+      bytes += PerfFileSize((inputs[i].path + "/" + inputs[i].hits).c_str());
+  }
+
+  TTree *tree;
+  if (nullFill)
+    tree = new TBenchNullTree();
+  else
+    tree = microCreateTree(bench);
+
+  Double_t total = 0;
+  Long64_t iterations = 0, rows = 0, allocs = 0;
+  Bool_t ok = kTRUE;
+  while (total < minTime || iterations == 0) {
+    tree->Reset();
+    ArenaReset(); // One iteration is like one activity
+    Long64_t allocStart = microAllocs;
+    Double_t start = PerfNow();
+    for (UInt_t i = 0; i < inputs.size(); i++)
+      ok &= microRunParser(bench, tree, inputs[i]);
+    total += PerfNow() - start;
+    allocs += microAllocs - allocStart;
+    rows = tree->GetEntries();
+    iterations++;
+    PerfReset(); // The parsers keep their own samples
+  }
+
+  delete tree;
+
+  char name[64];
+  snprintf(name, sizeof(name), "BM_%s/%s", bench.name, nullFill ? "nofill" : "fill");
+  Double_t perIter = total/iterations;
+  Double_t allocsPerCall = inputs.size() > 0 ? (Double_t)allocs/iterations/inputs.size() : 0;
+  printf("%-38s %12.1f %10lld %12.4g %10.2f %12.1f%s\n", name, 1e6*perIter, iterations,
+         rows/perIter, bytes/perIter/1e6, allocsPerCall, ok ? "" : "  (parse errors)");
+}
+
+void microReadBenchmark(const Int_t backend, const Double_t minTime)
+{
+//
+// Runs a file read benchmark: all corpus files are read as one batch
+// with the given backend until at least minTime seconds are spent, then
+// the mean time per iteration and the throughput in files and bytes are
+// printed
+//
+// Inputs:
+//          backend  : one of IOBACKEND_*
+//          minTime  : the minimum total time in seconds
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  char name[64];
+  snprintf(name, sizeof(name), "BM_ReadFiles/%s", IoGetBackendName(backend));
+  if (backend == IOBACKEND_URING && !IoSetBackend(IOBACKEND_URING)) {
+    printf("%-38s (not available)\n", name);
+    return;
+  }
+
+  std::vector<string> names;
+  for (UInt_t ib = 0; ib < sizeof(microBench)/sizeof(microBench[0]); ib++) {
+    std::vector<TMicroInput> inputs;
+    microBuildInputs(microBench[ib], inputs);
+    for (UInt_t i = 0; i < inputs.size(); i++) {
+      names.push_back(inputs[i].path + "/" + inputs[i].file);
+      if (inputs[i].hits.length() > 0)
+        names.push_back(inputs[i].path + "/" + inputs[i].hits);
+    }
+  }
+
+  std::vector<TIoFile> files(names.size());
+  std::vector<std::vector<char> > buffers(names.size());
+  for (UInt_t i = 0; i < names.size(); i++) {
+    files[i].name = names[i].c_str();
+    files[i].buffer = &buffers[i];
+  }
+
+  Double_t total = 0;
+  Long64_t iterations = 0, bytes = 0, allocs = 0;
+  while (total < minTime || iterations == 0) {
+    Long64_t allocStart = microAllocs;
+    Double_t start = PerfNow();
+    bytes = IoReadFiles(&files[0], files.size(), backend);
+    total += PerfNow() - start;
+    allocs += microAllocs - allocStart;
+    iterations++;
+  }
+
+  Double_t perIter = total/iterations;
+  Double_t allocsPerCall = files.size() > 0 ? (Double_t)allocs/iterations/files.size() : 0;
+  printf("%-38s %12.1f %10lld %12.4g %10.2f %12.1f\n", name, 1e6*perIter, iterations,
+         files.size()/perIter, bytes/perIter/1e6, allocsPerCall);
+}
+
+void microHelp(void)
+{
+//
+// Prints a usage message
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  printf("\nUsage:\n");
+  printf("   dataCompMicroBench [-h] [-i] [-p] [-d DIR] [-r ROWS] [-t SEC] [-m MODE] [-b NAME] [-w N]\n");
+  printf("             -h       prints this message\n");
+  printf("             -i       uses an IB HIC corpus instead of an OB one\n");
+  printf("             -p       fills packed pixel trees (one entry per chip)\n");
+  printf("             -d DIR   directory of the corpus (default benchdata)\n");
+  printf("             -r ROWS  pixel rows per chip in the pixel files (default 512)\n");
+  printf("             -t SEC   minimum time per benchmark (default 0.5)\n");
+  printf("             -m MODE  fill, nofill (tree Fill stubbed) or both (default)\n");
+  printf("             -b NAME  runs only the benchmarks whose name contains NAME\n");
+  printf("             -w N     worker threads of the file read benchmark (default 0 = one per core)\n");
+}
+
+int main(int argc, char** argv)
+{
+  Double_t minTime = 0.5;
+  string mode = "both", filter = "";
+  Int_t nworkers = 0;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-h") {
+      microHelp();
+      exit(0);
+    } else if (arg == "-i")
+      microHicType = HIC_IB;
+    else if (arg == "-p")
+      SetPackedPixelTrees(kTRUE);
+    else if (arg == "-d" && i+1 < argc)
+      benchDataDir = argv[++i];
+    else if (arg == "-r" && i+1 < argc)
+      benchNumRows = atoi(argv[++i]);
+    else if (arg == "-t" && i+1 < argc)
+      minTime = atof(argv[++i]);
+    else if (arg == "-m" && i+1 < argc)
+      mode = argv[++i];
+    else if (arg == "-b" && i+1 < argc)
+      filter = argv[++i];
+    else if (arg == "-w" && i+1 < argc)
+      nworkers = atoi(argv[++i]);
+    else {
+      microHelp();
+      exit(1);
+    }
+  }
+
+  if ((mode != "fill" && mode != "nofill" && mode != "both") || !SchedSetThreads(nworkers)) {
+    microHelp();
+    exit(1);
+  }
+
+  createLogFileName(argv[0]);
+  setBatchMode(true);
+
+  // The corpus is always regenerated, so that it is the same for all runs
+  if (!BenchGenerateAll(MICRONUMHICS, microHicType)) exit(1);
+  if (!DbLibSetSnapshotFile(BenchSnapshotName().c_str())) exit(1);
+
+  printf("\n%-38s %12s %10s %12s %10s %12s\n", "Benchmark", "Time(us)", "Iterations", "Rows/s", "MB/s", "Allocs/call");
+  for (UInt_t ib = 0; ib < sizeof(microBench)/sizeof(microBench[0]); ib++) {
+    if (filter.length() > 0 && string(microBench[ib].name).find(filter) == string::npos)
+      continue;
+    if (mode != "nofill") microBenchmark(microBench[ib], kFALSE, minTime);
+    if (mode != "fill")   microBenchmark(microBench[ib], kTRUE, minTime);
+  }
+
+  if (filter.length() == 0 || string("ReadFiles").find(filter) != string::npos)
+    for (Int_t backend = IOBACKEND_STDIO; backend <= IOBACKEND_URING; backend++)
+      microReadBenchmark(backend, minTime);
+
+  return 0;
+}
@@ -14,12 +14,55 @@ void printHelp(void)
 // Return:
 //
 // Created:      19 Sep 2018  Mario Sitta
+// Updated:      19 Oct 2026  Options of the run, I/O and analysis stages added
 //
 
   cout << endl << "Usage:" << endl;
-  cout << "   dataComp [-h|--help] [-c|--color]" << endl;
+  cout << "   dataComp [-h|--help] [-c|--color] [--shard i/N] [--merge N]" << endl;
+  cout << "            [--watch M] [--metrics FILE]" << endl;
+  cout << "            [--db-snapshot FILE|--db-record FILE] [--eos-root DIR]" << endl;
+  cout << "            [--packed-pixels] [--threads N] [--trend] [--trend-memory MB]" << endl;
+  cout << "            [--sort chip|pixel] [--sort-memory MB] [--resume]" << endl;
+  cout << "            [--workers N] [--max-memory MB] [--io-uring]" << endl;
   cout << "             -h|--help   prints this message" << endl;
   cout << "             -c|--color  uses colored menus" << endl;
+  cout << "             --shard i/N analyzes only the i-th of N shards of the" << endl;
+  cout << "                         HIC list (0 <= i < N) in the all-HICs modes" << endl;
+  cout << "             --merge N   merges the N shard files of the chosen" << endl;
+  cout << "                         all-HICs analysis into a single file" << endl;
+  cout << "             --watch M   polls the DB every M minutes in the all-HICs" << endl;
+  cout << "                         modes and appends only the new activities" << endl;
+  cout << "             --metrics FILE writes the run metrics to FILE (in" << endl;
+  cout << "                         Prometheus format if it ends with .prom," << endl;
+  cout << "                         otherwise in JSON) in the all-HICs modes" << endl;
+  cout << "             --db-snapshot FILE answers all DB queries from the" << endl;
+  cout << "                         snapshot FILE, without connecting to the DB" << endl;
+  cout << "             --db-record FILE writes all DB answers of this run" << endl;
+  cout << "                         to FILE, to be used later as snapshot" << endl;
+  cout << "             --eos-root DIR reads the EOS files from a local copy" << endl;
+  cout << "                         of /eos in DIR" << endl;
+  cout << "             --packed-pixels writes the Digital and Threshold Scan" << endl;
+  cout << "                         pixel trees with one entry per chip" << endl;
+  cout << "             --threads N compresses and writes the ROOT trees with" << endl;
+  cout << "                         N threads (0 = one per core)" << endl;
+  cout << "             --trend     joins the pixel data of the Threshold," << endl;
+  cout << "                         Digital and Noise Scan files across the" << endl;
+  cout << "                         test stages in the all-HICs modes" << endl;
+  cout << "             --trend-memory MB memory budget of the join of a HIC" << endl;
+  cout << "                         (default 256)" << endl;
+  cout << "             --sort chip|pixel writes the pixel trees of the chosen" << endl;
+  cout << "                         all-HICs analysis sorted chip-major or" << endl;
+  cout << "                         pixel-major into a new file" << endl;
+  cout << "             --sort-memory MB memory budget of the sort (default 512)" << endl;
+  cout << "             --resume    continues the all-HICs analysis of an" << endl;
+  cout << "                         existing file after its last checkpoint" << endl;
+  cout << "             --workers N reads and scans the Threshold Scan files" << endl;
+  cout << "                         with N threads (0 = one per core)" << endl;
+  cout << "             --max-memory MB memory of the files read ahead and of the" << endl;
+  cout << "                         pooled buffers above which the workers do" << endl;
+  cout << "                         not read ahead (default 2048)" << endl;
+  cout << "             --io-uring  reads the Threshold Scan files of an activity" << endl;
+  cout << "                         in batches with io_uring (Linux only)" << endl;
 }
 
 void scanArgs(const int argc, char** argv, bool* help, bool* color)
@@ -40,16 +83,144 @@ void scanArgs(const int argc, char** argv, bool* help, bool* color)
 // Return:
 //
 // Created:      19 Sep 2018  Mario Sitta
+// Updated:      19 Oct 2026  Options of the run, I/O and analysis stages added
 //
 
   if (argc == 1) return;  // User passed no arguments
 
+  bool dbRecord = false;
   for (int i = 1; i < argc; i++) {
     std::string arg = argv[i];
     if ((arg == "-h") || (arg == "--help"))
       *help = true;
     if ((arg == "-c") || (arg == "--color"))
       *color = true;
+    if (arg == "--shard") {
+      int index = -1, total = 0;
+      if (i+1 < argc) sscanf(argv[++i], "%d/%d", &index, &total);
+      if (total < 1 || index < 0 || index >= total) {
+        cerr << "Invalid shard specification, expected i/N with 0 <= i < N" << endl;
+        *help = true;
+      } else
+        SetShardNumber(index, total);
+    }
+    if (arg == "--merge") {
+      int nshards = 0;
+      if (i+1 < argc) sscanf(argv[++i], "%d", &nshards);
+      if (nshards < 1) {
+        cerr << "Invalid number of shards to merge" << endl;
+        *help = true;
+      } else
+        setMergeShards(nshards);
+    }
+    if (arg == "--watch") {
+      int minutes = 0;
+      if (i+1 < argc) sscanf(argv[++i], "%d", &minutes);
+      if (minutes < 1) {
+        cerr << "Invalid watch interval, expected a number of minutes" << endl;
+        *help = true;
+      } else
+        setWatchInterval(minutes);
+    }
+    if (arg == "--metrics") {
+      if (i+1 < argc)
+        setMetricsFile(argv[++i]);
+      else {
+        cerr << "Missing metrics file name" << endl;
+        *help = true;
+      }
+    }
+    if (arg == "--db-snapshot") {
+      if (dbRecord) {
+        cerr << "The DB cannot be recorded while a DB snapshot is in use" << endl;
+        *help = true;
+      } else if (i+1 < argc && DbLibSetSnapshotFile(argv[i+1]))
+        i++;
+      else {
+        cerr << "Cannot read the DB snapshot file" << endl;
+        *help = true;
+      }
+    }
+    if (arg == "--db-record") {
+      if (i+1 < argc && DbLibSetRecordFile(argv[i+1])) {
+        dbRecord = true;
+        i++;
+      } else {
+        cerr << "Missing DB record file name or DB snapshot in use" << endl;
+        *help = true;
+      }
+    }
+    if (arg == "--eos-root") {
+      if (i+1 < argc && DbLibSetEosRoot(argv[i+1]))
+        i++;
+      else {
+        cerr << "Missing or invalid local EOS directory" << endl;
+        *help = true;
+      }
+    }
+    if (arg == "--packed-pixels")
+      SetPackedPixelTrees(kTRUE);
+    if (arg == "--threads") {
+      int nthreads = -1;
+      if (i+1 < argc) sscanf(argv[++i], "%d", &nthreads);
+      if (nthreads < 0 || !SetRootThreads(nthreads)) {
+        cerr << "Invalid number of threads or ROOT built without multithreading" << endl;
+        *help = true;
+      }
+    }
+    if (arg == "--trend")
+      setPixelTrends(true);
+    if (arg == "--trend-memory") {
+      int mbytes = 0;
+      if (i+1 < argc) sscanf(argv[++i], "%d", &mbytes);
+      if (mbytes < 1) {
+        cerr << "Invalid trend memory budget, expected a number of MB" << endl;
+        *help = true;
+      } else
+        SetTrendMemory(mbytes);
+    }
+    if (arg == "--sort") {
+      std::string key = (i+1 < argc) ? argv[++i] : "";
+      if (key == "chip")
+        SetPixelSortKey(SORTKEY_CHIP);
+      else if (key == "pixel")
+        SetPixelSortKey(SORTKEY_PIXEL);
+      else {
+        cerr << "Invalid sort key, expected chip or pixel" << endl;
+        *help = true;
+      }
+    }
+    if (arg == "--sort-memory") {
+      int mbytes = 0;
+      if (i+1 < argc) sscanf(argv[++i], "%d", &mbytes);
+      if (mbytes < 1) {
+        cerr << "Invalid sort memory budget, expected a number of MB" << endl;
+        *help = true;
+      } else
+        SetPixelSortMemory(mbytes);
+    }
+    if (arg == "--resume")
+      SetResumeMode(kTRUE);
+    if (arg == "--workers") {
+      int nthreads = -1;
+      if (i+1 < argc) sscanf(argv[++i], "%d", &nthreads);
+      if (!SchedSetThreads(nthreads)) {
+        cerr << "Invalid number of worker threads" << endl;
+        *help = true;
+      }
+    }
+    if (arg == "--max-memory") {
+      int mbytes = 0;
+      if (i+1 < argc) sscanf(argv[++i], "%d", &mbytes);
+      if (mbytes < 1) {
+        cerr << "Invalid memory cap, expected a number of MB" << endl;
+        *help = true;
+      } else
+        SchedSetMemory(mbytes);
+    }
+    if (arg == "--io-uring")
+      if (!IoSetBackend(IOBACKEND_URING))
+        cerr << "Warning: io_uring not available, files read by the workers" << endl;
   }
 
 }
@@ -2,6 +2,8 @@
 #define DATACOMP_H
 
 #include "menulib.h"
+#include "sortlib.h"
+#include "trendlib.h"
 
 #include <time.h>
 
@@ -0,0 +1,829 @@
+#include "dblib.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//
+// The DB access layer: every query is answered either by the live
+// AlpideDB (through the DbGet* helpers) or, if a snapshot file was
+// given, by the content of the snapshot, so that the analyses can run
+// offline and reproducibly. When a record file is given, all answers of
+// the live DB are kept and written to it at exit, to be used as snapshot
+//
+
+// A component as known to the snapshot
+struct TDbComponent {
+  Int_t  ID;
+  string ComponentID;
+  Int_t  Type;      // -1 if unknown
+  Int_t  Position;  // -1 if unknown
+};
+
+// A value read from a JSON file
+struct TDbJson {
+  Char_t type;                // 'n'ull, 'b'ool, 'd'ouble, 's'tring, 'a'rray, 'o'bject
+  Double_t num;
+  string str;
+  std::vector<string> keys;   // Object member names
+  std::vector<TDbJson> items; // Array items or object member values
+};
+
+static Bool_t dbSnapshotMode = kFALSE;
+static string dbRecordFile = "";
+static string dbEosRoot = "";
+
+// The content of the snapshot (or what was recorded so far)
+static std::map<string, Int_t> dbCompTypes;
+static std::map<Int_t, TDbComponent> dbComponents;
+static std::map<Long64_t, std::vector<TChild> > dbChildren;
+static std::map<Long64_t, std::vector<ComponentDB::compActivity> > dbTests;
+static std::map<Int_t, ActivityDB::activityLong> dbActivities;
+
+// The live ActivityDB and the DB it was created for
+static ActivityDB *dbActivityDB = 0;
+static AlpideDB   *dbActivityDBOwner = 0;
+
+static void DbLibRecordComponent(const Int_t id, const string name, const Int_t type, const Int_t position)
+{
+//
+// Adds what is known of a component to the recorded data
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbComponents.count(id) == 0) {
+    TDbComponent comp;
+    comp.ID = id;
+    comp.ComponentID = "";
+    comp.Type = -1;
+    comp.Position = -1;
+    dbComponents[id] = comp;
+  }
+
+  TDbComponent &comp = dbComponents[id];
+  if (name.length() > 0) comp.ComponentID = name;
+  if (type >= 0)         comp.Type = type;
+  if (position >= 0)     comp.Position = position;
+}
+
+static void DbLibWriteAtExit(void)
+{
+  // Nothing to write if a snapshot was read after the recording was set
+  if (dbRecordFile.length() == 0) return;
+
+  DbLibWriteSnapshot(dbRecordFile.c_str());
+}
+
+//
+// JSON reading and writing
+//
+
+static void DbJsonSkipBlanks(const char *&p)
+{
+  while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+}
+
+static Bool_t DbJsonParse(const char *&p, TDbJson &val)
+{
+//
+// Parses a JSON value (recursive descent)
+//
+// Inputs:
+//          p   : pointer to the first character of the value
+//
+// Outputs:
+//          p   : pointer to the first character after the value
+//          val : the value
+//
+// Return:
+//          true if the value was parsed successfully
+//
+// Created:      19 Oct 2026
+//
+
+  DbJsonSkipBlanks(p);
+
+  val.keys.clear();
+  val.items.clear();
+
+  if (*p == '{' || *p == '[') {
+    Bool_t isObject = (*p == '{');
+    const Char_t close = isObject ? '}' : ']';
+    val.type = isObject ? 'o' : 'a';
+    p++;
+    DbJsonSkipBlanks(p);
+    if (*p == close) {
+      p++;
+      return kTRUE;
+    }
+    while (true) {
+      if (isObject) {
+        TDbJson key;
+        if (!DbJsonParse(p, key) || key.type != 's') return kFALSE;
+        DbJsonSkipBlanks(p);
+        if (*p++ != ':') return kFALSE;
+        val.keys.push_back(key.str);
+      }
+      val.items.push_back(TDbJson());
+      if (!DbJsonParse(p, val.items.back())) return kFALSE;
+      DbJsonSkipBlanks(p);
+      if (*p == ',') {
+        p++;
+        continue;
+      }
+      if (*p++ != close) return kFALSE;
+      return kTRUE;
+    }
+  }
+
+  if (*p == '"') {
+    val.type = 's';
+    val.str = "";
+    for (p++; *p && *p != '"'; p++) {
+      if (*p != '\\') {
+        val.str += *p;
+        continue;
+      }
+      p++;
+      switch (*p) {
+        case 'n': val.str += '\n'; break;
+        case 't': val.str += '\t'; break;
+        case 'r': val.str += '\r'; break;
+        case 'b': val.str += '\b'; break;
+        case 'f': val.str += '\f'; break;
+        case 'u': { // Only ASCII is written by us
+          unsigned int code = 0;
+          if (sscanf(p+1, "%4x", &code) != 1) return kFALSE;
+          val.str += (Char_t)code;
+          p += 4;
+          break;
+        }
+        case '\0': return kFALSE;
+        default: val.str += *p; break;
+      }
+    }
+    if (*p++ != '"') return kFALSE;
+    return kTRUE;
+  }
+
+  if (strncmp(p, "true", 4) == 0 || strncmp(p, "false", 5) == 0) {
+    val.type = 'b';
+    val.num = (*p == 't') ? 1 : 0;
+    p += (*p == 't') ? 4 : 5;
+    return kTRUE;
+  }
+
+  if (strncmp(p, "null", 4) == 0) {
+    val.type = 'n';
+    p += 4;
+    return kTRUE;
+  }
+
+  char *end;
+  val.type = 'd';
+  val.num = strtod(p, &end);
+  if (end == p) return kFALSE;
+  p = end;
+
+  return kTRUE;
+}
+
+static const TDbJson* DbJsonMember(const TDbJson &obj, const char *key)
+{
+  for (UInt_t i = 0; i < obj.keys.size(); i++)
+    if (obj.keys[i] == key) return &obj.items[i];
+
+  return 0;
+}
+
+static Double_t DbJsonNumber(const TDbJson &obj, const char *key, const Double_t defval=0)
+{
+  const TDbJson *val = DbJsonMember(obj, key);
+  if (!val || (val->type != 'd' && val->type != 'b')) return defval;
+
+  return val->num;
+}
+
+static string DbJsonString(const TDbJson &obj, const char *key)
+{
+  const TDbJson *val = DbJsonMember(obj, key);
+  if (!val || val->type != 's') return "";
+
+  return val->str;
+}
+
+static void DbJsonNameId(const TDbJson &obj, const char *key, Int_t &id, string &name)
+{
+  const TDbJson *val = DbJsonMember(obj, key);
+  id = val ? (Int_t)DbJsonNumber(*val, "ID") : 0;
+  name = val ? DbJsonString(*val, "Name") : "";
+}
+
+static string DbJsonQuote(const string str)
+{
+//
+// Returns a string quoted and escaped for JSON
+//
+// Created:      19 Oct 2026
+//
+
+  string quoted = "\"";
+  for (UInt_t i = 0; i < str.length(); i++) {
+    Char_t c = str[i];
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if ((UChar_t)c < 0x20) {
+      char code[8];
+      snprintf(code, sizeof(code), "\\u%04x", (UChar_t)c);
+      quoted += code;
+    } else
+      quoted += c;
+  }
+  quoted += "\"";
+
+  return quoted;
+}
+
+//
+// The DB access routines
+//
+
+AlpideDB* DbLibConnect(void)
+{
+//
+// Opens the connection to the live DB (nothing to open with a snapshot)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the opened DB (0 if a snapshot is used)
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbSnapshotMode) return 0;
+
+  return new AlpideDB(false);
+}
+
+void DbLibDisconnect(AlpideDB *db)
+{
+//
+// Closes the connection to the live DB and frees what was created for it
+//
+// Inputs:
+//          db : the DB returned by DbLibConnect (nothing done if 0)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!db) return;
+
+  if (dbActivityDBOwner == db) {
+    delete dbActivityDB;
+    dbActivityDB = 0;
+    dbActivityDBOwner = 0;
+  }
+
+  delete db;
+}
+
+Int_t DbLibGetComponentId(AlpideDB *db, const Int_t typeId, const string name)
+{
+//
+// Returns the Id of a component given its name (-1 if not found)
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbSnapshotMode) {
+    std::map<Int_t, TDbComponent>::iterator it;
+    for (it = dbComponents.begin(); it != dbComponents.end(); it++)
+      if (it->second.ComponentID == name &&
+          (it->second.Type == typeId || it->second.Type < 0))
+        return it->first;
+    return -1;
+  }
+
+  Int_t id = DbGetComponentId(db, typeId, name);
+  if (dbRecordFile.length() > 0 && id != -1)
+    DbLibRecordComponent(id, name, typeId, -1);
+
+  return id;
+}
+
+void DbLibGetComponentList(AlpideDB *db, const Int_t typeId, std::vector<ComponentDB::componentShort> &componentList)
+{
+//
+// Returns the list of all components of a given type
+//
+// Created:      19 Oct 2026
+//
+
+  componentList.clear();
+
+  if (dbSnapshotMode) {
+    std::map<Int_t, TDbComponent>::iterator it;
+    for (it = dbComponents.begin(); it != dbComponents.end(); it++)
+      if (it->second.Type == typeId) {
+        ComponentDB::componentShort comp;
+        comp.ID = it->first;
+        comp.ComponentID = it->second.ComponentID;
+        componentList.push_back(comp);
+      }
+    return;
+  }
+
+  ComponentDB *componentDB = new ComponentDB(db);
+  componentDB->GetListByType(db->GetProjectId(), typeId, &componentList);
+  delete componentDB;
+
+  if (dbRecordFile.length() > 0)
+    for (UInt_t i = 0; i < componentList.size(); i++)
+      DbLibRecordComponent(componentList[i].ID, componentList[i].ComponentID, typeId, -1);
+}
+
+string DbLibGetComponentName(AlpideDB *db, const Int_t typeId, const Int_t id)
+{
+//
+// Returns the name of a component given its Id
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbSnapshotMode) {
+    if (dbComponents.count(id) == 0) return "";
+    return dbComponents[id].ComponentID;
+  }
+
+  string name = DbGetComponentName(db, typeId, id);
+  if (dbRecordFile.length() > 0)
+    DbLibRecordComponent(id, name, typeId, -1);
+
+  return name;
+}
+
+Int_t DbLibGetComponentTypeId(AlpideDB *db, const string name)
+{
+//
+// Returns the Id of a component type given its name (-1 if not found)
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbSnapshotMode) {
+    if (dbCompTypes.count(name) == 0) return -1;
+    return dbCompTypes[name];
+  }
+
+  Int_t id = DbGetComponentTypeId(db, name);
+  if (dbRecordFile.length() > 0)
+    dbCompTypes[name] = id;
+
+  return id;
+}
+
+void DbLibGetAllTests(AlpideDB *db, const Int_t compId, std::vector<ComponentDB::compActivity> &tests, const TScanType scanType, const Bool_t lastOnly)
+{
+//
+// Returns the list of the activities of a given scan type of a component
+//
+// Created:      19 Oct 2026
+//
+
+  Long64_t key = ((Long64_t)compId << 16) | ((Int_t)scanType << 1) | (lastOnly ? 1 : 0);
+
+  if (dbSnapshotMode) {
+    tests.clear();
+    if (dbTests.count(key) > 0) tests = dbTests[key];
+    return;
+  }
+
+  DbGetAllTests(db, compId, tests, scanType, lastOnly);
+  if (dbRecordFile.length() > 0)
+    dbTests[key] = tests;
+}
+
+Int_t DbLibGetListOfChildren(AlpideDB *db, const Int_t id, std::vector<TChild> &children, const Bool_t chipsOnly)
+{
+//
+// Returns the list of the children of a component
+//
+// Created:      19 Oct 2026
+//
+
+  Long64_t key = ((Long64_t)id << 1) | (chipsOnly ? 1 : 0);
+
+  if (dbSnapshotMode) {
+    children.clear();
+    if (dbChildren.count(key) > 0) children = dbChildren[key];
+    return children.size();
+  }
+
+  Int_t nchildren = DbGetListOfChildren(db, id, children, chipsOnly);
+  if (dbRecordFile.length() > 0)
+    dbChildren[key] = children;
+
+  return nchildren;
+}
+
+Int_t DbLibGetPosition(AlpideDB *db, const Int_t compId)
+{
+//
+// Returns the position of a component
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbSnapshotMode) {
+    if (dbComponents.count(compId) == 0) return -1;
+    return dbComponents[compId].Position;
+  }
+
+  Int_t position = DbGetPosition(db, compId);
+  if (dbRecordFile.length() > 0)
+    DbLibRecordComponent(compId, "", -1, position);
+
+  return position;
+}
+
+Bool_t DbLibIsOpen(AlpideDB *db)
+{
+//
+// Checks whether the DB can be queried
+//
+// Inputs:
+//          db : the DB returned by DbLibConnect
+//
+// Outputs:
+//
+// Return:
+//          true if the DB is open or a snapshot is used
+//
+// Created:      19 Oct 2026
+//
+
+  return (dbSnapshotMode || db != 0);
+}
+
+string DbLibMapEosPath(const string &path)
+{
+//
+// Maps an EOS path to the local copy of EOS (if one was given)
+//
+// Inputs:
+//          path : the EOS path
+//
+// Outputs:
+//
+// Return:
+//          the path with the leading /eos replaced by the local directory
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbEosRoot.length() == 0 || path.compare(0, 5, "/eos/") != 0)
+    return path;
+
+  return dbEosRoot + path.substr(4);
+}
+
+Bool_t DbLibReadActivity(AlpideDB *db, const Int_t actId, ActivityDB::activityLong *actlong)
+{
+//
+// Reads the full information of an activity
+//
+// Inputs:
+//          db    : the DB
+//          actId : the Activity Id
+//
+// Outputs:
+//          actlong : the activity
+//
+// Return:
+//          true if the activity was found
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbSnapshotMode) {
+    if (dbActivities.count(actId) == 0) return kFALSE;
+    *actlong = dbActivities[actId];
+    return kTRUE;
+  }
+
+  // The credentials are renewed from time to time: a new DB means
+  // a new ActivityDB
+  if (!dbActivityDB || dbActivityDBOwner != db) {
+    dbActivityDB = new ActivityDB(db);
+    dbActivityDBOwner = db;
+  }
+
+  dbActivityDB->Read(actId, actlong);
+  if (dbRecordFile.length() > 0)
+    dbActivities[actId] = *actlong;
+
+  return kTRUE;
+}
+
+Bool_t DbLibSetEosRoot(const char *dirname)
+{
+//
+// Sets the local directory holding a copy of EOS
+//
+// Inputs:
+//          dirname : the directory (used in place of /eos)
+//
+// Outputs:
+//
+// Return:
+//          true if the directory exists
+//
+// Created:      19 Oct 2026
+//
+
+  struct stat dirStat;
+  if (stat(dirname, &dirStat) != 0 || !S_ISDIR(dirStat.st_mode))
+    return kFALSE;
+
+  dbEosRoot = dirname;
+  if (dbEosRoot.length() > 1 && dbEosRoot[dbEosRoot.length()-1] == '/')
+    dbEosRoot.erase(dbEosRoot.length()-1);
+
+  return kTRUE;
+}
+
+Bool_t DbLibSetRecordFile(const char *filename)
+{
+//
+// Records all answers of the live DB and writes them to a snapshot
+// file at exit
+//
+// Inputs:
+//          filename : the snapshot file name
+//
+// Outputs:
+//
+// Return:
+//          false if a snapshot is used (nothing to record)
+//
+// Created:      19 Oct 2026
+//
+
+  if (dbSnapshotMode) return kFALSE;
+
+  if (dbRecordFile.length() == 0)
+    atexit(DbLibWriteAtExit);
+  dbRecordFile = filename;
+
+  return kTRUE;
+}
+
+Bool_t DbLibSetSnapshotFile(const char *filename)
+{
+//
+// Reads a snapshot file: from now on all queries are answered from it
+// and the live DB is never contacted
+//
+// Inputs:
+//          filename : the snapshot file name
+//
+// Outputs:
+//
+// Return:
+//          true if the snapshot was successfully read
+//
+// Created:      19 Oct 2026
+//
+
+  FILE *infile = fopen(filename, "r");
+  if (!infile) return kFALSE;
+
+  string text;
+  char buffer[65536];
+  size_t nread;
+  while ((nread = fread(buffer, 1, sizeof(buffer), infile)) > 0)
+    text.append(buffer, nread);
+  fclose(infile);
+
+  TDbJson root;
+  const char *p = text.c_str();
+  if (!DbJsonParse(p, root) || root.type != 'o') return kFALSE;
+
+  dbCompTypes.clear();
+  dbComponents.clear();
+  dbChildren.clear();
+  dbTests.clear();
+  dbActivities.clear();
+
+  const TDbJson *list;
+
+  if ((list = DbJsonMember(root, "componentTypes")))
+    for (UInt_t i = 0; i < list->items.size(); i++)
+      dbCompTypes[DbJsonString(list->items[i], "Name")] = (Int_t)DbJsonNumber(list->items[i], "ID");
+
+  if ((list = DbJsonMember(root, "components")))
+    for (UInt_t i = 0; i < list->items.size(); i++) {
+      const TDbJson &item = list->items[i];
+      DbLibRecordComponent((Int_t)DbJsonNumber(item, "ID"), DbJsonString(item, "ComponentID"),
+                           (Int_t)DbJsonNumber(item, "Type", -1), (Int_t)DbJsonNumber(item, "Position", -1));
+    }
+
+  if ((list = DbJsonMember(root, "children")))
+    for (UInt_t i = 0; i < list->items.size(); i++) {
+      const TDbJson &item = list->items[i];
+      Long64_t key = ((Long64_t)DbJsonNumber(item, "Parent") << 1) | (Int_t)DbJsonNumber(item, "ChipsOnly");
+      std::vector<TChild> &children = dbChildren[key];
+      const TDbJson *sublist = DbJsonMember(item, "List");
+      for (UInt_t j = 0; sublist && j < sublist->items.size(); j++) {
+        TChild child;
+        child.Id = (Int_t)DbJsonNumber(sublist->items[j], "Id");
+        child.Name = DbJsonString(sublist->items[j], "Name");
+        child.Position = DbJsonString(sublist->items[j], "Position");
+        children.push_back(child);
+      }
+    }
+
+  if ((list = DbJsonMember(root, "tests")))
+    for (UInt_t i = 0; i < list->items.size(); i++) {
+      const TDbJson &item = list->items[i];
+      Long64_t key = ((Long64_t)DbJsonNumber(item, "Component") << 16)
+                   | ((Int_t)DbJsonNumber(item, "ScanType") << 1)
+                   | (Int_t)DbJsonNumber(item, "LastOnly");
+      std::vector<ComponentDB::compActivity> &tests = dbTests[key];
+      const TDbJson *sublist = DbJsonMember(item, "List");
+      for (UInt_t j = 0; sublist && j < sublist->items.size(); j++) {
+        const TDbJson &jact = sublist->items[j];
+        ComponentDB::compActivity act;
+        act.ID = (Int_t)DbJsonNumber(jact, "ID");
+        act.Name = DbJsonString(jact, "Name");
+        DbJsonNameId(jact, "Type", act.Type.ID, act.Type.Name);
+        DbJsonNameId(jact, "Result", act.Result.ID, act.Result.Name);
+        DbJsonNameId(jact, "Status", act.Status.ID, act.Status.Name);
+        act.StartDate = (time_t)DbJsonNumber(jact, "StartDate");
+        act.EndDate = (time_t)DbJsonNumber(jact, "EndDate");
+        tests.push_back(act);
+      }
+    }
+
+  if ((list = DbJsonMember(root, "activities")))
+    for (UInt_t i = 0; i < list->items.size(); i++) {
+      const TDbJson &jact = list->items[i];
+      ActivityDB::activityLong act;
+      act.ID = (Int_t)DbJsonNumber(jact, "ID");
+      act.Name = DbJsonString(jact, "Name");
+      DbJsonNameId(jact, "Type", act.Type.ID, act.Type.Name);
+      DbJsonNameId(jact, "Location", act.Location.ID, act.Location.Name);
+      DbJsonNameId(jact, "Result", act.Result.ID, act.Result.Name);
+      DbJsonNameId(jact, "Status", act.Status.ID, act.Status.Name);
+      act.StartDate = (time_t)DbJsonNumber(jact, "StartDate");
+      act.EndDate = (time_t)DbJsonNumber(jact, "EndDate");
+      const TDbJson *sublist = DbJsonMember(jact, "Parameters");
+      for (UInt_t j = 0; sublist && j < sublist->items.size(); j++) {
+        ActivityDB::actParameter par;
+        par.ID = (Int_t)DbJsonNumber(sublist->items[j], "ID");
+        par.Type.ID = 0;
+        par.Type.Parameter.ID = 0;
+        par.Type.Parameter.Name = DbJsonString(sublist->items[j], "Name");
+        par.Value = DbJsonNumber(sublist->items[j], "Value");
+        act.Parameters.push_back(par);
+      }
+      sublist = DbJsonMember(jact, "Attachments");
+      for (UInt_t j = 0; sublist && j < sublist->items.size(); j++) {
+        ActivityDB::attachment att;
+        att.ID = (Int_t)DbJsonNumber(sublist->items[j], "ID");
+        att.FileName = DbJsonString(sublist->items[j], "FileName");
+        act.Attachments.push_back(att);
+      }
+      dbActivities[act.ID] = act;
+    }
+
+  dbSnapshotMode = kTRUE;
+  dbRecordFile = "";
+
+  return kTRUE;
+}
+
+Bool_t DbLibUseSnapshot(void)
+{
+//
+// Returns true if the queries are answered from a snapshot
+//
+// Created:      19 Oct 2026
+//
+
+  return dbSnapshotMode;
+}
+
+Bool_t DbLibWriteSnapshot(const char *filename)
+{
+//
+// Writes all known DB answers to a snapshot file (JSON). The file
+// is written under a temporary name and then renamed
+//
+// Inputs:
+//          filename : the snapshot file name
+//
+// Outputs:
+//
+// Return:
+//          true if the file was successfully written
+//
+// Created:      19 Oct 2026
+//
+
+  string tmpname = string(filename) + ".tmp";
+  FILE *outfile = fopen(tmpname.c_str(), "w");
+  if (!outfile) return kFALSE;
+
+  const char *sep;
+
+  fprintf(outfile, "{\n\"version\": 1,\n\"componentTypes\": [");
+  sep = "\n";
+  std::map<string, Int_t>::iterator itype;
+  for (itype = dbCompTypes.begin(); itype != dbCompTypes.end(); itype++) {
+    fprintf(outfile, "%s {\"Name\": %s, \"ID\": %d}", sep, DbJsonQuote(itype->first).c_str(), itype->second);
+    sep = ",\n";
+  }
+
+  fprintf(outfile, "\n],\n\"components\": [");
+  sep = "\n";
+  std::map<Int_t, TDbComponent>::iterator icomp;
+  for (icomp = dbComponents.begin(); icomp != dbComponents.end(); icomp++) {
+    fprintf(outfile, "%s {\"ID\": %d, \"ComponentID\": %s, \"Type\": %d, \"Position\": %d}", sep,
+            icomp->first, DbJsonQuote(icomp->second.ComponentID).c_str(),
+            icomp->second.Type, icomp->second.Position);
+    sep = ",\n";
+  }
+
+  fprintf(outfile, "\n],\n\"children\": [");
+  sep = "\n";
+  std::map<Long64_t, std::vector<TChild> >::iterator ichild;
+  for (ichild = dbChildren.begin(); ichild != dbChildren.end(); ichild++) {
+    fprintf(outfile, "%s {\"Parent\": %lld, \"ChipsOnly\": %s, \"List\": [", sep,
+            ichild->first >> 1, (ichild->first & 1) ? "true" : "false");
+    for (UInt_t j = 0; j < ichild->second.size(); j++)
+      fprintf(outfile, "%s\n  {\"Id\": %d, \"Name\": %s, \"Position\": %s}", j ? "," : "",
+              ichild->second[j].Id, DbJsonQuote(ichild->second[j].Name).c_str(),
+              DbJsonQuote(ichild->second[j].Position).c_str());
+    fprintf(outfile, "]}");
+    sep = ",\n";
+  }
+
+  fprintf(outfile, "\n],\n\"tests\": [");
+  sep = "\n";
+  std::map<Long64_t, std::vector<ComponentDB::compActivity> >::iterator itest;
+  for (itest = dbTests.begin(); itest != dbTests.end(); itest++) {
+    fprintf(outfile, "%s {\"Component\": %lld, \"ScanType\": %lld, \"LastOnly\": %s, \"List\": [", sep,
+            itest->first >> 16, (itest->first >> 1) & 0x7fff, (itest->first & 1) ? "true" : "false");
+    for (UInt_t j = 0; j < itest->second.size(); j++) {
+      const ComponentDB::compActivity &act = itest->second[j];
+      fprintf(outfile, "%s\n  {\"ID\": %d, \"Name\": %s, \"Type\": {\"ID\": %d, \"Name\": %s}, "
+              "\"Result\": {\"ID\": %d, \"Name\": %s}, \"Status\": {\"ID\": %d, \"Name\": %s}, "
+              "\"StartDate\": %ld, \"EndDate\": %ld}", j ? "," : "",
+              act.ID, DbJsonQuote(act.Name).c_str(), act.Type.ID, DbJsonQuote(act.Type.Name).c_str(),
+              act.Result.ID, DbJsonQuote(act.Result.Name).c_str(),
+              act.Status.ID, DbJsonQuote(act.Status.Name).c_str(),
+              (long)act.StartDate, (long)act.EndDate);
+    }
+    fprintf(outfile, "]}");
+    sep = ",\n";
+  }
+
+  fprintf(outfile, "\n],\n\"activities\": [");
+  sep = "\n";
+  std::map<Int_t, ActivityDB::activityLong>::iterator iact;
+  for (iact = dbActivities.begin(); iact != dbActivities.end(); iact++) {
+    const ActivityDB::activityLong &act = iact->second;
+    fprintf(outfile, "%s {\"ID\": %d, \"Name\": %s, \"Type\": {\"ID\": %d, \"Name\": %s}, "
+            "\"Location\": {\"ID\": %d, \"Name\": %s}, \"Result\": {\"ID\": %d, \"Name\": %s}, "
+            "\"Status\": {\"ID\": %d, \"Name\": %s}, \"StartDate\": %ld, \"EndDate\": %ld,\n  \"Parameters\": [",
+            sep, act.ID, DbJsonQuote(act.Name).c_str(), act.Type.ID, DbJsonQuote(act.Type.Name).c_str(),
+            act.Location.ID, DbJsonQuote(act.Location.Name).c_str(),
+            act.Result.ID, DbJsonQuote(act.Result.Name).c_str(),
+            act.Status.ID, DbJsonQuote(act.Status.Name).c_str(),
+            (long)act.StartDate, (long)act.EndDate);
+    for (UInt_t j = 0; j < act.Parameters.size(); j++)
+      fprintf(outfile, "%s{\"ID\": %d, \"Name\": %s, \"Value\": %.9g}", j ? ", " : "",
+              act.Parameters[j].ID, DbJsonQuote(act.Parameters[j].Type.Parameter.Name).c_str(),
+              act.Parameters[j].Value);
+    fprintf(outfile, "],\n  \"Attachments\": [");
+    for (UInt_t j = 0; j < act.Attachments.size(); j++)
+      fprintf(outfile, "%s{\"ID\": %d, \"FileName\": %s}", j ? ", " : "",
+              act.Attachments[j].ID, DbJsonQuote(act.Attachments[j].FileName).c_str());
+    fprintf(outfile, "]}");
+    sep = ",\n";
+  }
+
+  fprintf(outfile, "\n]\n}\n");
+  fclose(outfile);
+
+  return (rename(tmpname.c_str(), filename) == 0);
+}
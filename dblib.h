@@ -0,0 +1,40 @@
+#ifndef DBLIB_H
+#define DBLIB_H
+
+#include <Rtypes.h>
+
+#include "DBHelpers.h"
+#include "AlpideDB.h"
+#include "AlpideDBEndPoints.h"
+
+#include <map>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using std::string;
+
+// All DB queries of the analyses go through these routines: they are
+// served either by the live AlpideDB or by a snapshot file (JSON), and
+// the answers of the live DB can be recorded into a snapshot file
+
+AlpideDB* DbLibConnect(void);
+void DbLibDisconnect(AlpideDB *db);
+Int_t DbLibGetComponentId(AlpideDB *db, const Int_t typeId, const string name);
+void DbLibGetComponentList(AlpideDB *db, const Int_t typeId, std::vector<ComponentDB::componentShort> &componentList);
+string DbLibGetComponentName(AlpideDB *db, const Int_t typeId, const Int_t id);
+Int_t DbLibGetComponentTypeId(AlpideDB *db, const string name);
+void DbLibGetAllTests(AlpideDB *db, const Int_t compId, std::vector<ComponentDB::compActivity> &tests, const TScanType scanType, const Bool_t lastOnly);
+Int_t DbLibGetListOfChildren(AlpideDB *db, const Int_t id, std::vector<TChild> &children, const Bool_t chipsOnly);
+Int_t DbLibGetPosition(AlpideDB *db, const Int_t compId);
+Bool_t DbLibIsOpen(AlpideDB *db);
+string DbLibMapEosPath(const string &path);
+Bool_t DbLibReadActivity(AlpideDB *db, const Int_t actId, ActivityDB::activityLong *actlong);
+Bool_t DbLibSetEosRoot(const char *dirname);
+Bool_t DbLibSetRecordFile(const char *filename);
+Bool_t DbLibSetSnapshotFile(const char *filename);
+Bool_t DbLibUseSnapshot(void);
+Bool_t DbLibWriteSnapshot(const char *filename);
+
+#endif // DBLIB_H
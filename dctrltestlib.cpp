@@ -37,9 +37,17 @@ Double_t maxRiseNeg[NUMCHIPS];
 Double_t maxFallNeg[NUMCHIPS];
 Float_t  classificDctrlTest;
 
+// The trees of each activity type (see MergeShardRootFiles)
+static const TActTreeNames dctrlTestTreeNames[] = {
+  {ACTMASK_QUALIF, "hicQualTree", 0, "hicQualResTree"},
+  {ACTMASK_RECEPT, "hicRecpTree", 0, "hicRecpResTree"},
+  {ACTMASK_HALFST, "hicHSTree", 0, "hicHSResTree"},
+  {ACTMASK_STAVET, "hicStaveQualTree", 0, "hicStaveQualResTree"},
+  {ACTMASK_STVREC, "hicStaveRecpTree", 0, "hicStaveRecpResTree"}
+};
 
 
-void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType)
+void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType)
 {
 //
 // Steering routine to analyze the data of DCTRL Test for all HICs
@@ -59,6 +67,7 @@ void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList
 // Updated:      07 Mar 2019  Mario Sitta  HIC position added
 // Updated:      08 Mar 2019  Mario Sitta  Flag ML/OL staves
 // Updated:      08 Mar 2019  Mario Sitta  Stave Reception Test added
+// Updated:      19 Oct 2026  Append in place, checkpoints, DB access layer
 //
 
   // We need to define here the TTree's for the existing ROOT file
@@ -67,14 +76,12 @@ void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList
   TTree *oldActFastListTree = 0;
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeAllDCTRLTests","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeAllDCTRLTests","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Check whether the ROOT file already exists
   // If yes, ask the user whether to use it or redo a new one
   TString rootFileName;
@@ -82,21 +89,30 @@ void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList
     rootFileName = "IBHIC_DCTRLTest_AllHICs.root";
   else
     rootFileName = "OBHIC_DCTRLTest_AllHICs.root";
+  rootFileName = ShardRootFileName(rootFileName);
 
   redoFromStart = kTRUE;
+  appendToFile = kFALSE;
+  TString oldRootFileName; // Set if the activities are copied from it
   if(CheckRootFileExists(rootFileName)) {
-    if(AskUserRedoScan() == 2) { // User chose to re-use existing tree
+    Int_t userChoice = AskUserRedoScan();
+    if(userChoice == 3) { // User chose to append to existing trees
+      appendToFile = kTRUE;
+      // A resumed run goes on copying from the old file, if it did
+      if(CheckpointOldFile(rootFileName, oldRootFileName))
+        userChoice = 2;
+    }
+    if(userChoice == 2) { // User chose to re-use existing tree
       redoFromStart = kFALSE;
-      TString oldRootFileName;
-      if(!RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
-        printMessage("\nanalyzeAllDCTRLTests","Error: error renaming existing ROOT file");
+      if(!appendToFile && !RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
+        printMessage("\nanalyzeAllDCTRLTests","Error: error renaming existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
 
       TFile *oldDctrltestFile = OpenRootFile(oldRootFileName);
       if(!oldDctrltestFile) {
-        printMessage("\nanalyzeAllDigitalScans","Error: error opening existing ROOT file");
+        printMessage("\nanalyzeAllDigitalScans","Error: error opening existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -118,7 +134,7 @@ void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList
       if(!oldHicQualTree || !oldHicRecpTree || !oldHicHSTree || !oldHicStaveQualTree || !oldHicStaveRecpTree ||
          !oldHicQualResTree || !oldHicRecpResTree || !oldHicHSResTree || !oldHicStaveQualResTree || !oldHicStaveRecpResTree ||
          !oldActFastListTree) {
-        printMessage("\nanalyzeAllDCTRLTests","Error: error reading trees from existing ROOT file");
+        printMessage("\nanalyzeAllDCTRLTests","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -126,43 +142,94 @@ void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList
   } // if(CheckRootFileExists())
 
   // Open the ROOT file
-  TFile *newDctrltestFile = OpenRootFile(rootFileName, kTRUE);
+  TFile *newDctrltestFile = OpenRootFile(rootFileName, !appendToFile, appendToFile);
 
   if(!newDctrltestFile) {
-    printMessage("\nanalyzeAllDCTRLTests","Error: error opening new ROOT file");
+    printMessage("\nanalyzeAllDCTRLTests","Error: error opening new ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   // Create or read the trees
-  TTree *hicQualTree = CreateTreeDctrlTest("hicQualTree","HicQualificationTest");
-  TTree *hicRecpTree = CreateTreeDctrlTest("hicRecpTree","HicReceptionTest");
-  TTree *hicHSTree = CreateTreeDctrlTest("hicHSTree","HicHalfStaveTest");
-  TTree *hicStaveQualTree = CreateTreeDctrlTest("hicStaveQualTree","HicStaveQualTest");
-  TTree *hicStaveRecpTree = CreateTreeDctrlTest("hicStaveRecpTree","HicStaveQualTest");
+  TTree *hicQualTree = SetupDctrlTestTree("hicQualTree","HicQualificationTest",newDctrltestFile);
+  TTree *hicRecpTree = SetupDctrlTestTree("hicRecpTree","HicReceptionTest",newDctrltestFile);
+  TTree *hicHSTree = SetupDctrlTestTree("hicHSTree","HicHalfStaveTest",newDctrltestFile);
+  TTree *hicStaveQualTree = SetupDctrlTestTree("hicStaveQualTree","HicStaveQualTest",newDctrltestFile);
+  TTree *hicStaveRecpTree = SetupDctrlTestTree("hicStaveRecpTree","HicStaveQualTest",newDctrltestFile);
+
+  TTree *hicQualResTree = SetupDctrlTestTreeResult("hicQualResTree","HicQualificationTestResults",newDctrltestFile);
+  TTree *hicRecpResTree = SetupDctrlTestTreeResult("hicRecpResTree","HicReceptionTestResults",newDctrltestFile);
+  TTree *hicHSResTree = SetupDctrlTestTreeResult("hicHSResTree","HicHalfStaveTestResults",newDctrltestFile);
+  TTree *hicStaveQualResTree = SetupDctrlTestTreeResult("hicStaveQualResTree","HicStaveQualTestResults",newDctrltestFile);
+  TTree *hicStaveRecpResTree = SetupDctrlTestTreeResult("hicStaveRecpResTree","HicStaveQualTestResults",newDctrltestFile);
+
+  TTree *actFastListTree = SetupHicActListTreeDT(newDctrltestFile);
+
+  if(!hicQualTree || !hicRecpTree || !hicHSTree || !hicStaveQualTree || !hicStaveRecpTree ||
+     !hicQualResTree || !hicRecpResTree || !hicHSResTree || !hicStaveQualResTree || !hicStaveRecpResTree ||
+     !actFastListTree) { // Only possible when reading from file
+    printMessage("\nanalyzeAllDCTRLTests","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
 
-  TTree *hicQualResTree = CreateTreeDctrlTestResult("hicQualResTree","HicQualificationTestResults");
-  TTree *hicRecpResTree = CreateTreeDctrlTestResult("hicRecpResTree","HicReceptionTestResults");
-  TTree *hicHSResTree = CreateTreeDctrlTestResult("hicHSResTree","HicHalfStaveTestResults");
-  TTree *hicStaveQualResTree = CreateTreeDctrlTestResult("hicStaveQualResTree","HicStaveQualTestResults");
-  TTree *hicStaveRecpResTree = CreateTreeDctrlTestResult("hicStaveRecpResTree","HicStaveQualTestResults");
+  // When appending, index the activities already in the file with their
+  // DB fingerprint, so that the unchanged ones are skipped and the changed
+  // ones are replaced (see AddChangedActivity)
+  std::map<ULong64_t, ULong64_t> actIndex;
+  if(appendToFile)
+    for (Long64_t j = 0; j < actFastListTree->GetEntries(); j++) {
+      actDbFingerprint = 0; // Not in files written before fingerprints
+      actFastListTree->GetEntry(j);
+      actIndex[ActivityKey(hicID, actID)] = actDbFingerprint;
+    }
 
-  TTree *actFastListTree = CreateHicActListTreeDT();
+  // The trees are saved together every CHECKPOINTMIN minutes, so that
+  // a broken run can be resumed after the last HIC saved (--resume)
+  TTree *ckptTrees[] = {hicQualTree, hicRecpTree, hicHSTree, hicStaveQualTree, hicStaveRecpTree,
+                         hicQualResTree, hicRecpResTree, hicHSResTree, hicStaveQualResTree,
+                         hicStaveRecpResTree, actFastListTree};
+  UInt_t firstComp = CheckpointBegin(newDctrltestFile, ckptTrees, sizeof(ckptTrees)/sizeof(TTree*), componentList, oldRootFileName);
 
   // Loop on all components
   int totHICAnal = 0, totActAnal = 0;
+  Double_t perfStart;
   std::vector<ComponentDB::compActivity> tests;
   std::vector<ComponentDB::componentShort>::iterator iComp;
-  for (iComp = componentList.begin(); iComp != componentList.end(); iComp++) {
+  for (iComp = componentList.begin() + firstComp; iComp != componentList.end(); iComp++) {
     ComponentDB::componentShort comp = *iComp;
-    DbGetAllTests (db, comp.ID, tests, STDctrl, true);
+    perfStart = PerfNow();
+    DbLibGetAllTests (db, comp.ID, tests, STDctrl, true);
+    PerfAddSample(PERF_DBLIST, PerfNow() - perfStart);
+
+    // In watch mode a HIC whose activities did not change since the last
+    // poll is not looked at again
+    if(appendToFile && !WatchHicChanged(comp.ID, tests)) {
+      PerfCount(PERF_NHICSKIP);
+      continue;
+    }
 
     // Loop on all activities
     std::vector<ComponentDB::compActivity>::iterator it;
     for(it = tests.begin(); it != tests.end(); it++) {
       ComponentDB::compActivity act = *it;
       ActivityDB::activityLong actLong;
-      activityDB->Read(act.ID, &actLong);
+      perfStart = PerfNow();
+      DbLibReadActivity(db, act.ID, &actLong);
+      PerfAddSample(PERF_DBREAD, PerfNow() - perfStart);
+
+      // Already in file: skipped if unchanged, otherwise the file is
+      // rewritten afterwards to replace its entries
+      std::map<ULong64_t, ULong64_t>::iterator stored;
+      if(appendToFile &&
+         (stored = actIndex.find(ActivityKey(comp.ID, act.ID))) != actIndex.end()) {
+        if(stored->second != 0 && stored->second != ActivityDBFingerprint(actLong)) {
+          AddChangedActivity();
+          PerfCount(PERF_NACTCHANGED);
+        } else
+          PerfCount(PERF_NACTSKIP);
+        continue;
+      }
 
       TTree *testree = 0, *resultree = 0;
       TTree *oldtestree = 0, *oldresultree = 0;
@@ -222,18 +289,31 @@ void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList
 
       if (!testree) continue; // Not a Qualification/Reception/HS/Stave test
 
+      // The fingerprints tell whether the activity changed since it was
+      // stored in the old file (if so it is reprocessed, not copied): the
+      // EOS directory is looked for only if the DB data changed
+      Bool_t inOldFile = kFALSE;
+      ULong64_t oldDbFinger = 0, oldFinger = 0;
       if(!redoFromStart)
-	if(FindActivityInDctrlTestTree(oldActFastListTree, comp.ID, act.ID, actMask)) {
-          printMessage("\nanalyzeAllDCTRLTests", "Activity already in file, copying trees ", actLong.Name.c_str());
-          CopyDctrlTestOldToNew(comp.ID, act.ID, testree, resultree, oldtestree, oldresultree);
-          actFastListTree->Fill();
-          continue;
-        }
-
-      string eosPath = FindEOSPath(actLong, hicType);
+        inOldFile = FindActivityInDctrlTestTree(oldActFastListTree, comp.ID, act.ID, actMask, oldDbFinger, oldFinger);
+
+      string eosPath;
+      Bool_t copyOld = CopyOldActivity(actLong, hicType, inOldFile, oldDbFinger, oldFinger, eosPath);
+      actDbFingerprint = oldDbFinger;
+      actFingerprint = oldFinger;
+
+      if(copyOld) {
+        printMessage("\nanalyzeAllDCTRLTests", "Activity already in file, copying trees ", actLong.Name.c_str());
+        CopyDctrlTestOldToNew(comp.ID, act.ID, testree, resultree, oldtestree, oldresultree);
+        actFastListTree->Fill();
+        PerfCount(PERF_NACTCOPY);
+        continue;
+      }
+
       if(eosPath.length() == 0) { // No valid path found on EOS
         string hicAct = actLong.Name + " " + actLong.Type.Name;
-        printMessage("\nanalyzeAllDCTRLTests", "EOS for this activity does not exists", hicAct.c_str());
+        printMessage("\nanalyzeAllDCTRLTests", "EOS for this activity does not exists", hicAct.c_str(), LOG_WARNING);
+        PerfCount(PERF_NEOSMISS);
         continue;
       }
 
@@ -241,7 +321,7 @@ void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList
       testOffset = testree->GetEntries();
       testResOffset = resultree->GetEntries();
 
-      hicPosition = DbGetPosition(db, comp.ID);
+      hicPosition = DbLibGetPosition(db, comp.ID);
 
       DctrlTestAllChips(testree, actLong, comp.ID, act.ID, eosPath);
       DctrlTestResults(resultree, actLong, comp.ID, act.ID, eosPath, hicType);
@@ -249,41 +329,46 @@ void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList
       Long64_t prevTestOffset = testree->GetEntries();
       Long64_t prevTestResOffset = resultree->GetEntries();
 
-      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset)
-        printMessage("\nanalyzeAllDCTRLTests", "Trees not filled for activity ", actLong.Name.c_str());
-      else
+      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset) {
+        printMessage("\nanalyzeAllDCTRLTests", "Trees not filled for activity ", actLong.Name.c_str(), LOG_WARNING);
+        PerfCount(PERF_NNOTFILLED);
+      } else
 	actFastListTree->Fill();
 
       totActAnal++;
+      PerfCount(PERF_NACTANAL);
       cout << ".";
       fflush(stdout);
 
     }
     totHICAnal++;
+    PerfCount(PERF_NHICS);
     if(totHICAnal%50 == 0) cout << totHICAnal;
     fflush(stdout);
     if(totHICAnal%50 == 0) { // Renew the db credentials
-      db = 0;
+      DbLibDisconnect(db);
       db = initAlpideDB();
-      activityDB = 0;
-      activityDB = new ActivityDB(db);
     }
+    CheckpointCommit(comp.ID);
   }
 
 
   // Close the ROOT file and exit
-  hicQualTree->Write();
-  hicRecpTree->Write();
-  hicHSTree->Write();
-  hicStaveQualTree->Write();
-  hicStaveRecpTree->Write();
-  hicQualResTree->Write();
-  hicRecpResTree->Write();
-  hicHSResTree->Write();
-  hicStaveQualResTree->Write();
-  hicStaveRecpResTree->Write();
-  actFastListTree->Write();
+  CheckpointEnd();
+  perfStart = PerfNow();
+  hicQualTree->Write("", TObject::kOverwrite);
+  hicRecpTree->Write("", TObject::kOverwrite);
+  hicHSTree->Write("", TObject::kOverwrite);
+  hicStaveQualTree->Write("", TObject::kOverwrite);
+  hicStaveRecpTree->Write("", TObject::kOverwrite);
+  hicQualResTree->Write("", TObject::kOverwrite);
+  hicRecpResTree->Write("", TObject::kOverwrite);
+  hicHSResTree->Write("", TObject::kOverwrite);
+  hicStaveQualResTree->Write("", TObject::kOverwrite);
+  hicStaveRecpResTree->Write("", TObject::kOverwrite);
+  actFastListTree->Write("", TObject::kOverwrite);
   CloseRootFile(newDctrltestFile);
+  PerfAddSample(PERF_WRITE, PerfNow() - perfStart, PerfFileSize(rootFileName.Data()));
 
 #ifdef USENCURSES
   mvprintw(LINES-4, 0, "\n ROOT file %s filled with %d activities\n", rootFileName.Data(), totActAnal);
@@ -313,24 +398,23 @@ void analyzeDCTRLTest(const int hicid, const ComponentDB::compActivity act, Alpi
 // Updated:      07 Mar 2019  Mario Sitta  HIC position added
 // Updated:      08 Mar 2019  Mario Sitta  Flag ML/OL staves
 // Updated:      06 Jun 2019  Mario Sitta  Get rid of timestamp from act name
+// Updated:      19 Oct 2026  DB access layer used
 //
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeDCTRLTest","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeDCTRLTest","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Get the proper path to the DCTRL Test result files
   ActivityDB::activityLong actLong;
-  activityDB->Read(act.ID, &actLong);
+  DbLibReadActivity(db, act.ID, &actLong);
 
   string eosPath = FindEOSPath(actLong, hicType);
   if (eosPath == "") {
-    printMessage("\nanalyzeDCTRLTest","Error: no valid EOS path found");
+    printMessage("\nanalyzeDCTRLTest","Error: no valid EOS path found", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -352,7 +436,7 @@ void analyzeDCTRLTest(const int hicid, const ComponentDB::compActivity act, Alpi
 
   TFile *dctrltestFile = OpenRootFile(rootFileName, kTRUE);
   if (!dctrltestFile) {
-    printMessage("\nanalyzeDCTRLTest","Error: error opening the ROOT file");
+    printMessage("\nanalyzeDCTRLTest","Error: error opening the ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -360,14 +444,14 @@ void analyzeDCTRLTest(const int hicid, const ComponentDB::compActivity act, Alpi
   // Create the trees
   TTree *dctrltestTree = CreateTreeDctrlTest("dctrltestTree","DctrlTestTree");
   if (!dctrltestTree) {
-    printMessage("\nanalyzeDCTRLTest","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeDCTRLTest","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   TTree *dctrlresulTree = CreateTreeDctrlTestResult("dctrlresulTree","DctrlTestResulTree");
   if (!dctrlresulTree) {
-    printMessage("\nanalyzeDCTRLTest","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeDCTRLTest","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -391,7 +475,7 @@ void analyzeDCTRLTest(const int hicid, const ComponentDB::compActivity act, Alpi
       staveOLML = 2;
   }
 
-  hicPosition = DbGetPosition(db, hicid);
+  hicPosition = DbLibGetPosition(db, hicid);
   DctrlTestAllChips(dctrltestTree, actLong, hicid, act.ID, eosPath);
   DctrlTestResults(dctrlresulTree, actLong, hicid, act.ID, eosPath, hicType);
 
@@ -409,6 +493,26 @@ void analyzeDCTRLTest(const int hicid, const ComponentDB::compActivity act, Alpi
 
 }
 
+void mergeAllDCTRLTests(const int nshards, const THicType hicType)
+{
+//
+// Steering routine to merge the files produced by the shard jobs
+// of DCTRL Tests into a single file
+//
+// Inputs:
+//          nshards : the number of shards
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  MergeAllShardFiles("DCTRLTest", nshards, hicType, dctrlTestTreeNames, sizeof(dctrlTestTreeNames)/sizeof(dctrlTestTreeNames[0]));
+}
+
 void CopyDctrlTestOldToNew(const UInt_t hicid, const UInt_t actid,
 			   TTree *newscan, TTree *newres,
 			   TTree *oldscan, TTree *oldres)
@@ -481,6 +585,7 @@ TTree* CreateHicActListTreeDT(void)
 //
 // Created:      27 Nov 2018  Mario Sitta
 // Updated:      25 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newTree = 0;
@@ -492,6 +597,8 @@ TTree* CreateHicActListTreeDT(void)
     newTree->Branch("actMask", &actMask,"actMask/s");
     newTree->Branch("actOffs", &testOffset, "testOffset/L");
     newTree->Branch("actResOff", &testResOffset, "testResOffset/L");
+    newTree->Branch("actFinger", &actFingerprint, "actFingerprint/l");
+    newTree->Branch("actDbFinger", &actDbFingerprint, "actDbFingerprint/l");
   }
 
   return newTree;
@@ -624,7 +731,7 @@ TTree* CreateTreeDctrlTestResult(TString treeName, TString treeTitle)
   return newTree;
 }
 
-void DctrlTestAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath)
+void DctrlTestAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath)
 {
 //
 // Loops on chips and fills the tree for the given activity
@@ -641,8 +748,14 @@ void DctrlTestAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int
 // Return:
 //
 // Created:      07 Feb 2019  Mario Sitta
+// Updated:      19 Oct 2026  Arguments passed by reference, string arena
 //
 
+  // A new activity: the strings of the previous one are released
+  // and the messages are tagged with it
+  ArenaReset();
+  LogSetActivity(hicid, actid);
+
   hicID = hicid;
   actID = actid;
   locID = actlong.Location.ID;
@@ -656,7 +769,7 @@ void DctrlTestAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int
 
 }
 
-void DctrlTestResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType)
+void DctrlTestResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType)
 {
 //
 // Fills the tree for the given activity results
@@ -675,6 +788,7 @@ void DctrlTestResults(TTree *ftree, ActivityDB::activityLong actlong, const int
 //
 // Created:      08 Jan 2019  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Arguments passed by reference, string arena
 //
 
   hicID = hicid;
@@ -691,7 +805,7 @@ void DctrlTestResults(TTree *ftree, ActivityDB::activityLong actlong, const int
 
 }
 
-Bool_t FillDctrlTestTree(TTree *tree, string path, string file)
+Bool_t FillDctrlTestTree(TTree *tree, const string &path, const string &file)
 {
 //
 // Opens the DCTRL Test file and fills the tree
@@ -707,19 +821,24 @@ Bool_t FillDctrlTestTree(TTree *tree, string path, string file)
 //          true if the input file was read without error, otherwise false
 //
 // Created:      07 Feb 2019  Mario Sitta
+// Updated:      19 Oct 2026  Timing added, arguments passed by reference
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfEntries = tree->GetEntries();
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
+  const char *fullName;
   int    ichip, drivset;
   float  pk2pkpos, pk2pkneg, amplpos, amplneg;
   double risetpos, risetneg, falltpos, falltneg;
 
-  fullName = path + "/" + file;
+  fullName = ArenaJoinPath(path, file);
 
-  infile = fopen(fullName.c_str(),"r");
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillDctrlTestTree","Warning: cannot open input file",file.c_str());
+    printMessage("FillDctrlTestTree","Warning: cannot open input file",file.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
@@ -738,12 +857,16 @@ Bool_t FillDctrlTestTree(TTree *tree, string path, string file)
     fallTimeN = falltneg;
     tree->Fill();
   }
+  perfBytes += ftell(infile);
   fclose(infile);
 
+  PerfAddSample(PERF_FILLDATA, PerfNow() - perfStart, perfBytes,
+                tree->GetEntries() - perfEntries);
+
   return kTRUE;
 }
 
-Bool_t FillDctrlTestTreeResult(TTree *tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType)
+Bool_t FillDctrlTestTreeResult(TTree *tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType)
 {
 //
 // Opens the DctrlScanResult file and fills the tree
@@ -764,22 +887,28 @@ Bool_t FillDctrlTestTreeResult(TTree *tree, string path, string file, ActivityDB
 //
 // Created:      08 Feb 2019  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Timing, chip numbering tables, parameter index
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfEntries = tree->GetEntries();
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
+  const char *fullName;
   double dvalue;
   float value, dummy;
   unsigned int reg, regval;
-  int ichip;
+  int ichip = -1;
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
   char *line = NULL;
   size_t len = 0;
 
-  fullName = path + "/" + file;
+  fullName = ArenaJoinPath(path, file);
 
-  infile = fopen(fullName.c_str(),"r");
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillPowTestTreeResult","Warning: cannot open input file",file.c_str());
+    printMessage("FillPowTestTreeResult","Warning: cannot open input file",file.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
@@ -927,50 +1056,38 @@ Bool_t FillDctrlTestTreeResult(TTree *tree, string path, string file, ActivityDB
     // Per-chip data
     if (strstr(line,"Analogue voltage (") && strstr(line,"start")) {
       sscanf(line, "  Analogue voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-	chipAnalVoltStart[ichip-1] = value;
-      else
-	chipAnalVoltStart[ichip] = value; 
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipAnalVoltStart[ichip] = value;
     }
 
     if (strstr(line,"Analogue voltage (") && strstr(line,"end")) {
       sscanf(line, "  Analogue voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-	chipAnalVoltEnd[ichip-1] = value;
-      else
-	chipAnalVoltEnd[ichip] = value;
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipAnalVoltEnd[ichip] = value;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"start")) {
       sscanf(line, "  Digital voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltStart[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltStart[ichip] = value;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"end")) {
       sscanf(line, "  Digital voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltEnd[ichip] = value;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"start")) {
       sscanf(line, "  Temperature (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-	chipTempStart[ichip-1] = value;
-      else
-	chipTempStart[ichip] = value;
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipTempStart[ichip] = value;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"end")) {
       sscanf(line, "  Temperature (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-	chipTempEnd[ichip-1] = value;
-      else
-	chipTempEnd[ichip] = value;
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipTempEnd[ichip] = value;
     }
 
     // Specific DCTRL Test data and single chip results
@@ -980,7 +1097,7 @@ Bool_t FillDctrlTestTreeResult(TTree *tree, string path, string file, ActivityDB
 
     if (strstr(line, "Result chip")) {
       sscanf(line, "Result chip %d:", &ichip);
-      if(hicType == HIC_OB && ichip > 7) ichip--;
+      ichip = CHIPNUM(chipMap, ichip);
       continue;
     }
 
@@ -1020,85 +1137,85 @@ Bool_t FillDctrlTestTreeResult(TTree *tree, string path, string file, ActivityDB
 
     if (strstr(line, "Slope p")) {
       sscanf(line, "Slope p: %f", &value);
-      slopePos[ichip] = value;
+      if (ichip >= 0) slopePos[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Intercept p")) {
       sscanf(line, "Intercept p: %f", &value);
-      intercPos[ichip] = value;
+      if (ichip >= 0) intercPos[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Chi sq p")) {
       sscanf(line, "Chi sq p: %f", &value);
-      chisqPos[ichip] = value;
+      if (ichip >= 0) chisqPos[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Correlation coeff p")) {
       sscanf(line, "Correlation coeff p: %f", &value);
-      correlPos[ichip] = value;
+      if (ichip >= 0) correlPos[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Max. amplitude p")) {
       sscanf(line, "Max. amplitude p: %f", &value);
-      maxAmpPos[ichip] = value;
+      if (ichip >= 0) maxAmpPos[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Max. rise time p")) {
       sscanf(line, "Max. rise time p: %lf", &dvalue);
-      maxRisePos[ichip] = dvalue;
+      if (ichip >= 0) maxRisePos[ichip] = dvalue;
       continue;
     }
 
     if (strstr(line, "Max. fall time p")) {
       sscanf(line, "Max. fall time p: %lf", &dvalue);
-      maxFallPos[ichip] = dvalue;
+      if (ichip >= 0) maxFallPos[ichip] = dvalue;
       continue;
     }
 
     if (strstr(line, "Slope n")) {
       sscanf(line, "Slope n: %f", &value);
-      slopeNeg[ichip] = value;
+      if (ichip >= 0) slopeNeg[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Intercept n")) {
       sscanf(line, "Intercept n: %f", &value);
-      intercNeg[ichip] = value;
+      if (ichip >= 0) intercNeg[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Chi sq n")) {
       sscanf(line, "Chi sq n: %f", &value);
-      chisqNeg[ichip] = value;
+      if (ichip >= 0) chisqNeg[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Correlation coeff n")) {
       sscanf(line, "Correlation coeff n: %f", &value);
-      correlNeg[ichip] = value;
+      if (ichip >= 0) correlNeg[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Max. amplitude n")) {
       sscanf(line, "Max. amplitude n: %f", &value);
-      maxAmpNeg[ichip] = value;
+      if (ichip >= 0) maxAmpNeg[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Max. rise time n")) {
       sscanf(line, "Max. rise time n: %lf", &dvalue);
-      maxRiseNeg[ichip] = dvalue;
+      if (ichip >= 0) maxRiseNeg[ichip] = dvalue;
       continue;
     }
 
     if (strstr(line, "Max. fall time n")) {
       sscanf(line, "Max. fall time n: %lf", &dvalue);
-      maxFallNeg[ichip] = dvalue;
+      if (ichip >= 0) maxFallNeg[ichip] = dvalue;
       continue;
     }
 
@@ -1112,48 +1229,38 @@ Bool_t FillDctrlTestTreeResult(TTree *tree, string path, string file, ActivityDB
     if(reg == 0x700) {
       ichip &= 0x0f; // ichip is the lower 4 bits
       if(regStartFound) {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700Start[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700Start[ichip] = regval;
       } else {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700End[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700End[ichip] = regval;
       }
     }
 
   } // while(getline(&line, &len, infile))
 
+  perfBytes += ftell(infile);
   fclose(infile);
 
   // Now get data from DB
-  vector<ActivityDB::actParameter>  parameters = actlong.Parameters;
-
-  std::vector<ActivityDB::actParameter>::iterator loop;
-  for(loop = parameters.begin(); loop != parameters.end(); loop++) {
-    ActivityDB::actParameter actpar = *loop;
-
-    if(actpar.Type.Parameter.Name.compare("Classification Version") == 0) {
-      classificVers = actpar.Value;
-      continue;
-    }
+  const TActParameters *actPars = GetActParameters(actlong);
 
-    if(actpar.Type.Parameter.Name.compare("Classification Dctrl Measurement") == 0) {
-      classificDctrlTest = actpar.Value;
-      continue;
-    }
+  if(actPars->found[ACTPAR_VERSION])
+    classificVers = actPars->value[ACTPAR_VERSION];
 
-  }
+  if(actPars->found[ACTPAR_DCTRL])
+    classificDctrlTest = actPars->value[ACTPAR_DCTRL];
 
   // Fill the tree, close the file and return
   tree->Fill();
 
+  PerfAddSample(PERF_FILLRES, PerfNow() - perfStart, perfBytes,
+                tree->GetEntries() - perfEntries);
+
   return kTRUE;
 }
 
-Bool_t FindActivityInDctrlTestTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask)
+Bool_t FindActivityInDctrlTestTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger)
 {
 //
 // Finds the activity in the tree
@@ -1165,11 +1272,14 @@ Bool_t FindActivityInDctrlTestTree(TTree* listree, const UInt_t hicid, const UIn
 //          mask  : the activity mask
 //
 // Outputs:
+//          dbfinger : the DB data fingerprint stored with the activity
+//          finger   : the fingerprint stored with the activity
 //
 // Return:
 //          true if activity found
 //
 // Created:      09 Feb 2019  Mario Sitta
+// Updated:      19 Oct 2026  Stored fingerprints returned
 //
 
   Bool_t found = kFALSE;
@@ -1180,11 +1290,19 @@ Bool_t FindActivityInDctrlTestTree(TTree* listree, const UInt_t hicid, const UIn
   Int_t currHicId = hicID;
   Int_t currActId = actID;
   UShort_t currMask = actMask;
+  ULong64_t currDbFinger = actDbFingerprint;
+  ULong64_t currFinger = actFingerprint;
+
+  // Files written before fingerprints were introduced have no such branches
+  actDbFingerprint = 0;
+  actFingerprint = 0;
   
   Int_t nEntries = listree->GetEntries();
   for (Int_t j = 0; j < nEntries; j++) {
     listree->GetEntry(j);
     if(hicID == hicid && actID == actid && actMask == mask) {
+      dbfinger = actDbFingerprint;
+      finger = actFingerprint;
       found = kTRUE;
       break;
     }
@@ -1194,6 +1312,8 @@ Bool_t FindActivityInDctrlTestTree(TTree* listree, const UInt_t hicid, const UIn
   hicID = currHicId;
   actID = currActId;
   actMask = currMask;
+  actDbFingerprint = currDbFinger;
+  actFingerprint = currFinger;
 
   return found;
 }
@@ -1215,6 +1335,7 @@ TTree* ReadHicActListTreeDT(TFile *rootfile)
 //
 // Created:      28 Nov 2018  Mario Sitta
 // Updated:      25 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newtree = 0;
@@ -1226,6 +1347,10 @@ TTree* ReadHicActListTreeDT(TFile *rootfile)
     newtree->SetBranchAddress("actMask", &actMask);
     newtree->SetBranchAddress("actOffs", &testOffset);
     newtree->SetBranchAddress("actResOff", &testResOffset);
+    if(newtree->GetBranch("actFinger")) // Missing in older files
+      newtree->SetBranchAddress("actFinger", &actFingerprint);
+    if(newtree->GetBranch("actDbFinger")) // Ditto
+      newtree->SetBranchAddress("actDbFinger", &actDbFingerprint);
   }
 
   return newtree;
@@ -1450,11 +1575,12 @@ TTree* SetupHicActListTreeDT(TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateHicActListTreeDT();
   else
     newtree = ReadHicActListTreeDT(rootfile);
@@ -1478,11 +1604,12 @@ TTree* SetupDctrlTestTree(TString treename, TString treetitle, TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreeDctrlTest(treename,treetitle);
   else
     newtree = ReadDctrlTestTree(treename, rootfile);
@@ -1506,11 +1633,12 @@ TTree* SetupDctrlTestTreeResult(TString treename, TString treetitle, TFile *root
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreeDctrlTestResult(treename,treetitle);
   else
     newtree = ReadDctrlTestTreeResult(treename, rootfile);
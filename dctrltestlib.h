@@ -22,6 +22,8 @@
 #include "AlpideDBEndPoints.h"
 #include "THIC.h"
 #include "TScanFactory.h"
+#include "dblib.h"
+#include "perflib.h"
 
 #include <iostream>
 #include <stdio.h>
@@ -29,17 +31,18 @@
 
 //Bool_t redoFromStart;
 
-void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType);
+void analyzeAllDCTRLTests(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType);
 void analyzeDCTRLTest(const int hicid, const ComponentDB::compActivity act, AlpideDB *db, const THicType hicType);
+void mergeAllDCTRLTests(const int nshards, const THicType hicType);
 void CopyDctrlTestOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newscan, TTree *newres, TTree *oldscan, TTree *oldres);
 TTree* CreateHicActListTreeDT(void);
 TTree* CreateTreeDctrlTest(TString treeName, TString treeTitle);
 TTree* CreateTreeDctrlTestResult(TString treeName, TString treeTitle);
-void DctrlTestAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath);
-void DctrlTestResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType);
-Bool_t FillDctrlTestTree(TTree* tree, string path, string file);
-Bool_t FillDctrlTestTreeResult(TTree* tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType);
-Bool_t FindActivityInDctrlTestTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask);
+void DctrlTestAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath);
+void DctrlTestResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType);
+Bool_t FillDctrlTestTree(TTree* tree, const string &path, const string &file);
+Bool_t FillDctrlTestTreeResult(TTree* tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType);
+Bool_t FindActivityInDctrlTestTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger);
 TTree* ReadHicActListTreeDT(TFile *rootfile);
 TTree* ReadDctrlTestTree(TString treename, TFile *rootfile);
 TTree* ReadDctrlTestTreeResult(TString treename, TFile *rootfile);
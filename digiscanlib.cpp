@@ -15,8 +15,29 @@ Int_t    deadIncrease;
 Float_t  classificDigiScan;
 Float_t  numWorkChips;
 
-
-void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType)
+// Local arrays of the packed pixel trees (see SetPackedPixelTrees)
+static Int_t    pixNum;
+static std::vector<UShort_t> colArr;
+static std::vector<UShort_t> rowArr;
+static std::vector<UShort_t> hitsArr;
+
+// Local variables of the pixel map tree (see CreateTreeDigitalScanMap)
+static TPixMap  digMap[DIGMAP_NCAT];
+static Int_t    digMapLen[DIGMAP_NCAT];
+static UChar_t  digMapBuf[DIGMAP_NCAT][PIXMAPMAXBYTES];
+static const char* digMapName[DIGMAP_NCAT] = {"dead", "ineff", "noisy"};
+
+// The trees of each activity type (see MergeShardRootFiles)
+static const TActTreeNames digScanTreeNames[] = {
+  {ACTMASK_QUALIF, "hicQualTree", 0, "hicQualResTree"},
+  {ACTMASK_RECEPT, "hicRecpTree", 0, "hicRecpResTree"},
+  {ACTMASK_HALFST, "hicHSTree", 0, "hicHSResTree"},
+  {ACTMASK_STAVET, "hicStaveQualTree", 0, "hicStaveQualResTree"},
+  {ACTMASK_STVREC, "hicStaveRecpTree", 0, "hicStaveRecpResTree"}
+};
+
+
+void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType)
 {
 //
 // Steering routine to analyze the data of Digital Scan for all HICs
@@ -39,22 +60,21 @@ void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentLi
 //                                         Flag ML/OL staves
 //                                         Stave Reception Test added
 // Updated:      19 Sep 2019  Mario Sitta  HIC name and classification added
+// Updated:      19 Oct 2026  Append in place, checkpoints, pixel maps
 //
 
   // We need to define here the TTree's for the existing ROOT file
   TTree *oldHicQualTree = 0, *oldHicRecpTree = 0, *oldHicHSTree = 0, *oldHicStaveQualTree = 0, *oldHicStaveRecpTree = 0;;
   TTree *oldHicQualResTree = 0, *oldHicRecpResTree = 0, *oldHicHSResTree = 0, *oldHicStaveQualResTree = 0, *oldHicStaveRecpResTree = 0;
-  TTree *oldActFastListTree = 0;
+  TTree *oldActFastListTree = 0, *oldPixMapTree = 0;
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeAllDigitalScans","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeAllDigitalScans","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Check whether the ROOT file already exists
   // If yes, ask the user whether to use it or redo a new one
   TString rootFileName;
@@ -62,21 +82,30 @@ void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentLi
     rootFileName = "IBHIC_DigitalScan_AllHICs.root";
   else
     rootFileName = "OBHIC_DigitalScan_AllHICs.root";
+  rootFileName = ShardRootFileName(rootFileName);
 
   redoFromStart = kTRUE;
+  appendToFile = kFALSE;
+  TString oldRootFileName; // Set if the activities are copied from it
   if(CheckRootFileExists(rootFileName)) {
-    if(AskUserRedoScan() == 2) { // User chose to re-use existing tree
+    Int_t userChoice = AskUserRedoScan();
+    if(userChoice == 3) { // User chose to append to existing trees
+      appendToFile = kTRUE;
+      // A resumed run goes on copying from the old file, if it did
+      if(CheckpointOldFile(rootFileName, oldRootFileName))
+        userChoice = 2;
+    }
+    if(userChoice == 2) { // User chose to re-use existing tree
       redoFromStart = kFALSE;
-      TString oldRootFileName;
-      if(!RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
-        printMessage("\nanalyzeAllDigitalScans","Error: error renaming existing ROOT file");
+      if(!appendToFile && !RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
+        printMessage("\nanalyzeAllDigitalScans","Error: error renaming existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
 
       TFile *oldDigiscanFile = OpenRootFile(oldRootFileName);
       if(!oldDigiscanFile) {
-        printMessage("\nanalyzeAllDigitalScans","Error: error opening existing ROOT file");
+        printMessage("\nanalyzeAllDigitalScans","Error: error opening existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -95,10 +124,12 @@ void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentLi
 
       oldActFastListTree = ReadHicActListTreeDS(oldDigiscanFile);
 
+      oldPixMapTree = ReadDigScanTreeMap("pixMapTree",oldDigiscanFile); // Can be missing
+
       if(!oldHicQualTree || !oldHicRecpTree || !oldHicHSTree || !oldHicStaveQualTree || !oldHicStaveRecpTree ||
          !oldHicQualResTree || !oldHicRecpResTree || !oldHicHSResTree || !oldHicStaveQualResTree || !oldHicStaveRecpResTree ||
          !oldActFastListTree) {
-        printMessage("\nanalyzeAllDigitalScans","Error: error reading trees from existing ROOT file");
+        printMessage("\nanalyzeAllDigitalScans","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -106,43 +137,96 @@ void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentLi
   } // if(CheckRootFileExists())
 
   // Open the new ROOT file
-  TFile *newDigiscanFile = OpenRootFile(rootFileName, kTRUE);
+  TFile *newDigiscanFile = OpenRootFile(rootFileName, !appendToFile, appendToFile);
 
   if(!newDigiscanFile) {
-    printMessage("\nanalyzeAllDigitalScans","Error: error opening new ROOT file");
+    printMessage("\nanalyzeAllDigitalScans","Error: error opening new ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   // Create the new trees
-  TTree *hicQualTree = CreateTreeDigitalScan("hicQualTree","HicQualificationTest");
-  TTree *hicRecpTree = CreateTreeDigitalScan("hicRecpTree","HicReceptionTest");
-  TTree *hicHSTree = CreateTreeDigitalScan("hicHSTree","HicHalfStaveTest");
-  TTree *hicStaveQualTree = CreateTreeDigitalScan("hicStaveQualTree","HicStaveQualTest");
-  TTree *hicStaveRecpTree = CreateTreeDigitalScan("hicStaveRecpTree","HicStaveRecpTest");
+  TTree *hicQualTree = SetupDigScanTree("hicQualTree","HicQualificationTest",newDigiscanFile);
+  TTree *hicRecpTree = SetupDigScanTree("hicRecpTree","HicReceptionTest",newDigiscanFile);
+  TTree *hicHSTree = SetupDigScanTree("hicHSTree","HicHalfStaveTest",newDigiscanFile);
+  TTree *hicStaveQualTree = SetupDigScanTree("hicStaveQualTree","HicStaveQualTest",newDigiscanFile);
+  TTree *hicStaveRecpTree = SetupDigScanTree("hicStaveRecpTree","HicStaveRecpTest",newDigiscanFile);
+
+  TTree *hicQualResTree = SetupDigScanTreeResult("hicQualResTree","HicQualificationTestResults",newDigiscanFile);
+  TTree *hicRecpResTree = SetupDigScanTreeResult("hicRecpResTree","HicReceptionTestResults",newDigiscanFile);
+  TTree *hicHSResTree = SetupDigScanTreeResult("hicHSResTree","HicHalfStaveTestResults",newDigiscanFile);
+  TTree *hicStaveQualResTree = SetupDigScanTreeResult("hicStaveQualResTree","HicStaveQualTestResults",newDigiscanFile);
+  TTree *hicStaveRecpResTree = SetupDigScanTreeResult("hicStaveRecpResTree","HicStaveRecpTestResults",newDigiscanFile);
+
+  TTree *actFastListTree = SetupHicActListTreeDS(newDigiscanFile);
+
+  TTree *pixMapTree = SetupDigScanTreeMap("pixMapTree","HicPixelMaps",newDigiscanFile);
+
+  if(!hicQualTree || !hicRecpTree || !hicHSTree || !hicStaveQualTree || !hicStaveRecpTree ||
+     !hicQualResTree || !hicRecpResTree || !hicHSResTree || !hicStaveQualResTree || !hicStaveRecpResTree ||
+     !actFastListTree || !pixMapTree) { // Only possible when reading from file
+    printMessage("\nanalyzeAllDigitalScans","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
 
-  TTree *hicQualResTree = CreateTreeDigitalScanResult("hicQualResTree","HicQualificationTestResults");
-  TTree *hicRecpResTree = CreateTreeDigitalScanResult("hicRecpResTree","HicReceptionTestResults");
-  TTree *hicHSResTree = CreateTreeDigitalScanResult("hicHSResTree","HicHalfStaveTestResults");
-  TTree *hicStaveQualResTree = CreateTreeDigitalScanResult("hicStaveQualResTree","HicStaveQualTestResults");
-  TTree *hicStaveRecpResTree = CreateTreeDigitalScanResult("hicStaveRecpResTree","HicStaveRecpTestResults");
+  // When appending, index the activities already in the file with their
+  // DB fingerprint, so that the unchanged ones are skipped and the changed
+  // ones are replaced (see AddChangedActivity)
+  std::map<ULong64_t, ULong64_t> actIndex;
+  if(appendToFile)
+    for (Long64_t j = 0; j < actFastListTree->GetEntries(); j++) {
+      actDbFingerprint = 0; // Not in files written before fingerprints
+      actFastListTree->GetEntry(j);
+      actIndex[ActivityKey(hicID, actID)] = actDbFingerprint;
+    }
 
-  TTree *actFastListTree = CreateHicActListTreeDS();
+  // The trees are saved together every CHECKPOINTMIN minutes, so that
+  // a broken run can be resumed after the last HIC saved (--resume)
+  TTree *ckptTrees[] = {hicQualTree, hicRecpTree, hicHSTree, hicStaveQualTree, hicStaveRecpTree,
+                         hicQualResTree, hicRecpResTree, hicHSResTree, hicStaveQualResTree,
+                         hicStaveRecpResTree, actFastListTree, pixMapTree};
+  UInt_t firstComp = CheckpointBegin(newDigiscanFile, ckptTrees, sizeof(ckptTrees)/sizeof(TTree*), componentList, oldRootFileName);
 
   // Loop on all components
   int totHICAnal = 0, totActAnal = 0;
+  Double_t perfStart;
   std::vector<ComponentDB::compActivity> tests;
   std::vector<ComponentDB::componentShort>::iterator iComp;
-  for (iComp = componentList.begin(); iComp != componentList.end(); iComp++) {
+  for (iComp = componentList.begin() + firstComp; iComp != componentList.end(); iComp++) {
     ComponentDB::componentShort comp = *iComp;
-    DbGetAllTests (db, comp.ID, tests, STDigital, true);
+    perfStart = PerfNow();
+    DbLibGetAllTests (db, comp.ID, tests, STDigital, true);
+    PerfAddSample(PERF_DBLIST, PerfNow() - perfStart);
+
+    // In watch mode a HIC whose activities did not change since the last
+    // poll is not looked at again
+    if(appendToFile && !WatchHicChanged(comp.ID, tests)) {
+      PerfCount(PERF_NHICSKIP);
+      continue;
+    }
 
     // Loop on all activities
     std::vector<ComponentDB::compActivity>::iterator it;
     for(it = tests.begin(); it != tests.end(); it++) {
       ComponentDB::compActivity act = *it;
       ActivityDB::activityLong actLong;
-      activityDB->Read(act.ID, &actLong);
+      perfStart = PerfNow();
+      DbLibReadActivity(db, act.ID, &actLong);
+      PerfAddSample(PERF_DBREAD, PerfNow() - perfStart);
+
+      // Already in file: skipped if unchanged, otherwise the file is
+      // rewritten afterwards to replace its entries
+      std::map<ULong64_t, ULong64_t>::iterator stored;
+      if(appendToFile &&
+         (stored = actIndex.find(ActivityKey(comp.ID, act.ID))) != actIndex.end()) {
+        if(stored->second != 0 && stored->second != ActivityDBFingerprint(actLong)) {
+          AddChangedActivity();
+          PerfCount(PERF_NACTCHANGED);
+        } else
+          PerfCount(PERF_NACTSKIP);
+        continue;
+      }
 
       TTree *testree = 0, *resultree = 0;
       TTree *oldtestree = 0, *oldresultree = 0;
@@ -202,18 +286,32 @@ void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentLi
 
       if (!testree) continue; // Not a Qualification/Reception/HS/Stave test
 
+      // The fingerprints tell whether the activity changed since it was
+      // stored in the old file (if so it is reprocessed, not copied): the
+      // EOS directory is looked for only if the DB data changed
+      Bool_t inOldFile = kFALSE;
+      ULong64_t oldDbFinger = 0, oldFinger = 0;
       if(!redoFromStart)
-        if(FindActivityInDigScanTree(oldActFastListTree, comp.ID, act.ID, actMask)) {
-          printMessage("\nanalyzeAllDigitalScans", "Activity already in file, copying trees ", actLong.Name.c_str());
-          CopyDigScanOldToNew(comp.ID, act.ID, testree, resultree, oldtestree, oldresultree);
-          actFastListTree->Fill();
-          continue;
-        }
+        inOldFile = FindActivityInDigScanTree(oldActFastListTree, comp.ID, act.ID, actMask, oldDbFinger, oldFinger);
+
+      string eosPath;
+      Bool_t copyOld = CopyOldActivity(actLong, hicType, inOldFile, oldDbFinger, oldFinger, eosPath);
+      actDbFingerprint = oldDbFinger;
+      actFingerprint = oldFinger;
+
+      if(copyOld) {
+        printMessage("\nanalyzeAllDigitalScans", "Activity already in file, copying trees ", actLong.Name.c_str());
+        CopyDigScanOldToNew(comp.ID, act.ID, testree, resultree, oldtestree, oldresultree);
+        CopyDigScanMapOldToNew(comp.ID, act.ID, pixMapTree, oldPixMapTree);
+        actFastListTree->Fill();
+        PerfCount(PERF_NACTCOPY);
+        continue;
+      }
 
-      string eosPath = FindEOSPath(actLong, hicType);
       if(eosPath.length() == 0) { // No valid path found on EOS
         string hicAct = actLong.Name + " " + actLong.Type.Name;
-        printMessage("\nanalyzeAllDigitalScans", "EOS for this activity does not exists", hicAct.c_str());
+        printMessage("\nanalyzeAllDigitalScans", "EOS for this activity does not exists", hicAct.c_str(), LOG_WARNING);
+        PerfCount(PERF_NEOSMISS);
         continue;
       }
 
@@ -222,50 +320,56 @@ void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentLi
       testResOffset = resultree->GetEntries();
 
       strncpy(hicName, comp.ComponentID.c_str(), HICNAMELEN-1);
-      hicPosition = DbGetPosition(db, comp.ID);
+      hicPosition = DbLibGetPosition(db, comp.ID);
       hicClass = ConvertTestResult(act.Result.Name);
 
-      DigitalScanAllChips(testree, actLong, comp.ID, act.ID, eosPath, hicType);
+      DigitalScanAllChips(testree, actLong, comp.ID, act.ID, eosPath, hicType, pixMapTree);
       DigitalScanResults(resultree, actLong, comp.ID, act.ID, eosPath, hicType);
 
       Long64_t prevTestOffset = testree->GetEntries();
       Long64_t prevTestResOffset = resultree->GetEntries();
 
-      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset)
-        printMessage("\nanalyzeAllDigitalScans", "Trees not filled for activity ", actLong.Name.c_str());
-      else
+      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset) {
+        printMessage("\nanalyzeAllDigitalScans", "Trees not filled for activity ", actLong.Name.c_str(), LOG_WARNING);
+        PerfCount(PERF_NNOTFILLED);
+      } else
         actFastListTree->Fill();
 
       totActAnal++;
+      PerfCount(PERF_NACTANAL);
       cout << ".";
       fflush(stdout);
 
     }
     totHICAnal++;
+    PerfCount(PERF_NHICS);
     if(totHICAnal%50 == 0) cout << totHICAnal;
     fflush(stdout);
     if(totHICAnal%50 == 0) { // Renew the db credentials
-      db = 0;
+      DbLibDisconnect(db);
       db = initAlpideDB();
-      activityDB = 0;
-      activityDB = new ActivityDB(db);
     }
+    CheckpointCommit(comp.ID);
   }
 
 
   // Close the ROOT file and exit
-  hicQualTree->Write();
-  hicRecpTree->Write();
-  hicHSTree->Write();
-  hicStaveQualTree->Write();
-  hicStaveRecpTree->Write();
-  hicQualResTree->Write();
-  hicRecpResTree->Write();
-  hicHSResTree->Write();
-  hicStaveQualResTree->Write();
-  hicStaveRecpResTree->Write();
-  actFastListTree->Write();
+  CheckpointEnd();
+  perfStart = PerfNow();
+  hicQualTree->Write("", TObject::kOverwrite);
+  hicRecpTree->Write("", TObject::kOverwrite);
+  hicHSTree->Write("", TObject::kOverwrite);
+  hicStaveQualTree->Write("", TObject::kOverwrite);
+  hicStaveRecpTree->Write("", TObject::kOverwrite);
+  hicQualResTree->Write("", TObject::kOverwrite);
+  hicRecpResTree->Write("", TObject::kOverwrite);
+  hicHSResTree->Write("", TObject::kOverwrite);
+  hicStaveQualResTree->Write("", TObject::kOverwrite);
+  hicStaveRecpResTree->Write("", TObject::kOverwrite);
+  actFastListTree->Write("", TObject::kOverwrite);
+  pixMapTree->Write("", TObject::kOverwrite);
   CloseRootFile(newDigiscanFile);
+  PerfAddSample(PERF_WRITE, PerfNow() - perfStart, PerfFileSize(rootFileName.Data()));
 
 #ifdef USENCURSES
   mvprintw(LINES-4, 0, "\n ROOT file %s filled with %d activities\n", rootFileName.Data(), totActAnal);
@@ -296,24 +400,23 @@ void analyzeDigitalScan(const int hicid, const ComponentDB::compActivity act, Al
 // Updated:      08 Mar 2019  Mario Sitta  HIC position & Flag ML/OL staves
 // Updated:      06 Jun 2019  Mario Sitta  Get rid of timestamp from act name
 // Updated:      19 Sep 2019  Mario Sitta  HIC name and classification added
+// Updated:      19 Oct 2026  DB access layer used, pixel maps added
 //
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeDigitalScan","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeDigitalScan","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Get the proper path to the Digital Scan result files
   ActivityDB::activityLong actLong;
-  activityDB->Read(act.ID, &actLong);
+  DbLibReadActivity(db, act.ID, &actLong);
 
   string eosPath = FindEOSPath(actLong, hicType);
   if (eosPath == "") {
-    printMessage("\nanalyzeDigitalScan","Error: no valid EOS path found");
+    printMessage("\nanalyzeDigitalScan","Error: no valid EOS path found", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -335,7 +438,7 @@ void analyzeDigitalScan(const int hicid, const ComponentDB::compActivity act, Al
 
   TFile *digiscanFile = OpenRootFile(rootFileName, kTRUE);
   if (!digiscanFile) {
-    printMessage("\nanalyzeDigitalScan","Error: error opening the ROOT file");
+    printMessage("\nanalyzeDigitalScan","Error: error opening the ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -343,14 +446,21 @@ void analyzeDigitalScan(const int hicid, const ComponentDB::compActivity act, Al
   // Create the trees
   TTree *digiscanTree = CreateTreeDigitalScan("digiscanTree","DigiScanTree");
   if (!digiscanTree) {
-    printMessage("\nanalyzeDigitalScan","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeDigitalScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   TTree *digiresulTree = CreateTreeDigitalScanResult("digiresulTree","DigiScanResulTree");
   if (!digiresulTree) {
-    printMessage("\nanalyzeDigitalScan","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeDigitalScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
+
+  TTree *digimapTree = CreateTreeDigitalScanMap("digimapTree","DigiScanMapTree");
+  if (!digimapTree) {
+    printMessage("\nanalyzeDigitalScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -358,10 +468,10 @@ void analyzeDigitalScan(const int hicid, const ComponentDB::compActivity act, Al
   // Get the name of the HIC
   int componentTypeId;
   if (hicType == HIC_IB)
-    componentTypeId = DbGetComponentTypeId (db, "Inner Barrel HIC Module");
+    componentTypeId = DbLibGetComponentTypeId (db, "Inner Barrel HIC Module");
   else
-    componentTypeId = DbGetComponentTypeId (db, "Outer Barrel HIC Module");
-  string hicNameStr = DbGetComponentName(db, componentTypeId, hicid);
+    componentTypeId = DbLibGetComponentTypeId (db, "Outer Barrel HIC Module");
+  string hicNameStr = DbLibGetComponentName(db, componentTypeId, hicid);
   strncpy(hicName, hicNameStr.c_str(), HICNAMELEN-1);
 
   // Fill the trees for all chips
@@ -383,14 +493,16 @@ void analyzeDigitalScan(const int hicid, const ComponentDB::compActivity act, Al
       staveOLML = 2;
   }
 
-  hicPosition = DbGetPosition(db, hicid);
+  hicPosition = DbLibGetPosition(db, hicid);
   hicClass = ConvertTestResult(act.Result.Name);
-  DigitalScanAllChips(digiscanTree, actLong, hicid, act.ID, eosPath, hicType);
+  actMask = 0; // Unknown type, not needed here
+  DigitalScanAllChips(digiscanTree, actLong, hicid, act.ID, eosPath, hicType, digimapTree);
   DigitalScanResults(digiresulTree, actLong, hicid, act.ID, eosPath, hicType);
 
   // Close the ROOT file and exit
   digiscanTree->Write();
   digiresulTree->Write();
+  digimapTree->Write();
   CloseRootFile(digiscanFile);
 
 #ifdef USENCURSES
@@ -402,6 +514,187 @@ void analyzeDigitalScan(const int hicid, const ComponentDB::compActivity act, Al
 
 }
 
+void mergeAllDigitalScans(const int nshards, const THicType hicType)
+{
+//
+// Steering routine to merge the files produced by the shard jobs
+// of Digital Scans into a single file
+//
+// Inputs:
+//          nshards : the number of shards
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const char *extraNames[] = {"pixMapTree"};
+
+  MergeAllShardFiles("DigitalScan", nshards, hicType, digScanTreeNames, sizeof(digScanTreeNames)/sizeof(digScanTreeNames[0]), extraNames, 1);
+}
+
+void sortAllDigitalScans(const THicType hicType)
+{
+//
+// Steering routine to sort the pixel trees of the file of all
+// Digital Scans on the key chosen with SetPixelSortKey
+//
+// Inputs:
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TString rootFileName, sortedName;
+  if (hicType == HIC_IB)
+    rootFileName = "IBHIC_DigitalScan_AllHICs.root";
+  else
+    rootFileName = "OBHIC_DigitalScan_AllHICs.root";
+
+  if (SortPixelRootFile(rootFileName, digScanTreeNames, sizeof(digScanTreeNames)/sizeof(digScanTreeNames[0]), sortedName)) {
+#ifdef USENCURSES
+    mvprintw(LINES-4, 0, "\n Pixel trees of %s sorted into %s\n", rootFileName.Data(), sortedName.Data());
+#else
+    printf("\n\n Pixel trees of %s sorted into %s\n", rootFileName.Data(), sortedName.Data());
+#endif
+  } else
+    printMessage("\nsortAllDigitalScans","Error: error sorting the pixel trees", 0, LOG_ERROR);
+
+  f12ToExit();
+}
+
+static void AddDigScanPixel(TTree *tree, const Bool_t packed, const Bool_t mapped, const Int_t column, const Int_t row, const Int_t nhits)
+{
+//
+// Adds a pixel to the tree: in the usual layout the tree is filled
+// at once, in the packed one the pixel is appended to the arrays,
+// which are filled when full (and by the caller at end of file)
+//
+// Inputs:
+//          tree   : the tree to be filled
+//          packed : true if the tree has the packed layout
+//          mapped : true if the pixel is also added to the pixel maps
+//          column : the pixel column
+//          row    : the pixel row
+//          nhits  : the number of hits
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (mapped) {
+    if (nhits == 0)
+      PixMapAdd(digMap[DIGMAP_DEAD], column, row);
+    else if (nhits < DIGMAP_NINJ)
+      PixMapAdd(digMap[DIGMAP_INEFF], column, row);
+    else
+      PixMapAdd(digMap[DIGMAP_NOISY], column, row);
+  }
+
+  if (packed) {
+    colArr[pixNum] = column;
+    rowArr[pixNum] = row;
+    hitsArr[pixNum] = nhits;
+    if (++pixNum == PIXPACKSIZE) {
+      tree->Fill();
+      pixNum = 0;
+    }
+  } else {
+    rowNum = row;
+    colNum = column;
+    numHits = nhits;
+    tree->Fill();
+  }
+}
+
+static void AllocDigScanPixels(void)
+{
+//
+// Allocates the arrays of the packed pixel trees, only once
+// so that the addresses the branches point to never change
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (colArr.size() == 0) {
+    colArr.resize(PIXPACKSIZE);
+    rowArr.resize(PIXPACKSIZE);
+    hitsArr.resize(PIXPACKSIZE);
+  }
+  pixNum = 0;
+}
+
+void CopyDigScanMapOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newmap, TTree *oldmap)
+{
+//
+// Copies the pixel maps of a given activity from the old tree to the
+// new tree (they have no offset in the actFastListTree, so the first
+// entry of each activity in the old tree is indexed the first time)
+//
+// Inputs:
+//          hicid  : the HIC Id
+//          actid  : the Activity Id
+//          newmap : the new pixel map tree
+//          oldmap : the old pixel map tree (can be missing in old files)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  // The index is rebuilt when another tree is given, or the same
+  // address is reused by the tree of a later file (seen by its size)
+  static TTree *indexTree = 0;
+  static Long64_t indexEntries = -1;
+  static std::map<ULong64_t, Long64_t> firstEntry;
+
+  if (!oldmap) return;
+
+  Long64_t currEntries = oldmap->GetEntries();
+  if (oldmap != indexTree || currEntries != indexEntries) {
+    firstEntry.clear();
+    for (Long64_t j = 0; j < currEntries; j++) {
+      oldmap->GetEntry(j);
+      firstEntry.insert(std::make_pair(ActivityKey(hicID, actID), j));
+    }
+    indexTree = oldmap;
+    indexEntries = currEntries;
+  }
+
+  std::map<ULong64_t, Long64_t>::iterator it = firstEntry.find(ActivityKey(hicid, actid));
+  if (it != firstEntry.end()) {
+    Long64_t j = it->second;
+    oldmap->GetEntry(j); // Get the first entry, then loop
+    while(hicID == hicid && actID == actid && j < currEntries) {
+      newmap->Fill();
+      j++;
+      oldmap->GetEntry(j);
+    }
+  }
+
+  // Reset values (to fill new activity tree) then exit
+  hicID = hicid;
+  actID = actid;
+}
+
 void CopyDigScanOldToNew(const UInt_t hicid, const UInt_t actid,
                          TTree *newscan, TTree *newres,
                          TTree *oldscan, TTree *oldres)
@@ -474,6 +767,7 @@ TTree* CreateHicActListTreeDS(void)
 //
 // Created:      27 Nov 2018  Mario Sitta
 // Updated:      18 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newTree = 0;
@@ -485,6 +779,8 @@ TTree* CreateHicActListTreeDS(void)
     newTree->Branch("actMask", &actMask, "actMask/s");
     newTree->Branch("actOffs", &testOffset, "testOffset/L");
     newTree->Branch("actResOff", &testResOffset, "testResOffset/L");
+    newTree->Branch("actFinger", &actFingerprint, "actFingerprint/l");
+    newTree->Branch("actDbFinger", &actDbFingerprint, "actDbFingerprint/l");
   }
 
   return newTree;
@@ -509,6 +805,7 @@ TTree* CreateTreeDigitalScan(TString treeName, TString treeTitle)
 // Updated:      15 Jan 2019  Mario Sitta
 // Updated:      08 Mar 2019  Mario Sitta  HIC position & Flag ML/OL staves
 // Updated:      19 Sep 2019  Mario Sitta  HIC name and classification added
+// Updated:      19 Oct 2026  Packed layout added
 //
 
   TTree *newTree = 0;
@@ -524,9 +821,57 @@ TTree* CreateTreeDigitalScan(TString treeName, TString treeTitle)
     newTree->Branch("hicClass", &hicClass, "hicClass/B");
     newTree->Branch("staveOLML", &staveOLML, "staveOLML/b");
     newTree->Branch("chipNum", &chipNum, "chipNum/b");
-    newTree->Branch("colNum", &colNum, "colNum/s");
-    newTree->Branch("rowNum", &rowNum, "rowNum/s");
-    newTree->Branch("numHits", &numHits, "numHits/s");
+    if (GetPackedPixelTrees()) {
+      AllocDigScanPixels();
+      newTree->Branch("pixNum", &pixNum, "pixNum/I");
+      newTree->Branch("colNum", &colArr[0], "colNum[pixNum]/s");
+      newTree->Branch("rowNum", &rowArr[0], "rowNum[pixNum]/s");
+      newTree->Branch("numHits", &hitsArr[0], "numHits[pixNum]/s");
+    } else {
+      newTree->Branch("colNum", &colNum, "colNum/s");
+      newTree->Branch("rowNum", &rowNum, "rowNum/s");
+      newTree->Branch("numHits", &numHits, "numHits/s");
+    }
+  }
+
+  return newTree;
+}
+
+TTree* CreateTreeDigitalScanMap(TString treeName, TString treeTitle)
+{
+//
+// Creates a tree for the Digital Scan pixel maps: one entry per chip
+// and condition, with the dead, inefficient and noisy pixels of the
+// chip each stored as a serialized roaring bitmap (see pixmaplib)
+//
+// Inputs:
+//          treeName  : the tree name
+//          treeTitle : the tree title
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created ROOT tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newTree = 0;
+  newTree = new TTree(treeName.Data(), treeTitle.Data());
+
+  if(newTree) {
+    newTree->Branch("hicName", hicName, "hicName[13]/B");
+    newTree->Branch("hicID", &hicID, "hicID/i");
+    newTree->Branch("actID", &actID, "actID/i");
+    newTree->Branch("actMask", &actMask, "actMask/s");
+    newTree->Branch("condVB", &condVB, "condVB/b");
+    newTree->Branch("chipNum", &chipNum, "chipNum/b");
+    for (Int_t icat = 0; icat < DIGMAP_NCAT; icat++) {
+      TString len = TString(digMapName[icat]) + "Len";
+      TString map = TString(digMapName[icat]) + "Map";
+      newTree->Branch(len.Data(), &digMapLen[icat], (len + "/I").Data());
+      newTree->Branch(map.Data(), digMapBuf[icat], (map + "[" + len + "]/b").Data());
+    }
   }
 
   return newTree;
@@ -605,7 +950,7 @@ TTree* CreateTreeDigitalScanResult(TString treeName, TString treeTitle)
   return newTree;
 }
 
-void DigitalScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType)
+void DigitalScanAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType, TTree *maptree)
 {
 //
 // Loops on chips and fills the tree for the given activity
@@ -617,6 +962,7 @@ void DigitalScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const i
 //          actid   : the activity id
 //          eospath : the input file path on EOS
 //          hicType : the HIC type (IB or OB)
+//          maptree : the pixel map tree to be filled (if any)
 //
 // Outputs:
 //
@@ -627,8 +973,14 @@ void DigitalScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const i
 // Updated:      15 Jan 2019  Mario Sitta
 // Updated:      30 Jan 2019  Mario Sitta  Bug fix
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added, bug fix in chip loop
+// Updated:      19 Oct 2026  Pixel maps, chip numbering tables
 //
 
+  // A new activity: the strings of the previous one are released
+  // and the messages are tagged with it
+  ArenaReset();
+  LogSetActivity(hicid, actid);
+
   hicID = hicid;
   actID = actid;
   locID = actlong.Location.ID;
@@ -637,28 +989,25 @@ void DigitalScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const i
   string dataName, resultName;
   unsigned char conds[4] = {100, 103, 90, 110};
 
-  const int numchips = ((hicType == HIC_OB) ? NUMCHIPS+1 : NUMCHIPSIB);
- 
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
+
   for (int icond = 0; icond < 4; icond ++) {
-    for (int ichip = 0; ichip < numchips; ichip++) {
-      if(hicType == HIC_OB && ichip == 7) continue;
-      if(hicType == HIC_OB && ichip > 7)
-	chipNum = ichip - 1;
-      else
-	chipNum = ichip;
+    for (int i = 0; i < chipMap->numChips; i++) {
+      chipNum = i;
+      int ichip = chipMap->chipId[i];
 
       Int_t vchip = (conds[icond]/10)*10; // We deliberately divide int's
       Int_t vBB = conds[icond] - vchip;
       if(GetDigitalFileName(actlong, ichip, vchip, vBB, dataName, resultName)) {
         condVB = conds[icond];
-        FillDigScanTree(ftree, eospath, dataName);
+        FillDigScanTree(ftree, eospath, dataName, maptree);
       }
     }
   }
 
 }
 
-void DigitalScanResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType)
+void DigitalScanResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType)
 {
 //
 // Fills the tree for the given activity results
@@ -678,6 +1027,7 @@ void DigitalScanResults(TTree *ftree, ActivityDB::activityLong actlong, const in
 // Created:      19 Oct 2018  Mario Sitta
 // Updated:      06 Nov 2018  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Arguments passed by reference, string arena
 //
 
   hicID = hicid;
@@ -714,7 +1064,28 @@ void DigitalScanResults(TTree *ftree, ActivityDB::activityLong actlong, const in
 
 }
 
-Bool_t FillDigScanTree(TTree *tree, string path, string file)
+static void FillDigScanMapTree(TTree *maptree)
+{
+//
+// Fills the pixel map tree with the maps of the current chip
+//
+// Inputs:
+//          maptree : the pixel map tree
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  for (Int_t icat = 0; icat < DIGMAP_NCAT; icat++)
+    digMapLen[icat] = PixMapWrite(digMap[icat], digMapBuf[icat]);
+
+  maptree->Fill();
+}
+
+Bool_t FillDigScanTree(TTree *tree, const string &path, const string &file, TTree *maptree)
 {
 //
 // Opens the DigitalScan file and fills the tree
@@ -723,6 +1094,7 @@ Bool_t FillDigScanTree(TTree *tree, string path, string file)
 //          tree  : the pointer to the tree to be filled
 //          path  : the input file path
 //          file  : the input file name
+//          maptree : the pixel map tree to be filled (if any)
 //
 // Outputs:
 //
@@ -734,22 +1106,34 @@ Bool_t FillDigScanTree(TTree *tree, string path, string file)
 // Updated:      08 Oct 2018  Mario Sitta
 // Updated:      06 Nov 2018  Mario Sitta
 // Updated:      05 Dec 2018  Mario Sitta  Bug in reading rows/cols
+// Updated:      19 Oct 2026  Timing, packed layout and pixel maps added
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfRows = 0;
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
+  const char *fullName;
   Int_t  row, column, nhits;
   Int_t  expectRow, expectCol;
   Int_t  colold = -1;
+  const Bool_t packed = IsPackedPixelTree(tree);
 
-  fullName = path + "/" + file;
+  fullName = ArenaJoinPath(path, file);
 
-  infile = fopen(fullName.c_str(),"r");
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillDigScanTree","Warning: cannot open input file",file.c_str());
+    printMessage("FillDigScanTree","Warning: cannot open input file",file.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
+  const Bool_t mapped = (maptree != 0);
+  if (mapped)
+    for (Int_t icat = 0; icat < DIGMAP_NCAT; icat++)
+      PixMapClear(digMap[icat]);
+
+  pixNum = 0;
   expectRow = 0;
   expectCol = 0;
   while(fscanf(infile, "%d %d %d", &column, &row, &nhits) != EOF){
@@ -759,10 +1143,8 @@ Bool_t FillDigScanTree(TTree *tree, string path, string file)
 //    }
     if (row != expectRow || column != expectCol) { // 0 entries are not on file
       do {
-        rowNum = expectRow;
-        colNum = expectCol;
-        numHits = 0;
-        tree->Fill();
+        AddDigScanPixel(tree, packed, mapped, expectCol, expectRow, 0);
+        perfRows++;
 
         expectCol++;
         if(expectCol == 1024) {
@@ -771,11 +1153,9 @@ Bool_t FillDigScanTree(TTree *tree, string path, string file)
         }
       } while(row != expectRow || column != expectCol);
     }
-    if (nhits != 50) {
-      rowNum = row;
-      colNum = column;
-      numHits = nhits;
-      tree->Fill();
+    if (nhits != DIGMAP_NINJ) {
+      AddDigScanPixel(tree, packed, mapped, column, row, nhits);
+      perfRows++;
     }
 
     expectCol++;
@@ -784,12 +1164,22 @@ Bool_t FillDigScanTree(TTree *tree, string path, string file)
       expectCol = 0;
     }
   } // while(fscanf(infile))
+  perfBytes += ftell(infile);
   fclose(infile);
 
+  // The last (or only) entry of the chip in the packed layout
+  if (packed && pixNum > 0)
+    tree->Fill();
+
+  if (mapped)
+    FillDigScanMapTree(maptree);
+
+  PerfAddSample(PERF_FILLDATA, PerfNow() - perfStart, perfBytes, perfRows);
+
   return kTRUE;
 }
 
-Bool_t FillDigScanTreeResult(TTree *tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType)
+Bool_t FillDigScanTreeResult(TTree *tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType)
 {
 //
 // Opens the DigitalScanResult file and fills the tree
@@ -816,22 +1206,28 @@ Bool_t FillDigScanTreeResult(TTree *tree, string path, string file, ActivityDB::
 // Updated:      12 Jan 2019  Mario Sitta
 // Updated:      05 Feb 2019  Mario Sitta  Bug fix in reading registers
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Timing, chip numbering tables, parameter index
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfEntries = tree->GetEntries();
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
+  const char *fullName;
   float value, dummy;
   unsigned int reg, regval;
   int ichip;
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
   char *line = NULL;
   size_t len = 0;
   bool baddoubcols_found = false, stuckpixels_found = false, deadpixels_found = false;
 
-  fullName = path + "/" + file;
+  fullName = ArenaJoinPath(path, file);
 
-  infile = fopen(fullName.c_str(),"r");
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillDigScanTreeResult","Warning: cannot open input file",file.c_str());
+    printMessage("FillDigScanTreeResult","Warning: cannot open input file",file.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
@@ -973,54 +1369,42 @@ Bool_t FillDigScanTreeResult(TTree *tree, string path, string file, ActivityDB::
     // Per-chip data
     if (strstr(line,"Analogue voltage (") && strstr(line,"start")) {
       sscanf(line, "  Analogue voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipAnalVoltStart[ichip-1] = value;
-      else
-        chipAnalVoltStart[ichip] = value; 
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipAnalVoltStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Analogue voltage (") && strstr(line,"end")) {
       sscanf(line, "  Analogue voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipAnalVoltEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipAnalVoltEnd[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"start")) {
       sscanf(line, "  Digital voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltStart[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"end")) {
       sscanf(line, "  Digital voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltEnd[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"start")) {
       sscanf(line, "  Temperature (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipTempStart[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipTempStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"end")) {
       sscanf(line, "  Temperature (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipTempEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipTempEnd[ichip] = value;
       continue;
     }
@@ -1064,74 +1448,46 @@ Bool_t FillDigScanTreeResult(TTree *tree, string path, string file, ActivityDB::
     if(reg == 0x700) {
       ichip &= 0x0f; // ichip is the lower 4 bits
       if(chipStartFound) {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700Start[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700Start[ichip] = regval;
       } else {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700End[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700End[ichip] = regval;
       }
     }
 
   } // while(getline(&line, &len, infile))
 
+  perfBytes += ftell(infile);
   fclose(infile);
 
   // Now get data from DB
-  vector<ActivityDB::actParameter>  parameters = actlong.Parameters;
-
-  std::vector<ActivityDB::actParameter>::iterator loop;
-  for(loop = parameters.begin(); loop != parameters.end(); loop++) {
-    ActivityDB::actParameter actpar = *loop;
-
-    if(actpar.Type.Parameter.Name.compare("Classification Version") == 0) {
-      classificVers = actpar.Value;
-      continue;
-    }
-
-    if(condVB == 103 &&
-       actpar.Type.Parameter.Name.compare("Classification Digital Scan BB 3") == 0) {
-      classificDigiScan = actpar.Value;
-      continue;
-    }
-
-    if(condVB == 90 &&
-       actpar.Type.Parameter.Name.compare("Classification Digital Scan BB 0, V -10%") == 0) {
-      classificDigiScan = actpar.Value;
-      continue;
-    }
+  const TActParameters *actPars = GetActParameters(actlong);
 
-    if(condVB == 110 &&
-       actpar.Type.Parameter.Name.compare("Classification Digital Scan BB 0, V +10%") == 0) {
-      classificDigiScan = actpar.Value;
-      continue;
-    }
+  if(actPars->found[ACTPAR_VERSION])
+    classificVers = actPars->value[ACTPAR_VERSION];
 
-    // This string is a substring of the previous ones, but these were
-    // catched by previous tests and the 'continue' statements jump this check
-    if(condVB == 100 &&
-       actpar.Type.Parameter.Name.compare("Classification Digital Scan BB 0") == 0) {
-      classificDigiScan = actpar.Value;
-      continue;
-    }
+  Int_t parDigi = -1;
+  if(condVB == 100) parDigi = ACTPAR_DIGI0;
+  if(condVB == 103) parDigi = ACTPAR_DIGI3;
+  if(condVB == 90)  parDigi = ACTPAR_DIGIM10;
+  if(condVB == 110) parDigi = ACTPAR_DIGIP10;
+  if(parDigi >= 0 && actPars->found[parDigi])
+    classificDigiScan = actPars->value[parDigi];
 
-    if(actpar.Type.Parameter.Name.compare("Number of Working Chips") == 0) {
-      numWorkChips = actpar.Value;
-      continue;
-    }
-    
-  }
+  if(actPars->found[ACTPAR_WORKCHIPS])
+    numWorkChips = actPars->value[ACTPAR_WORKCHIPS];
 
   // Fill the tree, close the file and return
   tree->Fill();
 
+  PerfAddSample(PERF_FILLRES, PerfNow() - perfStart, perfBytes,
+                tree->GetEntries() - perfEntries);
+
   return kTRUE;
 }
 
-Bool_t FindActivityInDigScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask)
+Bool_t FindActivityInDigScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger)
 {
 //
 // Finds the activity in the tree
@@ -1143,11 +1499,14 @@ Bool_t FindActivityInDigScanTree(TTree* listree, const UInt_t hicid, const UInt_
 //          mask  : the activity mask
 //
 // Outputs:
+//          dbfinger : the DB data fingerprint stored with the activity
+//          finger   : the fingerprint stored with the activity
 //
 // Return:
 //          true if activity found
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Stored fingerprints returned
 //
 
   Bool_t found = kFALSE;
@@ -1158,11 +1517,19 @@ Bool_t FindActivityInDigScanTree(TTree* listree, const UInt_t hicid, const UInt_
   Int_t currHicId = hicID;
   Int_t currActId = actID;
   UShort_t currMask = actMask;
+  ULong64_t currDbFinger = actDbFingerprint;
+  ULong64_t currFinger = actFingerprint;
+
+  // Files written before fingerprints were introduced have no such branches
+  actDbFingerprint = 0;
+  actFingerprint = 0;
   
   Int_t nEntries = listree->GetEntries();
   for (Int_t j = 0; j < nEntries; j++) {
     listree->GetEntry(j);
     if(hicID == hicid && actID == actid && actMask == mask) {
+      dbfinger = actDbFingerprint;
+      finger = actFingerprint;
       found = kTRUE;
       break;
     }
@@ -1172,10 +1539,107 @@ Bool_t FindActivityInDigScanTree(TTree* listree, const UInt_t hicid, const UInt_
   hicID = currHicId;
   actID = currActId;
   actMask = currMask;
+  actDbFingerprint = currDbFinger;
+  actFingerprint = currFinger;
 
   return found;
 }
 
+Bool_t GetDigScanMap(TTree *maptree, const UInt_t hicid, const UShort_t actmask, const UChar_t cond, const UChar_t chip, const Int_t category, TPixMap &map)
+{
+//
+// Gets a pixel map of a chip from the pixel map tree, which is indexed
+// the first time (if a HIC has more activities of the same type the
+// last one in the tree is used)
+//
+// Inputs:
+//          maptree  : the pixel map tree (created or read from file)
+//          hicid    : the HIC Id
+//          actmask  : the activity type (one of ACTMASK_*)
+//          cond     : the test condition (condVB)
+//          chip     : the chip number
+//          category : the pixel category (one of DIGMAP_*)
+//
+// Outputs:
+//          map : the pixel map
+//
+// Return:
+//          kTRUE if the map was found, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  static TTree *indexTree = 0;
+  static Long64_t indexEntries = 0;
+  static std::map<ULong64_t, Long64_t> entryIndex;
+
+  PixMapClear(map);
+  if (!maptree || category < 0 || category >= DIGMAP_NCAT) return kFALSE;
+
+  if (maptree != indexTree || maptree->GetEntries() != indexEntries) {
+    entryIndex.clear();
+    indexEntries = maptree->GetEntries();
+    for (Long64_t j = 0; j < indexEntries; j++) {
+      maptree->GetEntry(j);
+      ULong64_t key = ((ULong64_t)hicID << 32) | ((ULong64_t)actMask << 16) | (condVB << 8) | chipNum;
+      entryIndex[key] = j;
+    }
+    indexTree = maptree;
+  }
+
+  ULong64_t key = ((ULong64_t)hicid << 32) | ((ULong64_t)actmask << 16) | (cond << 8) | chip;
+  std::map<ULong64_t, Long64_t>::iterator it = entryIndex.find(key);
+  if (it == entryIndex.end()) return kFALSE;
+
+  maptree->GetEntry(it->second);
+
+  return PixMapRead(map, digMapBuf[category], digMapLen[category]);
+}
+
+void GetDigScanTrendRecords(TTree *tree, const Long64_t first, const Long64_t last, const UChar_t stage, std::vector<TTrendRecord> &records)
+{
+//
+// Gets the number of hits of the bad pixels of an activity
+// for the trend analysis (only the TRENDCOND_DIGITAL condition):
+// the pixels not in the tree had all the injected hits
+//
+// Inputs:
+//          tree    : the pixel tree (read from file)
+//          first   : the first entry of the activity
+//          last    : the entry after the last one of the activity
+//          stage   : the test stage of the tree (one of TRENDSTAGE_*)
+//
+// Outputs:
+//          records : the records of the pixels, appended
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const Bool_t packed = IsPackedPixelTree(tree);
+  TTrendRecord rec;
+  rec.stage = stage;
+  rec.source = TRENDSRC_DIGITAL;
+  rec.value2 = 0;
+
+  for (Long64_t j = first; j < last; j++) {
+    tree->GetEntry(j);
+    if (condVB != TRENDCOND_DIGITAL) continue;
+    if (packed) {
+      for (Int_t i = 0; i < pixNum; i++) {
+        rec.pixel = TRENDPIXEL(chipNum, colArr[i], rowArr[i]);
+        rec.value = hitsArr[i];
+        records.push_back(rec);
+      }
+    } else {
+      rec.pixel = TRENDPIXEL(chipNum, colNum, rowNum);
+      rec.value = numHits;
+      records.push_back(rec);
+    }
+  }
+}
+
 TTree* ReadHicActListTreeDS(TFile *rootfile)
 {
 //
@@ -1193,6 +1657,7 @@ TTree* ReadHicActListTreeDS(TFile *rootfile)
 //
 // Created:      28 Nov 2018  Mario Sitta
 // Updated:      18 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newtree = 0;
@@ -1204,6 +1669,10 @@ TTree* ReadHicActListTreeDS(TFile *rootfile)
     newtree->SetBranchAddress("actMask", &actMask);
     newtree->SetBranchAddress("actOffs", &testOffset);
     newtree->SetBranchAddress("actResOff", &testResOffset);
+    if(newtree->GetBranch("actFinger")) // Missing in older files
+      newtree->SetBranchAddress("actFinger", &actFingerprint);
+    if(newtree->GetBranch("actDbFinger")) // Ditto
+      newtree->SetBranchAddress("actDbFinger", &actDbFingerprint);
   }
 
   return newtree;
@@ -1229,6 +1698,7 @@ TTree* ReadDigScanTree(TString treename, TFile *rootfile)
 // Updated:      15 Jan 2019  Mario Sitta
 // Updated:      08 Mar 2019  Mario Sitta  HIC position & Flag ML/OL staves
 // Updated:      19 Sep 2019  Mario Sitta  HIC name and classification added
+// Updated:      19 Oct 2026  Packed layout added
 //
 
   TTree *newtree = 0;
@@ -1244,9 +1714,56 @@ TTree* ReadDigScanTree(TString treename, TFile *rootfile)
     newtree->SetBranchAddress("hicClass", &hicClass);
     newtree->SetBranchAddress("staveOLML", &staveOLML);
     newtree->SetBranchAddress("chipNum",&chipNum);
-    newtree->SetBranchAddress( "colNum", &colNum);
-    newtree->SetBranchAddress( "rowNum", &rowNum);
-    newtree->SetBranchAddress("numHits",&numHits);
+    if (IsPackedPixelTree(newtree)) {
+      AllocDigScanPixels();
+      newtree->SetBranchAddress( "pixNum", &pixNum);
+      newtree->SetBranchAddress( "colNum", &colArr[0]);
+      newtree->SetBranchAddress( "rowNum", &rowArr[0]);
+      newtree->SetBranchAddress("numHits", &hitsArr[0]);
+    } else {
+      newtree->SetBranchAddress( "colNum", &colNum);
+      newtree->SetBranchAddress( "rowNum", &rowNum);
+      newtree->SetBranchAddress("numHits",&numHits);
+    }
+    MatchPackedPixelTrees(newtree);
+  }
+
+  return newtree;
+}
+
+TTree* ReadDigScanTreeMap(TString treename, TFile *rootfile)
+{
+//
+// Reads a tree of Digital Scan pixel maps from file
+// WARNING!! We assume the rootfile was already successfully opened!
+// NO checks on file!
+//
+// Inputs:
+//          treename : the tree name
+//          rootfile : the Root file
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the read ROOT tree (0 in files older than the maps)
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newtree = 0;
+  newtree = (TTree*)rootfile->Get(treename.Data());
+
+  if(newtree) {
+    newtree->SetBranchAddress("hicName", hicName);
+    newtree->SetBranchAddress(  "hicID", &hicID);
+    newtree->SetBranchAddress(  "actID", &actID);
+    newtree->SetBranchAddress("actMask", &actMask);
+    newtree->SetBranchAddress( "condVB", &condVB);
+    newtree->SetBranchAddress("chipNum", &chipNum);
+    for (Int_t icat = 0; icat < DIGMAP_NCAT; icat++) {
+      newtree->SetBranchAddress((TString(digMapName[icat]) + "Len").Data(), &digMapLen[icat]);
+      newtree->SetBranchAddress((TString(digMapName[icat]) + "Map").Data(), digMapBuf[icat]);
+    }
   }
 
   return newtree;
@@ -1390,11 +1907,12 @@ TTree* SetupHicActListTreeDS(TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateHicActListTreeDS();
   else
     newtree = ReadHicActListTreeDS(rootfile);
@@ -1418,11 +1936,12 @@ TTree* SetupDigScanTree(TString treename, TString treetitle, TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreeDigitalScan(treename,treetitle);
   else
     newtree = ReadDigScanTree(treename, rootfile);
@@ -1430,6 +1949,35 @@ TTree* SetupDigScanTree(TString treename, TString treetitle, TFile *rootfile)
   return newtree;
 }
 
+TTree* SetupDigScanTreeMap(TString treename, TString treetitle, TFile *rootfile)
+{
+//
+// Creates a new pixel map tree or reads it from file
+//
+// Inputs:
+//          treename  : the tree name
+//          treetitle : the tree title
+//          rootfile  : the (already opened) Root file
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created/read tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newtree = 0;
+
+  if(appendToFile)
+    newtree = ReadDigScanTreeMap(treename, rootfile);
+
+  if(!newtree) // Also when appending to a file older than the maps
+    newtree = CreateTreeDigitalScanMap(treename,treetitle);
+
+  return newtree;
+}
+
 TTree* SetupDigScanTreeResult(TString treename, TString treetitle, TFile *rootfile)
 {
 //
@@ -1446,11 +1994,12 @@ TTree* SetupDigScanTreeResult(TString treename, TString treetitle, TFile *rootfi
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreeDigitalScanResult(treename,treetitle);
   else
     newtree = ReadDigScanTreeResult(treename, rootfile);
@@ -22,30 +22,51 @@
 #include "AlpideDBEndPoints.h"
 #include "THIC.h"
 #include "TScanFactory.h"
+#include "dblib.h"
+#include "perflib.h"
+#include "pixmaplib.h"
+#include "sortlib.h"
+#include "trendlib.h"
 
 #include <iostream>
+#include <map>
 #include <stdio.h>
 #include <sys/stat.h>
 
 //Bool_t redoFromStart;
 
-void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType);
+// The categories of the pixel maps (see CreateTreeDigitalScanMap)
+#define DIGMAP_DEAD  0  // No hits
+#define DIGMAP_INEFF 1  // Less hits than injections
+#define DIGMAP_NOISY 2  // More hits than injections
+#define DIGMAP_NCAT  3
+#define DIGMAP_NINJ  50 // The number of injections per pixel
+
+void analyzeAllDigitalScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType);
 void analyzeDigitalScan(const int hicid, const ComponentDB::compActivity act, AlpideDB *db, const THicType hicType);
+void mergeAllDigitalScans(const int nshards, const THicType hicType);
+void sortAllDigitalScans(const THicType hicType);
+void CopyDigScanMapOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newmap, TTree *oldmap);
 void CopyDigScanOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newscan, TTree *newres, TTree *oldscan, TTree *oldres);
 TTree* CreateHicActListTreeDS(void);
 TTree* CreateTreeDigitalScan(TString treeName, TString treeTitle);
+TTree* CreateTreeDigitalScanMap(TString treeName, TString treeTitle);
 TTree* CreateTreeDigitalScanResult(TString treeName, TString treeTitle);
-void DigitalScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType);
-void DigitalScanResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType);
-Bool_t FillDigScanTree(TTree* tree, string path, string file);
-Bool_t FillDigScanTreeResult(TTree* tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType);
-Bool_t FindActivityInDigScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask);
+void DigitalScanAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType, TTree *maptree=0);
+void DigitalScanResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType);
+Bool_t FillDigScanTree(TTree* tree, const string &path, const string &file, TTree *maptree=0);
+Bool_t FillDigScanTreeResult(TTree* tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType);
+Bool_t FindActivityInDigScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger);
+Bool_t GetDigScanMap(TTree *maptree, const UInt_t hicid, const UShort_t actmask, const UChar_t cond, const UChar_t chip, const Int_t category, TPixMap &map);
+void GetDigScanTrendRecords(TTree *tree, const Long64_t first, const Long64_t last, const UChar_t stage, std::vector<TTrendRecord> &records);
 TTree* ReadHicActListTreeDS(TFile *rootfile);
 TTree* ReadDigScanTree(TString treename, TFile *rootfile);
+TTree* ReadDigScanTreeMap(TString treename, TFile *rootfile);
 TTree* ReadDigScanTreeResult(TString treename, TFile *rootfile);
 void ResetDigScanTreeVariables(void);
 TTree* SetupHicActListTreeDS(TFile *rootfile);
 TTree* SetupDigScanTree(TString treename, TString treetitle, TFile *rootfile);
+TTree* SetupDigScanTreeMap(TString treename, TString treetitle, TFile *rootfile);
 TTree* SetupDigScanTreeResult(TString treename, TString treetitle, TFile *rootfile);
 
 
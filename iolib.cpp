@@ -0,0 +1,543 @@
+#include "iolib.h"
+
+//
+// The batch file reader: the files of a batch (e.g. the chip files of
+// an activity) are read at once, either by the worker threads or, where
+// the kernel has it, through io_uring, which opens and reads all of them
+// with a couple of system calls instead of some five per file: with many
+// small files on EOS the time goes in the opens, not in the bytes
+//
+
+// The printable name of each backend
+static const char* ioBackendName[3] = {"stdio", "pool", "io_uring"};
+
+// The backend used by IoReadFiles (the worker threads, if any, by default)
+static Int_t ioBackend = IOBACKEND_POOL;
+
+#ifdef IOHAVEURING
+// The io_uring instance, set up once (see IoRingSetup) and used by the
+// thread calling IoReadFiles only: it is kept until the process exits
+struct TIoRing {
+  Int_t                 fd;
+  UInt_t               *sqHead;
+  UInt_t               *sqTail;
+  UInt_t               *sqMask;
+  UInt_t               *sqArray;
+  struct io_uring_sqe  *sqes;
+  UInt_t               *cqHead;
+  UInt_t               *cqTail;
+  UInt_t               *cqMask;
+  struct io_uring_cqe  *cqes;
+  UInt_t                queued;   // entries queued but not yet submitted
+  UInt_t                inflight; // entries submitted but not yet reaped
+};
+static TIoRing ioRing = {-1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static struct io_uring_sqe* IoRingGetEntry(void)
+{
+//
+// Returns the next free submission queue entry, cleared
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          the entry (submitted by the next IoRingSubmitAndWait)
+//
+// Created:      19 Oct 2026
+//
+
+  UInt_t tail = *ioRing.sqTail + ioRing.queued;
+  UInt_t index = tail & *ioRing.sqMask;
+  struct io_uring_sqe *sqe = &ioRing.sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  ioRing.sqArray[index] = index;
+  ioRing.queued++;
+
+  return sqe;
+}
+
+static Int_t IoRingSubmitAndWait(const UInt_t nwait)
+{
+//
+// Submits the queued entries and waits for nwait completions
+//
+// Inputs:
+//          nwait : the number of completions to wait for
+//
+// Outputs:
+//
+// Return:
+//          0 if successful, otherwise -errno
+//
+// Created:      19 Oct 2026
+//
+
+  __atomic_store_n(ioRing.sqTail, *ioRing.sqTail + ioRing.queued, __ATOMIC_RELEASE);
+  UInt_t nsubmit = ioRing.queued;
+  ioRing.queued = 0;
+
+  while (nsubmit > 0 || nwait > 0) {
+    UInt_t ndone = __atomic_load_n(ioRing.cqTail, __ATOMIC_ACQUIRE) - *ioRing.cqHead;
+    if (nsubmit == 0 && ndone >= nwait) break;
+    Long64_t ret = syscall(__NR_io_uring_enter, ioRing.fd, nsubmit,
+                           nwait > ndone ? nwait - ndone : 0,
+                           IORING_ENTER_GETEVENTS, NULL, 0);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      return -errno;
+    }
+    nsubmit -= ret;
+    ioRing.inflight += ret;
+  }
+
+  return 0;
+}
+
+static Bool_t IoRingSetup(void)
+{
+//
+// Sets up the io_uring instance and checks that the kernel can open,
+// read and close files through it (Linux 5.6 or later, and not
+// forbidden e.g. by a container seccomp policy)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if io_uring can be used, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  if (ioRing.fd >= 0) return kTRUE;
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  Int_t fd = syscall(__NR_io_uring_setup, IORINGSIZE, &params);
+  if (fd < 0) return kFALSE;
+
+  // The opcodes we need must be supported
+  const Int_t nops = 256;
+  struct io_uring_probe *probe = (struct io_uring_probe*)calloc(1,
+                     sizeof(struct io_uring_probe) + nops*sizeof(struct io_uring_probe_op));
+  Bool_t supported = kFALSE;
+  if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, nops) == 0) {
+    const Int_t need[3] = {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE};
+    supported = kTRUE;
+    for (Int_t i = 0; i < 3; i++)
+      if (need[i] > probe->last_op || !(probe->ops[need[i]].flags & IO_URING_OP_SUPPORTED))
+        supported = kFALSE;
+  }
+  free(probe);
+  if (!supported) {
+    close(fd);
+    return kFALSE;
+  }
+
+  // Map the queues in memory
+  size_t sqSize = params.sq_off.array + params.sq_entries*sizeof(UInt_t);
+  size_t cqSize = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    sqSize = cqSize = std::max(sqSize, cqSize);
+
+  char *sq = (char*)mmap(0, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQ_RING);
+  char *cq = sq;
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP) && sq != MAP_FAILED)
+    cq = (char*)mmap(0, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_CQ_RING);
+  void *sqes = mmap(0, params.sq_entries*sizeof(struct io_uring_sqe),
+                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+    close(fd); // Also releases the mappings
+    return kFALSE;
+  }
+
+  ioRing.sqHead  = (UInt_t*)(sq + params.sq_off.head);
+  ioRing.sqTail  = (UInt_t*)(sq + params.sq_off.tail);
+  ioRing.sqMask  = (UInt_t*)(sq + params.sq_off.ring_mask);
+  ioRing.sqArray = (UInt_t*)(sq + params.sq_off.array);
+  ioRing.sqes    = (struct io_uring_sqe*)sqes;
+  ioRing.cqHead  = (UInt_t*)(cq + params.cq_off.head);
+  ioRing.cqTail  = (UInt_t*)(cq + params.cq_off.tail);
+  ioRing.cqMask  = (UInt_t*)(cq + params.cq_off.ring_mask);
+  ioRing.cqes    = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+  ioRing.queued  = 0;
+  ioRing.inflight = 0;
+  ioRing.fd      = fd;
+
+  return kTRUE;
+}
+
+static void IoRingReap(TIoFile *files, Int_t *results)
+{
+//
+// Takes the result of all completed entries
+//
+// Inputs:
+//          files   : the files of the batch
+//
+// Outputs:
+//          results : the result of each file whose entry completed
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  UInt_t head = *ioRing.cqHead;
+  UInt_t tail = __atomic_load_n(ioRing.cqTail, __ATOMIC_ACQUIRE);
+  for (; head != tail; head++) {
+    struct io_uring_cqe *cqe = &ioRing.cqes[head & *ioRing.cqMask];
+    results[cqe->user_data] = cqe->res;
+    files[cqe->user_data].done = 1;
+    ioRing.inflight--;
+  }
+  __atomic_store_n(ioRing.cqHead, head, __ATOMIC_RELEASE);
+}
+
+static void IoRingAbort(TIoFile *files, const Int_t nfiles, const UChar_t opcode)
+{
+//
+// Cleans up after the ring failed in the middle of a batch: the entries
+// not yet submitted are dropped, those in flight are waited for (they
+// still use the buffers and the file descriptors), and the files left
+// open are closed, so that the batch can be read again by another backend
+//
+// Inputs:
+//          files  : the files of the batch
+//          nfiles : their number
+//          opcode : the operation of the entries in flight (IORING_OP_*)
+//
+// Outputs:
+//          files  : the files, all closed
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  Int_t results[IORINGSIZE];
+
+  __atomic_store_n(ioRing.sqTail, __atomic_load_n(ioRing.sqHead, __ATOMIC_ACQUIRE),
+                   __ATOMIC_RELEASE);
+  ioRing.queued = 0;
+
+  for (Int_t i = 0; i < nfiles; i++)
+    files[i].done = 0;
+
+  while (kTRUE) {
+    IoRingReap(files, results);
+    if (ioRing.inflight == 0) break;
+    if (syscall(__NR_io_uring_enter, ioRing.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0
+        && errno != EINTR) {
+      // Cannot even wait: closing the ring cancels what is in flight,
+      // and a new one is set up for the next batch
+      close(ioRing.fd);
+      ioRing.fd = -1;
+      break;
+    }
+  }
+
+  for (Int_t i = 0; i < nfiles; i++) {
+    if (files[i].done && opcode == IORING_OP_OPENAT && results[i] >= 0)
+      files[i].fd = results[i];  // Opened, not yet known
+    if (files[i].done && opcode == IORING_OP_CLOSE)
+      files[i].fd = -1;          // Already closed
+    if (files[i].fd >= 0) close(files[i].fd);
+    files[i].fd = -1;
+    files[i].bytes = -1;
+    files[i].done = 0;
+  }
+}
+
+static Long64_t IoRingReadFiles(TIoFile *files, const Int_t nfiles)
+{
+//
+// Reads up to IORINGSIZE files through io_uring: all opens are
+// submitted at once, then all reads (again for the files read only in
+// part), then all closes
+//
+// Inputs:
+//          files  : the files, with their name and buffer set
+//          nfiles : their number
+//
+// Outputs:
+//          files  : the files, with their content and bytes read
+//
+// Return:
+//          the total bytes read, or -1 if io_uring failed
+//
+// Created:      19 Oct 2026
+//
+
+  Int_t results[IORINGSIZE];
+  Long64_t offset[IORINGSIZE];
+  Long64_t size[IORINGSIZE];
+  Bool_t failed[IORINGSIZE];
+
+  // Open them all
+  for (Int_t i = 0; i < nfiles; i++) {
+    struct io_uring_sqe *sqe = IoRingGetEntry();
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (__u64)(unsigned long)files[i].name;
+    sqe->open_flags = O_RDONLY;
+    sqe->user_data = i;
+    files[i].fd = -1;
+    files[i].bytes = -1;
+    files[i].done = 0;
+  }
+  if (IoRingSubmitAndWait(nfiles) < 0) {
+    IoRingAbort(files, nfiles, IORING_OP_OPENAT);
+    return -1;
+  }
+  IoRingReap(files, results);
+
+  // Size the buffers and read them all, until each one is full or
+  // at its end (a read may return less than asked)
+  Int_t nread = 0;
+  for (Int_t i = 0; i < nfiles; i++) {
+    if (results[i] < 0) continue;
+    files[i].fd = results[i];
+    struct stat fileStat;
+    size[i] = 0;
+    if (fstat(files[i].fd, &fileStat) == 0 && fileStat.st_size > 0)
+      size[i] = fileStat.st_size;
+    files[i].buffer->resize(size[i] + 1);
+    offset[i] = 0;
+    failed[i] = kFALSE;
+    files[i].done = (size[i] == 0) ? 2 : 0; // 2 = nothing more to read
+    if (!files[i].done) nread++;
+  }
+
+  while (nread > 0) {
+    for (Int_t i = 0; i < nfiles; i++) {
+      if (files[i].fd < 0 || files[i].done) continue;
+      struct io_uring_sqe *sqe = IoRingGetEntry();
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = files[i].fd;
+      sqe->addr = (__u64)(unsigned long)(&(*files[i].buffer)[0] + offset[i]);
+      sqe->len = size[i] - offset[i];
+      sqe->off = offset[i];
+      sqe->user_data = i;
+    }
+    if (IoRingSubmitAndWait(nread) < 0) {
+      IoRingAbort(files, nfiles, IORING_OP_READ);
+      return -1;
+    }
+    IoRingReap(files, results);
+
+    nread = 0;
+    for (Int_t i = 0; i < nfiles; i++) {
+      if (files[i].fd < 0 || files[i].done == 2) continue;
+      if (results[i] > 0) offset[i] += results[i];
+      if (results[i] < 0) failed[i] = kTRUE;
+      if (results[i] <= 0 || offset[i] >= size[i]) {
+        files[i].done = 2;     // At its end, or unreadable
+      } else {
+        files[i].done = 0;     // Read again from where it stopped
+        nread++;
+      }
+    }
+  }
+
+  // Close them all
+  Int_t nclose = 0;
+  Long64_t total = 0;
+  for (Int_t i = 0; i < nfiles; i++) {
+    if (files[i].fd < 0) continue;
+    struct io_uring_sqe *sqe = IoRingGetEntry();
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = files[i].fd;
+    sqe->user_data = i;
+    nclose++;
+
+    // A file which cannot be read is as one which cannot be opened
+    files[i].bytes = failed[i] ? -1 : ((size[i] > 0) ? offset[i] : 0);
+    files[i].buffer->resize(std::max(files[i].bytes, (Long64_t)0) + 1);
+    (*files[i].buffer)[std::max(files[i].bytes, (Long64_t)0)] = '\0';
+    total += std::max(files[i].bytes, (Long64_t)0);
+  }
+  if (IoRingSubmitAndWait(nclose) < 0) {
+    IoRingAbort(files, nfiles, IORING_OP_CLOSE);
+    return -1;
+  }
+  IoRingReap(files, results);
+
+  for (Int_t i = 0; i < nfiles; i++)
+    files[i].done = 1;
+
+  return total;
+}
+#endif // IOHAVEURING
+
+static void IoReadTask(void *arg)
+{
+//
+// Reads a file of a batch (run by a worker thread)
+//
+// Inputs:
+//          arg : the TIoFile, with the name and buffer set
+//
+// Outputs:
+//          arg : the TIoFile, with the content and bytes read
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TIoFile *file = (TIoFile*)arg;
+  file->bytes = ReadWholeFile(file->name, *file->buffer);
+}
+
+Int_t IoGetBackend(void)
+{
+//
+// Returns the backend used to read the batches of files
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          one of IOBACKEND_*
+//
+// Created:      19 Oct 2026
+//
+
+  return ioBackend;
+}
+
+const char* IoGetBackendName(const Int_t backend)
+{
+//
+// Returns the printable name of a backend
+//
+// Inputs:
+//          backend : one of IOBACKEND_*
+//
+// Outputs:
+//
+// Return:
+//          the name
+//
+// Created:      19 Oct 2026
+//
+
+  if (backend < IOBACKEND_STDIO || backend > IOBACKEND_URING) return "unknown";
+
+  return ioBackendName[backend];
+}
+
+Long64_t IoReadFiles(TIoFile *files, const Int_t nfiles, const Int_t backend)
+{
+//
+// Reads a batch of files, each one whole in its buffer, with the given
+// backend: io_uring falls back to the worker threads if it cannot be
+// used, and these to the caller if there are none
+//
+// Inputs:
+//          files   : the files, with their name and buffer set
+//          nfiles  : their number
+//          backend : one of IOBACKEND_*
+//
+// Outputs:
+//          files   : the files, with their content (null terminated,
+//                    as with ReadWholeFile) and bytes read
+//
+// Return:
+//          the total bytes read
+//
+// Created:      19 Oct 2026
+//
+
+  Long64_t total = 0;
+  Int_t first = 0;
+
+#ifdef IOHAVEURING
+  if (backend == IOBACKEND_URING && IoRingSetup()) {
+    for (; first < nfiles; first += IORINGSIZE) {
+      Long64_t nbytes = IoRingReadFiles(files + first, std::min(nfiles - first, IORINGSIZE));
+      if (nbytes < 0) break; // The ring failed: the rest is read as below
+      total += nbytes;
+    }
+    if (first >= nfiles) return total;
+  }
+#endif
+
+  if (backend == IOBACKEND_STDIO) {
+    for (Int_t i = first; i < nfiles; i++) {
+      IoReadTask(&files[i]);
+      total += std::max(files[i].bytes, (Long64_t)0);
+    }
+    return total;
+  }
+
+  for (Int_t i = first; i < nfiles; i++) {
+    files[i].done = 0;
+    TSchedTask task = {IoReadTask, &files[i], SCHEDTASK_READFILE, -1, -1, -1, -1, &files[i].done};
+    SchedSubmit(task);
+  }
+  for (Int_t i = first; i < nfiles; i++) {
+    SchedWait(&files[i].done);
+    total += std::max(files[i].bytes, (Long64_t)0);
+  }
+
+  return total;
+}
+
+Long64_t IoReadFiles(TIoFile *files, const Int_t nfiles)
+{
+//
+// Reads a batch of files with the backend set by IoSetBackend
+//
+// Inputs:
+//          files  : the files, with their name and buffer set
+//          nfiles : their number
+//
+// Outputs:
+//          files  : the files, with their content and bytes read
+//
+// Return:
+//          the total bytes read
+//
+// Created:      19 Oct 2026
+//
+
+  return IoReadFiles(files, nfiles, ioBackend);
+}
+
+Bool_t IoSetBackend(const Int_t backend)
+{
+//
+// Sets the backend used to read the batches of files: if io_uring is
+// asked but cannot be used, the worker threads are used instead
+//
+// Inputs:
+//          backend : one of IOBACKEND_*
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the backend can be used, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  if (backend < IOBACKEND_STDIO || backend > IOBACKEND_URING) return kFALSE;
+
+  ioBackend = backend;
+  if (backend != IOBACKEND_URING) return kTRUE;
+
+#ifdef IOHAVEURING
+  if (IoRingSetup()) return kTRUE;
+#endif
+
+  ioBackend = IOBACKEND_POOL;
+  return kFALSE;
+}
@@ -0,0 +1,48 @@
+#ifndef IOLIB_H
+#define IOLIB_H
+
+#include <Rtypes.h>
+
+#include "perflib.h"
+#include "schedlib.h"
+#include "utillib.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define IOHAVEURING
+#endif
+#endif
+
+// The ways a batch of files can be read (see IoReadFiles)
+#define IOBACKEND_STDIO 0  // One file after the other, by the caller
+#define IOBACKEND_POOL  1  // One task per file, by the worker threads
+#define IOBACKEND_URING 2  // All opens and reads submitted at once to io_uring
+
+// Number of entries of the io_uring queues (files in flight at once)
+#define IORINGSIZE 256
+
+// A file of a batch
+struct TIoFile {
+  const char        *name;    // the file path and name
+  std::vector<char> *buffer;  // the file content, terminated by a null character
+  Long64_t           bytes;   // the bytes read (-1 if the file cannot be opened)
+  Int_t              fd;      // (used while reading)
+  Int_t              done;    // (used while reading)
+};
+
+Int_t IoGetBackend(void);
+const char* IoGetBackendName(const Int_t backend);
+Long64_t IoReadFiles(TIoFile *files, const Int_t nfiles, const Int_t backend);
+Long64_t IoReadFiles(TIoFile *files, const Int_t nfiles);
+Bool_t IoSetBackend(const Int_t backend);
+
+#endif // IOLIB_H
@@ -0,0 +1,277 @@
+#include "loglib.h"
+
+//
+// The log sink: the messages of the analyses are queued as records,
+// each with its time, severity and the HIC and activity being analyzed
+// by the thread which wrote it, and a writer thread appends them to the
+// log file in batches, so that no worker waits for the disk
+//
+
+// The printable name of each severity
+static const char* logSeverityName[3] = {"INFO", "WARNING", "ERROR"};
+
+// The log file and the queue of the records still to be written
+static FILE *logFile = 0;
+static std::deque<string> logQueue;
+static std::mutex logMutex;
+static std::condition_variable logWake;  // Wakes the writer thread
+static std::condition_variable logDone;  // Tells a batch was written
+static std::thread logThread;
+static Bool_t logStop = kFALSE;
+static Bool_t logFlushAsked = kFALSE;
+static Long64_t logQueued = 0;   // Records queued since the start
+static Long64_t logWritten = 0;  // Records written since the start
+
+// The HIC and activity analyzed by each thread (see LogSetActivity)
+static thread_local Int_t logHicID = -1;
+static thread_local Int_t logActID = -1;
+
+// The capture of the library output (see LogBeginCapture)
+static std::mutex logCaptureMutex;
+static Int_t logCaptureDepth = 0;
+static Int_t logSavedStdout = -1;
+
+
+void LogBeginCapture(void)
+{
+//
+// Sends what the external libraries write on stdout (e.g. the DB
+// chatter) to the log file, until the matching LogEndCapture: the
+// calls can be nested or made by several threads at once, only the
+// outermost ones redirect stdout (no reopen of the log file)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  std::lock_guard<std::mutex> lock(logCaptureMutex);
+
+  if (logCaptureDepth++ > 0 || !logFile) return;
+
+  fflush(stdout);
+  logSavedStdout = dup(fileno(stdout));
+  if (logSavedStdout >= 0)
+    dup2(fileno(logFile), fileno(stdout));
+}
+
+void LogClose(void)
+{
+//
+// Writes all records still queued, stops the writer thread and closes
+// the log file (called at exit)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!logFile) return;
+
+  {
+    std::lock_guard<std::mutex> lock(logMutex);
+    logStop = kTRUE;
+  }
+  logWake.notify_one();
+  if (logThread.joinable()) logThread.join();
+
+  fclose(logFile);
+  logFile = 0;
+}
+
+void LogEndCapture(void)
+{
+//
+// Ends the capture of the library output started by LogBeginCapture
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  std::lock_guard<std::mutex> lock(logCaptureMutex);
+
+  if (logCaptureDepth == 0 || --logCaptureDepth > 0) return;
+
+  if (logSavedStdout >= 0) {
+    fflush(stdout);
+    dup2(logSavedStdout, fileno(stdout));
+    close(logSavedStdout);
+    logSavedStdout = -1;
+  }
+}
+
+void LogFlush(void)
+{
+//
+// Waits until all records queued so far are written to the log file
+// (e.g. before the file is appended to by someone else)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  std::unique_lock<std::mutex> lock(logMutex);
+
+  if (!logThread.joinable()) return;
+
+  Long64_t target = logQueued;
+  logFlushAsked = kTRUE;
+  logWake.notify_one();
+  while (logWritten < target)
+    logDone.wait(lock);
+}
+
+Bool_t LogOpen(const char *filename)
+{
+//
+// Opens the log file (in append mode) and starts the writer thread
+//
+// Inputs:
+//          filename : the log file name
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the file was opened, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  if (logFile) return kTRUE;
+
+  logFile = fopen(filename, "a");
+  if (!logFile) return kFALSE;
+
+  logStop = kFALSE;
+  logThread = std::thread(LogWriter);
+  atexit(LogClose);
+
+  return kTRUE;
+}
+
+void LogSetActivity(const Int_t hicid, const Int_t actid)
+{
+//
+// Sets the HIC and activity the calling thread is analyzing: they tag
+// all records it writes from now on (-1 for none)
+//
+// Inputs:
+//          hicid : the HIC Id
+//          actid : the activity Id
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  logHicID = hicid;
+  logActID = actid;
+}
+
+void LogWrite(const Int_t severity, const char *routine, const char *message1, const char *message2)
+{
+//
+// Queues a record for the log file: the caller does not wait for
+// the file to be written
+//
+// Inputs:
+//          severity : one of LOG_*
+//          routine  : the name of the function generating the message
+//          message1 : the actual message
+//          message2 : an optional second message
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!logFile) return;
+
+  char stamp[32];
+  time_t now = time(NULL);
+  struct tm tmNow;
+  localtime_r(&now, &tmNow);
+  strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tmNow);
+
+  char tags[48] = "";
+  if (logHicID >= 0)
+    snprintf(tags, sizeof(tags), " [hic %d act %d]", logHicID, logActID);
+
+  while (routine && *routine == '\n') routine++; // Screen layout only
+
+  string record = string(stamp) + " " + logSeverityName[severity] + tags + " "
+                + (routine ? routine : "") + ": " + (message1 ? message1 : "");
+  if (message2) record += string(" ") + message2;
+  record += "\n";
+
+  Bool_t wake;
+  {
+    std::lock_guard<std::mutex> lock(logMutex);
+    logQueue.push_back(record);
+    logQueued++;
+    wake = (logQueue.size() >= LOGQUEUEMAX);
+  }
+  if (wake) logWake.notify_one();
+}
+
+void LogWriter(void)
+{
+//
+// The writer thread: every LOGFLUSHMS milliseconds, or earlier if
+// the queue is long or a flush was asked, writes all queued records
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  std::deque<string> batch;
+  std::unique_lock<std::mutex> lock(logMutex);
+
+  while (kTRUE) {
+    if (!logStop && !logFlushAsked && logQueue.size() < LOGQUEUEMAX)
+      logWake.wait_for(lock, std::chrono::milliseconds(LOGFLUSHMS));
+
+    batch.swap(logQueue);
+    Long64_t upto = logQueued;
+    Bool_t stop = logStop;
+    logFlushAsked = kFALSE;
+    lock.unlock();
+
+    for (UInt_t i = 0; i < batch.size(); i++)
+      fputs(batch[i].c_str(), logFile);
+    fflush(logFile);
+    batch.clear();
+
+    lock.lock();
+    logWritten = upto;
+    logDone.notify_all();
+    if (stop && logQueue.empty()) break;
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef LOGLIB_H
+#define LOGLIB_H
+
+#include <Rtypes.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+using std::string;
+
+// The severity of a log record
+#define LOG_INFO    0
+#define LOG_WARNING 1
+#define LOG_ERROR   2
+
+// The writer thread flushes the records at least this often (in ms)
+// or as soon as this many of them are waiting
+#define LOGFLUSHMS  200
+#define LOGQUEUEMAX 256
+
+void LogBeginCapture(void);
+void LogClose(void);
+void LogEndCapture(void);
+void LogFlush(void);
+Bool_t LogOpen(const char *filename);
+void LogSetActivity(const Int_t hicid, const Int_t actid);
+void LogWrite(const Int_t severity, const char *routine, const char *message1, const char *message2=0);
+void LogWriter(void);
+
+#endif // LOGLIB_H
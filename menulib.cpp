@@ -9,11 +9,13 @@ int menuSize;
 
 string versubver;
 
-fpos_t posStdout, posStderr;
-int fdStdout, fdStderr;
+fpos_t posStderr;
+int fdStderr;
 
 char* logfilename;
 
+bool batchMode = false; // No user interaction (e.g. in watch mode)
+
 const char* menuEntries[NUMENTRIES+1] = {
   "Read data for single IB HIC",
   "Read data for single OB HIC",
@@ -37,6 +39,7 @@ void createLogFileName(char* progname)
 //
 // Created:      20 Sep 2018  Mario Sitta
 // Updated:      26 Apr 2019  Mario Sitta  Print version number
+// Updated:      19 Oct 2026  Log sink opened
 //
 
   const int pgname_len = strlen(progname);
@@ -57,6 +60,9 @@ void createLogFileName(char* progname)
   FILE* logfile = fopen(logfilename, "a");
   fprintf(logfile, "dataComp Version %s\n", versubver.c_str());
   fclose(logfile);
+
+  // From now on the messages are also written to the log file
+  LogOpen(logfilename);
 }
 
 void createMainMenu(const bool color)
@@ -221,7 +227,10 @@ void f12ToExit(void)
 // Return:
 //
 // Created:      26 Sep 2018  Mario Sitta
+// Updated:      19 Oct 2026  Do not wait in batch mode
 //
+  if (batchMode) return;
+
 #ifdef USENCURSES
   mvprintw(LINES - 2, 0, "F12 to exit");
   while(getch() != KEY_F(12));
@@ -232,6 +241,24 @@ void f12ToExit(void)
 #endif
 }
 
+const char* getLogFileName(void)
+{
+//
+// Returns the name of the log file
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//            the log file name (null if not yet created)
+//
+// Created:      19 Oct 2026
+//
+
+  return logfilename;
+}
+
 #ifdef USENCURSES
 WINDOW* getMenuWindow(void)
 {
@@ -296,7 +323,7 @@ void menuTitle(WINDOW *win, int starty, int startx, int width, const char *strin
 }
 #endif
 
-void printMessage(const char *routine, const char *message1, const char *message2)
+void printMessage(const char *routine, const char *message1, const char *message2, const Int_t severity)
 {
 //
 // Prints an error message
@@ -305,6 +332,7 @@ void printMessage(const char *routine, const char *message1, const char *message
 //            routine  : the name of the function generating the message
 //            message1 : the actual message (mandatory)
 //            message2 : an optional second message
+//            severity : the severity of the message (one of LOG_*)
 //
 // Outputs:
 //
@@ -312,8 +340,11 @@ void printMessage(const char *routine, const char *message1, const char *message
 //
 // Created:      27 Sep 2018  Mario Sitta
 // Updated:      25 Oct 2018  Mario Sitta
+// Updated:      19 Oct 2026  Queued to the log sink, severity given
 //
  
+  LogWrite(severity, routine, message1, message2);
+
 #ifdef USENCURSES
   if (message2 == 0)
     printw("%s: %s\n", routine, message1);
@@ -443,28 +474,6 @@ void redirectStderr(void)
 
 }
 
-void redirectStdout(void)
-{
-//
-// Redirects stdout to file to avoid mangling the menu screen
-//
-// Inputs:
-//
-// Outputs:
-//
-// Return:
-//
-// Created:      20 Sep 2018  Mario Sitta
-//
-
-  // Redirect to file but keep memory of current stdout position
-  fflush(stdout);
-  fgetpos(stdout, &posStdout);
-  fdStdout = dup(fileno(stdout));
-  freopen(logfilename, "a", stdout);
-
-}
-
 #ifdef USENCURSES
 void refreshMenu(void)
 {
@@ -507,26 +516,23 @@ void restoreStderr(void)
 
 }
 
-void restoreStdout(void)
+void setBatchMode(const bool batch)
 {
 //
-// Restores stdout to screen after redirection to file
+// Sets the batch mode, where the program does not wait for the user
+// at the end of an analysis
 //
 // Inputs:
+//            batch : the batch flag
 //
 // Outputs:
 //
 // Return:
 //
-// Created:      20 Sep 2018  Mario Sitta
+// Created:      19 Oct 2026
 //
 
-  // Flush file and restore stdout
-  fflush(stdout);
-  dup2(fdStdout, fileno(stdout));
-  close(fdStdout);
-  clearerr(stdout);
-  fsetpos(stdout, &posStdout);
+  batchMode = batch;
 
 }
 
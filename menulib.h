@@ -10,6 +10,7 @@
 #include <iostream>
 #include <string>
 #include "analysislib.h"
+#include "loglib.h"
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
 
@@ -20,12 +21,12 @@ void createMainMenu(const bool color=false);
 void createLogFileName(char* progname);
 void exitFromMenu(void);
 void f12ToExit(void);
-void printMessage(const char *routine, const char *message1, const char *message2=0);
+const char* getLogFileName(void);
+void printMessage(const char *routine, const char *message1, const char *message2=0, const Int_t severity=LOG_INFO);
 void readMenuEntry(void);
 void redirectStderr(void);
-void redirectStdout(void);
 void restoreStderr(void);
-void restoreStdout(void);
+void setBatchMode(const bool batch);
 void setVersionNumber(const int version, const int subversion);
 #ifdef USENCURSES
 void clearScreen(WINDOW* win, const int ywin);
@@ -7,14 +7,30 @@
 static UShort_t regioNum;
 static UShort_t doubNum;
 static UShort_t address;
+static UShort_t colNum;
+static UShort_t rowNum;
+static UInt_t   numHits;
 UInt_t   noisePixTotal;
 Double_t noiseOccTotal;
 UInt_t   noisePixels[NUMCHIPS];
 Double_t noiseOccup[NUMCHIPS];
 Int_t    classificNoiseScan;
 
+// Local variables of the pixel map tree (see CreateTreeNoiseScanMap)
+static Int_t    noisyNum;
+static std::vector<UInt_t> noisyPix;
+static std::vector<UInt_t> noisyHits;
 
-void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType)
+// The trees of each activity type (see MergeShardRootFiles)
+static const TActTreeNames noiseScanTreeNames[] = {
+  {ACTMASK_QUALIF, "hicQualTree", 0, "hicQualResTree"},
+  {ACTMASK_RECEPT, "hicRecpTree", 0, "hicRecpResTree"},
+  {ACTMASK_HALFST, "hicHSTree", 0, "hicHSResTree"},
+  {ACTMASK_STAVET, "hicStaveTree", 0, "hicStaveResTree"}
+};
+
+
+void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType)
 {
 //
 // Steering routine to analyze the data of all Noise Scans for all HICs
@@ -32,22 +48,21 @@ void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList
 // Created:      05 Feb 2019  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
 // Updated:      17 Sep 2019  Mario Sitta  HIC name added
+// Updated:      19 Oct 2026  Append in place, checkpoints, noisy pixel maps
 //
 
   // We need to define here the TTree's for the existing ROOT file
   TTree *oldHicQualTree = 0, *oldHicRecpTree = 0, *oldHicHSTree = 0, *oldHicStaveTree = 0;
   TTree *oldHicQualResTree = 0, *oldHicRecpResTree = 0, *oldHicHSResTree = 0, *oldHicStaveResTree = 0;
-  TTree *oldActFastListTree = 0;
+  TTree *oldActFastListTree = 0, *oldPixMapTree = 0;
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeAllNoiseScans","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeAllNoiseScans","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Check whether the ROOT file already exists
   // If yes, ask the user whether to use it or redo a new one
   TString rootFileName;
@@ -55,21 +70,30 @@ void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList
     rootFileName = "IBHIC_NoiseScan_AllHICs.root";
   else
     rootFileName = "OBHIC_NoiseScan_AllHICs.root";
+  rootFileName = ShardRootFileName(rootFileName);
 
   redoFromStart = kTRUE;
+  appendToFile = kFALSE;
+  TString oldRootFileName; // Set if the activities are copied from it
   if(CheckRootFileExists(rootFileName)) {
-    if(AskUserRedoScan() == 2) { // User chose to re-use existing tree
+    Int_t userChoice = AskUserRedoScan();
+    if(userChoice == 3) { // User chose to append to existing trees
+      appendToFile = kTRUE;
+      // A resumed run goes on copying from the old file, if it did
+      if(CheckpointOldFile(rootFileName, oldRootFileName))
+        userChoice = 2;
+    }
+    if(userChoice == 2) { // User chose to re-use existing tree
       redoFromStart = kFALSE;
-      TString oldRootFileName;
-      if(!RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
-        printMessage("\nanalyzeAllNoiseScans","Error: error renaming existing ROOT file");
+      if(!appendToFile && !RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
+        printMessage("\nanalyzeAllNoiseScans","Error: error renaming existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
 
       TFile *oldNoisescanFile = OpenRootFile(oldRootFileName);
       if(!oldNoisescanFile) {
-        printMessage("\nanalyzeAllNoiseScans","Error: error opening existing ROOT file");
+        printMessage("\nanalyzeAllNoiseScans","Error: error opening existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -86,10 +110,12 @@ void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList
 
       oldActFastListTree = ReadHicActListTreeNS(oldNoisescanFile);
 
+      oldPixMapTree = ReadNoiseScanTreeMap("pixMapTree",oldNoisescanFile); // Can be missing
+
       if(!oldHicQualTree || !oldHicRecpTree || !oldHicHSTree || !oldHicStaveTree ||
          !oldHicQualResTree || !oldHicRecpResTree || !oldHicHSResTree || !oldHicStaveResTree ||
          !oldActFastListTree) {
-        printMessage("\nanalyzeAllNoiseScans","Error: error reading trees from existing ROOT file");
+        printMessage("\nanalyzeAllNoiseScans","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -97,41 +123,94 @@ void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList
   } // if(CheckRootFileExists())
 
   // Open the ROOT file
-  TFile *newNoisescanFile = OpenRootFile(rootFileName, kTRUE);
+  TFile *newNoisescanFile = OpenRootFile(rootFileName, !appendToFile, appendToFile);
 
   if(!newNoisescanFile) {
-    printMessage("\nanalyzeAllNoiseScans","Error: error opening new ROOT file");
+    printMessage("\nanalyzeAllNoiseScans","Error: error opening new ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   // Create or read the trees
-  TTree *hicQualTree = CreateTreeNoiseScan("hicQualTree","HicQualificationTest");
-  TTree *hicRecpTree = CreateTreeNoiseScan("hicRecpTree","HicReceptionTest");
-  TTree *hicHSTree = CreateTreeNoiseScan("hicHSTree","HicHalfStaveTest");
-  TTree *hicStaveTree = CreateTreeNoiseScan("hicStaveTree","HicStaveTest");
+  TTree *hicQualTree = SetupNoiseScanTree("hicQualTree","HicQualificationTest",newNoisescanFile);
+  TTree *hicRecpTree = SetupNoiseScanTree("hicRecpTree","HicReceptionTest",newNoisescanFile);
+  TTree *hicHSTree = SetupNoiseScanTree("hicHSTree","HicHalfStaveTest",newNoisescanFile);
+  TTree *hicStaveTree = SetupNoiseScanTree("hicStaveTree","HicStaveTest",newNoisescanFile);
 
-  TTree *hicQualResTree = CreateTreeNoiseScanResult("hicQualResTree","HicQualificationTestResults");
-  TTree *hicRecpResTree = CreateTreeNoiseScanResult("hicRecpResTree","HicReceptionTestResults");
-  TTree *hicHSResTree = CreateTreeNoiseScanResult("hicHSResTree","HicHalfStaveTestResults");
-  TTree *hicStaveResTree = CreateTreeNoiseScanResult("hicStaveResTree","HicStaveTestResults");
+  TTree *hicQualResTree = SetupNoiseScanTreeResult("hicQualResTree","HicQualificationTestResults",newNoisescanFile);
+  TTree *hicRecpResTree = SetupNoiseScanTreeResult("hicRecpResTree","HicReceptionTestResults",newNoisescanFile);
+  TTree *hicHSResTree = SetupNoiseScanTreeResult("hicHSResTree","HicHalfStaveTestResults",newNoisescanFile);
+  TTree *hicStaveResTree = SetupNoiseScanTreeResult("hicStaveResTree","HicStaveTestResults",newNoisescanFile);
 
-  TTree *actFastListTree = CreateHicActListTreeNS();
+  TTree *actFastListTree = SetupHicActListTreeNS(newNoisescanFile);
+
+  TTree *pixMapTree = SetupNoiseScanTreeMap("pixMapTree","HicNoisyPixelMaps",newNoisescanFile);
+
+  if(!hicQualTree || !hicRecpTree || !hicHSTree || !hicStaveTree ||
+     !hicQualResTree || !hicRecpResTree || !hicHSResTree || !hicStaveResTree ||
+     !actFastListTree || !pixMapTree) { // Only possible when reading from file
+    printMessage("\nanalyzeAllNoiseScans","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
+
+  // When appending, index the activities already in the file with their
+  // DB fingerprint, so that the unchanged ones are skipped and the changed
+  // ones are replaced (see AddChangedActivity)
+  std::map<ULong64_t, ULong64_t> actIndex;
+  if(appendToFile)
+    for (Long64_t j = 0; j < actFastListTree->GetEntries(); j++) {
+      actDbFingerprint = 0; // Not in files written before fingerprints
+      actFastListTree->GetEntry(j);
+      actIndex[ActivityKey(hicID, actID)] = actDbFingerprint;
+    }
+
+  // The trees are saved together every CHECKPOINTMIN minutes, so that
+  // a broken run can be resumed after the last HIC saved (--resume)
+  TTree *ckptTrees[] = {hicQualTree, hicRecpTree, hicHSTree, hicStaveTree, hicQualResTree,
+                         hicRecpResTree, hicHSResTree, hicStaveResTree, actFastListTree,
+                         pixMapTree};
+  UInt_t firstComp = CheckpointBegin(newNoisescanFile, ckptTrees, sizeof(ckptTrees)/sizeof(TTree*), componentList, oldRootFileName);
 
   // Loop on all components
   int totHICAnal = 0, totActAnal = 0;
+  Double_t perfStart;
   std::vector<ComponentDB::compActivity> tests;
   std::vector<ComponentDB::componentShort>::iterator iComp;
-  for (iComp = componentList.begin(); iComp != componentList.end(); iComp++) {
+  for (iComp = componentList.begin() + firstComp; iComp != componentList.end(); iComp++) {
     ComponentDB::componentShort comp = *iComp;
-    DbGetAllTests (db, comp.ID, tests, STNoise, true);
+    perfStart = PerfNow();
+    DbLibGetAllTests (db, comp.ID, tests, STNoise, true);
+    PerfAddSample(PERF_DBLIST, PerfNow() - perfStart);
+
+    // In watch mode a HIC whose activities did not change since the last
+    // poll is not looked at again
+    if(appendToFile && !WatchHicChanged(comp.ID, tests)) {
+      PerfCount(PERF_NHICSKIP);
+      continue;
+    }
 
     // Loop on all activities
     std::vector<ComponentDB::compActivity>::iterator it;
     for(it = tests.begin(); it != tests.end(); it++) {
       ComponentDB::compActivity act = *it;
       ActivityDB::activityLong actLong;
-      activityDB->Read(act.ID, &actLong);
+      perfStart = PerfNow();
+      DbLibReadActivity(db, act.ID, &actLong);
+      PerfAddSample(PERF_DBREAD, PerfNow() - perfStart);
+
+      // Already in file: skipped if unchanged, otherwise the file is
+      // rewritten afterwards to replace its entries
+      std::map<ULong64_t, ULong64_t>::iterator stored;
+      if(appendToFile &&
+         (stored = actIndex.find(ActivityKey(comp.ID, act.ID))) != actIndex.end()) {
+        if(stored->second != 0 && stored->second != ActivityDBFingerprint(actLong)) {
+          AddChangedActivity();
+          PerfCount(PERF_NACTCHANGED);
+        } else
+          PerfCount(PERF_NACTSKIP);
+        continue;
+      }
 
       TTree *testree = 0, *resultree = 0;
       TTree *oldtestree = 0, *oldresultree = 0;
@@ -172,18 +251,32 @@ void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList
 
       if (!testree) continue; // Not a Qualification/Reception/HS/Stave test
 
+      // The fingerprints tell whether the activity changed since it was
+      // stored in the old file (if so it is reprocessed, not copied): the
+      // EOS directory is looked for only if the DB data changed
+      Bool_t inOldFile = kFALSE;
+      ULong64_t oldDbFinger = 0, oldFinger = 0;
       if(!redoFromStart)
-        if(FindActivityInNoiseScanTree(oldActFastListTree, comp.ID, act.ID, actMask)) {
-          printMessage("\nanalyzeAllNoiseScans", "Activity already in file, copying trees ", actLong.Name.c_str());
-          CopyNoiseScanOldToNew(comp.ID, act.ID, testree, resultree, oldtestree, oldresultree);
-          actFastListTree->Fill();
-          continue;
-        }
-
-      string eosPath = FindEOSPath(actLong, hicType);
+        inOldFile = FindActivityInNoiseScanTree(oldActFastListTree, comp.ID, act.ID, actMask, oldDbFinger, oldFinger);
+
+      string eosPath;
+      Bool_t copyOld = CopyOldActivity(actLong, hicType, inOldFile, oldDbFinger, oldFinger, eosPath);
+      actDbFingerprint = oldDbFinger;
+      actFingerprint = oldFinger;
+
+      if(copyOld) {
+        printMessage("\nanalyzeAllNoiseScans", "Activity already in file, copying trees ", actLong.Name.c_str());
+        CopyNoiseScanOldToNew(comp.ID, act.ID, testree, resultree, oldtestree, oldresultree);
+        CopyNoiseScanMapOldToNew(comp.ID, act.ID, pixMapTree, oldPixMapTree);
+        actFastListTree->Fill();
+        PerfCount(PERF_NACTCOPY);
+        continue;
+      }
+
       if(eosPath.length() == 0) { // No valid path found on EOS
         string hicAct = actLong.Name + " " + actLong.Type.Name;
-        printMessage("\nanalyzeAllNoiseScans", "EOS for this activity does not exists", hicAct.c_str());
+        printMessage("\nanalyzeAllNoiseScans", "EOS for this activity does not exists", hicAct.c_str(), LOG_WARNING);
+        PerfCount(PERF_NEOSMISS);
         continue;
       }
 
@@ -193,45 +286,51 @@ void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList
 
       strncpy(hicName, comp.ComponentID.c_str(), HICNAMELEN-1);
 
-      NoiseScanAllChips(testree, actLong, comp.ID, act.ID, eosPath);
+      NoiseScanAllChips(testree, actLong, comp.ID, act.ID, eosPath, hicType, pixMapTree);
       NoiseScanResults(resultree, actLong, comp.ID, act.ID, eosPath, hicType);
 
       Long64_t prevTestOffset = testree->GetEntries();
       Long64_t prevTestResOffset = resultree->GetEntries();
 
-      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset)
-        printMessage("\nanalyzeAllNoiseScans", "Trees not filled for activity ", actLong.Name.c_str());
-      else
+      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset) {
+        printMessage("\nanalyzeAllNoiseScans", "Trees not filled for activity ", actLong.Name.c_str(), LOG_WARNING);
+        PerfCount(PERF_NNOTFILLED);
+      } else
         actFastListTree->Fill();
 
       totActAnal++;
+      PerfCount(PERF_NACTANAL);
       cout << ".";
       fflush(stdout);
 
     }
     totHICAnal++;
+    PerfCount(PERF_NHICS);
     if(totHICAnal%50 == 0) cout << totHICAnal;
     fflush(stdout);
     if(totHICAnal%50 == 0) { // Renew the db credentials
-      db = 0;
+      DbLibDisconnect(db);
       db = initAlpideDB();
-      activityDB = 0;
-      activityDB = new ActivityDB(db);
     }
+    CheckpointCommit(comp.ID);
   }
 
 
   // Close the ROOT file and exit
-  hicQualTree->Write();
-  hicRecpTree->Write();
-  hicHSTree->Write();
-  hicStaveTree->Write();
-  hicQualResTree->Write();
-  hicRecpResTree->Write();
-  hicHSResTree->Write();
-  hicStaveResTree->Write();
-  actFastListTree->Write();
+  CheckpointEnd();
+  perfStart = PerfNow();
+  hicQualTree->Write("", TObject::kOverwrite);
+  hicRecpTree->Write("", TObject::kOverwrite);
+  hicHSTree->Write("", TObject::kOverwrite);
+  hicStaveTree->Write("", TObject::kOverwrite);
+  hicQualResTree->Write("", TObject::kOverwrite);
+  hicRecpResTree->Write("", TObject::kOverwrite);
+  hicHSResTree->Write("", TObject::kOverwrite);
+  hicStaveResTree->Write("", TObject::kOverwrite);
+  actFastListTree->Write("", TObject::kOverwrite);
+  pixMapTree->Write("", TObject::kOverwrite);
   CloseRootFile(newNoisescanFile);
+  PerfAddSample(PERF_WRITE, PerfNow() - perfStart, PerfFileSize(rootFileName.Data()));
 
 #ifdef USENCURSES
   mvprintw(LINES-4, 0, "\n ROOT file %s filled with %d activities\n", rootFileName.Data(), totActAnal);
@@ -260,24 +359,23 @@ void analyzeNoiseScan(const int hicid, const ComponentDB::compActivity act, Alpi
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
 // Updated:      06 Jun 2019  Mario Sitta  Get rid of timestamp from act name
 // Updated:      17 Sep 2019  Mario Sitta  HIC name added
+// Updated:      19 Oct 2026  DB access layer used, noisy pixel maps added
 //
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeNoiseScan","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeNoiseScan","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Get the proper path to the Digital Scan result files
   ActivityDB::activityLong actLong;
-  activityDB->Read(act.ID, &actLong);
+  DbLibReadActivity(db, act.ID, &actLong);
 
   string eosPath = FindEOSPath(actLong, hicType);
   if (eosPath == "") {
-    printMessage("\nanalyzeNoiseScan","Error: no valid EOS path found");
+    printMessage("\nanalyzeNoiseScan","Error: no valid EOS path found", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -299,7 +397,7 @@ void analyzeNoiseScan(const int hicid, const ComponentDB::compActivity act, Alpi
 
   TFile *noisescanFile = OpenRootFile(rootFileName, kTRUE);
   if (!noisescanFile) {
-    printMessage("\nanalyzeNoiseScan","Error: error opening the ROOT file");
+    printMessage("\nanalyzeNoiseScan","Error: error opening the ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -307,14 +405,21 @@ void analyzeNoiseScan(const int hicid, const ComponentDB::compActivity act, Alpi
   // Create the trees
   TTree *noisescanTree = CreateTreeNoiseScan("noisescanTree","NoiseScanTree");
   if (!noisescanTree) {
-    printMessage("\nanalyzeNoiseScan","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeNoiseScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   TTree *noiseresulTree = CreateTreeNoiseScanResult("noiseresulTree","NoiseScanResulTree");
   if (!noiseresulTree) {
-    printMessage("\nanalyzeNoiseScan","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeNoiseScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
+
+  TTree *noisemapTree = CreateTreeNoiseScanMap("noisemapTree","NoiseScanMapTree");
+  if (!noisemapTree) {
+    printMessage("\nanalyzeNoiseScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -322,19 +427,21 @@ void analyzeNoiseScan(const int hicid, const ComponentDB::compActivity act, Alpi
   // Get the name of the HIC
   int componentTypeId;
   if (hicType == HIC_IB)
-    componentTypeId = DbGetComponentTypeId (db, "Inner Barrel HIC Module");
+    componentTypeId = DbLibGetComponentTypeId (db, "Inner Barrel HIC Module");
   else
-    componentTypeId = DbGetComponentTypeId (db, "Outer Barrel HIC Module");
-  string hicNameStr = DbGetComponentName(db, componentTypeId, hicid);
+    componentTypeId = DbLibGetComponentTypeId (db, "Outer Barrel HIC Module");
+  string hicNameStr = DbLibGetComponentName(db, componentTypeId, hicid);
   strncpy(hicName, hicNameStr.c_str(), HICNAMELEN-1);
 
   // Fill the trees for all chips
-  NoiseScanAllChips(noisescanTree, actLong, hicid, act.ID, eosPath);
+  actMask = 0; // Unknown type, not needed here
+  NoiseScanAllChips(noisescanTree, actLong, hicid, act.ID, eosPath, hicType, noisemapTree);
   NoiseScanResults(noiseresulTree, actLong, hicid, act.ID, eosPath, hicType);
 
   // Close the ROOT file and exit
   noisescanTree->Write();
   noiseresulTree->Write();
+  noisemapTree->Write();
   CloseRootFile(noisescanFile);
 
 #ifdef USENCURSES
@@ -346,6 +453,138 @@ void analyzeNoiseScan(const int hicid, const ComponentDB::compActivity act, Alpi
 
 }
 
+void mergeAllNoiseScans(const int nshards, const THicType hicType)
+{
+//
+// Steering routine to merge the files produced by the shard jobs
+// of Noise Scans into a single file
+//
+// Inputs:
+//          nshards : the number of shards
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const char *extraNames[] = {"pixMapTree"};
+
+  MergeAllShardFiles("NoiseScan", nshards, hicType, noiseScanTreeNames, sizeof(noiseScanTreeNames)/sizeof(noiseScanTreeNames[0]), extraNames, 1);
+}
+
+void sortAllNoiseScans(const THicType hicType)
+{
+//
+// Steering routine to sort the pixel trees of the file of all
+// Noise Scans on the key chosen with SetPixelSortKey
+//
+// Inputs:
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TString rootFileName, sortedName;
+  if (hicType == HIC_IB)
+    rootFileName = "IBHIC_NoiseScan_AllHICs.root";
+  else
+    rootFileName = "OBHIC_NoiseScan_AllHICs.root";
+
+  if (SortPixelRootFile(rootFileName, noiseScanTreeNames, sizeof(noiseScanTreeNames)/sizeof(noiseScanTreeNames[0]), sortedName)) {
+#ifdef USENCURSES
+    mvprintw(LINES-4, 0, "\n Pixel trees of %s sorted into %s\n", rootFileName.Data(), sortedName.Data());
+#else
+    printf("\n\n Pixel trees of %s sorted into %s\n", rootFileName.Data(), sortedName.Data());
+#endif
+  } else
+    printMessage("\nsortAllNoiseScans","Error: error sorting the pixel trees", 0, LOG_ERROR);
+
+  f12ToExit();
+}
+
+static void AllocNoiseScanMaps(void)
+{
+//
+// Allocates the arrays of the pixel map tree, only once
+// so that the addresses the branches point to never change
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (noisyPix.size() == 0) {
+    noisyPix.resize(PIXPACKSIZE);
+    noisyHits.resize(PIXPACKSIZE);
+  }
+}
+
+void CopyNoiseScanMapOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newmap, TTree *oldmap)
+{
+//
+// Copies the noisy pixel maps of a given activity from the old tree to
+// the new tree (they have no offset in the actFastListTree, so the
+// first entry of each activity in the old tree is indexed the first time)
+//
+// Inputs:
+//          hicid  : the HIC Id
+//          actid  : the Activity Id
+//          newmap : the new pixel map tree
+//          oldmap : the old pixel map tree (can be missing in old files)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  // The index is rebuilt when another tree is given, or the same
+  // address is reused by the tree of a later file (seen by its size)
+  static TTree *indexTree = 0;
+  static Long64_t indexEntries = -1;
+  static std::map<ULong64_t, Long64_t> firstEntry;
+
+  if (!oldmap) return;
+
+  Long64_t currEntries = oldmap->GetEntries();
+  if (oldmap != indexTree || currEntries != indexEntries) {
+    firstEntry.clear();
+    for (Long64_t j = 0; j < currEntries; j++) {
+      oldmap->GetEntry(j);
+      firstEntry.insert(std::make_pair(ActivityKey(hicID, actID), j));
+    }
+    indexTree = oldmap;
+    indexEntries = currEntries;
+  }
+
+  std::map<ULong64_t, Long64_t>::iterator it = firstEntry.find(ActivityKey(hicid, actid));
+  if (it != firstEntry.end()) {
+    Long64_t j = it->second;
+    oldmap->GetEntry(j); // Get the first entry, then loop
+    while(hicID == hicid && actID == actid && j < currEntries) {
+      newmap->Fill();
+      j++;
+      oldmap->GetEntry(j);
+    }
+  }
+
+  // Reset values (to fill new activity tree) then exit
+  hicID = hicid;
+  actID = actid;
+}
+
 void CopyNoiseScanOldToNew(const UInt_t hicid, const UInt_t actid,
 			   TTree *newscan, TTree *newres,
 			   TTree *oldscan, TTree *oldres)
@@ -366,6 +605,7 @@ void CopyNoiseScanOldToNew(const UInt_t hicid, const UInt_t actid,
 // Return:
 //
 // Created:      18 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Pixel column, row and hits added
 //
 
   // Save current values (they were filled by FindActivityInNoiseScanTree
@@ -376,11 +616,19 @@ void CopyNoiseScanOldToNew(const UInt_t hicid, const UInt_t actid,
   testOffset = newscan->GetEntries();
   testResOffset = newres->GetEntries();
 
-  // Copy scan data from old tree to new tree
+  // Copy scan data from old tree to new tree (the pixel position
+  // is decoded again, since it is missing in older files, and so
+  // is the number of hits)
+  Bool_t oldHasHits = (oldscan->GetBranch("numHits") != 0);
+  Int_t col, row;
   Long64_t currEntries = oldscan->GetEntries();
   Int_t i = 0;
   oldscan->GetEntry(offsetest + i); // Get the first entry, then loop
   while(hicID == hicid && actID == actid && (offsetest + i) < currEntries) {
+    DecodeAlpideAddress(regioNum, doubNum, address, col, row);
+    colNum = col;
+    rowNum = row;
+    if (!oldHasHits) numHits = 0;
     newscan->Fill();
     i++;
     oldscan->GetEntry(offsetest + i);
@@ -418,6 +666,7 @@ TTree* CreateHicActListTreeNS(void)
 //
 // Created:      27 Nov 2018  Mario Sitta
 // Updated:      18 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newTree = 0;
@@ -429,6 +678,8 @@ TTree* CreateHicActListTreeNS(void)
     newTree->Branch("actMask", &actMask, "actMask/s");
     newTree->Branch("actOffs", &testOffset, "testOffset/L");
     newTree->Branch("actResOff", &testResOffset, "testResOffset/L");
+    newTree->Branch("actFinger", &actFingerprint, "actFingerprint/l");
+    newTree->Branch("actDbFinger", &actDbFingerprint, "actDbFingerprint/l");
   }
 
   return newTree;
@@ -452,6 +703,7 @@ TTree* CreateTreeNoiseScan(TString treeName, TString treeTitle)
 // Updated:      17 Sep 2019  Mario Sitta  HIC name added
 // Updated:      19 Sep 2019  Mario Sitta  numHits changed to UInt
 // Updated:      19 Sep 2019  Mario Sitta  Bug fix in reading NoisyPixels file
+// Updated:      19 Oct 2026  Pixel column, row and hits added
 //
 
   TTree *newTree = 0;
@@ -467,6 +719,47 @@ TTree* CreateTreeNoiseScan(TString treeName, TString treeTitle)
     newTree->Branch("region", &regioNum, "regioNum/s");
     newTree->Branch("doubcol", &doubNum, "doubNum/s");
     newTree->Branch("address", &address, "address/s");
+    newTree->Branch("colNum", &colNum, "colNum/s");
+    newTree->Branch("rowNum", &rowNum, "rowNum/s");
+    newTree->Branch("numHits", &numHits, "numHits/i");
+  }
+
+  return newTree;
+}
+
+TTree* CreateTreeNoiseScanMap(TString treeName, TString treeTitle)
+{
+//
+// Creates a tree for the Noise Scan pixel maps: one entry per chip
+// and condition, with the noisy pixels (row*1024+col) of the chip in
+// increasing order and their number of hits (0 if not known)
+//
+// Inputs:
+//          treeName  : the tree name
+//          treeTitle : the tree title
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created ROOT tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newTree = 0;
+  newTree = new TTree(treeName.Data(), treeTitle.Data());
+
+  if(newTree) {
+    AllocNoiseScanMaps();
+    newTree->Branch("hicName", hicName, "hicName[13]/B");
+    newTree->Branch("hicID", &hicID, "hicID/i");
+    newTree->Branch("actID", &actID, "actID/i");
+    newTree->Branch("actMask", &actMask, "actMask/s");
+    newTree->Branch("condVB", &condVB, "condVB/b");
+    newTree->Branch("chipNum", &chipNum, "chipNum/b");
+    newTree->Branch("noisyNum", &noisyNum, "noisyNum/I");
+    newTree->Branch("noisyPix", &noisyPix[0], "noisyPix[noisyNum]/i");
+    newTree->Branch("noisyHits", &noisyHits[0], "noisyHits[noisyNum]/i");
   }
 
   return newTree;
@@ -537,7 +830,7 @@ TTree* CreateTreeNoiseScanResult(TString treeName, TString treeTitle)
   return newTree;
 }
 
-void NoiseScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath)
+void NoiseScanAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType, TTree *maptree)
 {
 //
 // Loops on chips and fills the tree for the given activity
@@ -548,14 +841,22 @@ void NoiseScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int
 //          hicid   : the HIC id
 //          actid   : the activity id
 //          eospath : the input file path on EOS
+//          hicType : the HIC type (IB or OB)
+//          maptree : the pixel map tree to be filled (if any)
 //
 // Outputs:
 //
 // Return:
 //
 // Created:      03 Feb 2019  Mario Sitta
+// Updated:      19 Oct 2026  Noisy pixel maps added
 //
 
+  // A new activity: the strings of the previous one are released
+  // and the messages are tagged with it
+  ArenaReset();
+  LogSetActivity(hicid, actid);
+
   hicID = hicid;
   actID = actid;
   locID = actlong.Location.ID;
@@ -570,13 +871,13 @@ void NoiseScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int
     bool masked = (code == 200);
     if(GetNoiseFileName(actlong, masked, vBB, dataName, hitsName, resultName)) {
       condVB = conds[icond];
-      FillNoiseScanTree(ftree, eospath, dataName, hitsName);
+      FillNoiseScanTree(ftree, eospath, dataName, hitsName, hicType, maptree);
     }
   }
 
 }
 
-void NoiseScanResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType)
+void NoiseScanResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType)
 {
 //
 // Fills the tree for the given activity results
@@ -595,6 +896,7 @@ void NoiseScanResults(TTree *ftree, ActivityDB::activityLong actlong, const int
 //
 // Created:      01 Feb 2019  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Arguments passed by reference, string arena
 //
 
   hicID = hicid;
@@ -631,17 +933,55 @@ void NoiseScanResults(TTree *ftree, ActivityDB::activityLong actlong, const int
 
 }
 
-Bool_t FillNoiseScanTree(TTree *tree, string path, string filepix, string filehits)
+static void FillNoiseScanMapTree(TTree *maptree, std::map<UInt_t, UInt_t> &hitmap)
 {
 //
-// Opens the NoiseHits file, if present, or the NoisyPixels file
-// and fills the tree
+// Fills the pixel map tree with the noisy pixels of all chips,
+// one entry per chip
+//
+// Inputs:
+//          maptree : the pixel map tree
+//          hitmap  : the number of hits of the pixels, indexed by
+//                    chip*2^19 + row*1024 + col (chip being the chip
+//                    number in the trees, see CHIPNUM)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  std::map<UInt_t, UInt_t>::iterator it = hitmap.begin();
+  while (it != hitmap.end()) {
+    UInt_t chip = it->first >> 19;
+    noisyNum = 0;
+    for (; it != hitmap.end() && (it->first >> 19) == chip; it++) {
+      noisyPix[noisyNum] = it->first & 0x7ffff;
+      noisyHits[noisyNum] = it->second;
+      noisyNum++;
+    }
+    chipNum = chip;
+    maptree->Fill();
+  }
+}
+
+Bool_t FillNoiseScanTree(TTree *tree, const string &path, const string &filepix, const string &filehits, const THicType hicType, TTree *maptree)
+{
+//
+// Opens the NoiseHits file, if present, and the NoisyPixels file
+// and fills the tree, with the chip Id of the files converted into the
+// chip number of the trees, the pixel position decoded into column and
+// row and the number of hits of the pixel (0 if not known), and the
+// pixel map tree, if any, with the noisy pixels of each chip
 //
 // Inputs:
 //          tree     : the pointer to the tree to be filled
 //          path     : the input file path
 //          filepix  : the NoisyPixels file name
 //          filehits : the NoiseHits file name
+//          hicType  : the HIC type (IB or OB)
+//          maptree  : the pixel map tree to be filled (if any)
 //
 // Outputs:
 //
@@ -650,32 +990,75 @@ Bool_t FillNoiseScanTree(TTree *tree, string path, string filepix, string filehi
 //
 // Created:      04 Feb 2019  Mario Sitta  Modelled on Digital Scan routine
 // Updated:      19 Sep 2019  Mario Sitta  Bug fix in reading NoisyPixels file
+// Updated:      19 Oct 2026  Timing, pixels decoded, noisy pixel maps
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfEntries = tree->GetEntries();
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
-  Int_t  ichip, region, doublecol, addr;
+  const char *fullName;
+  Int_t  ichip, inum, region, doublecol, addr;
+  Int_t  col, row, nhits;
+  std::map<UInt_t, UInt_t> hitMap; // Hits per chip*2^19 + row*1024 + col
+
+  // The files have the chip Id, the map the chip number in the trees
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
+
+  // The NoiseHits file has a line (chip, column, row, hits) for each
+  // pixel which fired: hits of the same pixel are accumulated
+  if (filehits.length() > 0) {
+    fullName = ArenaJoinPath(path, filehits);
+    infile = fopen(fullName,"r");
+    if (infile) {
+      while(fscanf(infile, "%d %d %d %d", &ichip, &col, &row, &nhits) == 4)
+        if ((inum = CHIPNUM(chipMap, ichip)) >= 0 && col >= 0 && col < 1024 && row >= 0 && row < 512)
+          hitMap[(inum << 19) + row*1024 + col] += nhits;
+      perfBytes += ftell(infile);
+      fclose(infile);
+    }
+  }
 
-  fullName = path + "/" + filepix;
-  infile = fopen(fullName.c_str(),"r");
+  fullName = ArenaJoinPath(path, filepix);
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillNoiseScanTree","Warning: cannot open input file",filepix.c_str());
+    printMessage("FillNoiseScanTree","Warning: cannot open input file",filepix.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
   while(fscanf(infile, "%d %d %d %d", &ichip, &region, &doublecol, &addr) != EOF){
-    chipNum = ichip;
+    if ((inum = CHIPNUM(chipMap, ichip)) < 0) continue; // Not a chip of this HIC
+    chipNum = inum;
     regioNum = region;
     doubNum = doublecol;
     address = addr;
+    DecodeAlpideAddress(region, doublecol, addr, col, row);
+    colNum = col;
+    rowNum = row;
+    UInt_t key = (inum << 19) + row*1024 + col;
+    std::map<UInt_t, UInt_t>::iterator it = hitMap.find(key);
+    if (it != hitMap.end())
+      numHits = it->second;
+    else {
+      numHits = 0;
+      if (maptree) hitMap[key] = 0; // Noisy pixels are in the map anyway
+    }
     tree->Fill();
   }
+  perfBytes += ftell(infile);
   fclose(infile);
 
+  if (maptree)
+    FillNoiseScanMapTree(maptree, hitMap);
+
+  PerfAddSample(PERF_FILLDATA, PerfNow() - perfStart, perfBytes,
+                tree->GetEntries() - perfEntries);
+
   return kTRUE;
 }
 
-Bool_t FillNoiseScanTreeResult(TTree *tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType)
+Bool_t FillNoiseScanTreeResult(TTree *tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType)
 {
 //
 // Opens the NoiseOccResult file and fills the tree
@@ -697,22 +1080,28 @@ Bool_t FillNoiseScanTreeResult(TTree *tree, string path, string file, ActivityDB
 // Created:      02 Feb 2019  Mario Sitta  Modelled on Digital Scan routine
 // Updated:      05 Feb 2019  Mario Sitta  Bug fix in reading registers
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Timing, chip numbering tables, parameter index
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfEntries = tree->GetEntries();
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
+  const char *fullName;
   double dvalue;
   float value, dummy;
   unsigned int reg, regval;
-  int ichip, ivalue;
+  int ichip = -1, ivalue;
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
   char *line = NULL;
   size_t len = 0;
 
-  fullName = path + "/" + file;
+  fullName = ArenaJoinPath(path, file);
 
-  infile = fopen(fullName.c_str(),"r");
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillNoiseScanTreeResult","Warning: cannot open input file",file.c_str());
+    printMessage("FillNoiseScanTreeResult","Warning: cannot open input file",file.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
@@ -860,54 +1249,42 @@ Bool_t FillNoiseScanTreeResult(TTree *tree, string path, string file, ActivityDB
     // Per-chip data
     if (strstr(line,"Analogue voltage (") && strstr(line,"start")) {
       sscanf(line, "  Analogue voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipAnalVoltStart[ichip-1] = value;
-      else
-        chipAnalVoltStart[ichip] = value; 
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipAnalVoltStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Analogue voltage (") && strstr(line,"end")) {
       sscanf(line, "  Analogue voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipAnalVoltEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipAnalVoltEnd[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"start")) {
       sscanf(line, "  Digital voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltStart[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"end")) {
       sscanf(line, "  Digital voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltEnd[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"start")) {
       sscanf(line, "  Temperature (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipTempStart[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipTempStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"end")) {
       sscanf(line, "  Temperature (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipTempEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipTempEnd[ichip] = value;
       continue;
     }
@@ -927,19 +1304,19 @@ Bool_t FillNoiseScanTreeResult(TTree *tree, string path, string file, ActivityDB
   singleChipResults:
     if (strstr(line, "Results chip")) {
       sscanf(line, "Results chip %d:", &ichip);
-      if(hicType == HIC_OB && ichip > 7) ichip--;
+      ichip = CHIPNUM(chipMap, ichip);
       continue;
     }
 
     if (strstr(line, "Noisy pixels")) {
       sscanf(line, "Noisy pixels:    %d", &ivalue);
-      noisePixels[ichip] = ivalue;
+      if (ichip >= 0) noisePixels[ichip] = ivalue;
       continue;
     }
 
     if (strstr(line, "Noise occupancy")) {
       sscanf(line, "Noise occupancy: %lf", &dvalue);
-      noiseOccup[ichip] = dvalue;
+      if (ichip >= 0) noiseOccup[ichip] = dvalue;
       continue;
     }
 
@@ -953,67 +1330,43 @@ Bool_t FillNoiseScanTreeResult(TTree *tree, string path, string file, ActivityDB
     if(reg == 0x700) {
       ichip &= 0x0f; // ichip is the lower 4 bits
       if(regStartFound) {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700Start[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700Start[ichip] = regval;
       } else {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700End[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700End[ichip] = regval;
       }
     }
 
   } // while(getline(&line, &len, infile))
 
+  perfBytes += ftell(infile);
   fclose(infile);
 
   // Now get data from DB
-  vector<ActivityDB::actParameter>  parameters = actlong.Parameters;
-
-  std::vector<ActivityDB::actParameter>::iterator loop;
-  for(loop = parameters.begin(); loop != parameters.end(); loop++) {
-    ActivityDB::actParameter actpar = *loop;
+  const TActParameters *actPars = GetActParameters(actlong);
 
-    if(actpar.Type.Parameter.Name.compare("Classification Version") == 0) {
-      classificVers = actpar.Value;
-      continue;
-    }
+  if(actPars->found[ACTPAR_VERSION])
+    classificVers = actPars->value[ACTPAR_VERSION];
 
-    if( condVB == 100 &&
-	actpar.Type.Parameter.Name.compare("Classification Noise Occupancy 0.0 V") == 0) {
-      classificNoiseScan = actpar.Value;
-      continue;
-    }
-
-    if( condVB == 103 &&
-	actpar.Type.Parameter.Name.compare("Classification Noise Occupancy 3.0 V") == 0) {
-      classificNoiseScan = actpar.Value;
-      continue;
-    }
-
-    if( condVB == 200 &&
-	actpar.Type.Parameter.Name.compare("Classification Noise Occupancy 0.0 V, masked") == 0) {
-      classificNoiseScan = actpar.Value;
-      continue;
-    }
-
-    if( condVB == 203 &&
-	actpar.Type.Parameter.Name.compare("Classification Noise Occupancy 3.0 V, masked") == 0) {
-      classificNoiseScan = actpar.Value;
-      continue;
-    }
-    
-  }
+  Int_t parNoise = -1;
+  if(condVB == 100) parNoise = ACTPAR_NOISE0;
+  if(condVB == 103) parNoise = ACTPAR_NOISE3;
+  if(condVB == 200) parNoise = ACTPAR_NOISE0M;
+  if(condVB == 203) parNoise = ACTPAR_NOISE3M;
+  if(parNoise >= 0 && actPars->found[parNoise])
+    classificNoiseScan = actPars->value[parNoise];
 
   // Fill the tree, close the file and return
   tree->Fill();
 
+  PerfAddSample(PERF_FILLRES, PerfNow() - perfStart, perfBytes,
+                tree->GetEntries() - perfEntries);
+
   return kTRUE;
 }
 
-Bool_t FindActivityInNoiseScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask)
+Bool_t FindActivityInNoiseScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger)
 {
 //
 // Finds the activity in the tree
@@ -1025,11 +1378,14 @@ Bool_t FindActivityInNoiseScanTree(TTree* listree, const UInt_t hicid, const UIn
 //          mask  : the activity mask
 //
 // Outputs:
+//          dbfinger : the DB data fingerprint stored with the activity
+//          finger   : the fingerprint stored with the activity
 //
 // Return:
 //          true if activity found
 //
 // Created:      09 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Stored fingerprints returned
 //
 
   Bool_t found = kFALSE;
@@ -1040,11 +1396,19 @@ Bool_t FindActivityInNoiseScanTree(TTree* listree, const UInt_t hicid, const UIn
   Int_t currHicId = hicID;
   Int_t currActId = actID;
   UShort_t currMask = actMask;
+  ULong64_t currDbFinger = actDbFingerprint;
+  ULong64_t currFinger = actFingerprint;
+
+  // Files written before fingerprints were introduced have no such branches
+  actDbFingerprint = 0;
+  actFingerprint = 0;
   
   Int_t nEntries = listree->GetEntries();
   for (Int_t j = 0; j < nEntries; j++) {
     listree->GetEntry(j);
     if(hicID == hicid && actID == actid && actMask == mask) {
+      dbfinger = actDbFingerprint;
+      finger = actFingerprint;
       found = kTRUE;
       break;
     }
@@ -1054,10 +1418,113 @@ Bool_t FindActivityInNoiseScanTree(TTree* listree, const UInt_t hicid, const UIn
   hicID = currHicId;
   actID = currActId;
   actMask = currMask;
+  actDbFingerprint = currDbFinger;
+  actFingerprint = currFinger;
 
   return found;
 }
 
+Bool_t GetNoiseScanMap(TTree *maptree, const UInt_t hicid, const UShort_t actmask, const UChar_t cond, const UChar_t chip, TPixMap &map, std::vector<UInt_t> *hits)
+{
+//
+// Gets the noisy pixel map of a chip from the pixel map tree, which is
+// indexed the first time (if a HIC has more activities of the same type
+// the last one in the tree is used)
+//
+// Inputs:
+//          maptree : the pixel map tree (created or read from file)
+//          hicid   : the HIC Id
+//          actmask : the activity type (one of ACTMASK_*)
+//          cond    : the test condition (condVB)
+//          chip    : the chip number (as in the trees, see CHIPNUM)
+//
+// Outputs:
+//          map  : the noisy pixels
+//          hits : if given, their number of hits (in the order given
+//                 by PixMapGetPixels)
+//
+// Return:
+//          kTRUE if the map was found, otherwise kFALSE (no noisy pixels)
+//
+// Created:      19 Oct 2026
+//
+
+  static TTree *indexTree = 0;
+  static Long64_t indexEntries = 0;
+  static std::map<ULong64_t, Long64_t> entryIndex;
+
+  PixMapClear(map);
+  if (hits) hits->clear();
+  if (!maptree) return kFALSE;
+
+  if (maptree != indexTree || maptree->GetEntries() != indexEntries) {
+    entryIndex.clear();
+    indexEntries = maptree->GetEntries();
+    for (Long64_t j = 0; j < indexEntries; j++) {
+      maptree->GetEntry(j);
+      ULong64_t key = ((ULong64_t)hicID << 32) | ((ULong64_t)actMask << 16) | (condVB << 8) | chipNum;
+      entryIndex[key] = j;
+    }
+    indexTree = maptree;
+  }
+
+  ULong64_t key = ((ULong64_t)hicid << 32) | ((ULong64_t)actmask << 16) | (cond << 8) | chip;
+  std::map<ULong64_t, Long64_t>::iterator it = entryIndex.find(key);
+  if (it == entryIndex.end()) return kFALSE;
+
+  maptree->GetEntry(it->second);
+
+  for (Int_t i = 0; i < noisyNum; i++)
+    PixMapAdd(map, noisyPix[i] & 1023, noisyPix[i] >> 10);
+  if (hits) hits->assign(noisyHits.begin(), noisyHits.begin() + noisyNum);
+
+  return kTRUE;
+}
+
+void GetNoiseScanTrendRecords(TTree *tree, const Long64_t first, const Long64_t last, const UChar_t stage, std::vector<TTrendRecord> &records)
+{
+//
+// Gets the number of hits of the noisy pixels of an activity
+// for the trend analysis (only the TRENDCOND_NOISE condition):
+// the pixels not in the tree were not noisy
+//
+// Inputs:
+//          tree    : the pixel tree (read from file)
+//          first   : the first entry of the activity
+//          last    : the entry after the last one of the activity
+//          stage   : the test stage of the tree (one of TRENDSTAGE_*)
+//
+// Outputs:
+//          records : the records of the pixels, appended
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const Bool_t decoded = (tree->GetBranch("colNum") != 0); // Missing in older files
+  Int_t col, row;
+  TTrendRecord rec;
+  rec.stage = stage;
+  rec.source = TRENDSRC_NOISE;
+  rec.value2 = 0;
+
+  for (Long64_t j = first; j < last; j++) {
+    tree->GetEntry(j);
+    if (condVB != TRENDCOND_NOISE) continue;
+    if (decoded) {
+      col = colNum;
+      row = rowNum;
+    } else {
+      DecodeAlpideAddress(regioNum, doubNum, address, col, row);
+      numHits = 0;
+    }
+    rec.pixel = TRENDPIXEL(chipNum, col, row);
+    rec.value = (numHits > 0) ? numHits : 1; // Noisy even if hits unknown
+    records.push_back(rec);
+  }
+}
+
 TTree* ReadHicActListTreeNS(TFile *rootfile)
 {
 //
@@ -1075,6 +1542,7 @@ TTree* ReadHicActListTreeNS(TFile *rootfile)
 //
 // Created:      28 Nov 2018  Mario Sitta
 // Updated:      18 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newtree = 0;
@@ -1086,6 +1554,10 @@ TTree* ReadHicActListTreeNS(TFile *rootfile)
     newtree->SetBranchAddress("actMask", &actMask);
     newtree->SetBranchAddress("actOffs", &testOffset);
     newtree->SetBranchAddress("actResOff", &testResOffset);
+    if(newtree->GetBranch("actFinger")) // Missing in older files
+      newtree->SetBranchAddress("actFinger", &actFingerprint);
+    if(newtree->GetBranch("actDbFinger")) // Ditto
+      newtree->SetBranchAddress("actDbFinger", &actDbFingerprint);
   }
 
   return newtree;
@@ -1109,6 +1581,7 @@ TTree* ReadNoiseScanTree(TString treename, TFile *rootfile)
 //
 // Created:      05 Feb 2019  Mario Sitta
 // Updated:      17 Sep 2019  Mario Sitta  HIC name added
+// Updated:      19 Oct 2026  Pixel column, row and hits added
 //
 
   TTree *newtree = 0;
@@ -1124,6 +1597,49 @@ TTree* ReadNoiseScanTree(TString treename, TFile *rootfile)
     newtree->SetBranchAddress("region", &regioNum);
     newtree->SetBranchAddress("doubcol", &doubNum);
     newtree->SetBranchAddress("address", &address);
+    if (newtree->GetBranch("colNum")) { // Missing in older files
+      newtree->SetBranchAddress( "colNum", &colNum);
+      newtree->SetBranchAddress( "rowNum", &rowNum);
+      newtree->SetBranchAddress("numHits", &numHits);
+    }
+  }
+
+  return newtree;
+}
+
+TTree* ReadNoiseScanTreeMap(TString treename, TFile *rootfile)
+{
+//
+// Reads a tree of Noise Scan pixel maps from file
+// WARNING!! We assume the rootfile was already successfully opened!
+// NO checks on file!
+//
+// Inputs:
+//          treename : the tree name
+//          rootfile : the Root file
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the read ROOT tree (0 in files older than the maps)
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newtree = 0;
+  newtree = (TTree*)rootfile->Get(treename.Data());
+
+  if(newtree) {
+    AllocNoiseScanMaps();
+    newtree->SetBranchAddress(  "hicName", hicName);
+    newtree->SetBranchAddress(    "hicID", &hicID);
+    newtree->SetBranchAddress(    "actID", &actID);
+    newtree->SetBranchAddress(  "actMask", &actMask);
+    newtree->SetBranchAddress(   "condVB", &condVB);
+    newtree->SetBranchAddress(  "chipNum", &chipNum);
+    newtree->SetBranchAddress( "noisyNum", &noisyNum);
+    newtree->SetBranchAddress( "noisyPix", &noisyPix[0]);
+    newtree->SetBranchAddress("noisyHits", &noisyHits[0]);
   }
 
   return newtree;
@@ -1260,11 +1776,12 @@ TTree* SetupHicActListTreeNS(TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateHicActListTreeNS();
   else
     newtree = ReadHicActListTreeNS(rootfile);
@@ -1288,11 +1805,12 @@ TTree* SetupNoiseScanTree(TString treename, TString treetitle, TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreeNoiseScan(treename,treetitle);
   else
     newtree = ReadNoiseScanTree(treename, rootfile);
@@ -1300,6 +1818,35 @@ TTree* SetupNoiseScanTree(TString treename, TString treetitle, TFile *rootfile)
   return newtree;
 }
 
+TTree* SetupNoiseScanTreeMap(TString treename, TString treetitle, TFile *rootfile)
+{
+//
+// Creates a new pixel map tree or reads it from file
+//
+// Inputs:
+//          treename  : the tree name
+//          treetitle : the tree title
+//          rootfile  : the (already opened) Root file
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created/read tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newtree = 0;
+
+  if(appendToFile)
+    newtree = ReadNoiseScanTreeMap(treename, rootfile);
+
+  if(!newtree) // Also when appending to a file older than the maps
+    newtree = CreateTreeNoiseScanMap(treename,treetitle);
+
+  return newtree;
+}
+
 TTree* SetupNoiseScanTreeResult(TString treename, TString treetitle, TFile *rootfile)
 {
 //
@@ -1316,11 +1863,12 @@ TTree* SetupNoiseScanTreeResult(TString treename, TString treetitle, TFile *root
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreeNoiseScanResult(treename,treetitle);
   else
     newtree = ReadNoiseScanTreeResult(treename, rootfile);
@@ -22,30 +22,44 @@
 #include "AlpideDBEndPoints.h"
 #include "THIC.h"
 #include "TScanFactory.h"
+#include "dblib.h"
+#include "perflib.h"
+#include "pixmaplib.h"
+#include "sortlib.h"
+#include "trendlib.h"
 
 #include <iostream>
+#include <map>
 #include <stdio.h>
 #include <sys/stat.h>
 
 //Bool_t redoFromStart;
 
-void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType);
+void analyzeAllNoiseScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType);
 void analyzeNoiseScan(const int hicid, const ComponentDB::compActivity act, AlpideDB *db, const THicType hicType);
+void mergeAllNoiseScans(const int nshards, const THicType hicType);
+void sortAllNoiseScans(const THicType hicType);
+void CopyNoiseScanMapOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newmap, TTree *oldmap);
 void CopyNoiseScanOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newscan, TTree *newres, TTree *oldscan, TTree *oldres);
 TTree* CreateHicActListTreeNS(void);
 TTree* CreateTreeNoiseScan(TString treeName, TString treeTitle);
+TTree* CreateTreeNoiseScanMap(TString treeName, TString treeTitle);
 TTree* CreateTreeNoiseScanResult(TString treeName, TString treeTitle);
-Bool_t FillNoiseScanTree(TTree* tree, string path, string filepix, string filehits);
-Bool_t FillNoiseScanTreeResult(TTree* tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType);
-Bool_t FindActivityInNoiseScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask);
-void NoiseScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath);
-void NoiseScanResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType);
+Bool_t FillNoiseScanTree(TTree* tree, const string &path, const string &filepix, const string &filehits, const THicType hicType, TTree *maptree=0);
+Bool_t FillNoiseScanTreeResult(TTree* tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType);
+Bool_t FindActivityInNoiseScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger);
+void NoiseScanAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType, TTree *maptree=0);
+void NoiseScanResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType);
+Bool_t GetNoiseScanMap(TTree *maptree, const UInt_t hicid, const UShort_t actmask, const UChar_t cond, const UChar_t chip, TPixMap &map, std::vector<UInt_t> *hits=0);
+void GetNoiseScanTrendRecords(TTree *tree, const Long64_t first, const Long64_t last, const UChar_t stage, std::vector<TTrendRecord> &records);
 TTree* ReadHicActListTreeNS(TFile *rootfile);
 TTree* ReadNoiseScanTree(TString treename, TFile *rootfile);
+TTree* ReadNoiseScanTreeMap(TString treename, TFile *rootfile);
 TTree* ReadNoiseScanTreeResult(TString treename, TFile *rootfile);
 void ResetNoiseScanTreeVariables(void);
 TTree* SetupHicActListTreeNS(TFile *rootfile);
 TTree* SetupNoiseScanTree(TString treename, TString treetitle, TFile *rootfile);
+TTree* SetupNoiseScanTreeMap(TString treename, TString treetitle, TFile *rootfile);
 TTree* SetupNoiseScanTreeResult(TString treename, TString treetitle, TFile *rootfile);
 
 
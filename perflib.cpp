@@ -0,0 +1,354 @@
+#include "perflib.h"
+#include "loglib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+using std::string;
+
+// The printable name of each stage
+static const char* perfStageName[PERF_NSTAGES] = {
+  "DB activity list",
+  "DB children list",
+  "DB activity read",
+  "EOS path lookup",
+  "Fill data tree",
+  "Fill result tree",
+  "Batch file read",
+  "Wait for workers",
+  "Tree write"
+};
+
+// The stage names used in the metrics file
+static const char* perfStageKey[PERF_NSTAGES] = {
+  "db_list",
+  "db_children",
+  "db_read",
+  "eos_path",
+  "fill_data",
+  "fill_result",
+  "read_batch",
+  "wait_workers",
+  "write"
+};
+
+// The counter names used in the metrics file
+static const char* perfCounterKey[PERF_NCOUNTERS] = {
+  "hics_processed",
+  "activities_analyzed",
+  "activities_copied",
+  "activities_skipped",
+  "activities_changed",
+  "hics_unchanged",
+  "activities_eos_missing",
+  "activities_not_filled"
+};
+
+// The accumulated statistics of each stage
+static std::vector<Float_t> perfSamples[PERF_NSTAGES]; // Durations in s
+static Double_t perfTotal[PERF_NSTAGES];
+static Long64_t perfBytes[PERF_NSTAGES];
+static Long64_t perfRows[PERF_NSTAGES];
+
+// The counters and the start time of the run
+static Long64_t perfCounter[PERF_NCOUNTERS];
+static Double_t perfRunStart = PerfNow();
+
+void PerfAddSample(const TPerfStage stage, const Double_t seconds, const Long64_t bytes, const Long64_t rows)
+{
+//
+// Adds one timing sample to a stage
+//
+// Inputs:
+//          stage   : the stage
+//          seconds : the time spent in this call of the stage
+//          bytes   : the number of input bytes read (if any)
+//          rows    : the number of tree rows filled (if any)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  perfSamples[stage].push_back((Float_t)seconds);
+  perfTotal[stage] += seconds;
+  perfBytes[stage] += bytes;
+  perfRows[stage] += rows;
+}
+
+void PerfCount(const TPerfCounter counter, const Long64_t n)
+{
+//
+// Increments a counter
+//
+// Inputs:
+//          counter : the counter
+//          n       : the increment
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  perfCounter[counter] += n;
+}
+
+Long64_t PerfFileSize(const char *filename)
+{
+//
+// Returns the size of a file (to account for the bytes written)
+//
+// Inputs:
+//          filename : the file name
+//
+// Outputs:
+//
+// Return:
+//          the file size in bytes (0 if the file does not exist)
+//
+// Created:      19 Oct 2026
+//
+
+  struct stat fileStat;
+  if (stat(filename, &fileStat) != 0) return 0;
+
+  return fileStat.st_size;
+}
+
+Long64_t PerfMemoryPeak(void)
+{
+//
+// Returns the peak resident memory of the process since its start
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          the peak resident memory in bytes (0 if not known)
+//
+// Created:      19 Oct 2026
+//
+
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+  return (Long64_t)usage.ru_maxrss << 10; // In kB on Linux
+}
+
+Double_t PerfNow(void)
+{
+//
+// Returns a monotonic time stamp, to be used as the start time
+// of a timed stage (only differences are meaningful)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          the current time in seconds
+//
+// Created:      19 Oct 2026
+//
+
+  return std::chrono::duration<Double_t>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PerfReport(const char *logname, const char *title)
+{
+//
+// Appends the breakdown of the time spent in each stage
+// and the counters to the log file
+//
+// Inputs:
+//          logname : the log file name
+//          title   : a title to identify the report
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!logname) return;
+
+  // The records still queued go first, then this report
+  LogFlush();
+
+  FILE *logfile = fopen(logname, "a");
+  if (!logfile) return;
+
+  fprintf(logfile, "\n==== Timing breakdown: %s ====\n", title);
+  fprintf(logfile, "%-18s %9s %10s %9s %9s %9s %12s %10s\n", "Stage", "Calls",
+          "Total(s)", "Mean(ms)", "p50(ms)", "p99(ms)", "Bytes", "Rows");
+
+  for (Int_t i = 0; i < PERF_NSTAGES; i++) {
+    Long64_t ncalls = perfSamples[i].size();
+    if (ncalls == 0) continue;
+
+    std::vector<Float_t> sorted(perfSamples[i]);
+    std::sort(sorted.begin(), sorted.end());
+    Double_t p50 = sorted[(ncalls - 1)/2];
+    Double_t p99 = sorted[(ncalls - 1)*99/100];
+
+    fprintf(logfile, "%-18s %9lld %10.3f %9.3f %9.3f %9.3f %12lld %10lld\n",
+            perfStageName[i], ncalls, perfTotal[i],
+            1000*perfTotal[i]/ncalls, 1000*p50, 1000*p99,
+            perfBytes[i], perfRows[i]);
+  }
+
+  for (Int_t i = 0; i < PERF_NCOUNTERS; i++)
+    fprintf(logfile, "%-24s %lld\n", perfCounterKey[i], perfCounter[i]);
+  fprintf(logfile, "%-24s %lld\n", "peak_rss_bytes", PerfMemoryPeak());
+
+  fclose(logfile);
+}
+
+void PerfReset(void)
+{
+//
+// Resets the statistics of all stages and all counters
+// and sets the start time of the run
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  for (Int_t i = 0; i < PERF_NSTAGES; i++) {
+    perfSamples[i].clear();
+    perfTotal[i] = 0;
+    perfBytes[i] = 0;
+    perfRows[i] = 0;
+  }
+
+  for (Int_t i = 0; i < PERF_NCOUNTERS; i++)
+    perfCounter[i] = 0;
+
+  perfRunStart = PerfNow();
+}
+
+Bool_t PerfWriteMetrics(const char *filename, const char *analysis, const char *hictype)
+{
+//
+// Writes the counters and the statistics of all stages to a metrics file
+// for the batch monitoring: if the file name ends with ".prom" it is in
+// the Prometheus text format (for the node-exporter textfile collector),
+// otherwise in JSON. The file is written under a temporary name and then
+// renamed, so that a reader never sees it half written
+//
+// Inputs:
+//          filename : the metrics file name
+//          analysis : the analysis name
+//          hictype  : the HIC type ("IB" or "OB")
+//
+// Outputs:
+//
+// Return:
+//          true if the file was successfully written
+//
+// Created:      19 Oct 2026
+//
+
+  if (!filename) return kFALSE;
+
+  const size_t namelen = strlen(filename);
+  Bool_t prometheus = (namelen > 5 && strcmp(filename+namelen-5, ".prom") == 0);
+
+  string tmpname = string(filename) + ".tmp";
+  // The records still queued for the log file go first
+  LogFlush();
+
+  FILE *outfile = fopen(tmpname.c_str(), "w");
+  if (!outfile) return kFALSE;
+
+  Double_t wallTime = PerfNow() - perfRunStart;
+  Long64_t bytesIn = perfBytes[PERF_FILLDATA] + perfBytes[PERF_FILLRES];
+  Long64_t bytesOut = perfBytes[PERF_WRITE];
+  Long64_t ingested = perfCounter[PERF_NACTANAL] - perfCounter[PERF_NNOTFILLED];
+
+  if (prometheus) {
+    string labels = string("analysis=\"") + analysis + "\",hictype=\"" + hictype + "\"";
+
+    fprintf(outfile, "# HELP datacomp_last_run_timestamp_seconds End time of the last run\n");
+    fprintf(outfile, "# TYPE datacomp_last_run_timestamp_seconds gauge\n");
+    fprintf(outfile, "datacomp_last_run_timestamp_seconds{%s} %ld\n", labels.c_str(), (long)time(NULL));
+    fprintf(outfile, "# HELP datacomp_run_seconds Wall time of the last run\n");
+    fprintf(outfile, "# TYPE datacomp_run_seconds gauge\n");
+    fprintf(outfile, "datacomp_run_seconds{%s} %.3f\n", labels.c_str(), wallTime);
+
+    for (Int_t i = 0; i < PERF_NCOUNTERS; i++) {
+      fprintf(outfile, "# TYPE datacomp_%s gauge\n", perfCounterKey[i]);
+      fprintf(outfile, "datacomp_%s{%s} %lld\n", perfCounterKey[i], labels.c_str(), perfCounter[i]);
+    }
+    fprintf(outfile, "# TYPE datacomp_activities_ingested gauge\n");
+    fprintf(outfile, "datacomp_activities_ingested{%s} %lld\n", labels.c_str(), ingested);
+    fprintf(outfile, "# TYPE datacomp_bytes_in gauge\n");
+    fprintf(outfile, "datacomp_bytes_in{%s} %lld\n", labels.c_str(), bytesIn);
+    fprintf(outfile, "# TYPE datacomp_bytes_out gauge\n");
+    fprintf(outfile, "datacomp_bytes_out{%s} %lld\n", labels.c_str(), bytesOut);
+    fprintf(outfile, "# HELP datacomp_peak_rss_bytes Peak resident memory of the process\n");
+    fprintf(outfile, "# TYPE datacomp_peak_rss_bytes gauge\n");
+    fprintf(outfile, "datacomp_peak_rss_bytes{%s} %lld\n", labels.c_str(), PerfMemoryPeak());
+
+    const char* stageMetric[6] = {"calls", "seconds", "bytes", "rows",
+                                  "bytes_per_second", "rows_per_second"};
+    for (Int_t m = 0; m < 6; m++) {
+      fprintf(outfile, "# TYPE datacomp_stage_%s gauge\n", stageMetric[m]);
+      for (Int_t i = 0; i < PERF_NSTAGES; i++) {
+        Double_t value = 0;
+        switch (m) {
+          case 0: value = perfSamples[i].size(); break;
+          case 1: value = perfTotal[i]; break;
+          case 2: value = perfBytes[i]; break;
+          case 3: value = perfRows[i]; break;
+          case 4: value = (perfTotal[i] > 0 ? perfBytes[i]/perfTotal[i] : 0); break;
+          case 5: value = (perfTotal[i] > 0 ? perfRows[i]/perfTotal[i] : 0); break;
+        }
+        fprintf(outfile, "datacomp_stage_%s{%s,stage=\"%s\"} %.6g\n",
+                stageMetric[m], labels.c_str(), perfStageKey[i], value);
+      }
+    }
+  } else {
+    fprintf(outfile, "{\n");
+    fprintf(outfile, "  \"analysis\": \"%s\",\n", analysis);
+    fprintf(outfile, "  \"hic_type\": \"%s\",\n", hictype);
+    fprintf(outfile, "  \"timestamp\": %ld,\n", (long)time(NULL));
+    fprintf(outfile, "  \"run_seconds\": %.3f,\n", wallTime);
+    for (Int_t i = 0; i < PERF_NCOUNTERS; i++)
+      fprintf(outfile, "  \"%s\": %lld,\n", perfCounterKey[i], perfCounter[i]);
+    fprintf(outfile, "  \"activities_ingested\": %lld,\n", ingested);
+    fprintf(outfile, "  \"bytes_in\": %lld,\n", bytesIn);
+    fprintf(outfile, "  \"bytes_out\": %lld,\n", bytesOut);
+    fprintf(outfile, "  \"peak_rss_bytes\": %lld,\n", PerfMemoryPeak());
+    fprintf(outfile, "  \"stages\": {\n");
+    for (Int_t i = 0; i < PERF_NSTAGES; i++) {
+      fprintf(outfile, "    \"%s\": {\"calls\": %lu, \"seconds\": %.6f, "
+              "\"bytes\": %lld, \"rows\": %lld, "
+              "\"bytes_per_second\": %.6g, \"rows_per_second\": %.6g}%s\n",
+              perfStageKey[i], (unsigned long)perfSamples[i].size(), perfTotal[i],
+              perfBytes[i], perfRows[i],
+              (perfTotal[i] > 0 ? perfBytes[i]/perfTotal[i] : 0),
+              (perfTotal[i] > 0 ? perfRows[i]/perfTotal[i] : 0),
+              (i < PERF_NSTAGES-1 ? "," : ""));
+    }
+    fprintf(outfile, "  }\n");
+    fprintf(outfile, "}\n");
+  }
+
+  fclose(outfile);
+
+  return (rename(tmpname.c_str(), filename) == 0);
+}
@@ -0,0 +1,49 @@
+#ifndef PERFLIB_H
+#define PERFLIB_H
+
+#include <Rtypes.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <vector>
+
+// The stages of the analysis which are timed
+enum TPerfStage {
+  PERF_DBLIST,    // DB: get the list of activities of a HIC
+  PERF_DBCHILD,   // DB: get the list of children of a HIC
+  PERF_DBREAD,    // DB: read a single activity
+  PERF_EOSPATH,   // EOS: find the directory of an activity
+  PERF_FILLDATA,  // Fill*Tree: read a data file and fill the tree
+  PERF_FILLRES,   // Fill*TreeResult: read a result file and fill the tree
+  PERF_READBATCH, // Read a batch of files at once with io_uring (see iolib)
+  PERF_WAITWORK,  // Wait for a file read by the worker threads
+  PERF_WRITE,     // Write the trees and close the file (bytes written)
+  PERF_NSTAGES
+};
+
+// The counters of the run
+enum TPerfCounter {
+  PERF_NHICS,      // HICs processed
+  PERF_NACTANAL,   // Activities analyzed (read from EOS)
+  PERF_NACTCOPY,   // Activities copied from the old file
+  PERF_NACTSKIP,   // Activities skipped because already in file
+  PERF_NACTCHANGED,// Activities already in file but changed in the DB
+  PERF_NHICSKIP,   // HICs skipped because unchanged since the last poll
+  PERF_NEOSMISS,   // Activities with no directory on EOS
+  PERF_NNOTFILLED, // Activities analyzed but with trees not filled
+  PERF_NCOUNTERS
+};
+
+void PerfAddSample(const TPerfStage stage, const Double_t seconds, const Long64_t bytes=0, const Long64_t rows=0);
+void PerfCount(const TPerfCounter counter, const Long64_t n=1);
+Long64_t PerfFileSize(const char *filename);
+Long64_t PerfMemoryPeak(void);
+Double_t PerfNow(void);
+void PerfReport(const char *logname, const char *title);
+void PerfReset(void);
+Bool_t PerfWriteMetrics(const char *filename, const char *analysis, const char *hictype);
+
+#endif // PERFLIB_H
@@ -0,0 +1,541 @@
+#include "pixmaplib.h"
+
+#include <algorithm>
+#include <iterator>
+
+// Largest total number of pixels of two array chunks which are merged
+#define PIXMAPMERGEMAX 512
+
+// The set operations between two maps
+enum TPixMapOp {
+  PIXMAP_AND,
+  PIXMAP_ANDNOT,
+  PIXMAP_OR
+};
+
+static Int_t PixMapFindChunk(const TPixMap &map, const UChar_t key)
+{
+//
+// Finds a chunk in a map
+//
+// Inputs:
+//          map : the map
+//          key : the chunk number
+//
+// Outputs:
+//
+// Return:
+//          the position of the chunk in the map, -1 if not there
+//
+// Created:      19 Oct 2026
+//
+
+  for (UInt_t i = 0; i < map.chunks.size(); i++) {
+    if (map.chunks[i].key == key) return i;
+    if (map.chunks[i].key > key) break;
+  }
+
+  return -1;
+}
+
+static void PixMapFromWords(TPixMapChunk &chunk, const ULong64_t *words)
+{
+//
+// Sets a chunk from a bitmap, choosing the cheaper container
+//
+// Inputs:
+//          words : the PIXMAPWORDS words of the bitmap
+//
+// Outputs:
+//          chunk : the chunk (the key is not changed)
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  chunk.card = 0;
+  for (Int_t i = 0; i < PIXMAPWORDS; i++)
+    chunk.card += __builtin_popcountll(words[i]);
+
+  chunk.array.clear();
+  chunk.bitmap.clear();
+  if (chunk.card > PIXMAPARRAYMAX) {
+    chunk.bitmap.assign(words, words + PIXMAPWORDS);
+    return;
+  }
+
+  chunk.array.reserve(chunk.card);
+  for (Int_t i = 0; i < PIXMAPWORDS; i++) {
+    ULong64_t word = words[i];
+    while (word) {
+      chunk.array.push_back((i << 6) + __builtin_ctzll(word));
+      word &= word - 1;
+    }
+  }
+}
+
+static void PixMapToWords(const TPixMapChunk &chunk, ULong64_t *words)
+{
+//
+// Expands a chunk into a bitmap
+//
+// Inputs:
+//          chunk : the chunk
+//
+// Outputs:
+//          words : the PIXMAPWORDS words of the bitmap
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (chunk.bitmap.size() > 0) {
+    memcpy(words, &chunk.bitmap[0], PIXMAPWORDS*sizeof(ULong64_t));
+    return;
+  }
+
+  memset(words, 0, PIXMAPWORDS*sizeof(ULong64_t));
+  for (UInt_t i = 0; i < chunk.array.size(); i++)
+    words[chunk.array[i] >> 6] |= 1ULL << (chunk.array[i] & 63);
+}
+
+static Bool_t PixMapOperateChunks(const TPixMapChunk &chunk1, const TPixMapChunk &chunk2, const TPixMapOp op, TPixMapChunk &result)
+{
+//
+// Computes the intersection, difference or union of two chunks
+// with the same key: small sorted arrays are merged, otherwise the
+// operation is done word by word on the two bitmaps (which is faster
+// than a merge, full of unpredictable branches, already above a few
+// hundred pixels)
+//
+// Inputs:
+//          chunk1 : the first chunk
+//          chunk2 : the second chunk
+//          op     : the operation
+//
+// Outputs:
+//          result : the resulting chunk
+//
+// Return:
+//          kTRUE if the result is not empty, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  result.key = chunk1.key;
+
+  if (chunk1.bitmap.size() == 0 && chunk2.bitmap.size() == 0 &&
+      chunk1.card + chunk2.card <= PIXMAPMERGEMAX) {
+    result.array.clear();
+    result.bitmap.clear();
+    std::back_insert_iterator< std::vector<UShort_t> > out(result.array);
+    if (op == PIXMAP_AND)
+      std::set_intersection(chunk1.array.begin(), chunk1.array.end(),
+                            chunk2.array.begin(), chunk2.array.end(), out);
+    else if (op == PIXMAP_ANDNOT)
+      std::set_difference(chunk1.array.begin(), chunk1.array.end(),
+                          chunk2.array.begin(), chunk2.array.end(), out);
+    else
+      std::set_union(chunk1.array.begin(), chunk1.array.end(),
+                     chunk2.array.begin(), chunk2.array.end(), out);
+    result.card = result.array.size();
+    return (result.card > 0);
+  }
+
+  ULong64_t words1[PIXMAPWORDS], words2[PIXMAPWORDS];
+  const ULong64_t *w1 = words1, *w2 = words2;
+  if (chunk1.bitmap.size() > 0)
+    w1 = &chunk1.bitmap[0];
+  else
+    PixMapToWords(chunk1, words1);
+  if (chunk2.bitmap.size() > 0)
+    w2 = &chunk2.bitmap[0];
+  else
+    PixMapToWords(chunk2, words2);
+
+  ULong64_t words[PIXMAPWORDS];
+  if (op == PIXMAP_AND)
+    for (Int_t i = 0; i < PIXMAPWORDS; i++) words[i] = w1[i] & w2[i];
+  else if (op == PIXMAP_ANDNOT)
+    for (Int_t i = 0; i < PIXMAPWORDS; i++) words[i] = w1[i] & ~w2[i];
+  else
+    for (Int_t i = 0; i < PIXMAPWORDS; i++) words[i] = w1[i] | w2[i];
+  PixMapFromWords(result, words);
+
+  return (result.card > 0);
+}
+
+static void PixMapOperate(const TPixMap &map1, const TPixMap &map2, const TPixMapOp op, TPixMap &result)
+{
+//
+// Computes the intersection, difference or union of two maps,
+// chunk by chunk (the result can be one of the two maps)
+//
+// Inputs:
+//          map1 : the first map
+//          map2 : the second map
+//          op   : the operation
+//
+// Outputs:
+//          result : the resulting map
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TPixMap out;
+  out.chunks.reserve(PIXMAPNCHUNKS);
+
+  UInt_t i1 = 0, i2 = 0;
+  while (i1 < map1.chunks.size() || i2 < map2.chunks.size()) {
+    if (i2 == map2.chunks.size() ||
+        (i1 < map1.chunks.size() && map1.chunks[i1].key < map2.chunks[i2].key)) {
+      if (op != PIXMAP_AND) out.chunks.push_back(map1.chunks[i1]);
+      i1++;
+    } else if (i1 == map1.chunks.size() || map2.chunks[i2].key < map1.chunks[i1].key) {
+      if (op == PIXMAP_OR) out.chunks.push_back(map2.chunks[i2]);
+      i2++;
+    } else {
+      out.chunks.push_back(TPixMapChunk());
+      if (!PixMapOperateChunks(map1.chunks[i1], map2.chunks[i2], op, out.chunks.back()))
+        out.chunks.pop_back();
+      i1++;
+      i2++;
+    }
+  }
+
+  result.chunks.swap(out.chunks);
+}
+
+void PixMapAdd(TPixMap &map, const Int_t col, const Int_t row)
+{
+//
+// Adds a pixel to a map (pixels are usually added in increasing
+// order of row and column, for which the add is just an append)
+//
+// Inputs:
+//          map : the map
+//          col : the pixel column
+//          row : the pixel row
+//
+// Outputs:
+//          map : the updated map
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (col < 0 || col >= PIXMAPNCOLS || row < 0 || row >= PIXMAPNROWS) return;
+
+  UInt_t index = row*PIXMAPNCOLS + col;
+  UChar_t key = index >> 16;
+  UShort_t pos = index & 0xffff;
+
+  Int_t ichunk = PixMapFindChunk(map, key);
+  if (ichunk < 0) {
+    TPixMapChunk chunk;
+    chunk.key = key;
+    chunk.card = 0;
+    UInt_t i = 0;
+    while (i < map.chunks.size() && map.chunks[i].key < key) i++;
+    map.chunks.insert(map.chunks.begin() + i, chunk);
+    ichunk = i;
+  }
+
+  TPixMapChunk &chunk = map.chunks[ichunk];
+  if (chunk.bitmap.size() > 0) {
+    ULong64_t bit = 1ULL << (pos & 63);
+    if (!(chunk.bitmap[pos >> 6] & bit)) {
+      chunk.bitmap[pos >> 6] |= bit;
+      chunk.card++;
+    }
+    return;
+  }
+
+  if (chunk.array.size() == 0 || chunk.array.back() < pos)
+    chunk.array.push_back(pos);
+  else {
+    std::vector<UShort_t>::iterator it = std::lower_bound(chunk.array.begin(), chunk.array.end(), pos);
+    if (*it == pos) return; // Already there
+    chunk.array.insert(it, pos);
+  }
+  chunk.card++;
+
+  if (chunk.card > PIXMAPARRAYMAX) {
+    ULong64_t words[PIXMAPWORDS];
+    PixMapToWords(chunk, words);
+    PixMapFromWords(chunk, words);
+  }
+}
+
+void PixMapAnd(const TPixMap &map1, const TPixMap &map2, TPixMap &result)
+{
+//
+// Computes the pixels which are in both maps
+//
+// Inputs:
+//          map1 : the first map
+//          map2 : the second map
+//
+// Outputs:
+//          result : the intersection (can be one of the two maps)
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  PixMapOperate(map1, map2, PIXMAP_AND, result);
+}
+
+void PixMapAndNot(const TPixMap &map1, const TPixMap &map2, TPixMap &result)
+{
+//
+// Computes the pixels which are in the first map but not in the second
+//
+// Inputs:
+//          map1 : the first map
+//          map2 : the second map
+//
+// Outputs:
+//          result : the difference (can be one of the two maps)
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  PixMapOperate(map1, map2, PIXMAP_ANDNOT, result);
+}
+
+UInt_t PixMapCardinality(const TPixMap &map)
+{
+//
+// Counts the pixels of a map
+//
+// Inputs:
+//          map : the map
+//
+// Outputs:
+//
+// Return:
+//          the number of pixels
+//
+// Created:      19 Oct 2026
+//
+
+  UInt_t card = 0;
+  for (UInt_t i = 0; i < map.chunks.size(); i++)
+    card += map.chunks[i].card;
+
+  return card;
+}
+
+void PixMapClear(TPixMap &map)
+{
+//
+// Removes all pixels from a map
+//
+// Inputs:
+//          map : the map
+//
+// Outputs:
+//          map : the empty map
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  map.chunks.clear();
+}
+
+Bool_t PixMapContains(const TPixMap &map, const Int_t col, const Int_t row)
+{
+//
+// Checks whether a pixel is in a map
+//
+// Inputs:
+//          map : the map
+//          col : the pixel column
+//          row : the pixel row
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the pixel is in the map, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  if (col < 0 || col >= PIXMAPNCOLS || row < 0 || row >= PIXMAPNROWS) return kFALSE;
+
+  UInt_t index = row*PIXMAPNCOLS + col;
+  UShort_t pos = index & 0xffff;
+
+  Int_t ichunk = PixMapFindChunk(map, index >> 16);
+  if (ichunk < 0) return kFALSE;
+
+  const TPixMapChunk &chunk = map.chunks[ichunk];
+  if (chunk.bitmap.size() > 0)
+    return (chunk.bitmap[pos >> 6] >> (pos & 63)) & 1;
+  else
+    return std::binary_search(chunk.array.begin(), chunk.array.end(), pos);
+}
+
+void PixMapGetPixels(const TPixMap &map, std::vector<UInt_t> &pixels)
+{
+//
+// Lists the pixels of a map
+//
+// Inputs:
+//          map : the map
+//
+// Outputs:
+//          pixels : the pixel indices (row*1024+col) in increasing order
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  pixels.clear();
+  pixels.reserve(PixMapCardinality(map));
+
+  for (UInt_t i = 0; i < map.chunks.size(); i++) {
+    const TPixMapChunk &chunk = map.chunks[i];
+    UInt_t base = (UInt_t)chunk.key << 16;
+    if (chunk.bitmap.size() > 0) {
+      for (Int_t j = 0; j < PIXMAPWORDS; j++) {
+        ULong64_t word = chunk.bitmap[j];
+        while (word) {
+          pixels.push_back(base + (j << 6) + __builtin_ctzll(word));
+          word &= word - 1;
+        }
+      }
+    } else
+      for (UInt_t j = 0; j < chunk.array.size(); j++)
+        pixels.push_back(base + chunk.array[j]);
+  }
+}
+
+void PixMapOr(const TPixMap &map1, const TPixMap &map2, TPixMap &result)
+{
+//
+// Computes the pixels which are in any of the two maps
+//
+// Inputs:
+//          map1 : the first map
+//          map2 : the second map
+//
+// Outputs:
+//          result : the union (can be one of the two maps)
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  PixMapOperate(map1, map2, PIXMAP_OR, result);
+}
+
+Bool_t PixMapRead(TPixMap &map, const UChar_t *buffer, const Int_t length)
+{
+//
+// Rebuilds a map from its serialized form (see PixMapWrite)
+//
+// Inputs:
+//          buffer : the serialized map
+//          length : the length of the buffer
+//
+// Outputs:
+//          map : the map
+//
+// Return:
+//          kTRUE if the buffer was valid, otherwise kFALSE (map is empty)
+//
+// Created:      19 Oct 2026
+//
+
+  map.chunks.clear();
+  if (length == 0) return kTRUE; // An empty map
+
+  Int_t nchunks = buffer[0];
+  Int_t p = 1;
+  for (Int_t i = 0; i < nchunks; i++) {
+    if (p + 4 > length) break;
+    TPixMapChunk chunk;
+    chunk.key = buffer[p];
+    UChar_t type = buffer[p+1];
+    UShort_t card1;
+    memcpy(&card1, buffer + p + 2, sizeof(card1));
+    chunk.card = card1 + 1;
+    p += 4;
+
+    if (type == 0) {
+      if (chunk.card > PIXMAPARRAYMAX || p + 2*(Int_t)chunk.card > length) break;
+      chunk.array.resize(chunk.card);
+      memcpy(&chunk.array[0], buffer + p, 2*chunk.card);
+      p += 2*chunk.card;
+    } else {
+      if (p + 8*PIXMAPWORDS > length) break;
+      chunk.bitmap.resize(PIXMAPWORDS);
+      memcpy(&chunk.bitmap[0], buffer + p, 8*PIXMAPWORDS);
+      p += 8*PIXMAPWORDS;
+    }
+    map.chunks.push_back(chunk);
+  }
+
+  if ((Int_t)map.chunks.size() != nchunks || p != length) {
+    map.chunks.clear();
+    return kFALSE;
+  }
+
+  return kTRUE;
+}
+
+Int_t PixMapWrite(const TPixMap &map, UChar_t *buffer)
+{
+//
+// Serializes a map: the number of chunks, then for each chunk its key,
+// type (0 array, 1 bitmap), number of pixels minus one (16 bits) and
+// the positions or the bitmap words
+//
+// Inputs:
+//          map : the map
+//
+// Outputs:
+//          buffer : the serialized map (at most PIXMAPMAXBYTES long)
+//
+// Return:
+//          the length of the serialized map (0 for an empty map)
+//
+// Created:      19 Oct 2026
+//
+
+  if (map.chunks.size() == 0) return 0;
+
+  buffer[0] = map.chunks.size();
+  Int_t p = 1;
+  for (UInt_t i = 0; i < map.chunks.size(); i++) {
+    const TPixMapChunk &chunk = map.chunks[i];
+    UShort_t card1 = chunk.card - 1;
+    buffer[p] = chunk.key;
+    buffer[p+1] = (chunk.bitmap.size() > 0) ? 1 : 0;
+    memcpy(buffer + p + 2, &card1, sizeof(card1));
+    p += 4;
+    if (chunk.bitmap.size() > 0) {
+      memcpy(buffer + p, &chunk.bitmap[0], 8*PIXMAPWORDS);
+      p += 8*PIXMAPWORDS;
+    } else {
+      memcpy(buffer + p, &chunk.array[0], 2*chunk.card);
+      p += 2*chunk.card;
+    }
+  }
+
+  return p;
+}
@@ -0,0 +1,43 @@
+#ifndef PIXMAPLIB_H
+#define PIXMAPLIB_H
+
+#include <Rtypes.h>
+
+#include <string.h>
+#include <vector>
+
+#define PIXMAPNCOLS 1024
+#define PIXMAPNROWS 512
+#define PIXMAPNCHUNKS 8        // 512x1024 pixels in chunks of 65536
+#define PIXMAPARRAYMAX 4096    // Largest chunk kept as a sorted array
+#define PIXMAPWORDS 1024       // 64-bit words of a chunk kept as a bitmap
+#define PIXMAPMAXBYTES (1 + PIXMAPNCHUNKS*(4 + 8*PIXMAPWORDS))
+
+// A set of pixels of a chip, stored as a roaring bitmap: the pixel
+// index row*1024+col is split in a chunk number (the high bits) and a
+// 16-bit position in the chunk, and each non empty chunk holds its
+// positions either in a sorted array (up to PIXMAPARRAYMAX of them)
+// or in a 65536-bit bitmap (above that)
+struct TPixMapChunk {
+  UChar_t  key;                  // the chunk number
+  UInt_t   card;                 // the number of pixels in the chunk
+  std::vector<UShort_t>  array;  // the positions, if an array chunk
+  std::vector<ULong64_t> bitmap; // the PIXMAPWORDS words, if a bitmap chunk
+};
+
+struct TPixMap {
+  std::vector<TPixMapChunk> chunks; // the non empty chunks, sorted by key
+};
+
+void PixMapAdd(TPixMap &map, const Int_t col, const Int_t row);
+void PixMapAnd(const TPixMap &map1, const TPixMap &map2, TPixMap &result);
+void PixMapAndNot(const TPixMap &map1, const TPixMap &map2, TPixMap &result);
+UInt_t PixMapCardinality(const TPixMap &map);
+void PixMapClear(TPixMap &map);
+Bool_t PixMapContains(const TPixMap &map, const Int_t col, const Int_t row);
+void PixMapGetPixels(const TPixMap &map, std::vector<UInt_t> &pixels);
+void PixMapOr(const TPixMap &map1, const TPixMap &map2, TPixMap &result);
+Bool_t PixMapRead(TPixMap &map, const UChar_t *buffer, const Int_t length);
+Int_t PixMapWrite(const TPixMap &map, UChar_t *buffer);
+
+#endif // PIXMAPLIB_H
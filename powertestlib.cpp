@@ -17,9 +17,17 @@ Float_t  ibias0V;
 Float_t  ibias3V;
 Float_t  classificPowTest;
 
+// The trees of each activity type (see MergeShardRootFiles)
+static const TActTreeNames powTestTreeNames[] = {
+  {ACTMASK_QUALIF, "hicQualTree", 0, "hicQualResTree"},
+  {ACTMASK_RECEPT, "hicRecpTree", 0, "hicRecpResTree"},
+  {ACTMASK_HALFST, "hicHSTree", 0, "hicHSResTree"},
+  {ACTMASK_STAVET, "hicStaveQualTree", 0, "hicStaveQualResTree"},
+  {ACTMASK_STVREC, "hicStaveRecpTree", 0, "hicStaveRecpResTree"}
+};
 
 
-void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType)
+void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType)
 {
 //
 // Steering routine to analyze the data of Power Test for all HICs
@@ -40,6 +48,7 @@ void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList
 // Updated:      08 Mar 2019  Mario Sitta  HIC position added
 //                                         Flag ML/OL staves
 //                                         Stave Reception Test added
+// Updated:      19 Oct 2026  Append in place, checkpoints, DB access layer
 //
 
   // We need to define here the TTree's for the existing ROOT file
@@ -48,14 +57,12 @@ void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList
   TTree *oldActFastListTree = 0;
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeAllPowerTests","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeAllPowerTests","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Check whether the ROOT file already exists
   // If yes, ask the user whether to use it or redo a new one
   TString rootFileName;
@@ -63,21 +70,30 @@ void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList
     rootFileName = "IBHIC_PowerTest_AllHICs.root";
   else
     rootFileName = "OBHIC_PowerTest_AllHICs.root";
+  rootFileName = ShardRootFileName(rootFileName);
 
   redoFromStart = kTRUE;
+  appendToFile = kFALSE;
+  TString oldRootFileName; // Set if the activities are copied from it
   if(CheckRootFileExists(rootFileName)) {
-    if(AskUserRedoScan() == 2) { // User chose to re-use existing tree
+    Int_t userChoice = AskUserRedoScan();
+    if(userChoice == 3) { // User chose to append to existing trees
+      appendToFile = kTRUE;
+      // A resumed run goes on copying from the old file, if it did
+      if(CheckpointOldFile(rootFileName, oldRootFileName))
+        userChoice = 2;
+    }
+    if(userChoice == 2) { // User chose to re-use existing tree
       redoFromStart = kFALSE;
-      TString oldRootFileName;
-      if(!RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
-        printMessage("\nanalyzeAllPowerTests","Error: error renaming existing ROOT file");
+      if(!appendToFile && !RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
+        printMessage("\nanalyzeAllPowerTests","Error: error renaming existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
 
       TFile *oldPowertestFile = OpenRootFile(oldRootFileName);
       if(!oldPowertestFile) {
-        printMessage("\nanalyzeAllPowerTests","Error: error opening existing ROOT file");
+        printMessage("\nanalyzeAllPowerTests","Error: error opening existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -99,7 +115,7 @@ void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList
       if(!oldHicQualTree || !oldHicRecpTree || !oldHicHSTree || !oldHicStaveQualTree || !oldHicStaveRecpTree ||
          !oldHicQualResTree || !oldHicRecpResTree || !oldHicHSResTree || !oldHicStaveQualResTree || !oldHicStaveRecpResTree ||
          !oldActFastListTree) {
-        printMessage("\nanalyzeAllPowerTests","Error: error reading trees from existing ROOT file");
+        printMessage("\nanalyzeAllPowerTests","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -107,43 +123,94 @@ void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList
   } // if(CheckRootFileExists())
 
   // Open the ROOT file
-  TFile *newPowtestFile = OpenRootFile(rootFileName, kTRUE);
+  TFile *newPowtestFile = OpenRootFile(rootFileName, !appendToFile, appendToFile);
 
   if(!newPowtestFile) {
-    printMessage("\nanalyzeAllPowerTests","Error: error opening new ROOT file");
+    printMessage("\nanalyzeAllPowerTests","Error: error opening new ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   // Create or read the trees
-  TTree *hicQualTree = CreateTreePowerTest("hicQualTree","HicQualificationTest");
-  TTree *hicRecpTree = CreateTreePowerTest("hicRecpTree","HicReceptionTest");
-  TTree *hicHSTree = CreateTreePowerTest("hicHSTree","HicHalfStaveTest");
-  TTree *hicStaveQualTree = CreateTreePowerTest("hicStaveQualTree","HicStaveQualTest");
-  TTree *hicStaveRecpTree = CreateTreePowerTest("hicStaveRecpTree","HicStaveRecpTest");
+  TTree *hicQualTree = SetupPowTestTree("hicQualTree","HicQualificationTest",newPowtestFile);
+  TTree *hicRecpTree = SetupPowTestTree("hicRecpTree","HicReceptionTest",newPowtestFile);
+  TTree *hicHSTree = SetupPowTestTree("hicHSTree","HicHalfStaveTest",newPowtestFile);
+  TTree *hicStaveQualTree = SetupPowTestTree("hicStaveQualTree","HicStaveQualTest",newPowtestFile);
+  TTree *hicStaveRecpTree = SetupPowTestTree("hicStaveRecpTree","HicStaveRecpTest",newPowtestFile);
+
+  TTree *hicQualResTree = SetupPowTestTreeResult("hicQualResTree","HicQualificationTestResults",newPowtestFile);
+  TTree *hicRecpResTree = SetupPowTestTreeResult("hicRecpResTree","HicReceptionTestResults",newPowtestFile);
+  TTree *hicHSResTree = SetupPowTestTreeResult("hicHSResTree","HicHalfStaveTestResults",newPowtestFile);
+  TTree *hicStaveQualResTree = SetupPowTestTreeResult("hicStaveQualResTree","HicStaveQualTestResults",newPowtestFile);
+  TTree *hicStaveRecpResTree = SetupPowTestTreeResult("hicStaveRecpResTree","HicStaveRecpTestResults",newPowtestFile);
+
+  TTree *actFastListTree = SetupHicActListTreePT(newPowtestFile);
+
+  if(!hicQualTree || !hicRecpTree || !hicHSTree || !hicStaveQualTree || !hicStaveRecpTree ||
+     !hicQualResTree || !hicRecpResTree || !hicHSResTree || !hicStaveQualResTree || !hicStaveRecpResTree ||
+     !actFastListTree) { // Only possible when reading from file
+    printMessage("\nanalyzeAllPowerTests","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
 
-  TTree *hicQualResTree = CreateTreePowerTestResult("hicQualResTree","HicQualificationTestResults");
-  TTree *hicRecpResTree = CreateTreePowerTestResult("hicRecpResTree","HicReceptionTestResults");
-  TTree *hicHSResTree = CreateTreePowerTestResult("hicHSResTree","HicHalfStaveTestResults");
-  TTree *hicStaveQualResTree = CreateTreePowerTestResult("hicStaveQualResTree","HicStaveQualTestResults");
-  TTree *hicStaveRecpResTree = CreateTreePowerTestResult("hicStaveRecpResTree","HicStaveRecpTestResults");
+  // When appending, index the activities already in the file with their
+  // DB fingerprint, so that the unchanged ones are skipped and the changed
+  // ones are replaced (see AddChangedActivity)
+  std::map<ULong64_t, ULong64_t> actIndex;
+  if(appendToFile)
+    for (Long64_t j = 0; j < actFastListTree->GetEntries(); j++) {
+      actDbFingerprint = 0; // Not in files written before fingerprints
+      actFastListTree->GetEntry(j);
+      actIndex[ActivityKey(hicID, actID)] = actDbFingerprint;
+    }
 
-  TTree *actFastListTree = CreateHicActListTreePT();
+  // The trees are saved together every CHECKPOINTMIN minutes, so that
+  // a broken run can be resumed after the last HIC saved (--resume)
+  TTree *ckptTrees[] = {hicQualTree, hicRecpTree, hicHSTree, hicStaveQualTree, hicStaveRecpTree,
+                         hicQualResTree, hicRecpResTree, hicHSResTree, hicStaveQualResTree,
+                         hicStaveRecpResTree, actFastListTree};
+  UInt_t firstComp = CheckpointBegin(newPowtestFile, ckptTrees, sizeof(ckptTrees)/sizeof(TTree*), componentList, oldRootFileName);
 
   // Loop on all components
   int totHICAnal = 0, totActAnal = 0;
+  Double_t perfStart;
   std::vector<ComponentDB::compActivity> tests;
   std::vector<ComponentDB::componentShort>::iterator iComp;
-  for (iComp = componentList.begin(); iComp != componentList.end(); iComp++) {
+  for (iComp = componentList.begin() + firstComp; iComp != componentList.end(); iComp++) {
     ComponentDB::componentShort comp = *iComp;
-    DbGetAllTests (db, comp.ID, tests, STPower, true);
+    perfStart = PerfNow();
+    DbLibGetAllTests (db, comp.ID, tests, STPower, true);
+    PerfAddSample(PERF_DBLIST, PerfNow() - perfStart);
+
+    // In watch mode a HIC whose activities did not change since the last
+    // poll is not looked at again
+    if(appendToFile && !WatchHicChanged(comp.ID, tests)) {
+      PerfCount(PERF_NHICSKIP);
+      continue;
+    }
 
     // Loop on all activities
     std::vector<ComponentDB::compActivity>::iterator it;
     for(it = tests.begin(); it != tests.end(); it++) {
       ComponentDB::compActivity act = *it;
       ActivityDB::activityLong actLong;
-      activityDB->Read(act.ID, &actLong);
+      perfStart = PerfNow();
+      DbLibReadActivity(db, act.ID, &actLong);
+      PerfAddSample(PERF_DBREAD, PerfNow() - perfStart);
+
+      // Already in file: skipped if unchanged, otherwise the file is
+      // rewritten afterwards to replace its entries
+      std::map<ULong64_t, ULong64_t>::iterator stored;
+      if(appendToFile &&
+         (stored = actIndex.find(ActivityKey(comp.ID, act.ID))) != actIndex.end()) {
+        if(stored->second != 0 && stored->second != ActivityDBFingerprint(actLong)) {
+          AddChangedActivity();
+          PerfCount(PERF_NACTCHANGED);
+        } else
+          PerfCount(PERF_NACTSKIP);
+        continue;
+      }
 
       TTree *testree = 0, *resultree = 0;
       TTree *oldtestree = 0, *oldresultree = 0;
@@ -203,18 +270,31 @@ void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList
 
       if (!testree) continue; // Not a Qualification/Reception/HS/Stave test
 
+      // The fingerprints tell whether the activity changed since it was
+      // stored in the old file (if so it is reprocessed, not copied): the
+      // EOS directory is looked for only if the DB data changed
+      Bool_t inOldFile = kFALSE;
+      ULong64_t oldDbFinger = 0, oldFinger = 0;
       if(!redoFromStart)
-	if(FindActivityInPowTestTree(oldActFastListTree, comp.ID, act.ID, actMask)) {
-          printMessage("\nanalyzeAllPowerTests", "Activity already in file, copying trees ", actLong.Name.c_str());
-          CopyPowTestOldToNew(comp.ID, act.ID, testree, resultree, oldtestree, oldresultree);
-          actFastListTree->Fill();
-          continue;
-        }
-
-      string eosPath = FindEOSPath(actLong, hicType);
+        inOldFile = FindActivityInPowTestTree(oldActFastListTree, comp.ID, act.ID, actMask, oldDbFinger, oldFinger);
+
+      string eosPath;
+      Bool_t copyOld = CopyOldActivity(actLong, hicType, inOldFile, oldDbFinger, oldFinger, eosPath);
+      actDbFingerprint = oldDbFinger;
+      actFingerprint = oldFinger;
+
+      if(copyOld) {
+        printMessage("\nanalyzeAllPowerTests", "Activity already in file, copying trees ", actLong.Name.c_str());
+        CopyPowTestOldToNew(comp.ID, act.ID, testree, resultree, oldtestree, oldresultree);
+        actFastListTree->Fill();
+        PerfCount(PERF_NACTCOPY);
+        continue;
+      }
+
       if(eosPath.length() == 0) { // No valid path found on EOS
         string hicAct = actLong.Name + " " + actLong.Type.Name;
-        printMessage("\nanalyzeAllPowerTests", "EOS for this activity does not exists", hicAct.c_str());
+        printMessage("\nanalyzeAllPowerTests", "EOS for this activity does not exists", hicAct.c_str(), LOG_WARNING);
+        PerfCount(PERF_NEOSMISS);
         continue;
       }
 
@@ -222,7 +302,7 @@ void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList
       testOffset = testree->GetEntries();
       testResOffset = resultree->GetEntries();
 
-      hicPosition = DbGetPosition(db, comp.ID);
+      hicPosition = DbLibGetPosition(db, comp.ID);
 
       PowerTestAllChips(testree, actLong, comp.ID, act.ID, eosPath);
       PowerTestResults(resultree, actLong, comp.ID, act.ID, eosPath, hicType);
@@ -230,41 +310,46 @@ void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList
       Long64_t prevTestOffset = testree->GetEntries();
       Long64_t prevTestResOffset = resultree->GetEntries();
 
-      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset)
-        printMessage("\nanalyzeAllPowerTests", "Trees not filled for activity ", actLong.Name.c_str());
-      else
+      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset) {
+        printMessage("\nanalyzeAllPowerTests", "Trees not filled for activity ", actLong.Name.c_str(), LOG_WARNING);
+        PerfCount(PERF_NNOTFILLED);
+      } else
 	actFastListTree->Fill();
 
       totActAnal++;
+      PerfCount(PERF_NACTANAL);
       cout << ".";
       fflush(stdout);
 
     }
     totHICAnal++;
+    PerfCount(PERF_NHICS);
     if(totHICAnal%50 == 0) cout << totHICAnal;
     fflush(stdout);
     if(totHICAnal%50 == 0) { // Renew the db credentials
-      db = 0;
+      DbLibDisconnect(db);
       db = initAlpideDB();
-      activityDB = 0;
-      activityDB = new ActivityDB(db);
     }
+    CheckpointCommit(comp.ID);
   }
 
 
   // Close the ROOT file and exit
-  hicQualTree->Write();
-  hicRecpTree->Write();
-  hicHSTree->Write();
-  hicStaveQualTree->Write();
-  hicStaveRecpTree->Write();
-  hicQualResTree->Write();
-  hicRecpResTree->Write();
-  hicHSResTree->Write();
-  hicStaveQualResTree->Write();
-  hicStaveRecpResTree->Write();
-  actFastListTree->Write();
+  CheckpointEnd();
+  perfStart = PerfNow();
+  hicQualTree->Write("", TObject::kOverwrite);
+  hicRecpTree->Write("", TObject::kOverwrite);
+  hicHSTree->Write("", TObject::kOverwrite);
+  hicStaveQualTree->Write("", TObject::kOverwrite);
+  hicStaveRecpTree->Write("", TObject::kOverwrite);
+  hicQualResTree->Write("", TObject::kOverwrite);
+  hicRecpResTree->Write("", TObject::kOverwrite);
+  hicHSResTree->Write("", TObject::kOverwrite);
+  hicStaveQualResTree->Write("", TObject::kOverwrite);
+  hicStaveRecpResTree->Write("", TObject::kOverwrite);
+  actFastListTree->Write("", TObject::kOverwrite);
   CloseRootFile(newPowtestFile);
+  PerfAddSample(PERF_WRITE, PerfNow() - perfStart, PerfFileSize(rootFileName.Data()));
 
 #ifdef USENCURSES
   mvprintw(LINES-4, 0, "\n ROOT file %s filled with %d activities\n", rootFileName.Data(), totActAnal);
@@ -294,24 +379,23 @@ void analyzePowerTest(const int hicid, const ComponentDB::compActivity act, Alpi
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
 // Updated:      08 Mar 2019  Mario Sitta  HIC position & Flag ML/OL staves
 // Updated:      06 Jun 2019  Mario Sitta  Get rid of timestamp from act name
+// Updated:      19 Oct 2026  DB access layer used
 //
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzePowerTest","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzePowerTest","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Get the proper path to the Power Test result files
   ActivityDB::activityLong actLong;
-  activityDB->Read(act.ID, &actLong);
+  DbLibReadActivity(db, act.ID, &actLong);
 
   string eosPath = FindEOSPath(actLong, hicType);
   if (eosPath == "") {
-    printMessage("\nanalyzePowerTest","Error: no valid EOS path found");
+    printMessage("\nanalyzePowerTest","Error: no valid EOS path found", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -333,7 +417,7 @@ void analyzePowerTest(const int hicid, const ComponentDB::compActivity act, Alpi
 
   TFile *powtestFile = OpenRootFile(rootFileName, kTRUE);
   if (!powtestFile) {
-    printMessage("\nanalyzePowerTest","Error: error opening the ROOT file");
+    printMessage("\nanalyzePowerTest","Error: error opening the ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -341,14 +425,14 @@ void analyzePowerTest(const int hicid, const ComponentDB::compActivity act, Alpi
   // Create the trees
   TTree *powtestTree = CreateTreePowerTest("powtestTree","PowerTestTree");
   if (!powtestTree) {
-    printMessage("\nanalyzePowerTest","Error: error creating the ROOT tree");
+    printMessage("\nanalyzePowerTest","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   TTree *powresulTree = CreateTreePowerTestResult("powresulTree","PowerTestResulTree");
   if (!powresulTree) {
-    printMessage("\nanalyzePowerTest","Error: error creating the ROOT tree");
+    printMessage("\nanalyzePowerTest","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -372,7 +456,7 @@ void analyzePowerTest(const int hicid, const ComponentDB::compActivity act, Alpi
       staveOLML = 2;
   }
 
-  hicPosition = DbGetPosition(db, hicid);
+  hicPosition = DbLibGetPosition(db, hicid);
   PowerTestAllChips(powtestTree, actLong, hicid, act.ID, eosPath);
   PowerTestResults(powresulTree, actLong, hicid, act.ID, eosPath, hicType);
 
@@ -390,6 +474,26 @@ void analyzePowerTest(const int hicid, const ComponentDB::compActivity act, Alpi
 
 }
 
+void mergeAllPowerTests(const int nshards, const THicType hicType)
+{
+//
+// Steering routine to merge the files produced by the shard jobs
+// of Power Tests into a single file
+//
+// Inputs:
+//          nshards : the number of shards
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  MergeAllShardFiles("PowerTest", nshards, hicType, powTestTreeNames, sizeof(powTestTreeNames)/sizeof(powTestTreeNames[0]));
+}
+
 void CopyPowTestOldToNew(const UInt_t hicid, const UInt_t actid,
                          TTree *newscan, TTree *newres,
                          TTree *oldscan, TTree *oldres)
@@ -462,6 +566,7 @@ TTree* CreateHicActListTreePT(void)
 //
 // Created:      27 Nov 2018  Mario Sitta
 // Updated:      25 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newTree = 0;
@@ -473,6 +578,8 @@ TTree* CreateHicActListTreePT(void)
     newTree->Branch("actMask", &actMask,"actMask/s");
     newTree->Branch("actOffs", &testOffset, "testOffset/L");
     newTree->Branch("actResOff", &testResOffset, "testResOffset/L");
+    newTree->Branch("actFinger", &actFingerprint, "actFingerprint/l");
+    newTree->Branch("actDbFinger", &actDbFingerprint, "actDbFingerprint/l");
   }
 
   return newTree;
@@ -581,7 +688,7 @@ TTree* CreateTreePowerTestResult(TString treeName, TString treeTitle)
   return newTree;
 }
 
-void PowerTestAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath)
+void PowerTestAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath)
 {
 //
 // Loops on chips and fills the tree for the given activity
@@ -600,8 +707,14 @@ void PowerTestAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int
 // Created:      09 Oct 2018  Mario Sitta
 // Updated:      06 Nov 2018  Mario Sitta
 // Updated:      25 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Arguments passed by reference, string arena
 //
 
+  // A new activity: the strings of the previous one are released
+  // and the messages are tagged with it
+  ArenaReset();
+  LogSetActivity(hicid, actid);
+
   hicID = hicid;
   actID = actid;
   locID = actlong.Location.ID;
@@ -616,7 +729,7 @@ void PowerTestAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int
 
 }
 
-void PowerTestResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType)
+void PowerTestResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType)
 {
 //
 // Fills the tree for the given activity results
@@ -635,6 +748,7 @@ void PowerTestResults(TTree *ftree, ActivityDB::activityLong actlong, const int
 //
 // Created:      08 Jan 2019  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Arguments passed by reference, string arena
 //
 
   hicID = hicid;
@@ -653,7 +767,7 @@ void PowerTestResults(TTree *ftree, ActivityDB::activityLong actlong, const int
 
 }
 
-Bool_t FillPowTestTree(TTree *tree, string path, string file)
+Bool_t FillPowTestTree(TTree *tree, const string &path, const string &file)
 {
 //
 // Opens the IV Current file and fills the tree
@@ -669,17 +783,22 @@ Bool_t FillPowTestTree(TTree *tree, string path, string file)
 //          true if the input file was read without error, otherwise false
 //
 // Created:      25 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Timing added, arguments passed by reference
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfEntries = tree->GetEntries();
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
+  const char *fullName;
   float  voltage, current;
 
-  fullName = path + "/" + file;
+  fullName = ArenaJoinPath(path, file);
 
-  infile = fopen(fullName.c_str(),"r");
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillPowTestTree","Warning: cannot open input file",file.c_str());
+    printMessage("FillPowTestTree","Warning: cannot open input file",file.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
@@ -695,12 +814,16 @@ Bool_t FillPowTestTree(TTree *tree, string path, string file)
 
   tree->Fill();
 
+  perfBytes += ftell(infile);
   fclose(infile);
 
+  PerfAddSample(PERF_FILLDATA, PerfNow() - perfStart, perfBytes,
+                tree->GetEntries() - perfEntries);
+
   return kTRUE;
 }
 
-Bool_t FillPowTestTreeResult(TTree *tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType)
+Bool_t FillPowTestTreeResult(TTree *tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType)
 {
 //
 // Opens the PowerTestResult file and fills the tree
@@ -724,21 +847,27 @@ Bool_t FillPowTestTreeResult(TTree *tree, string path, string file, ActivityDB::
 // Updated:      25 Jan 2019  Mario Sitta
 // Updated:      05 Feb 2019  Mario Sitta  Bug fix in reading registers
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Timing, chip numbering tables, parameter index
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfEntries = tree->GetEntries();
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
+  const char *fullName;
   float value, dummy;
   unsigned int reg, regval;
   int ichip;
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
   char *line = NULL;
   size_t len = 0;
 
-  fullName = path + "/" + file;
+  fullName = ArenaJoinPath(path, file);
 
-  infile = fopen(fullName.c_str(),"r");
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillPowTestTreeResult","Warning: cannot open input file",file.c_str());
+    printMessage("FillPowTestTreeResult","Warning: cannot open input file",file.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
@@ -880,50 +1009,38 @@ Bool_t FillPowTestTreeResult(TTree *tree, string path, string file, ActivityDB::
     // Per-chip data
     if (strstr(line,"Analogue voltage (") && strstr(line,"start")) {
       sscanf(line, "  Analogue voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-	chipAnalVoltStart[ichip-1] = value; 
-      else
-	chipAnalVoltStart[ichip] = value;
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipAnalVoltStart[ichip] = value;
     }
 
     if (strstr(line,"Analogue voltage (") && strstr(line,"end")) {
       sscanf(line, "  Analogue voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-	chipAnalVoltEnd[ichip-1] = value;
-      else
-	chipAnalVoltEnd[ichip] = value;
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipAnalVoltEnd[ichip] = value;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"start")) {
       sscanf(line, "  Digital voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltStart[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltStart[ichip] = value;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"end")) {
       sscanf(line, "  Digital voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltEnd[ichip] = value;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"start")) {
       sscanf(line, "  Temperature (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-	chipTempStart[ichip-1] = value;
-      else
-	chipTempStart[ichip] = value;
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipTempStart[ichip] = value;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"end")) {
       sscanf(line, "  Temperature (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-	chipTempEnd[ichip-1] = value;
-      else
-	chipTempEnd[ichip] = value;
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipTempEnd[ichip] = value;
     }
 
     // Specific Power Test data
@@ -977,53 +1094,38 @@ Bool_t FillPowTestTreeResult(TTree *tree, string path, string file, ActivityDB::
     if(reg == 0x700) {
       ichip &= 0x0f; // ichip is the lower 4 bits
       if(chipStartFound) {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700Start[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700Start[ichip] = regval;
       } else {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700End[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700End[ichip] = regval;
       }
     }
 
   } // while(getline(&line, &len, infile))
 
+  perfBytes += ftell(infile);
   fclose(infile);
 
   // Now get data from DB
-  vector<ActivityDB::actParameter>  parameters = actlong.Parameters;
-
-  std::vector<ActivityDB::actParameter>::iterator loop;
-  for(loop = parameters.begin(); loop != parameters.end(); loop++) {
-    ActivityDB::actParameter actpar = *loop;
-
-    if(actpar.Type.Parameter.Name.compare("Classification Version") == 0) {
-      classificVers = actpar.Value;
-      continue;
-    }
+  const TActParameters *actPars = GetActParameters(actlong);
 
-    if(actpar.Type.Parameter.Name.compare("Classification Power Test") == 0) {
-      classificPowTest = actpar.Value;
-      continue;
-    }
+  if(actPars->found[ACTPAR_VERSION])
+    classificVers = actPars->value[ACTPAR_VERSION];
 
-//    if(actpar.Type.Parameter.Name.compare("Number of Working Chips") == 0) {
-//      numWorkChips = actpar.Value;
-//      continue;
-//    }
-    
-  }
+  if(actPars->found[ACTPAR_POWER])
+    classificPowTest = actPars->value[ACTPAR_POWER];
 
   // Fill the tree, close the file and return
   tree->Fill();
 
+  PerfAddSample(PERF_FILLRES, PerfNow() - perfStart, perfBytes,
+                tree->GetEntries() - perfEntries);
+
   return kTRUE;
 }
 
-Bool_t FindActivityInPowTestTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask)
+Bool_t FindActivityInPowTestTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger)
 {
 //
 // Finds the activity in the tree
@@ -1035,11 +1137,14 @@ Bool_t FindActivityInPowTestTree(TTree* listree, const UInt_t hicid, const UInt_
 //          mask  : the activity mask
 //
 // Outputs:
+//          dbfinger : the DB data fingerprint stored with the activity
+//          finger   : the fingerprint stored with the activity
 //
 // Return:
 //          true if activity found
 //
 // Created:      09 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Stored fingerprints returned
 //
 
   Bool_t found = kFALSE;
@@ -1050,11 +1155,19 @@ Bool_t FindActivityInPowTestTree(TTree* listree, const UInt_t hicid, const UInt_
   Int_t currHicId = hicID;
   Int_t currActId = actID;
   UShort_t currMask = actMask;
+  ULong64_t currDbFinger = actDbFingerprint;
+  ULong64_t currFinger = actFingerprint;
+
+  // Files written before fingerprints were introduced have no such branches
+  actDbFingerprint = 0;
+  actFingerprint = 0;
   
   Int_t nEntries = listree->GetEntries();
   for (Int_t j = 0; j < nEntries; j++) {
     listree->GetEntry(j);
     if(hicID == hicid && actID == actid && actMask == mask) {
+      dbfinger = actDbFingerprint;
+      finger = actFingerprint;
       found = kTRUE;
       break;
     }
@@ -1064,6 +1177,8 @@ Bool_t FindActivityInPowTestTree(TTree* listree, const UInt_t hicid, const UInt_
   hicID = currHicId;
   actID = currActId;
   actMask = currMask;
+  actDbFingerprint = currDbFinger;
+  actFingerprint = currFinger;
 
   return found;
 }
@@ -1085,6 +1200,7 @@ TTree* ReadHicActListTreePT(TFile *rootfile)
 //
 // Created:      28 Nov 2018  Mario Sitta
 // Updated:      25 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newtree = 0;
@@ -1096,6 +1212,10 @@ TTree* ReadHicActListTreePT(TFile *rootfile)
     newtree->SetBranchAddress("actMask", &actMask);
     newtree->SetBranchAddress("actOffs", &testOffset);
     newtree->SetBranchAddress("actResOff", &testResOffset);
+    if(newtree->GetBranch("actFinger")) // Missing in older files
+      newtree->SetBranchAddress("actFinger", &actFingerprint);
+    if(newtree->GetBranch("actDbFinger")) // Ditto
+      newtree->SetBranchAddress("actDbFinger", &actDbFingerprint);
   }
 
   return newtree;
@@ -1275,11 +1395,12 @@ TTree* SetupHicActListTreePT(TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateHicActListTreePT();
   else
     newtree = ReadHicActListTreePT(rootfile);
@@ -1303,11 +1424,12 @@ TTree* SetupPowTestTree(TString treename, TString treetitle, TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreePowerTest(treename,treetitle);
   else
     newtree = ReadPowTestTree(treename, rootfile);
@@ -1331,11 +1453,12 @@ TTree* SetupPowTestTreeResult(TString treename, TString treetitle, TFile *rootfi
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreePowerTestResult(treename,treetitle);
   else
     newtree = ReadPowTestTreeResult(treename, rootfile);
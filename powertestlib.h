@@ -22,6 +22,8 @@
 #include "AlpideDBEndPoints.h"
 #include "THIC.h"
 #include "TScanFactory.h"
+#include "dblib.h"
+#include "perflib.h"
 
 #include <iostream>
 #include <stdio.h>
@@ -29,17 +31,18 @@
 
 //Bool_t redoFromStart;
 
-void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType);
+void analyzeAllPowerTests(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType);
 void analyzePowerTest(const int hicid, const ComponentDB::compActivity act, AlpideDB *db, const THicType hicType);
+void mergeAllPowerTests(const int nshards, const THicType hicType);
 void CopyPowTestOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newscan, TTree *newres, TTree *oldscan, TTree *oldres);
 TTree* CreateHicActListTreePT(void);
 TTree* CreateTreePowerTest(TString treeName, TString treeTitle);
 TTree* CreateTreePowerTestResult(TString treeName, TString treeTitle);
-void PowerTestAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath);
-void PowerTestResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType);
-Bool_t FillPowTestTree(TTree* tree, string path, string file);
-Bool_t FillPowTestTreeResult(TTree* tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType);
-Bool_t FindActivityInPowTestTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask);
+void PowerTestAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath);
+void PowerTestResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType);
+Bool_t FillPowTestTree(TTree* tree, const string &path, const string &file);
+Bool_t FillPowTestTreeResult(TTree* tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType);
+Bool_t FindActivityInPowTestTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger);
 TTree* ReadHicActListTreePT(TFile *rootfile);
 TTree* ReadPowTestTree(TString treename, TFile *rootfile);
 TTree* ReadPowTestTreeResult(TString treename, TFile *rootfile);
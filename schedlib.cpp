@@ -0,0 +1,509 @@
+#include "schedlib.h"
+#include "loglib.h"
+
+//
+// The task scheduler: the tasks are spread over the queues of a pool
+// of worker threads, each worker runs the tasks of its own queue and,
+// once it is empty, steals those still waiting in the queue of another
+// worker, so that a few long tasks do not leave the other cores idle.
+// The caller of SchedWait works as an additional worker until all
+// submitted tasks are done
+//
+
+// The printable name of each kind of task
+static const char* schedTaskName[SCHEDTASKKINDS] = {
+  "Threshold chip file",
+  "File read"
+};
+
+// The number of worker threads (0 = the tasks are run by the caller)
+static Int_t schedThreads = 0;
+
+// The cap on the memory of the data in flight, and the memory the
+// callers told is in use: they submit new tasks ahead only while the
+// cap is not reached (see SchedMemoryAvailable and SchedMemoryUse)
+static Long64_t schedMemory = (Long64_t)SCHEDMEMORYDEF << 20;
+static std::atomic<Long64_t> schedMemoryUsed(0);
+
+// The workers (the last one is the caller of SchedWait) and their threads
+static std::vector<TSchedWorker*> schedWorkers;
+static std::vector<std::thread> schedPool;
+
+static std::mutex schedMutex;
+static std::condition_variable schedWake;  // Wakes the idle workers
+static std::condition_variable schedDone;  // Tells all tasks are done
+static std::atomic<Long64_t> schedQueued(0);   // Tasks waiting in a queue
+static std::atomic<Long64_t> schedPending(0);  // Tasks not yet done
+static Bool_t schedStop = kFALSE;
+static UInt_t schedNext = 0;  // The queue of the next task submitted
+
+
+static bool SchedSampleSlower(const TSchedSample &sample1, const TSchedSample &sample2)
+{
+//
+// Orders the task timings from the slowest to the fastest
+//
+// Created:      19 Oct 2026
+//
+
+  return sample1.seconds > sample2.seconds;
+}
+
+static void SchedRun(const Int_t self, const TSchedTask &task, const Bool_t stolen)
+{
+//
+// Runs a task and records its timing in the worker running it
+//
+// Inputs:
+//          self   : the worker running the task
+//          task   : the task
+//          stolen : kTRUE if the task was taken from another worker
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  Double_t start = PerfNow();
+  task.func(task.arg);
+
+  TSchedSample sample;
+  sample.task = task;
+  sample.seconds = PerfNow() - start;
+  sample.worker = self;
+  sample.stolen = stolen;
+  schedWorkers[self]->samples.push_back(sample);
+  schedWorkers[self]->busy += sample.seconds;
+
+  std::lock_guard<std::mutex> lock(schedMutex);
+  if (task.done) *task.done = 1;
+  schedPending--;
+  schedDone.notify_all();
+}
+
+static Bool_t SchedTake(const Int_t self, TSchedTask &task, Bool_t &stolen)
+{
+//
+// Takes the next task for a worker: the last one of its own queue
+// or, if empty, the first one of the queue of another worker
+//
+// Inputs:
+//          self   : the worker
+//
+// Outputs:
+//          task   : the task
+//          stolen : kTRUE if the task was taken from another worker
+//
+// Return:
+//          kTRUE if a task was found, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  Int_t nworkers = schedWorkers.size();
+
+  for (Int_t k = 0; k < nworkers; k++) {
+    TSchedWorker *worker = schedWorkers[(self + k) % nworkers];
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (worker->tasks.empty()) continue;
+    if (k == 0) {
+      task = worker->tasks.back();
+      worker->tasks.pop_back();
+    } else {
+      task = worker->tasks.front();
+      worker->tasks.pop_front();
+    }
+    stolen = (k > 0);
+    schedQueued--;
+    return kTRUE;
+  }
+
+  return kFALSE;
+}
+
+static void SchedWorkerLoop(const Int_t self)
+{
+//
+// The worker threads: run the tasks until the scheduler is stopped,
+// waiting while there are none
+//
+// Inputs:
+//          self : the worker
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TSchedTask task;
+  Bool_t stolen;
+
+  while (kTRUE) {
+    if (SchedTake(self, task, stolen)) {
+      SchedRun(self, task, stolen);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(schedMutex);
+    schedWake.wait(lock, []{ return schedStop || schedQueued > 0; });
+    if (schedStop && schedQueued <= 0) return;
+  }
+}
+
+static void SchedStart(void)
+{
+//
+// Creates the workers and starts their threads (at the first task)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  for (Int_t i = 0; i <= schedThreads; i++) {
+    schedWorkers.push_back(new TSchedWorker);
+    schedWorkers.back()->busy = 0;
+  }
+
+  schedStop = kFALSE;
+  for (Int_t i = 0; i < schedThreads; i++)
+    schedPool.push_back(std::thread(SchedWorkerLoop, i));
+
+  static Bool_t registered = kFALSE;
+  if (!registered) {
+    atexit(SchedStop);
+    registered = kTRUE;
+  }
+}
+
+Long64_t SchedGetMemory(void)
+{
+//
+// Returns the cap on the memory of the data in flight
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          the memory cap in bytes
+//
+// Created:      19 Oct 2026
+//
+
+  return schedMemory;
+}
+
+Int_t SchedGetThreads(void)
+{
+//
+// Returns the number of worker threads
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          the number of worker threads (0 = the tasks are run by the caller)
+//
+// Created:      19 Oct 2026
+//
+
+  return schedThreads;
+}
+
+Bool_t SchedMemoryAvailable(const Long64_t bytes)
+{
+//
+// Tells whether some more memory can be used without the memory of
+// the data in flight going over the cap (see SchedSetMemory)
+//
+// Inputs:
+//          bytes : the memory which would be used
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the memory is available, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  return (schedMemoryUsed + bytes <= schedMemory);
+}
+
+void SchedMemoryUse(const Long64_t bytes)
+{
+//
+// Tells the memory of the data in flight: the files given out ahead
+// and the buffers kept for reuse are counted until they are released
+//
+// Inputs:
+//          bytes : the memory now used (negative if released)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  schedMemoryUsed += bytes;
+}
+
+void SchedReport(const char *logname, const char *title)
+{
+//
+// Appends the timing of the tasks run since the last SchedReset to the
+// log file: for each kind of task the time distribution, for each
+// worker the tasks run and stolen and its busy time, and the slowest
+// tasks with the HIC, activity, condition and chip they worked on
+//
+// Inputs:
+//          logname : the log file name
+//          title   : a title to identify the report
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!logname) return;
+
+  std::vector<TSchedSample> samples;
+  for (UInt_t i = 0; i < schedWorkers.size(); i++)
+    samples.insert(samples.end(), schedWorkers[i]->samples.begin(), schedWorkers[i]->samples.end());
+  if (samples.size() == 0) return;
+
+  // The records still queued go first, then this report
+  LogFlush();
+
+  FILE *logfile = fopen(logname, "a");
+  if (!logfile) return;
+
+  fprintf(logfile, "\n==== Task timing: %s (%d worker threads) ====\n", title, schedThreads);
+  fprintf(logfile, "%-20s %9s %10s %9s %9s %9s %9s\n", "Task", "Calls",
+          "Total(s)", "Mean(ms)", "p50(ms)", "p99(ms)", "Max(ms)");
+
+  for (Int_t kind = 0; kind < SCHEDTASKKINDS; kind++) {
+    std::vector<Float_t> sorted;
+    Double_t total = 0;
+    for (UInt_t i = 0; i < samples.size(); i++)
+      if (samples[i].task.kind == kind) {
+        sorted.push_back(samples[i].seconds);
+        total += samples[i].seconds;
+      }
+    Long64_t ncalls = sorted.size();
+    if (ncalls == 0) continue;
+
+    std::sort(sorted.begin(), sorted.end());
+    fprintf(logfile, "%-20s %9lld %10.3f %9.3f %9.3f %9.3f %9.3f\n",
+            schedTaskName[kind], ncalls, total, 1000*total/ncalls,
+            1000*sorted[(ncalls - 1)/2], 1000*sorted[(ncalls - 1)*99/100],
+            1000*sorted[ncalls - 1]);
+  }
+
+  fprintf(logfile, "%-20s %9s %10s %9s\n", "Worker", "Tasks", "Busy(s)", "Stolen");
+  for (UInt_t i = 0; i < schedWorkers.size(); i++) {
+    Long64_t nstolen = 0;
+    for (UInt_t j = 0; j < schedWorkers[i]->samples.size(); j++)
+      if (schedWorkers[i]->samples[j].stolen) nstolen++;
+    char name[32] = "caller";
+    if ((Int_t)i < schedThreads) snprintf(name, sizeof(name), "thread %d", i);
+    fprintf(logfile, "%-20s %9lld %10.3f %9lld\n", name,
+            (Long64_t)schedWorkers[i]->samples.size(), schedWorkers[i]->busy, nstolen);
+  }
+
+  UInt_t nslow = std::min((UInt_t)SCHEDSLOWEST, (UInt_t)samples.size());
+  std::partial_sort(samples.begin(), samples.begin() + nslow, samples.end(), SchedSampleSlower);
+  fprintf(logfile, "Slowest tasks:\n");
+  for (UInt_t i = 0; i < nslow; i++)
+    fprintf(logfile, "  %-20s hic %6d act %6d cond %3d chip %2d %9.3f ms\n",
+            schedTaskName[samples[i].task.kind], samples[i].task.hicID,
+            samples[i].task.actID, samples[i].task.cond, samples[i].task.chip,
+            1000*samples[i].seconds);
+
+  fclose(logfile);
+}
+
+void SchedReset(void)
+{
+//
+// Clears the timing of the tasks run so far (at the start of a run)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  for (UInt_t i = 0; i < schedWorkers.size(); i++) {
+    schedWorkers[i]->samples.clear();
+    schedWorkers[i]->busy = 0;
+  }
+}
+
+void SchedSetMemory(const Long64_t mbytes)
+{
+//
+// Sets the cap on the memory of the data in flight, i.e. the files
+// read ahead and the buffers kept for reuse: the files are read ahead
+// by the workers only while it is not reached, and the buffers which
+// would exceed it are freed rather than kept
+//
+// Inputs:
+//          mbytes : the memory cap in MB
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  schedMemory = mbytes << 20;
+}
+
+Bool_t SchedSetThreads(const Int_t nthreads)
+{
+//
+// Sets the number of worker threads running the tasks (to be called
+// before the first task is submitted)
+//
+// Inputs:
+//          nthreads : the number of threads (0 = one per core)
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the number was set, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  if (nthreads < 0 || schedWorkers.size() > 0) return kFALSE;
+
+  schedThreads = nthreads;
+  if (schedThreads == 0)
+    schedThreads = std::max(1U, std::thread::hardware_concurrency());
+
+  return kTRUE;
+}
+
+void SchedStop(void)
+{
+//
+// Stops the worker threads once their queues are empty (called at exit)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  {
+    std::lock_guard<std::mutex> lock(schedMutex);
+    schedStop = kTRUE;
+  }
+  schedWake.notify_all();
+
+  for (UInt_t i = 0; i < schedPool.size(); i++)
+    if (schedPool[i].joinable()) schedPool[i].join();
+  schedPool.clear();
+
+  for (UInt_t i = 0; i < schedWorkers.size(); i++)
+    delete schedWorkers[i];
+  schedWorkers.clear();
+}
+
+void SchedSubmit(const TSchedTask &task)
+{
+//
+// Submits a task: it is queued to a worker, in turn, and will be run
+// by it or by another one which steals it. With no worker threads it
+// is run at once by the caller
+//
+// Inputs:
+//          task : the task
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (schedWorkers.size() == 0) SchedStart();
+
+  schedPending++;
+
+  if (schedThreads == 0) {
+    SchedRun(0, task, kFALSE);
+    return;
+  }
+
+  TSchedWorker *worker = schedWorkers[(schedNext++) % schedThreads];
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->tasks.push_back(task);
+  }
+  {
+    std::lock_guard<std::mutex> lock(schedMutex);
+    schedQueued++;
+  }
+  schedWake.notify_one();
+}
+
+void SchedWait(const Int_t *done)
+{
+//
+// Waits until a task is done (the one with the given done flag), or
+// all submitted tasks are done, running those still queued meanwhile
+//
+// Inputs:
+//          done : the done flag of the task (0 = wait for all tasks)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TSchedTask task;
+  Bool_t stolen;
+
+  while (kTRUE) {
+    // The task waited for may be done while running others: return at
+    // once, so that its result is used without waiting for the queue
+    if (done) {
+      std::lock_guard<std::mutex> lock(schedMutex);
+      if (*done) return;
+    }
+
+    if (SchedTake(schedThreads, task, stolen)) {
+      SchedRun(schedThreads, task, stolen);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(schedMutex);
+    schedDone.wait(lock, [done]{ return (done ? *done : schedPending <= 0) || schedQueued > 0; });
+    if (done ? *done : schedPending <= 0) return;
+  }
+}
@@ -0,0 +1,70 @@
+#ifndef SCHEDLIB_H
+#define SCHEDLIB_H
+
+#include <Rtypes.h>
+
+#include "perflib.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+// The kinds of task run by the workers (see schedTaskName)
+#define SCHEDTASK_THRESCAN 0  // Read and scan a Threshold Scan chip file
+#define SCHEDTASK_READFILE 1  // Read a file of a batch (see iolib)
+#define SCHEDTASKKINDS     2
+
+// Number of slowest tasks listed in the report
+#define SCHEDSLOWEST 10
+
+#define SCHEDMEMORYDEF 2048 // Default memory cap in MB
+
+// A task: the function to run on its argument, and the HIC, activity,
+// condition and chip it works on (only used to report its timing)
+struct TSchedTask {
+  void  (*func)(void *arg);
+  void   *arg;
+  Int_t   kind;    // one of SCHEDTASK_*
+  Int_t   hicID;
+  Int_t   actID;
+  Int_t   cond;
+  Int_t   chip;
+  Int_t  *done;    // if not 0, set to 1 when the task is done (see SchedWait)
+};
+
+// The timing of a task which was run
+struct TSchedSample {
+  TSchedTask task;
+  Float_t    seconds;
+  Int_t      worker;  // the worker which ran it
+  Bool_t     stolen;  // kTRUE if taken from another worker queue
+};
+
+// A worker: its queue of tasks (the owner takes from the back, the
+// others steal from the front) and the timing of the tasks it ran
+struct TSchedWorker {
+  std::mutex                mutex;
+  std::deque<TSchedTask>    tasks;
+  std::vector<TSchedSample> samples;
+  Double_t                  busy;  // seconds spent running tasks
+};
+
+Long64_t SchedGetMemory(void);
+Int_t SchedGetThreads(void);
+Bool_t SchedMemoryAvailable(const Long64_t bytes);
+void SchedMemoryUse(const Long64_t bytes);
+void SchedReport(const char *logname, const char *title);
+void SchedReset(void);
+void SchedSetMemory(const Long64_t mbytes);
+Bool_t SchedSetThreads(const Int_t nthreads);
+void SchedStop(void);
+void SchedSubmit(const TSchedTask &task);
+void SchedWait(const Int_t *done=0);
+
+#endif // SCHEDLIB_H
@@ -0,0 +1,390 @@
+#include "sortlib.h"
+#include "menulib.h"
+
+// The order the pixel trees are sorted on (see SORTKEY_*)
+static Int_t sortKey = SORTKEY_NONE;
+
+// The memory budget of the sort in bytes
+static Long64_t sortMemory = (Long64_t)SORTMEMORYDEF << 20;
+
+// Local variables of the key branches of the tree being sorted
+static UInt_t   sortHicID;
+static UInt_t   sortActID;
+static UChar_t  sortCondVB;
+static UChar_t  sortChipNum;
+static UShort_t sortColNum;
+static UShort_t sortRowNum;
+static std::vector<TBranch*> sortKeyBranches;
+
+
+Int_t GetPixelSortKey(void)
+{
+//
+// Returns the order the pixel trees are sorted on
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          one of SORTKEY_*
+//
+// Created:      19 Oct 2026
+//
+
+  return sortKey;
+}
+
+void SetPixelSortKey(const Int_t key)
+{
+//
+// Sets the order the pixel trees are sorted on instead of analysing
+// the HICs (see SortPixelRootFile)
+//
+// Inputs:
+//          key : one of SORTKEY_*
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  sortKey = key;
+}
+
+void SetPixelSortMemory(const Long64_t mbytes)
+{
+//
+// Sets the memory budget of the sort: the runs sorted in memory
+// and the baskets read while sorting them do not exceed it
+//
+// Inputs:
+//          mbytes : the memory budget in MB
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  sortMemory = mbytes << 20;
+}
+
+bool SortEntryLess(const TSortEntry &entry1, const TSortEntry &entry2)
+{
+//
+// Orders the entries on their key, then on their position in the tree
+// (so that the sort is stable)
+//
+// Created:      19 Oct 2026
+//
+
+  if (entry1.key[0] != entry2.key[0]) return entry1.key[0] < entry2.key[0];
+  if (entry1.key[1] != entry2.key[1]) return entry1.key[1] < entry2.key[1];
+  return entry1.entry < entry2.entry;
+}
+
+static void SortMergeRuns(TTree *tree, TFile *spillfile, const std::vector<TString> &runnames, const UInt_t first, const UInt_t last, TTree *outtree, ULong64_t *outkey, const Long64_t cachesize)
+{
+//
+// Merges some runs of a spill file (a k-way merge) into a tree: only
+// the key of the next entry of each run is read, the whole entry is
+// read when it is the smallest and copied. The runs merged are deleted
+// from the spill file
+//
+// Inputs:
+//          tree      : the tree being sorted, whose branch buffers are
+//                      shared with the runs and with outtree
+//          spillfile : the spill file
+//          runnames  : the names of the runs in the spill file
+//          first     : the first run to merge
+//          last      : the run after the last one to merge
+//          outtree   : the tree to fill
+//          outkey    : if not 0, the buffer of the sortKey branch of outtree
+//          cachesize : the size of the read cache of each run
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const Int_t nruns = last - first;
+  std::vector<TTree*> runTrees(nruns);
+  std::vector<TBranch*> runKeyBranches(nruns);
+  std::vector<ULong64_t> runKeys(2*nruns);
+  std::vector<Long64_t> runPos(nruns, 0);
+  std::priority_queue<TSortHead, std::vector<TSortHead>, std::greater<TSortHead> > heads;
+  TSortHead head;
+
+  for (Int_t irun = 0; irun < nruns; irun++) {
+    runTrees[irun] = (TTree*)spillfile->Get(runnames[first + irun]);
+    runTrees[irun]->SetCacheSize(cachesize);
+    tree->CopyAddresses(runTrees[irun]);
+    runTrees[irun]->SetBranchAddress("sortKey", &runKeys[2*irun]);
+    runKeyBranches[irun] = runTrees[irun]->GetBranch("sortKey");
+    runKeyBranches[irun]->GetEntry(0);
+    head.key[0] = runKeys[2*irun];
+    head.key[1] = runKeys[2*irun+1];
+    head.run = irun;
+    heads.push(head);
+  }
+
+  while (!heads.empty()) {
+    Int_t irun = heads.top().run;
+    heads.pop();
+    runTrees[irun]->GetEntry(runPos[irun]);
+    if (outkey) {
+      outkey[0] = runKeys[2*irun];
+      outkey[1] = runKeys[2*irun+1];
+    }
+    outtree->Fill();
+    if (++runPos[irun] < runTrees[irun]->GetEntries()) {
+      runKeyBranches[irun]->GetEntry(runPos[irun]);
+      head.key[0] = runKeys[2*irun];
+      head.key[1] = runKeys[2*irun+1];
+      head.run = irun;
+      heads.push(head);
+    }
+  }
+
+  for (Int_t irun = 0; irun < nruns; irun++) {
+    delete runTrees[irun];
+    spillfile->Delete(runnames[first + irun] + ";*");
+  }
+}
+
+Bool_t SortPixelRootFile(TString rootfilename, const TActTreeNames *treenames, const Int_t ntypes, TString &sortedname)
+{
+//
+// Writes the pixel trees of a file sorted on the current key (see
+// SetPixelSortKey) into a new file: since the entries move, the file
+// has only the pixel trees, and not the result and activity list trees
+//
+// Inputs:
+//          rootfilename : the file name
+//          treenames    : the names of the trees of each activity type
+//          ntypes       : the number of activity types
+//
+// Outputs:
+//          sortedname   : the name of the sorted file
+//
+// Return:
+//          kTRUE if the trees were sorted, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  if (!CheckRootFileExists(rootfilename)) {
+    printMessage("\nSortPixelRootFile","Error: missing file",rootfilename.Data(), LOG_ERROR);
+    return kFALSE;
+  }
+
+  TFile *inFile = OpenRootFile(rootfilename);
+  if (!inFile || inFile->IsZombie()) {
+    printMessage("\nSortPixelRootFile","Error: cannot open file",rootfilename.Data(), LOG_ERROR);
+    return kFALSE;
+  }
+
+  sortedname = rootfilename;
+  sortedname.ReplaceAll(".root", (sortKey == SORTKEY_PIXEL) ? "_PixelSorted.root" : "_ChipSorted.root");
+  TFile *outFile = OpenRootFile(sortedname, kTRUE);
+  if (!outFile) {
+    printMessage("\nSortPixelRootFile","Error: cannot open file",sortedname.Data(), LOG_ERROR);
+    CloseRootFile(inFile);
+    return kFALSE;
+  }
+
+  TString spillName = sortedname;
+  spillName.ReplaceAll(".root", "_spill.root");
+
+  Bool_t ok = kTRUE;
+  for (Int_t itype = 0; itype < ntypes && ok; itype++) {
+    const char *names[2] = {treenames[itype].testTree, treenames[itype].tuneTree};
+    for (Int_t i = 0; i < 2 && ok; i++) {
+      if (!names[i]) continue;
+      TTree *tree = (TTree*)inFile->Get(names[i]);
+      if (!tree) continue; // Tree can be missing if never written
+      ok = SortPixelTree(tree, outFile, spillName);
+    }
+  }
+
+  CloseRootFile(outFile);
+  CloseRootFile(inFile);
+
+  // Do not leave a partially sorted file around
+  if (!ok)
+    remove(sortedname.Data());
+
+  return ok;
+}
+
+Bool_t SortPixelTree(TTree *tree, TFile *outfile, TString spillname)
+{
+//
+// Sorts a pixel tree with an external merge sort: runs of entries
+// which fit in the memory budget are sorted in memory and written
+// to a spill file, then the runs are merged (a k-way merge) into the
+// sorted tree, at most SORTMERGEFANIN at a time. In the packed layout the entries are whole chips, so
+// only the HIC, activity, chip and condition are used as key
+//
+// Inputs:
+//          tree      : the pixel tree (read from file)
+//          outfile   : the (already opened) file of the sorted tree
+//          spillname : the name of the spill file (removed at the end)
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the tree was sorted, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  // Bind the key branches to the local variables: the other branches
+  // use the buffers allocated by ROOT, shared with the copies of the tree
+  const char *keyNames[6] = {"hicID", "actID", "condVB", "chipNum", "colNum", "rowNum"};
+  void *keyAddr[6] = {&sortHicID, &sortActID, &sortCondVB, &sortChipNum, &sortColNum, &sortRowNum};
+  const Int_t nkeys = IsPackedPixelTree(tree) ? 4 : 6;
+
+  sortKeyBranches.clear();
+  sortColNum = sortRowNum = 0;
+  for (Int_t i = 0; i < nkeys; i++) {
+    if (!tree->GetBranch(keyNames[i])) continue; // No colNum/rowNum in old Noise Scan files
+    tree->SetBranchAddress(keyNames[i], keyAddr[i]);
+    sortKeyBranches.push_back(tree->GetBranch(keyNames[i]));
+  }
+
+  // Half of the budget goes to the keys of a run, half to its baskets,
+  // which are kept in memory while the run is read out of order
+  const Long64_t keyMemory = sortMemory/2;
+  const Long64_t basketMemory = sortMemory - keyMemory;
+
+  Long64_t nEntries = tree->GetEntries();
+  Long64_t entryBytes = TMath::Max((Long64_t)1, nEntries > 0 ? tree->GetTotBytes()/nEntries : 0);
+  Long64_t runSize = TMath::Min(keyMemory/(Long64_t)sizeof(TSortEntry), basketMemory/entryBytes);
+  runSize = TMath::Max((Long64_t)1, runSize);
+  Int_t nRuns = (nEntries + runSize - 1)/runSize;
+
+  tree->SetMaxVirtualSize(basketMemory);
+
+  // If all fits in memory there is no need to spill
+  if (nRuns <= 1) {
+    outfile->cd();
+    TTree *sortedTree = tree->CloneTree(0);
+    SortWriteRun(tree, 0, nEntries, sortedTree, 0);
+    tree->SetMaxVirtualSize(0);
+    sortedTree->Write();
+    return kTRUE;
+  }
+
+  TFile *spillFile = OpenRootFile(spillname, kTRUE);
+  if (!spillFile) {
+    printMessage("\nSortPixelTree","Error: cannot open spill file",spillname.Data(), LOG_ERROR);
+    tree->SetMaxVirtualSize(0);
+    return kFALSE;
+  }
+
+  ULong64_t runKey[2];
+  for (Int_t irun = 0; irun < nRuns; irun++) {
+    spillFile->cd();
+    TTree *runTree = tree->CloneTree(0);
+    runTree->SetName(Form("run%d", irun));
+    runTree->Branch("sortKey", runKey, "sortKey[2]/l");
+    SortWriteRun(tree, irun*runSize, TMath::Min(nEntries, (irun+1)*runSize), runTree, runKey);
+    runTree->Write();
+    delete runTree;
+  }
+  tree->SetMaxVirtualSize(0);
+
+  // Merge the runs, at most SORTMERGEFANIN at a time, each one with its
+  // share of the basket budget as read cache: while there are more, the
+  // groups of runs are merged into longer runs of the spill file
+  std::vector<TString> runNames(nRuns);
+  for (Int_t irun = 0; irun < nRuns; irun++)
+    runNames[irun] = Form("run%d", irun);
+  const Long64_t cacheSize = basketMemory/SORTMERGEFANIN;
+
+  Int_t nextRun = nRuns;
+  while (runNames.size() > SORTMERGEFANIN) {
+    std::vector<TString> mergedNames;
+    for (UInt_t first = 0; first < runNames.size(); first += SORTMERGEFANIN) {
+      UInt_t last = TMath::Min((UInt_t)runNames.size(), first + SORTMERGEFANIN);
+      if (last - first == 1) {
+        mergedNames.push_back(runNames[first]);
+        continue;
+      }
+      spillFile->cd();
+      TTree *runTree = tree->CloneTree(0);
+      runTree->SetName(Form("run%d", nextRun));
+      runTree->Branch("sortKey", runKey, "sortKey[2]/l");
+      SortMergeRuns(tree, spillFile, runNames, first, last, runTree, runKey, cacheSize);
+      runTree->Write();
+      delete runTree;
+      mergedNames.push_back(Form("run%d", nextRun++));
+    }
+    runNames.swap(mergedNames);
+  }
+
+  outfile->cd();
+  TTree *sortedTree = tree->CloneTree(0);
+  SortMergeRuns(tree, spillFile, runNames, 0, runNames.size(), sortedTree, 0, cacheSize);
+  sortedTree->Write();
+
+  CloseRootFile(spillFile);
+  remove(spillname.Data());
+
+  return kTRUE;
+}
+
+void SortWriteRun(TTree *tree, const Long64_t first, const Long64_t last, TTree *outtree, ULong64_t *outkey)
+{
+//
+// Sorts a run of entries in memory and fills the output tree with them
+//
+// Inputs:
+//          tree    : the tree (with the key branches bound)
+//          first   : the first entry of the run
+//          last    : the entry after the last one of the run
+//          outtree : the tree to fill, sharing the branch buffers of tree
+//          outkey  : if not 0, the buffer of the sortKey branch of outtree
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  std::vector<TSortEntry> entries(last - first);
+
+  // Only the key branches are read to build the keys
+  for (Long64_t j = first; j < last; j++) {
+    for (UInt_t i = 0; i < sortKeyBranches.size(); i++)
+      sortKeyBranches[i]->GetEntry(j);
+    TSortEntry &entry = entries[j - first];
+    entry.entry = j;
+    entry.key[0] = ((ULong64_t)sortHicID << 32) | sortActID;
+    if (sortKey == SORTKEY_PIXEL)
+      entry.key[1] = ((ULong64_t)sortChipNum << 48) | ((ULong64_t)sortRowNum << 32) |
+                     ((ULong64_t)sortColNum << 16) | sortCondVB;
+    else
+      entry.key[1] = ((ULong64_t)sortChipNum << 48) | ((ULong64_t)sortCondVB << 32) |
+                     ((ULong64_t)sortRowNum << 16) | sortColNum;
+  }
+
+  std::sort(entries.begin(), entries.end(), SortEntryLess);
+
+  for (UInt_t i = 0; i < entries.size(); i++) {
+    tree->GetEntry(entries[i].entry);
+    if (outkey) {
+      outkey[0] = entries[i].key[0];
+      outkey[1] = entries[i].key[1];
+    }
+    outtree->Fill();
+  }
+}
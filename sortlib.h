@@ -0,0 +1,50 @@
+#ifndef SORTLIB_H
+#define SORTLIB_H
+
+#include <Rtypes.h>
+#include <TBranch.h>
+#include <TFile.h>
+#include <TString.h>
+#include <TTree.h>
+
+#include "utillib.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <stdio.h>
+#include <vector>
+
+// The orders the pixel trees can be sorted on
+#define SORTKEY_NONE  0
+#define SORTKEY_CHIP  1  // HIC, activity, chip, condition, row, column
+#define SORTKEY_PIXEL 2  // HIC, activity, chip, row, column, condition
+
+#define SORTMEMORYDEF 512 // Default memory budget in MB
+#define SORTMERGEFANIN 16 // Runs merged at a time
+
+// An entry of a tree with its sort key
+struct TSortEntry {
+  ULong64_t key[2];  // HIC and activity, then the rest of the key
+  Long64_t  entry;
+};
+
+// The current entry of a run, in the k-way merge
+struct TSortHead {
+  ULong64_t key[2];
+  Int_t     run;
+  bool operator>(const TSortHead &other) const {
+    return (key[0] != other.key[0]) ? (key[0] > other.key[0]) :
+           (key[1] != other.key[1]) ? (key[1] > other.key[1]) : (run > other.run);
+  }
+};
+
+Int_t GetPixelSortKey(void);
+void SetPixelSortKey(const Int_t key);
+void SetPixelSortMemory(const Long64_t mbytes);
+bool SortEntryLess(const TSortEntry &entry1, const TSortEntry &entry2);
+Bool_t SortPixelRootFile(TString rootfilename, const TActTreeNames *treenames, const Int_t ntypes, TString &sortedname);
+Bool_t SortPixelTree(TTree *tree, TFile *outfile, TString spillname);
+void SortWriteRun(TTree *tree, const Long64_t first, const Long64_t last, TTree *outtree, ULong64_t *outkey);
+
+#endif // SORTLIB_H
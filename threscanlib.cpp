@@ -25,8 +25,32 @@ Float_t  noiseRMS[NUMCHIPS];
 Int_t    classificThreScan;
 static Long64_t testTunOffset;
 
-
-void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType)
+// Local arrays of the packed pixel trees (see SetPackedPixelTrees)
+static Int_t    pixNum;
+static std::vector<UShort_t> colArr;
+static std::vector<UShort_t> rowArr;
+static std::vector<UShort_t> thresArr;
+static std::vector<UShort_t> noiseArr;
+
+// The free buffers of the chip files (see TThreScanPixels), and their memory
+static std::vector<TThreScanPixels*> pixelsPool;
+static Long64_t pixelsPoolMemory = 0;
+
+// The bytes of the chip files read so far, from which the memory of
+// the next ones is estimated before they are read
+static Long64_t chipFilesBytes = 0;
+static Long64_t chipFilesRead = 0;
+
+// The trees of each activity type (see MergeShardRootFiles)
+static const TActTreeNames thrScanTreeNames[] = {
+  {ACTMASK_QUALIF, "hicQualTree", "hicQualTunTree", "hicQualResTree"},
+  {ACTMASK_RECEPT, "hicRecpTree", "hicRecpTunTree", "hicRecpResTree"},
+  {ACTMASK_HALFST, "hicHSTree", "hicHSTunTree", "hicHSResTree"},
+  {ACTMASK_STAVET, "hicStaveTree", "hicStaveTunTree", "hicStaveResTree"}
+};
+
+
+void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType)
 {
 //
 // Steering routine to analyze the data of all Threshold Scans for all HICs
@@ -46,6 +70,7 @@ void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> component
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
 // Updated:      05 Jul 2019  Mario Sitta  Chip Wafer and position added
 // Updated:      16 Sep 2019  Mario Sitta  HIC name added
+// Updated:      19 Oct 2026  Append in place, checkpoints, wafer map tree
 //
 
   // We need to define here the TTree's for the existing ROOT file
@@ -55,14 +80,12 @@ void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> component
   TTree *oldActFastListTree = 0;
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeAllThresholdScans","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeAllThresholdScans","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Check whether the ROOT file already exists
   // If yes, ask the user whether to use it or redo a new one
   TString rootFileName;
@@ -70,21 +93,30 @@ void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> component
     rootFileName = "IBHIC_ThresholdScan_AllHICs.root";
   else
     rootFileName = "OBHIC_ThresholdScan_AllHICs.root";
+  rootFileName = ShardRootFileName(rootFileName);
 
   redoFromStart = kTRUE;
+  appendToFile = kFALSE;
+  TString oldRootFileName; // Set if the activities are copied from it
   if(CheckRootFileExists(rootFileName)) {
-    if(AskUserRedoScan() == 2) { // User chose to re-use existing tree
+    Int_t userChoice = AskUserRedoScan();
+    if(userChoice == 3) { // User chose to append to existing trees
+      appendToFile = kTRUE;
+      // A resumed run goes on copying from the old file, if it did
+      if(CheckpointOldFile(rootFileName, oldRootFileName))
+        userChoice = 2;
+    }
+    if(userChoice == 2) { // User chose to re-use existing tree
       redoFromStart = kFALSE;
-      TString oldRootFileName;
-      if(!RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
-        printMessage("\nanalyzeAllThresholdScans","Error: error renaming existing ROOT file");
+      if(!appendToFile && !RenameExistingRootFile(rootFileName, "_old", oldRootFileName)) {
+        printMessage("\nanalyzeAllThresholdScans","Error: error renaming existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
 
       TFile *oldThrescanFile = OpenRootFile(oldRootFileName);
       if(!oldThrescanFile) {
-        printMessage("\nanalyzeAllThresholdScans","Error: error opening existing ROOT file");
+        printMessage("\nanalyzeAllThresholdScans","Error: error opening existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -110,7 +142,7 @@ void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> component
          !oldHicQualTunTree || !oldHicRecpTunTree || !oldHicHSTunTree || !oldHicStaveTunTree ||
          !oldHicQualResTree || !oldHicRecpResTree || !oldHicHSResTree || !oldHicStaveResTree ||
          !oldActFastListTree) {
-        printMessage("\nanalyzeAllThresholdScans","Error: error reading trees from existing ROOT file");
+        printMessage("\nanalyzeAllThresholdScans","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
         f12ToExit();
         return;
       }
@@ -118,52 +150,125 @@ void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> component
   } // if(CheckRootFileExists())
 
   // Open the ROOT file
-  TFile *newThrescanFile = OpenRootFile(rootFileName, kTRUE);
+  TFile *newThrescanFile = OpenRootFile(rootFileName, !appendToFile, appendToFile);
 
   if(!newThrescanFile) {
-    printMessage("\nanalyzeAllThresholdScans","Error: error opening new ROOT file");
+    printMessage("\nanalyzeAllThresholdScans","Error: error opening new ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   // Create or read the trees
-  TTree *hicQualTree = CreateTreeThresholdScan("hicQualTree","HicQualificationTest");
-  TTree *hicRecpTree = CreateTreeThresholdScan("hicRecpTree","HicReceptionTest");
-  TTree *hicHSTree = CreateTreeThresholdScan("hicHSTree","HicHalfStaveTest");
-  TTree *hicStaveTree = CreateTreeThresholdScan("hicStaveTree","HicStaveTest");
+  TTree *hicQualTree = SetupThreScanTree("hicQualTree","HicQualificationTest",newThrescanFile);
+  TTree *hicRecpTree = SetupThreScanTree("hicRecpTree","HicReceptionTest",newThrescanFile);
+  TTree *hicHSTree = SetupThreScanTree("hicHSTree","HicHalfStaveTest",newThrescanFile);
+  TTree *hicStaveTree = SetupThreScanTree("hicStaveTree","HicStaveTest",newThrescanFile);
+
+  TTree *hicQualTunTree = SetupThreScanTree("hicQualTunTree","HicQualifTuneTest",newThrescanFile);
+  TTree *hicRecpTunTree = SetupThreScanTree("hicRecpTunTree","HicReceptTuneTest",newThrescanFile);
+  TTree *hicHSTunTree = SetupThreScanTree("hicHSTunTree","HicHalfStavTuneTest",newThrescanFile);
+  TTree *hicStaveTunTree = SetupThreScanTree("hicStaveTunTree","HicStaveTuneTest",newThrescanFile);
+
+  TTree *hicQualResTree = SetupThreScanTreeResult("hicQualResTree","HicQualificationTestResults",newThrescanFile);
+  TTree *hicRecpResTree = SetupThreScanTreeResult("hicRecpResTree","HicReceptionTestResults",newThrescanFile);
+  TTree *hicHSResTree = SetupThreScanTreeResult("hicHSResTree","HicHalfStaveTestResults",newThrescanFile);
+  TTree *hicStaveResTree = SetupThreScanTreeResult("hicStaveResTree","HicStaveTestResults",newThrescanFile);
+
+  TTree *actFastListTree = SetupHicActListTreeTS(newThrescanFile);
+
+  TTree *waferMapTree = SetupThreScanTreeWaferMap("waferMapTree","HicWaferMaps",newThrescanFile);
+
+  if(!hicQualTree || !hicRecpTree || !hicHSTree || !hicStaveTree ||
+     !hicQualTunTree || !hicRecpTunTree || !hicHSTunTree || !hicStaveTunTree ||
+     !hicQualResTree || !hicRecpResTree || !hicHSResTree || !hicStaveResTree ||
+     !actFastListTree || !waferMapTree) { // Only possible when reading from file
+    printMessage("\nanalyzeAllThresholdScans","Error: error reading trees from existing ROOT file", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
 
-  TTree *hicQualTunTree = CreateTreeThresholdScan("hicQualTunTree","HicQualifTuneTest");
-  TTree *hicRecpTunTree = CreateTreeThresholdScan("hicRecpTunTree","HicReceptTuneTest");
-  TTree *hicHSTunTree = CreateTreeThresholdScan("hicHSTunTree","HicHalfStavTuneTest");
-  TTree *hicStaveTunTree = CreateTreeThresholdScan("hicStaveTunTree","HicStaveTuneTest");
+  // When appending, index the activities already in the file with their
+  // DB fingerprint, so that the unchanged ones are skipped and the changed
+  // ones are replaced (see AddChangedActivity)
+  std::map<ULong64_t, ULong64_t> actIndex;
+  if(appendToFile)
+    for (Long64_t j = 0; j < actFastListTree->GetEntries(); j++) {
+      actDbFingerprint = 0; // Not in files written before fingerprints
+      actFastListTree->GetEntry(j);
+      actIndex[ActivityKey(hicID, actID)] = actDbFingerprint;
+    }
 
-  TTree *hicQualResTree = CreateTreeThresholdScanResult("hicQualResTree","HicQualificationTestResults");
-  TTree *hicRecpResTree = CreateTreeThresholdScanResult("hicRecpResTree","HicReceptionTestResults");
-  TTree *hicHSResTree = CreateTreeThresholdScanResult("hicHSResTree","HicHalfStaveTestResults");
-  TTree *hicStaveResTree = CreateTreeThresholdScanResult("hicStaveResTree","HicStaveTestResults");
+  // Likewise the HICs already in the wafer map tree are not added again
+  std::set<UInt_t> waferIndex;
+  if(appendToFile)
+    for (Long64_t j = 0; j < waferMapTree->GetEntries(); j++) {
+      waferMapTree->GetEntry(j);
+      waferIndex.insert(hicID);
+    }
 
-  TTree *actFastListTree = CreateHicActListTreeTS();
+  // The trees are saved together every CHECKPOINTMIN minutes, so that
+  // a broken run can be resumed after the last HIC saved (--resume)
+  TTree *ckptTrees[] = {hicQualTree, hicRecpTree, hicHSTree, hicStaveTree, hicQualTunTree,
+                         hicRecpTunTree, hicHSTunTree, hicStaveTunTree, hicQualResTree,
+                         hicRecpResTree, hicHSResTree, hicStaveResTree, actFastListTree,
+                         waferMapTree};
+  UInt_t firstComp = CheckpointBegin(newThrescanFile, ckptTrees, sizeof(ckptTrees)/sizeof(TTree*), componentList, oldRootFileName);
 
   // Loop on all components
   int totHICAnal = 0, totActAnal = 0;
+  Double_t perfStart;
   std::vector<ComponentDB::compActivity> tests;
   std::vector<ComponentDB::componentShort>::iterator iComp;
-  for (iComp = componentList.begin(); iComp != componentList.end(); iComp++) {
+  for (iComp = componentList.begin() + firstComp; iComp != componentList.end(); iComp++) {
     ComponentDB::componentShort comp = *iComp;
-    DbGetAllTests (db, comp.ID, tests, STThreshold, true);
+    perfStart = PerfNow();
+    DbLibGetAllTests (db, comp.ID, tests, STThreshold, true);
+    PerfAddSample(PERF_DBLIST, PerfNow() - perfStart);
+
+    // In watch mode a HIC whose activities did not change since the last
+    // poll is not looked at again
+    if(appendToFile && !WatchHicChanged(comp.ID, tests)) {
+      PerfCount(PERF_NHICSKIP);
+      continue;
+    }
 
     // Get the list of chips in this HIC
     std::vector<TChild> children;
-    int nChildren = DbGetListOfChildren(db, comp.ID, children, true);
+    perfStart = PerfNow();
+    int nChildren = DbLibGetListOfChildren(db, comp.ID, children, true);
+    PerfAddSample(PERF_DBCHILD, PerfNow() - perfStart);
     if (nChildren == 0)
-      printMessage("\nanalyzeThresholdScan","Warning: HIC has no children ", comp.ComponentID.c_str());
+      printMessage("\nanalyzeThresholdScan","Warning: HIC has no children ", comp.ComponentID.c_str(), LOG_WARNING);
+
+    // The wafer map of the HIC is built once for all its activities
+    const TWaferMap *waferMap = GetHicWaferMap(comp.ID, hicType, children);
+    if(waferIndex.count(comp.ID) == 0) {
+      strncpy(hicName, comp.ComponentID.c_str(), HICNAMELEN-1);
+      FillThreScanWaferMapTree(waferMapTree, comp.ID, hicType, waferMap);
+      waferIndex.insert(comp.ID);
+    }
 
     // Loop on all activities
     std::vector<ComponentDB::compActivity>::iterator it;
     for(it = tests.begin(); it != tests.end(); it++) {
       ComponentDB::compActivity act = *it;
       ActivityDB::activityLong actLong;
-      activityDB->Read(act.ID, &actLong);
+      perfStart = PerfNow();
+      DbLibReadActivity(db, act.ID, &actLong);
+      PerfAddSample(PERF_DBREAD, PerfNow() - perfStart);
+
+      // Already in file: skipped if unchanged, otherwise the file is
+      // rewritten afterwards to replace its entries
+      std::map<ULong64_t, ULong64_t>::iterator stored;
+      if(appendToFile &&
+         (stored = actIndex.find(ActivityKey(comp.ID, act.ID))) != actIndex.end()) {
+        if(stored->second != 0 && stored->second != ActivityDBFingerprint(actLong)) {
+          AddChangedActivity();
+          PerfCount(PERF_NACTCHANGED);
+        } else
+          PerfCount(PERF_NACTSKIP);
+        continue;
+      }
 
       TTree *testree = 0, *testuntree = 0, *resultree = 0;
       TTree *oldtestree = 0, *oldtestuntree = 0, *oldresultree = 0;
@@ -212,18 +317,31 @@ void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> component
 
       if (!testree) continue; // Not a Qualification/Reception/HS/Stave test
 
+      // The fingerprints tell whether the activity changed since it was
+      // stored in the old file (if so it is reprocessed, not copied): the
+      // EOS directory is looked for only if the DB data changed
+      Bool_t inOldFile = kFALSE;
+      ULong64_t oldDbFinger = 0, oldFinger = 0;
       if(!redoFromStart)
-        if(FindActivityInThreScanTree(oldActFastListTree, comp.ID, act.ID, actMask)) {
-          printMessage("\nanalyzeAllThresholdScans", "Activity already in file, copying trees ", actLong.Name.c_str());
-          CopyThreScanOldToNew(comp.ID, act.ID, testree, testuntree, resultree, oldtestree, oldtestuntree, oldresultree);
-          actFastListTree->Fill();
-          continue;
-        }
-
-      string eosPath = FindEOSPath(actLong, hicType);
+        inOldFile = FindActivityInThreScanTree(oldActFastListTree, comp.ID, act.ID, actMask, oldDbFinger, oldFinger);
+
+      string eosPath;
+      Bool_t copyOld = CopyOldActivity(actLong, hicType, inOldFile, oldDbFinger, oldFinger, eosPath);
+      actDbFingerprint = oldDbFinger;
+      actFingerprint = oldFinger;
+
+      if(copyOld) {
+        printMessage("\nanalyzeAllThresholdScans", "Activity already in file, copying trees ", actLong.Name.c_str());
+        CopyThreScanOldToNew(comp.ID, act.ID, testree, testuntree, resultree, oldtestree, oldtestuntree, oldresultree);
+        actFastListTree->Fill();
+        PerfCount(PERF_NACTCOPY);
+        continue;
+      }
+
       if(eosPath.length() == 0) { // No valid path found on EOS
         string hicAct = actLong.Name + " " + actLong.Type.Name;
-        printMessage("\nanalyzeAllThresholdScans", "EOS for this activity does not exists", hicAct.c_str());
+        printMessage("\nanalyzeAllThresholdScans", "EOS for this activity does not exists", hicAct.c_str(), LOG_WARNING);
+        PerfCount(PERF_NEOSMISS);
         continue;
       }
 
@@ -235,7 +353,7 @@ void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> component
       strncpy(hicName, comp.ComponentID.c_str(), HICNAMELEN-1);
       hicClass = ConvertTestResult(act.Result.Name);
 
-      ThresholdScanAllChips(testree, actLong, comp.ID, act.ID, eosPath, hicType, children, false);
+      ThresholdScanAllChips(testree, actLong, comp.ID, act.ID, eosPath, hicType, waferMap, false);
       ThresholdTuneAllChips(testuntree, actLong, comp.ID, act.ID, eosPath, hicType, children);
       ThresholdScanResults(resultree, actLong, comp.ID, act.ID, eosPath, hicType);
 
@@ -243,39 +361,49 @@ void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> component
       Long64_t prevTestTunOffset = testuntree->GetEntries();
       Long64_t prevTestResOffset = resultree->GetEntries();
 
-      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset || testTunOffset == prevTestTunOffset)
-        printMessage("\nanalyzeAllThresholdScans", "Trees not filled for activity ", actLong.Name.c_str());
-      else
+      if(testOffset == prevTestOffset || testResOffset == prevTestResOffset || testTunOffset == prevTestTunOffset) {
+        printMessage("\nanalyzeAllThresholdScans", "Trees not filled for activity ", actLong.Name.c_str(), LOG_WARNING);
+        PerfCount(PERF_NNOTFILLED);
+      } else
         actFastListTree->Fill();
 
       totActAnal++;
+      PerfCount(PERF_NACTANAL);
       cout << ".";
       fflush(stdout);
 
     }
     totHICAnal++;
+    PerfCount(PERF_NHICS);
     if(totHICAnal%50 == 0) cout << totHICAnal;
     fflush(stdout);
     if(totHICAnal%50 == 0) { // Renew the db credentials
-      db = 0;
+      DbLibDisconnect(db);
       db = initAlpideDB();
-      activityDB = 0;
-      activityDB = new ActivityDB(db);
     }
+    CheckpointCommit(comp.ID);
   }
 
 
   // Close the ROOT file and exit
-  hicQualTree->Write();
-  hicRecpTree->Write();
-  hicHSTree->Write();
-  hicStaveTree->Write();
-  hicQualResTree->Write();
-  hicRecpResTree->Write();
-  hicHSResTree->Write();
-  hicStaveResTree->Write();
-  actFastListTree->Write();
+  CheckpointEnd();
+  perfStart = PerfNow();
+  hicQualTree->Write("", TObject::kOverwrite);
+  hicRecpTree->Write("", TObject::kOverwrite);
+  hicHSTree->Write("", TObject::kOverwrite);
+  hicStaveTree->Write("", TObject::kOverwrite);
+  hicQualTunTree->Write("", TObject::kOverwrite);
+  hicRecpTunTree->Write("", TObject::kOverwrite);
+  hicHSTunTree->Write("", TObject::kOverwrite);
+  hicStaveTunTree->Write("", TObject::kOverwrite);
+  hicQualResTree->Write("", TObject::kOverwrite);
+  hicRecpResTree->Write("", TObject::kOverwrite);
+  hicHSResTree->Write("", TObject::kOverwrite);
+  hicStaveResTree->Write("", TObject::kOverwrite);
+  actFastListTree->Write("", TObject::kOverwrite);
+  waferMapTree->Write("", TObject::kOverwrite);
   CloseRootFile(newThrescanFile);
+  PerfAddSample(PERF_WRITE, PerfNow() - perfStart, PerfFileSize(rootFileName.Data()));
 
 #ifdef USENCURSES
   mvprintw(LINES-4, 0, "\n ROOT file %s filled with %d activities\n", rootFileName.Data(), totActAnal);
@@ -306,24 +434,23 @@ void analyzeThresholdScan(const int hicid, const ComponentDB::compActivity act,
 // Updated:      06 Jun 2019  Mario Sitta  Get rid of timestamp from act name
 // Updated:      05 Jul 2019  Mario Sitta  Chip Wafer and position added
 // Updated:      16 Sep 2019  Mario Sitta  HIC name added
+// Updated:      19 Oct 2026  DB access layer used, wafer map tree added
 //
 
   // Should never happen (the caller should have created it for us)
-  if (!db) {
-    printMessage("analyzeThresholdScan","Error: the DataBase was not opened");
+  if (!DbLibIsOpen(db)) {
+    printMessage("analyzeThresholdScan","Error: the DataBase was not opened", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
-  ActivityDB *activityDB = new ActivityDB(db);
-
   // Get the proper path to the Digital Scan result files
   ActivityDB::activityLong actLong;
-  activityDB->Read(act.ID, &actLong);
+  DbLibReadActivity(db, act.ID, &actLong);
 
   string eosPath = FindEOSPath(actLong, hicType);
   if (eosPath == "") {
-    printMessage("\nanalyzeThresholdScan","Error: no valid EOS path found");
+    printMessage("\nanalyzeThresholdScan","Error: no valid EOS path found", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -345,7 +472,7 @@ void analyzeThresholdScan(const int hicid, const ComponentDB::compActivity act,
 
   TFile *threscanFile = OpenRootFile(rootFileName, kTRUE);
   if (!threscanFile) {
-    printMessage("\nanalyzeThresholdScan","Error: error opening the ROOT file");
+    printMessage("\nanalyzeThresholdScan","Error: error opening the ROOT file", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
@@ -353,43 +480,54 @@ void analyzeThresholdScan(const int hicid, const ComponentDB::compActivity act,
   // Create the trees
   TTree *threscanTree = CreateTreeThresholdScan("threscanTree","ThresholdScanTree");
   if (!threscanTree) {
-    printMessage("\nanalyzeThresholdScan","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeThresholdScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   TTree *threstunTree = CreateTreeThresholdScan("threstunTree","ThresholdTuneTree");
   if (!threstunTree) {
-    printMessage("\nanalyzeThresholdScan","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeThresholdScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   TTree *thresresulTree = CreateTreeThresholdScanResult("thresresulTree","ThresholdScanResulTree");
   if (!thresresulTree) {
-    printMessage("\nanalyzeThresholdScan","Error: error creating the ROOT tree");
+    printMessage("\nanalyzeThresholdScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
     f12ToExit();
     return;
   }
 
   // Get the list of chips in this HIC
   std::vector<TChild> children;
-  int nChildren = DbGetListOfChildren(db, hicid, children, true);
+  int nChildren = DbLibGetListOfChildren(db, hicid, children, true);
   if (nChildren == 0)
-    printMessage("\nanalyzeThresholdScan","Warning: HIC has no children");
+    printMessage("\nanalyzeThresholdScan","Warning: HIC has no children", 0, LOG_WARNING);
 
   // Get the name of the HIC
   int componentTypeId;
   if (hicType == HIC_IB)
-    componentTypeId = DbGetComponentTypeId (db, "Inner Barrel HIC Module");
+    componentTypeId = DbLibGetComponentTypeId (db, "Inner Barrel HIC Module");
   else
-    componentTypeId = DbGetComponentTypeId (db, "Outer Barrel HIC Module");
-  string hicNameStr = DbGetComponentName(db, componentTypeId, hicid);
+    componentTypeId = DbLibGetComponentTypeId (db, "Outer Barrel HIC Module");
+  string hicNameStr = DbLibGetComponentName(db, componentTypeId, hicid);
   strncpy(hicName, hicNameStr.c_str(), HICNAMELEN-1);
 
+  // Get the wafer map of the HIC
+  const TWaferMap *waferMap = GetHicWaferMap(hicid, hicType, children);
+
+  TTree *wafermapTree = CreateTreeThresholdScanWaferMap("wafermapTree","WaferMapTree");
+  if (!wafermapTree) {
+    printMessage("\nanalyzeThresholdScan","Error: error creating the ROOT tree", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
+  FillThreScanWaferMapTree(wafermapTree, hicid, hicType, waferMap);
+
   // Fill the trees for all chips (all scans)
   hicClass = ConvertTestResult(act.Result.Name);
-  ThresholdScanAllChips(threscanTree, actLong, hicid, act.ID, eosPath, hicType, children);
+  ThresholdScanAllChips(threscanTree, actLong, hicid, act.ID, eosPath, hicType, waferMap);
   ThresholdTuneAllChips(threstunTree, actLong, hicid, act.ID, eosPath, hicType, children);
   ThresholdScanResults(thresresulTree, actLong, hicid, act.ID, eosPath, hicType);
 
@@ -397,6 +535,7 @@ void analyzeThresholdScan(const int hicid, const ComponentDB::compActivity act,
   threscanTree->Write();
   threstunTree->Write();
   thresresulTree->Write();
+  wafermapTree->Write();
   CloseRootFile(threscanFile);
 
 #ifdef USENCURSES
@@ -408,6 +547,265 @@ void analyzeThresholdScan(const int hicid, const ComponentDB::compActivity act,
 
 }
 
+void mergeAllThresholdScans(const int nshards, const THicType hicType)
+{
+//
+// Steering routine to merge the files produced by the shard jobs
+// of Threshold Scans into a single file
+//
+// Inputs:
+//          nshards : the number of shards
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const char *extraNames[] = {"waferMapTree"};
+
+  MergeAllShardFiles("ThresholdScan", nshards, hicType, thrScanTreeNames, sizeof(thrScanTreeNames)/sizeof(thrScanTreeNames[0]), extraNames, 1);
+}
+
+void sortAllThresholdScans(const THicType hicType)
+{
+//
+// Steering routine to sort the pixel trees of the file of all
+// Threshold Scans on the key chosen with SetPixelSortKey
+//
+// Inputs:
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TString rootFileName, sortedName;
+  if (hicType == HIC_IB)
+    rootFileName = "IBHIC_ThresholdScan_AllHICs.root";
+  else
+    rootFileName = "OBHIC_ThresholdScan_AllHICs.root";
+
+  if (SortPixelRootFile(rootFileName, thrScanTreeNames, sizeof(thrScanTreeNames)/sizeof(thrScanTreeNames[0]), sortedName)) {
+#ifdef USENCURSES
+    mvprintw(LINES-4, 0, "\n Pixel trees of %s sorted into %s\n", rootFileName.Data(), sortedName.Data());
+#else
+    printf("\n\n Pixel trees of %s sorted into %s\n", rootFileName.Data(), sortedName.Data());
+#endif
+  } else
+    printMessage("\nsortAllThresholdScans","Error: error sorting the pixel trees", 0, LOG_ERROR);
+
+  f12ToExit();
+}
+
+static void AddThreScanPixel(TTree *tree, const Bool_t packed, const UShort_t column, const UShort_t row, const UShort_t thresh, const UShort_t noise)
+{
+//
+// Adds a pixel to the tree: in the usual layout the tree is filled
+// at once, in the packed one the pixel is appended to the arrays,
+// which are filled when full (and by the caller at end of file)
+//
+// Inputs:
+//          tree   : the tree to be filled
+//          packed : true if the tree has the packed layout
+//          column : the pixel column
+//          row    : the pixel row
+//          thresh : the pixel threshold (x100, as stored)
+//          noise  : the pixel noise (x100, as stored)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (packed) {
+    colArr[pixNum] = column;
+    rowArr[pixNum] = row;
+    thresArr[pixNum] = thresh;
+    noiseArr[pixNum] = noise;
+    if (++pixNum == PIXPACKSIZE) {
+      tree->Fill();
+      pixNum = 0;
+    }
+  } else {
+    rowNum = row;
+    colNum = column;
+    thresValue = thresh;
+    noiseValue = noise;
+    tree->Fill();
+  }
+}
+
+static Long64_t ThreScanPixelsMemory(const TThreScanPixels *pixels)
+{
+//
+// Returns the memory held by the buffers of a chip file
+//
+// Inputs:
+//          pixels : the buffers
+//
+// Outputs:
+//
+// Return:
+//          the memory in bytes
+//
+// Created:      19 Oct 2026
+//
+
+  return pixels->buffer.capacity() +
+         sizeof(UShort_t)*(pixels->col.capacity() + pixels->row.capacity() +
+                           pixels->thres.capacity() + pixels->noise.capacity());
+}
+
+static TThreScanPixels* AcquireThreScanPixels(void)
+{
+//
+// Takes the buffers of a chip file from the pool (new ones if empty):
+// from then on their memory is counted with the file they are used for
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          the buffers
+//
+// Created:      19 Oct 2026
+//
+
+  if (pixelsPool.empty()) return new TThreScanPixels;
+
+  TThreScanPixels *pixels = pixelsPool.back();
+  pixelsPool.pop_back();
+  Long64_t memory = ThreScanPixelsMemory(pixels);
+  pixelsPoolMemory -= memory;
+  SchedMemoryUse(-memory);
+
+  return pixels;
+}
+
+static void ReleaseThreScanPixels(TThreScanPixels *pixels)
+{
+//
+// Gives the buffers of a chip file back to the pool: if keeping them
+// would exceed the memory cap their memory is freed, otherwise it is
+// kept for reuse and counted against the cap while pooled
+//
+// Inputs:
+//          pixels : the buffers
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!SchedMemoryAvailable(ThreScanPixelsMemory(pixels))) {
+    std::vector<char>().swap(pixels->buffer);
+    std::vector<UShort_t>().swap(pixels->col);
+    std::vector<UShort_t>().swap(pixels->row);
+    std::vector<UShort_t>().swap(pixels->thres);
+    std::vector<UShort_t>().swap(pixels->noise);
+  }
+
+  Long64_t memory = ThreScanPixelsMemory(pixels);
+  pixelsPoolMemory += memory;
+  SchedMemoryUse(memory);
+  pixelsPool.push_back(pixels);
+}
+
+static void ReadThreScanChipFile(void *arg)
+{
+//
+// Reads a Threshold_FitResults file and scans its pixels into the
+// buffers of a TThreScanChipFile: it only uses its own memory, so it
+// can be run by a worker thread (see schedlib)
+//
+// Inputs:
+//          arg : the TThreScanChipFile, with the file name and buffers set
+//                (and the file content, if already read)
+//
+// Outputs:
+//          arg : the TThreScanChipFile, with the pixels and timing
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TThreScanChipFile *chipfile = (TThreScanChipFile*)arg;
+  TThreScanPixels *pixels = chipfile->pixels;
+  Double_t start = PerfNow();
+
+  pixels->col.clear();
+  pixels->row.clear();
+  pixels->thres.clear();
+  pixels->noise.clear();
+
+  if (!chipfile->read)
+    chipfile->bytes = ReadWholeFile(chipfile->fullName, pixels->buffer);
+  if (chipfile->bytes < 0) {
+    chipfile->seconds = PerfNow() - start;
+    return;
+  }
+
+  SanitizeDecimalCommas(&pixels->buffer[0], chipfile->bytes);
+
+  // Each line holds "col row thresh noise chisq": as with sscanf,
+  // the fields after the first unreadable one keep their old value
+  Int_t  row = 0, column = 0;
+  Float_t thresh = 0, noise = 0, chisq = 0;
+  const char *line = &pixels->buffer[0];
+  const char *end = line + chipfile->bytes;
+  while (line < end) {
+    const char *p = line;
+    if ((p = ScanIntField(p, column)) && (p = ScanIntField(p, row)) &&
+        (p = ScanFloatField(p, thresh)) && (p = ScanFloatField(p, noise)))
+      ScanFloatField(p, chisq);
+    pixels->col.push_back(column);
+    pixels->row.push_back(row);
+    pixels->thres.push_back((UShort_t)(thresh*100));
+    pixels->noise.push_back((UShort_t)(noise*100));
+
+    line = (const char*)memchr(line, '\n', end - line);
+    line = line ? line + 1 : end;
+  }
+
+  chipfile->seconds = PerfNow() - start;
+}
+
+static void AllocThreScanPixels(void)
+{
+//
+// Allocates the arrays of the packed pixel trees, only once
+// so that the addresses the branches point to never change
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (colArr.size() == 0) {
+    colArr.resize(PIXPACKSIZE);
+    rowArr.resize(PIXPACKSIZE);
+    thresArr.resize(PIXPACKSIZE);
+    noiseArr.resize(PIXPACKSIZE);
+  }
+  pixNum = 0;
+}
+
 void CopyThreScanOldToNew(const UInt_t hicid, const UInt_t actid,
 			  TTree *newscan, TTree *newtun, TTree *newres,
 			  TTree *oldscan, TTree *oldtun, TTree *oldres)
@@ -495,6 +893,7 @@ TTree* CreateHicActListTreeTS(void)
 //
 // Created:      27 Nov 2018  Mario Sitta
 // Updated:      18 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newTree = 0;
@@ -507,6 +906,8 @@ TTree* CreateHicActListTreeTS(void)
     newTree->Branch("actOffs", &testOffset, "testOffset/L");
     newTree->Branch("actTunOff", &testTunOffset, "testTunOffset/L");
     newTree->Branch("actResOff", &testResOffset, "testResOffset/L");
+    newTree->Branch("actFinger", &actFingerprint, "actFingerprint/l");
+    newTree->Branch("actDbFinger", &actDbFingerprint, "actDbFingerprint/l");
   }
 
   return newTree;
@@ -530,6 +931,7 @@ TTree* CreateTreeThresholdScan(TString treeName, TString treeTitle)
 // Updated:      05 Jul 2019  Mario Sitta  Chip Wafer and position added
 // Updated:      09 Jul 2019  Mario Sitta  HIC class added
 // Updated:      16 Sep 2019  Mario Sitta  HIC name added
+// Updated:      19 Oct 2026  Packed layout added
 //
 
   TTree *newTree = 0;
@@ -545,12 +947,53 @@ TTree* CreateTreeThresholdScan(TString treeName, TString treeTitle)
     newTree->Branch("chipNum", &chipNum, "chipNum/b");
     newTree->Branch("waferNum", &waferNum, "waferNum/B");
     newTree->Branch("waferPos", &waferPos, "waferPos/B");
-    newTree->Branch("colNum", &colNum, "colNum/s");
-    newTree->Branch("rowNum", &rowNum, "rowNum/s");
-//    newTree->Branch("thresh", &thresValue, "thresValue/F");
-//    newTree->Branch("noise", &noiseValue, "noiseValue/F");
-    newTree->Branch("thresh", &thresValue, "thresValue/s");
-    newTree->Branch("noise", &noiseValue, "noiseValue/s");
+    if (GetPackedPixelTrees()) {
+      AllocThreScanPixels();
+      newTree->Branch("pixNum", &pixNum, "pixNum/I");
+      newTree->Branch("colNum", &colArr[0], "colNum[pixNum]/s");
+      newTree->Branch("rowNum", &rowArr[0], "rowNum[pixNum]/s");
+      newTree->Branch("thresh", &thresArr[0], "thresValue[pixNum]/s");
+      newTree->Branch("noise", &noiseArr[0], "noiseValue[pixNum]/s");
+    } else {
+      newTree->Branch("colNum", &colNum, "colNum/s");
+      newTree->Branch("rowNum", &rowNum, "rowNum/s");
+//      newTree->Branch("thresh", &thresValue, "thresValue/F");
+//      newTree->Branch("noise", &noiseValue, "noiseValue/F");
+      newTree->Branch("thresh", &thresValue, "thresValue/s");
+      newTree->Branch("noise", &noiseValue, "noiseValue/s");
+    }
+  }
+
+  return newTree;
+}
+
+TTree* CreateTreeThresholdScanWaferMap(TString treeName, TString treeTitle)
+{
+//
+// Creates a tree for the wafer maps of the HICs: one entry per chip,
+// with the wafer number and the chip position in the wafer
+//
+// Inputs:
+//          treeName  : the tree name
+//          treeTitle : the tree title
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created ROOT tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newTree = 0;
+  newTree = new TTree(treeName.Data(), treeTitle.Data());
+
+  if(newTree) {
+    newTree->Branch("hicName", hicName, "hicName[13]/B");
+    newTree->Branch("hicID", &hicID, "hicID/i");
+    newTree->Branch("chipNum", &chipNum, "chipNum/b");
+    newTree->Branch("waferNum", &waferNum, "waferNum/B");
+    newTree->Branch("waferPos", &waferPos, "waferPos/B");
   }
 
   return newTree;
@@ -632,7 +1075,7 @@ TTree* CreateTreeThresholdScanResult(TString treeName, TString treeTitle)
   return newTree;
 }
 
-void ThresholdScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType, std::vector<TChild> children, bool allScans)
+void ThresholdScanAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType, const TWaferMap *wafermap, bool allScans)
 {
 //
 // Loops on chips and fills the tree for the given activity
@@ -644,7 +1087,7 @@ void ThresholdScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const
 //          actid   : the activity id
 //          eospath : the input file path on EOS
 //          hicType : the HIC type (IB or OB)
-//          children: vector of all HIC children
+//          wafermap: the wafer map of the HIC (see GetHicWaferMap)
 //          allScans: if false analyze only post-tuning scans, if true do all
 //
 // Outputs:
@@ -654,8 +1097,14 @@ void ThresholdScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const
 // Created:      29 Jan 2019  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added, bug fix in chip loop
 // Updated:      10 Jul 2019  Mario Sitta  Wafer number and chip position added
+// Updated:      19 Oct 2026  Chip files read by the workers, wafer map
 //
 
+  // A new activity: the strings of the previous one are released
+  // and the messages are tagged with it
+  ArenaReset();
+  LogSetActivity(hicid, actid);
+
   hicID = hicid;
   actID = actid;
   locID = actlong.Location.ID;
@@ -664,34 +1113,127 @@ void ThresholdScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const
   string dataName, resultName;
   unsigned char conds[4] = {100, 200, 103, 203}; // See next method for code meaning
 
+  // With worker threads (or io_uring) the files of all conditions and
+  // chips are first only listed, then read and scanned in parallel (see below)
+  const Bool_t parallel = (SchedGetThreads() > 0 || IoGetBackend() == IOBACKEND_URING);
+  static std::vector<TThreScanChipFile> chipFiles; // Kept across calls: their memory is reused
+  UInt_t nChipFiles = 0;
+
   for (int icond = 0; icond < 4; icond ++) {
     if(conds[icond] < 200 && !allScans) continue;
 
-    const int numchips = ((hicType == HIC_OB) ? NUMCHIPS+1 : NUMCHIPSIB);
+    const THicChipMap *chipMap = GetHicChipMap(hicType);
 
-    for (int ichip = 0; ichip < numchips; ichip++) {
-      if(hicType == HIC_IB) chipNum = ichip;
-      if(hicType == HIC_OB && ichip == 7) continue;
-      if(hicType == HIC_OB && ichip > 7)
-	chipNum = ichip - 1;
-      else
-	chipNum = ichip;
+    for (int i = 0; i < chipMap->numChips; i++) {
+      chipNum = i;
+      int ichip = chipMap->chipId[i];
 
-      WaferNumAndPos(hicType, children, chipNum, waferNum, waferPos);
+      waferNum = wafermap->waferNum[i];
+      waferPos = wafermap->waferPos[i];
 
       Int_t code = (conds[icond]/10)*10; // We deliberately divide int's
       Int_t vBB = conds[icond] - code;
       bool nominal = (code == 100);
       if(GetThresholdFileName(actlong, ichip, nominal, vBB, dataName, resultName)) {
         condVB = conds[icond];
-        FillThreScanTree(ftree, eospath, dataName);
+        if (parallel) {
+          if (nChipFiles == chipFiles.size()) chipFiles.resize(nChipFiles + 1);
+          TThreScanChipFile &chipFile = chipFiles[nChipFiles++];
+          chipFile.fullName = ArenaJoinPath(eospath, dataName);
+          chipFile.fileName = dataName;
+          chipFile.condVB = condVB;
+          chipFile.chipNum = chipNum;
+          chipFile.waferNum = waferNum;
+          chipFile.waferPos = waferPos;
+          chipFile.memory = 0;
+        } else
+          FillThreScanTree(ftree, eospath, dataName);
+      }
+    }
+  }
+
+  if (!parallel) return;
+
+  // Each file is a task, so that the workers which are done with the
+  // small files steal the big ones. The tree is filled in the same order
+  // as without workers, each file as soon as it is read, and the next
+  // files are given to the workers only while the memory cap is not
+  // reached (see SchedSetMemory): each file counts until it is filled,
+  // so the files read but not yet filled cannot pile up. The memory of
+  // a file (its text and pixels, 8 bytes out of some 25 per line) is
+  // estimated from the files read so far, without a stat of its own,
+  // and until one is read the files are given out one at a time; the
+  // buffers in the pool count as free, since the next files take them.
+  // With io_uring the files given out together are first read at once,
+  // as a batch, and the workers only scan them: the next files are then
+  // given out only once half of the cap is free, so that each batch
+  // holds many files, and their memory is set from the sizes read
+  const Long64_t refillFree = (IoGetBackend() == IOBACKEND_URING) ? SchedGetMemory()/2 : 0;
+  UInt_t nextFile = 0;
+  static std::vector<TIoFile> batch;
+  for (UInt_t j = 0; j < nChipFiles; j++) {
+    UInt_t firstFile = nextFile;
+    const Long64_t estimate = (chipFilesRead > 0) ? 2*chipFilesBytes/chipFilesRead : 0;
+    if (nextFile == j ||
+        (estimate > 0 && SchedMemoryAvailable(std::max(refillFree, estimate) - pixelsPoolMemory))) {
+      while (nextFile < nChipFiles &&
+             (nextFile == j || (estimate > 0 && SchedMemoryAvailable(estimate - pixelsPoolMemory)))) {
+        TThreScanChipFile &chipFile = chipFiles[nextFile++];
+        chipFile.pixels = AcquireThreScanPixels();
+        chipFile.done = 0;
+        chipFile.read = kFALSE;
+        chipFile.memory = estimate;
+        SchedMemoryUse(chipFile.memory);
+      }
+    }
+
+    if (nextFile > firstFile && IoGetBackend() == IOBACKEND_URING) {
+      batch.resize(nextFile - firstFile);
+      for (UInt_t k = firstFile; k < nextFile; k++) {
+        batch[k - firstFile].name = chipFiles[k].fullName;
+        batch[k - firstFile].buffer = &chipFiles[k].pixels->buffer;
+      }
+      Double_t perfStart = PerfNow();
+      Long64_t nbytes = IoReadFiles(&batch[0], batch.size());
+      PerfAddSample(PERF_READBATCH, PerfNow() - perfStart, nbytes);
+      for (UInt_t k = firstFile; k < nextFile; k++) {
+        chipFiles[k].bytes = batch[k - firstFile].bytes;
+        chipFiles[k].read = kTRUE;
+        Long64_t memory = 2*std::max(chipFiles[k].bytes, (Long64_t)0);
+        SchedMemoryUse(memory - chipFiles[k].memory);
+        chipFiles[k].memory = memory;
       }
     }
+
+    for (UInt_t k = firstFile; k < nextFile; k++) {
+      TThreScanChipFile &chipFile = chipFiles[k];
+      TSchedTask task = {ReadThreScanChipFile, &chipFile, SCHEDTASK_THRESCAN,
+                         hicid, actid, chipFile.condVB, chipFile.chipNum, &chipFile.done};
+      SchedSubmit(task);
+    }
+
+    Double_t perfStart = PerfNow();
+    SchedWait(&chipFiles[j].done);
+    PerfAddSample(PERF_WAITWORK, PerfNow() - perfStart);
+
+    condVB = chipFiles[j].condVB;
+    chipNum = chipFiles[j].chipNum;
+    waferNum = chipFiles[j].waferNum;
+    waferPos = chipFiles[j].waferPos;
+    FillThreScanChipFile(ftree, chipFiles[j]);
+    if (chipFiles[j].bytes >= 0) {
+      chipFilesBytes += chipFiles[j].bytes;
+      chipFilesRead++;
+    }
+
+    SchedMemoryUse(-chipFiles[j].memory);
+    ReleaseThreScanPixels(chipFiles[j].pixels);
+    chipFiles[j].pixels = 0;
   }
 
 }
 
-void ThresholdTuneAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType, std::vector<TChild> children)
+void ThresholdTuneAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType, const std::vector<TChild> &children)
 {
 //
 // Loops on chips and fills the tree for the threshold tuning 
@@ -712,6 +1254,7 @@ void ThresholdTuneAllChips(TTree *ftree, ActivityDB::activityLong actlong, const
 // Created:      31 Jan 2019  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added, bug fix in chip loop
 // Updated:      10 Jul 2019  Mario Sitta  Wafer number and chip position added
+// Updated:      19 Oct 2026  Chip numbering tables, no HIC type tests
 //
 
   hicID = hicid;
@@ -721,14 +1264,11 @@ void ThresholdTuneAllChips(TTree *ftree, ActivityDB::activityLong actlong, const
   // Open Threshold Tune files and fill the tree
   string dataName, resultName;
 
-  const int numchips = ((hicType == HIC_OB) ? NUMCHIPS+1 : NUMCHIPSIB);
- 
-  for (int ichip = 0; ichip < numchips; ichip++) {
-    if(hicType == HIC_OB && ichip == 7) continue;
-    if(hicType == HIC_OB && ichip > 7)
-      chipNum = ichip - 1;
-    else
-      chipNum = ichip;
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
+
+  for (int i = 0; i < chipMap->numChips; i++) {
+    chipNum = i;
+    int ichip = chipMap->chipId[i];
 
     if(GetITHRTuneFileName(actlong, ichip, 0, dataName, resultName)) {
       condVB = 100;
@@ -736,12 +1276,9 @@ void ThresholdTuneAllChips(TTree *ftree, ActivityDB::activityLong actlong, const
     }
   }
 
-  for (int ichip = 0; ichip < numchips; ichip++) {
-    if(hicType == HIC_OB && ichip == 7) continue;
-    if(hicType == HIC_OB && ichip > 7)
-      chipNum = ichip - 1;
-    else
-      chipNum = ichip;
+  for (int i = 0; i < chipMap->numChips; i++) {
+    chipNum = i;
+    int ichip = chipMap->chipId[i];
 
     if(GetVCASNTuneFileName(actlong, ichip, 0, dataName, resultName)) {
       condVB = 200;
@@ -751,7 +1288,7 @@ void ThresholdTuneAllChips(TTree *ftree, ActivityDB::activityLong actlong, const
 
 }
 
-void ThresholdScanResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType)
+void ThresholdScanResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType)
 {
 //
 // Fills the tree for the given activity results
@@ -770,6 +1307,7 @@ void ThresholdScanResults(TTree *ftree, ActivityDB::activityLong actlong, const
 //
 // Created:      27 Jan 2019  Mario Sitta
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Arguments passed by reference, string arena
 //
 
   hicID = hicid;
@@ -806,7 +1344,48 @@ void ThresholdScanResults(TTree *ftree, ActivityDB::activityLong actlong, const
 
 }
 
-Bool_t FillThreScanTree(TTree *tree, string path, string file)
+Bool_t FillThreScanChipFile(TTree *tree, const TThreScanChipFile &chipfile)
+{
+//
+// Fills the tree with the pixels of a chip file read and scanned by
+// ReadThreScanChipFile (the other tree variables are set by the caller)
+//
+// Inputs:
+//          tree     : the pointer to the tree to be filled
+//          chipfile : the chip file
+//
+// Outputs:
+//
+// Return:
+//          true if the input file was read without error, otherwise false
+//
+// Created:      19 Oct 2026
+//
+
+  Double_t perfStart = PerfNow();
+  const Bool_t packed = IsPackedPixelTree(tree);
+
+  if (chipfile.bytes < 0) {
+    printMessage("FillThreScanTree","Warning: cannot open input file",chipfile.fileName.c_str(), LOG_WARNING);
+    return kFALSE;
+  }
+
+  const TThreScanPixels *pixels = chipfile.pixels;
+  pixNum = 0;
+  Long64_t nrows = pixels->col.size();
+  for (Long64_t j = 0; j < nrows; j++)
+    AddThreScanPixel(tree, packed, pixels->col[j], pixels->row[j], pixels->thres[j], pixels->noise[j]);
+
+  // The last (or only) entry of the chip in the packed layout
+  if (packed && pixNum > 0)
+    tree->Fill();
+
+  PerfAddSample(PERF_FILLDATA, chipfile.seconds + PerfNow() - perfStart, chipfile.bytes, nrows);
+
+  return kTRUE;
+}
+
+Bool_t FillThreScanTree(TTree *tree, const string &path, const string &file)
 {
 //
 // Opens the Threshold_FitResults file and fills the tree
@@ -823,40 +1402,21 @@ Bool_t FillThreScanTree(TTree *tree, string path, string file)
 //
 // Created:      30 Jan 2019  Mario Sitta
 // Updated:      27 Mar 2019  Mario Sitta  Fix reading files with , insteda of .
+// Updated:      19 Oct 2026  Timing, bulk scan, packed layout
 //
 
-  FILE*  infile;
-  string fullName;
-  Int_t  row, column;
-  Float_t thresh, noise, chisq;
+  static TThreScanChipFile chipFile;
+  static TThreScanPixels pixels; // Kept across calls: its memory is reused
 
-  fullName = path + "/" + file;
+  chipFile.fullName = ArenaJoinPath(path, file);
+  chipFile.fileName = file;
+  chipFile.pixels = &pixels;
+  ReadThreScanChipFile(&chipFile);
 
-  infile = fopen(fullName.c_str(),"r");
-  if (!infile) {
-    printMessage("FillThreScanTree","Warning: cannot open input file",file.c_str());
-    return kFALSE;
-  }
-
-  char line[50];
-//  while(fscanf(infile, "%d %d %f %f %f", &column, &row, &thresh, &noise, &chisq) != EOF){
-  while(fgets(line, sizeof(line), infile)){
-    SanitizeThresScanInput(line);
-    sscanf(line, "%d %d %f %f %f", &column, &row, &thresh, &noise, &chisq);
-    rowNum = row;
-    colNum = column;
-//    thresValue = thresh;
-//    noiseValue = noise;
-    thresValue = (UShort_t)(thresh*100);
-    noiseValue = (UShort_t)(noise*100);
-    tree->Fill();
-  }
-  fclose(infile);
-
-  return kTRUE;
+  return FillThreScanChipFile(tree, chipFile);
 }
 
-Bool_t FillThreScanTreeResult(TTree *tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType)
+Bool_t FillThreScanTreeResult(TTree *tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType)
 {
 //
 // Opens the ThresholdScanResult file and fills the tree
@@ -878,21 +1438,27 @@ Bool_t FillThreScanTreeResult(TTree *tree, string path, string file, ActivityDB:
 // Created:      29 Jan 2019  Mario Sitta  Modelled on Digital Scan routine
 // Updated:      05 Feb 2019  Mario Sitta  Bug fix in reading registers
 // Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Timing, chip numbering tables, parameter index
 //
 
+  Double_t perfStart = PerfNow();
+  Long64_t perfEntries = tree->GetEntries();
+  Long64_t perfBytes = 0;
+
   FILE*  infile;
-  string fullName;
+  const char *fullName;
   float value, dummy;
   unsigned int reg, regval;
-  int ichip, ivalue;
+  int ichip = -1, ivalue;
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
   char *line = NULL;
   size_t len = 0;
 
-  fullName = path + "/" + file;
+  fullName = ArenaJoinPath(path, file);
 
-  infile = fopen(fullName.c_str(),"r");
+  infile = fopen(fullName,"r");
   if (!infile) {
-    printMessage("FillThreScanTreeResult","Warning: cannot open input file",file.c_str());
+    printMessage("FillThreScanTreeResult","Warning: cannot open input file",file.c_str(), LOG_WARNING);
     return kFALSE;
   }
 
@@ -1040,54 +1606,42 @@ Bool_t FillThreScanTreeResult(TTree *tree, string path, string file, ActivityDB:
     // Per-chip data
     if (strstr(line,"Analogue voltage (") && strstr(line,"start")) {
       sscanf(line, "  Analogue voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipAnalVoltStart[ichip-1] = value;
-      else
-        chipAnalVoltStart[ichip] = value; 
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
+        chipAnalVoltStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Analogue voltage (") && strstr(line,"end")) {
       sscanf(line, "  Analogue voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipAnalVoltEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipAnalVoltEnd[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"start")) {
       sscanf(line, "  Digital voltage (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltStart[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Digital voltage (") && strstr(line,"end")) {
       sscanf(line, "  Digital voltage (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipDigiVoltEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipDigiVoltEnd[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"start")) {
       sscanf(line, "  Temperature (start) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipTempStart[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipTempStart[ichip] = value;
       continue;
     }
 
     if (strstr(line,"Temperature (") && strstr(line,"end")) {
       sscanf(line, "  Temperature (end) on chip %d: %f", &ichip, &value);
-      if(hicType == HIC_OB && ichip > 7)
-        chipTempEnd[ichip-1] = value;
-      else
+      if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
         chipTempEnd[ichip] = value;
       continue;
     }
@@ -1117,55 +1671,55 @@ Bool_t FillThreScanTreeResult(TTree *tree, string path, string file, ActivityDB:
   singleChipResults:
     if (strstr(line, "Result chip")) {
       sscanf(line, "Result chip %d:", &ichip);
-      if(hicType == HIC_OB && ichip > 7) ichip--;
+      ichip = CHIPNUM(chipMap, ichip);
       continue;
     }
 
     if (strstr(line, "Pixels without hits")) {
       sscanf(line, "Pixels without hits:      %d", &ivalue);
-      pixWOHits[ichip] = ivalue;
+      if (ichip >= 0) pixWOHits[ichip] = ivalue;
       continue;
     }
 
     if (strstr(line, "Pixels without threshold")) {
       sscanf(line, "Pixels without threshold: %d", &ivalue);
-      pixWOThres[ichip] = ivalue;
+      if (ichip >= 0) pixWOThres[ichip] = ivalue;
       continue;
     }
 
     if (strstr(line, "Hot pixels")) {
       sscanf(line, "Hot pixels:               %d", &ivalue);
-      hotPixels[ichip] = ivalue;
+      if (ichip >= 0) hotPixels[ichip] = ivalue;
       continue;
     }
 
     if (strstr(line, "Av. Threshold")) {
       sscanf(line, "Av. Threshold: %f", &value);
-      avrgThres[ichip] = value;
+      if (ichip >= 0) avrgThres[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Threshold RMS")) {
       sscanf(line, "Threshold RMS: %f", &value);
-      thresRMS[ichip] = value;
+      if (ichip >= 0) thresRMS[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Deviation")) {
       sscanf(line, "Deviation:     %f", &value);
-      deviation[ichip] = value;
+      if (ichip >= 0) deviation[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Av. Noise")) {
       sscanf(line, "Av. Noise:     %f", &value);
-      avrgNoise[ichip] = value;
+      if (ichip >= 0) avrgNoise[ichip] = value;
       continue;
     }
 
     if (strstr(line, "Noise RMS")) {
       sscanf(line, "Noise RMS:     %f", &value);
-      noiseRMS[ichip] = value;
+      if (ichip >= 0) noiseRMS[ichip] = value;
       continue;
     }
 
@@ -1179,60 +1733,71 @@ Bool_t FillThreScanTreeResult(TTree *tree, string path, string file, ActivityDB:
     if(reg == 0x700) {
       ichip &= 0x0f; // ichip is the lower 4 bits
       if(regStartFound) {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700Start[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700Start[ichip] = regval;
       } else {
-	if(hicType == HIC_OB && ichip > 7)
-          reg700End[ichip-1] = regval;
-        else
+        if ((ichip = CHIPNUM(chipMap, ichip)) >= 0)
           reg700End[ichip] = regval;
       }
     }
 
   } // while(getline(&line, &len, infile))
 
+  perfBytes += ftell(infile);
   fclose(infile);
 
   // Now get data from DB
-  vector<ActivityDB::actParameter>  parameters = actlong.Parameters;
+  const TActParameters *actPars = GetActParameters(actlong);
 
-  std::vector<ActivityDB::actParameter>::iterator loop;
-  for(loop = parameters.begin(); loop != parameters.end(); loop++) {
-    ActivityDB::actParameter actpar = *loop;
+  if(actPars->found[ACTPAR_VERSION])
+    classificVers = actPars->value[ACTPAR_VERSION];
 
-    if(actpar.Type.Parameter.Name.compare("Classification Version") == 0) {
-      classificVers = actpar.Value;
-      continue;
-    }
-
-    if( (condVB == 100 || condVB == 200) &&
-	actpar.Type.Parameter.Name.compare("Classification Threshold Scan 0.0 V") == 0) {
-      classificThreScan = actpar.Value;
-      continue;
-    }
-
-    if( (condVB == 103 || condVB == 203) &&
-	actpar.Type.Parameter.Name.compare("Classification Threshold Scan 3.0 V") == 0) {
-      classificThreScan = actpar.Value;
-      continue;
-    }
-
-//    if(actpar.Type.Parameter.Name.compare("Number of Working Chips") == 0) {
-//      numWorkChips = actpar.Value;
-//      continue;
-//    }
-    
-  }
+  Int_t parThres = -1;
+  if(condVB == 100 || condVB == 200) parThres = ACTPAR_THRESH0;
+  if(condVB == 103 || condVB == 203) parThres = ACTPAR_THRESH3;
+  if(parThres >= 0 && actPars->found[parThres])
+    classificThreScan = actPars->value[parThres];
 
   // Fill the tree, close the file and return
   tree->Fill();
 
+  PerfAddSample(PERF_FILLRES, PerfNow() - perfStart, perfBytes,
+                tree->GetEntries() - perfEntries);
+
   return kTRUE;
 }
 
-Bool_t FindActivityInThreScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask)
+void FillThreScanWaferMapTree(TTree *tree, const UInt_t hicid, const THicType hicType, const TWaferMap *wafermap)
+{
+//
+// Fills the wafer map tree with all chips of a HIC
+// (the HIC name is the one currently set)
+//
+// Inputs:
+//          tree     : the wafer map tree
+//          hicid    : the HIC id
+//          hicType  : the HIC type (IB or OB)
+//          wafermap : the wafer map of the HIC (see GetHicWaferMap)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  hicID = hicid;
+
+  const Int_t numChips = GetHicChipMap(hicType)->numChips;
+  for (Int_t i = 0; i < numChips; i++) {
+    chipNum = i;
+    waferNum = wafermap->waferNum[i];
+    waferPos = wafermap->waferPos[i];
+    tree->Fill();
+  }
+}
+
+Bool_t FindActivityInThreScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger)
 {
 //
 // Finds the activity in the tree
@@ -1244,11 +1809,14 @@ Bool_t FindActivityInThreScanTree(TTree* listree, const UInt_t hicid, const UInt
 //          mask  : the activity mask
 //
 // Outputs:
+//          dbfinger : the DB data fingerprint stored with the activity
+//          finger   : the fingerprint stored with the activity
 //
 // Return:
 //          true if activity found
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Stored fingerprints returned
 //
 
   Bool_t found = kFALSE;
@@ -1259,11 +1827,19 @@ Bool_t FindActivityInThreScanTree(TTree* listree, const UInt_t hicid, const UInt
   Int_t currHicId = hicID;
   Int_t currActId = actID;
   UShort_t currMask = actMask;
+  ULong64_t currDbFinger = actDbFingerprint;
+  ULong64_t currFinger = actFingerprint;
+
+  // Files written before fingerprints were introduced have no such branches
+  actDbFingerprint = 0;
+  actFingerprint = 0;
   
   Int_t nEntries = listree->GetEntries();
   for (Int_t j = 0; j < nEntries; j++) {
     listree->GetEntry(j);
     if(hicID == hicid && actID == actid && actMask == mask) {
+      dbfinger = actDbFingerprint;
+      finger = actFingerprint;
       found = kTRUE;
       break;
     }
@@ -1273,10 +1849,56 @@ Bool_t FindActivityInThreScanTree(TTree* listree, const UInt_t hicid, const UInt
   hicID = currHicId;
   actID = currActId;
   actMask = currMask;
+  actDbFingerprint = currDbFinger;
+  actFingerprint = currFinger;
 
   return found;
 }
 
+void GetThreScanTrendRecords(TTree *tree, const Long64_t first, const Long64_t last, const UChar_t stage, std::vector<TTrendRecord> &records)
+{
+//
+// Gets the threshold and noise of all pixels of an activity
+// for the trend analysis (only the TRENDCOND_THRESH condition)
+//
+// Inputs:
+//          tree    : the pixel tree (read from file)
+//          first   : the first entry of the activity
+//          last    : the entry after the last one of the activity
+//          stage   : the test stage of the tree (one of TRENDSTAGE_*)
+//
+// Outputs:
+//          records : the records of the pixels, appended
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const Bool_t packed = IsPackedPixelTree(tree);
+  TTrendRecord rec;
+  rec.stage = stage;
+  rec.source = TRENDSRC_THRESH;
+
+  for (Long64_t j = first; j < last; j++) {
+    tree->GetEntry(j);
+    if (condVB != TRENDCOND_THRESH) continue;
+    if (packed) {
+      for (Int_t i = 0; i < pixNum; i++) {
+        rec.pixel = TRENDPIXEL(chipNum, colArr[i], rowArr[i]);
+        rec.value = thresArr[i];
+        rec.value2 = noiseArr[i];
+        records.push_back(rec);
+      }
+    } else {
+      rec.pixel = TRENDPIXEL(chipNum, colNum, rowNum);
+      rec.value = thresValue;
+      rec.value2 = noiseValue;
+      records.push_back(rec);
+    }
+  }
+}
+
 TTree* ReadHicActListTreeTS(TFile *rootfile)
 {
 //
@@ -1294,6 +1916,7 @@ TTree* ReadHicActListTreeTS(TFile *rootfile)
 //
 // Created:      28 Nov 2018  Mario Sitta
 // Updated:      18 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Fingerprints added
 //
 
   TTree *newtree = 0;
@@ -1306,6 +1929,10 @@ TTree* ReadHicActListTreeTS(TFile *rootfile)
     newtree->SetBranchAddress("actOffs", &testOffset);
     newtree->SetBranchAddress("actTunOff", &testTunOffset);
     newtree->SetBranchAddress("actResOff", &testResOffset);
+    if(newtree->GetBranch("actFinger")) // Missing in older files
+      newtree->SetBranchAddress("actFinger", &actFingerprint);
+    if(newtree->GetBranch("actDbFinger")) // Ditto
+      newtree->SetBranchAddress("actDbFinger", &actDbFingerprint);
   }
 
   return newtree;
@@ -1331,6 +1958,7 @@ TTree* ReadThreScanTree(TString treename, TFile *rootfile)
 // Updated:      05 Jul 2019  Mario Sitta  Chip Wafer and position added
 // Updated:      09 Jul 2019  Mario Sitta  HIC class added
 // Updated:      16 Sep 2019  Mario Sitta  HIC name added
+// Updated:      19 Oct 2026  Packed layout added
 //
 
   TTree *newtree = 0;
@@ -1346,10 +1974,20 @@ TTree* ReadThreScanTree(TString treename, TFile *rootfile)
     newtree->SetBranchAddress( "chipNum", &chipNum);
     newtree->SetBranchAddress("waferNum", &waferNum);
     newtree->SetBranchAddress("waferPos", &waferPos);
-    newtree->SetBranchAddress(  "colNum", &colNum);
-    newtree->SetBranchAddress(  "rowNum", &rowNum);
-    newtree->SetBranchAddress(  "thresh", &thresValue);
-    newtree->SetBranchAddress(   "noise", &noiseValue);
+    if (IsPackedPixelTree(newtree)) {
+      AllocThreScanPixels();
+      newtree->SetBranchAddress(  "pixNum", &pixNum);
+      newtree->SetBranchAddress(  "colNum", &colArr[0]);
+      newtree->SetBranchAddress(  "rowNum", &rowArr[0]);
+      newtree->SetBranchAddress(  "thresh", &thresArr[0]);
+      newtree->SetBranchAddress(   "noise", &noiseArr[0]);
+    } else {
+      newtree->SetBranchAddress(  "colNum", &colNum);
+      newtree->SetBranchAddress(  "rowNum", &rowNum);
+      newtree->SetBranchAddress(  "thresh", &thresValue);
+      newtree->SetBranchAddress(   "noise", &noiseValue);
+    }
+    MatchPackedPixelTrees(newtree);
   }
 
   return newtree;
@@ -1433,6 +2071,39 @@ TTree* ReadThreScanTreeResult(TString treename, TFile *rootfile)
   return newtree;
 }
 
+TTree* ReadThreScanTreeWaferMap(TString treename, TFile *rootfile)
+{
+//
+// Reads a tree of wafer maps from file
+// WARNING!! We assume the rootfile was already successfully opened!
+// NO checks on file!
+//
+// Inputs:
+//          treename : the tree name
+//          rootfile : the Root file
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the read ROOT tree (0 in files older than the maps)
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newtree = 0;
+  newtree = (TTree*)rootfile->Get(treename.Data());
+
+  if(newtree) {
+    newtree->SetBranchAddress( "hicName", hicName);
+    newtree->SetBranchAddress(   "hicID", &hicID);
+    newtree->SetBranchAddress( "chipNum", &chipNum);
+    newtree->SetBranchAddress("waferNum", &waferNum);
+    newtree->SetBranchAddress("waferPos", &waferPos);
+  }
+
+  return newtree;
+}
+
 void ResetThreScanTreeVariables(void)
 {
 //
@@ -1515,12 +2186,10 @@ void SanitizeThresScanInput(char *line)
 //          a pointer to the created/read tree
 //
 // Created:      26 Mar 2019  Mario Sitta
+// Updated:      19 Oct 2026  Vectorized kernel used
 //
 
-  const Int_t length = strlen(line);
-
-  for(Int_t j = 0; j < length; j++)
-    if(line[j] == ',') line[j] = '.';
+  SanitizeDecimalCommas(line, strlen(line));
 }
 
 TTree* SetupHicActListTreeTS(TFile *rootfile)
@@ -1537,11 +2206,12 @@ TTree* SetupHicActListTreeTS(TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateHicActListTreeTS();
   else
     newtree = ReadHicActListTreeTS(rootfile);
@@ -1565,11 +2235,12 @@ TTree* SetupThreScanTree(TString treename, TString treetitle, TFile *rootfile)
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreeThresholdScan(treename,treetitle);
   else
     newtree = ReadThreScanTree(treename, rootfile);
@@ -1593,14 +2264,44 @@ TTree* SetupThreScanTreeResult(TString treename, TString treetitle, TFile *rootf
 //          a pointer to the created/read tree
 //
 // Created:      28 Nov 2018  Mario Sitta
+// Updated:      19 Oct 2026  Read only when appending
 //
 
   TTree *newtree = 0;
   
-  if(redoFromStart)
+  if(!appendToFile)
     newtree = CreateTreeThresholdScanResult(treename,treetitle);
   else
     newtree = ReadThreScanTreeResult(treename, rootfile);
 
   return newtree;
 }
+
+TTree* SetupThreScanTreeWaferMap(TString treename, TString treetitle, TFile *rootfile)
+{
+//
+// Creates a new wafer map tree or reads it from file
+//
+// Inputs:
+//          treename  : the tree name
+//          treetitle : the tree title
+//          rootfile  : the (already opened) Root file
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created/read tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newtree = 0;
+
+  if(appendToFile)
+    newtree = ReadThreScanTreeWaferMap(treename, rootfile);
+
+  if(!newtree) // Also when appending to a file older than the maps
+    newtree = CreateTreeThresholdScanWaferMap(treename,treetitle);
+
+  return newtree;
+}
@@ -22,33 +22,77 @@
 #include "AlpideDBEndPoints.h"
 #include "THIC.h"
 #include "TScanFactory.h"
+#include "dblib.h"
+#include "iolib.h"
+#include "perflib.h"
+#include "schedlib.h"
+#include "sortlib.h"
+#include "trendlib.h"
 
 #include <iostream>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <vector>
+
+// The buffers of a Threshold Scan chip file: they are taken from a pool
+// when the file is read and given back once it is filled in the tree,
+// so that their memory is reused by the next files
+struct TThreScanPixels {
+  std::vector<char>     buffer; // the file content
+  std::vector<UShort_t> col;    // the pixels, as stored in the tree
+  std::vector<UShort_t> row;
+  std::vector<UShort_t> thres;
+  std::vector<UShort_t> noise;
+};
+
+// A Threshold Scan chip file: its pixels are read and scanned (by a
+// worker thread, if any) before being filled in the tree (see
+// ThresholdScanAllChips)
+struct TThreScanChipFile {
+  const char *fullName;         // the file path and name
+  string      fileName;         // the file name (for the messages)
+  UChar_t     condVB;           // the tree variables of the chip
+  UChar_t     chipNum;
+  Char_t      waferNum;
+  Char_t      waferPos;
+  Long64_t    memory;           // the memory needed to read it (estimated)
+  Long64_t    bytes;            // the bytes read (-1 if the file cannot be opened)
+  Double_t    seconds;          // the time spent reading and scanning it
+  Int_t       done;             // set to 1 by the worker when read
+  Bool_t      read;             // kTRUE if already read in a batch (see IoReadFiles)
+  TThreScanPixels *pixels;      // the buffers (while being read and filled)
+};
 
 //Bool_t redoFromStart;
 
-void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *db, const THicType hicType);
+void analyzeAllThresholdScans(std::vector<ComponentDB::componentShort> componentList, AlpideDB *&db, const THicType hicType);
 void analyzeThresholdScan(const int hicid, const ComponentDB::compActivity act, AlpideDB *db, const THicType hicType);
+void mergeAllThresholdScans(const int nshards, const THicType hicType);
+void sortAllThresholdScans(const THicType hicType);
 void CopyThreScanOldToNew(const UInt_t hicid, const UInt_t actid, TTree *newscan, TTree *newtun, TTree *newres, TTree *oldscan, TTree *oldtun, TTree *oldres);
 TTree* CreateHicActListTreeTS(void);
 TTree* CreateTreeThresholdScan(TString treeName, TString treeTitle);
 TTree* CreateTreeThresholdScanResult(TString treeName, TString treeTitle);
-Bool_t FillThreScanTree(TTree* tree, string path, string file);
-Bool_t FillThreScanTreeResult(TTree* tree, string path, string file, ActivityDB::activityLong actlong, const THicType hicType);
-Bool_t FindActivityInThreScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask);
+TTree* CreateTreeThresholdScanWaferMap(TString treeName, TString treeTitle);
+Bool_t FillThreScanChipFile(TTree *tree, const TThreScanChipFile &chipfile);
+Bool_t FillThreScanTree(TTree* tree, const string &path, const string &file);
+Bool_t FillThreScanTreeResult(TTree* tree, const string &path, const string &file, const ActivityDB::activityLong &actlong, const THicType hicType);
+void FillThreScanWaferMapTree(TTree *tree, const UInt_t hicid, const THicType hicType, const TWaferMap *wafermap);
+Bool_t FindActivityInThreScanTree(TTree* listree, const UInt_t hicid, const UInt_t actid, const UShort_t mask, ULong64_t &dbfinger, ULong64_t &finger);
+void GetThreScanTrendRecords(TTree *tree, const Long64_t first, const Long64_t last, const UChar_t stage, std::vector<TTrendRecord> &records);
 TTree* ReadHicActListTreeTS(TFile *rootfile);
 TTree* ReadThreScanTree(TString treename, TFile *rootfile);
 TTree* ReadThreScanTreeResult(TString treename, TFile *rootfile);
+TTree* ReadThreScanTreeWaferMap(TString treename, TFile *rootfile);
 void ResetThreScanTreeVariables(void);
 void SanitizeThresScanInput(char *line);
 TTree* SetupHicActListTreeTS(TFile *rootfile);
 TTree* SetupThreScanTree(TString treename, TString treetitle, TFile *rootfile);
 TTree* SetupThreScanTreeResult(TString treename, TString treetitle, TFile *rootfile);
-void ThresholdScanAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType, std::vector<TChild> children, bool allScans=true);
-void ThresholdTuneAllChips(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType, std::vector<TChild> children);
-void ThresholdScanResults(TTree *ftree, ActivityDB::activityLong actlong, const int hicid, const int actid, const string eospath, const THicType hicType);
+TTree* SetupThreScanTreeWaferMap(TString treename, TString treetitle, TFile *rootfile);
+void ThresholdScanAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType, const TWaferMap *wafermap, bool allScans=true);
+void ThresholdTuneAllChips(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType, const std::vector<TChild> &children);
+void ThresholdScanResults(TTree *ftree, const ActivityDB::activityLong &actlong, const int hicid, const int actid, const string &eospath, const THicType hicType);
 
 
 #endif // THRESCANLIB_H
@@ -6,6 +6,7 @@
 #define HICNAMELEN 13
 
 static Bool_t redoFromStart;
+static Bool_t appendToFile;  // New activities are appended to existing trees
 
 // Global tree variables
 static UChar_t  condVB; // Conditions of the test: Voltage percentage + Bias (0,3)
@@ -17,6 +18,8 @@ static Char_t   hicName[HICNAMELEN];
 static UShort_t actMask;
 static UInt_t   hicID;
 static UInt_t   actID;
+static ULong64_t actFingerprint; // Hash of the activity DB data and EOS files
+static ULong64_t actDbFingerprint; // Hash of the activity DB data only
 static ULong64_t startDate;
 static Int_t    locID;
 static Char_t   hicPosition; // HIC position in HS/Stave
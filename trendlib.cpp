@@ -0,0 +1,767 @@
+#include "trendlib.h"
+#include "digiscanlib.h"
+#include "noisescanlib.h"
+#include "threscanlib.h"
+#include "utillib.h"
+#include "menulib.h"
+#include "treevariables.h"
+
+#include <algorithm>
+#include <functional>
+
+// The pixel trees of each source, in stage order (see TRENDSTAGE_*)
+static const char* trendTreeNames[TRENDNSOURCES][TRENDNSTAGES] = {
+  {"hicQualTree", "hicRecpTree", "hicHSTree", "hicStaveTree"},
+  {"hicQualTree", "hicRecpTree", "hicHSTree", "hicStaveQualTree"},
+  {"hicQualTree", "hicRecpTree", "hicHSTree", "hicStaveTree"}
+};
+
+// Local tree variables
+static UShort_t colNum;
+static UShort_t rowNum;
+static UChar_t  stageMask;                    // Stages with data
+static Float_t  trendThresh[TRENDNSTAGES];    // -1 if missing
+static Float_t  trendNoise[TRENDNSTAGES];     // -1 if missing
+static Short_t  trendHits[TRENDNSTAGES];      // -1 if missing
+static Int_t    trendNoisyHits[TRENDNSTAGES]; // -1 if missing
+static Float_t  deltaThresh;                  // Last minus first stage
+static Float_t  deltaNoise;                   // Last minus first stage
+static UChar_t  degradFlags;                  // TRENDDEGR_* bits
+static Char_t   degradStage;                  // First stage degraded, -1 if none
+static Int_t    numPixels;
+static Float_t  meanDeltaThresh;
+static Float_t  rmsDeltaThresh;
+static Float_t  meanDeltaNoise;
+static Float_t  rmsDeltaNoise;
+static Int_t    numDegraded[TRENDNDEGR];
+
+// The sums of the current chip (see TrendFillChip)
+static Double_t sumDThresh, sumDThresh2, sumDNoise, sumDNoise2;
+
+// The memory budget of the records joined at once (see TrendJoinHic)
+static Long64_t trendMemory = (Long64_t)TRENDMEMORYDEF << 20;
+
+
+void analyzeAllPixelTrends(const THicType hicType)
+{
+//
+// Steering routine to join the per-pixel data of the Threshold, Digital
+// and Noise Scans of all HICs across the test stages (Qualification,
+// Reception, Half Stave, Stave) and write the per-pixel trends, the
+// list of degraded pixels and the per-chip trend statistics
+// The HICs are processed one at a time: the records of each stage and
+// source are sorted on the pixel key and joined with a k-way merge,
+// so only the data of one HIC (or of some of its chips, if they do not
+// fit in the memory budget) are in memory at any time
+//
+// Inputs:
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  const char* fileNames[TRENDNSOURCES] = {
+    "HIC_ThresholdScan_AllHICs.root",
+    "HIC_DigitalScan_AllHICs.root",
+    "HIC_NoiseScan_AllHICs.root"
+  };
+  TString prefix = (hicType == HIC_IB) ? "IB" : "OB";
+
+  // Open the files of all analyses and index their pixel trees
+  // (an analysis not yet performed is simply missing from the trends)
+  TFile *inputFiles[TRENDNSOURCES];
+  std::vector<TTrendInput> inputs;
+  std::map<UInt_t, string> hicNames;
+
+  for (Int_t isrc = 0; isrc < TRENDNSOURCES; isrc++) {
+    inputFiles[isrc] = 0;
+    TString rootFileName = prefix + fileNames[isrc];
+    if (!CheckRootFileExists(rootFileName)) {
+      printMessage("\nanalyzeAllPixelTrends","Warning: missing file",rootFileName.Data(), LOG_WARNING);
+      continue;
+    }
+    inputFiles[isrc] = OpenRootFile(rootFileName);
+    if (!inputFiles[isrc] || inputFiles[isrc]->IsZombie()) {
+      printMessage("\nanalyzeAllPixelTrends","Error: cannot open file",rootFileName.Data(), LOG_ERROR);
+      f12ToExit();
+      return;
+    }
+    for (Int_t istage = 0; istage < TRENDNSTAGES; istage++) {
+      TTrendInput input;
+      input.source = isrc;
+      input.stage = istage;
+      input.tree = TrendReadTree(inputFiles[isrc], isrc, istage);
+      if (!input.tree) continue;
+      TrendIndexTree(input.tree, input.hics, hicNames);
+      inputs.push_back(input);
+    }
+  }
+
+  if (inputs.size() == 0) {
+    printMessage("\nanalyzeAllPixelTrends","Error: no pixel trees found", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
+
+  // Create the output file and trees
+  TString rootFileName = prefix + "HIC_PixelTrend_AllHICs.root";
+  TFile *trendFile = OpenRootFile(rootFileName, kTRUE);
+  if (!trendFile) {
+    printMessage("\nanalyzeAllPixelTrends","Error: cannot open file",rootFileName.Data(), LOG_ERROR);
+    f12ToExit();
+    return;
+  }
+
+  TTree *pixTrendTree = CreateTreePixelTrend("pixTrendTree","PixelTrends");
+  TTree *degradTree = CreateTreePixelDegraded("degradTree","DegradedPixels");
+  TTree *chipTrendTree = CreateTreeChipTrend("chipTrendTree","ChipTrends");
+  if (!pixTrendTree || !degradTree || !chipTrendTree) {
+    printMessage("\nanalyzeAllPixelTrends","Error: error creating the ROOT trees", 0, LOG_ERROR);
+    f12ToExit();
+    return;
+  }
+
+  // Join the data of one HIC at a time
+  std::map<UInt_t, string>::iterator it;
+  for (it = hicNames.begin(); it != hicNames.end(); it++) {
+    hicID = it->first;
+    memset(hicName, 0, HICNAMELEN);
+    strncpy(hicName, it->second.c_str(), HICNAMELEN-1);
+    TrendJoinHic(hicID, inputs, pixTrendTree, degradTree, chipTrendTree);
+    PerfCount(PERF_NHICS);
+  }
+
+  Double_t perfStart = PerfNow();
+  trendFile->cd();
+  pixTrendTree->Write();
+  degradTree->Write();
+  chipTrendTree->Write();
+  CloseRootFile(trendFile);
+  PerfAddSample(PERF_WRITE, PerfNow() - perfStart, PerfFileSize(rootFileName.Data()));
+
+  for (Int_t isrc = 0; isrc < TRENDNSOURCES; isrc++)
+    if (inputFiles[isrc]) CloseRootFile(inputFiles[isrc]);
+
+#ifdef USENCURSES
+  mvprintw(LINES-4, 0, "\n ROOT file %s written: %lld pixels, %lld degraded\n",
+           rootFileName.Data(), pixTrendTree->GetEntries(), degradTree->GetEntries());
+#else
+  printf("\n\n ROOT file %s written: %lld pixels, %lld degraded\n",
+         rootFileName.Data(), pixTrendTree->GetEntries(), degradTree->GetEntries());
+#endif
+
+  f12ToExit();
+}
+
+TTree* CreateTreeChipTrend(TString treeName, TString treeTitle)
+{
+//
+// Creates a tree for the per-chip trend statistics: one entry per chip
+// with the mean and RMS of the threshold and noise changes of its
+// pixels (those with a threshold in at least two stages) and the number
+// of pixels degraded in each way (see TRENDDEGR_*)
+//
+// Inputs:
+//          treeName  : the tree name
+//          treeTitle : the tree title
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created ROOT tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newTree = 0;
+  newTree = new TTree(treeName.Data(), treeTitle.Data());
+
+  if(newTree) {
+    newTree->Branch("hicName", hicName, "hicName[13]/B");
+    newTree->Branch("hicID", &hicID, "hicID/i");
+    newTree->Branch("chipNum", &chipNum, "chipNum/b");
+    newTree->Branch("numPixels", &numPixels, "numPixels/I");
+    newTree->Branch("meanDeltaThresh", &meanDeltaThresh, "meanDeltaThresh/F");
+    newTree->Branch("rmsDeltaThresh", &rmsDeltaThresh, "rmsDeltaThresh/F");
+    newTree->Branch("meanDeltaNoise", &meanDeltaNoise, "meanDeltaNoise/F");
+    newTree->Branch("rmsDeltaNoise", &rmsDeltaNoise, "rmsDeltaNoise/F");
+    newTree->Branch("numDegraded", numDegraded, "numDegraded[4]/I");
+  }
+
+  return newTree;
+}
+
+TTree* CreateTreePixelDegraded(TString treeName, TString treeTitle)
+{
+//
+// Creates a tree for the list of degraded pixels
+//
+// Inputs:
+//          treeName  : the tree name
+//          treeTitle : the tree title
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created ROOT tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newTree = 0;
+  newTree = new TTree(treeName.Data(), treeTitle.Data());
+
+  if(newTree) {
+    newTree->Branch("hicName", hicName, "hicName[13]/B");
+    newTree->Branch("hicID", &hicID, "hicID/i");
+    newTree->Branch("chipNum", &chipNum, "chipNum/b");
+    newTree->Branch("colNum", &colNum, "colNum/s");
+    newTree->Branch("rowNum", &rowNum, "rowNum/s");
+    newTree->Branch("degradFlags", &degradFlags, "degradFlags/b");
+    newTree->Branch("degradStage", &degradStage, "degradStage/B");
+  }
+
+  return newTree;
+}
+
+TTree* CreateTreePixelTrend(TString treeName, TString treeTitle)
+{
+//
+// Creates a tree for the per-pixel trends: one entry per pixel with
+// data in at least two stages, with its values in each stage (-1 if
+// missing), the changes from the first to the last stage and the ways
+// it degraded (see TRENDDEGR_*)
+//
+// Inputs:
+//          treeName  : the tree name
+//          treeTitle : the tree title
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created ROOT tree
+//
+// Created:      19 Oct 2026
+//
+
+  TTree *newTree = 0;
+  newTree = new TTree(treeName.Data(), treeTitle.Data());
+
+  if(newTree) {
+    newTree->Branch("hicName", hicName, "hicName[13]/B");
+    newTree->Branch("hicID", &hicID, "hicID/i");
+    newTree->Branch("chipNum", &chipNum, "chipNum/b");
+    newTree->Branch("colNum", &colNum, "colNum/s");
+    newTree->Branch("rowNum", &rowNum, "rowNum/s");
+    newTree->Branch("stageMask", &stageMask, "stageMask/b");
+    newTree->Branch("thresh", trendThresh, "thresh[4]/F");
+    newTree->Branch("noise", trendNoise, "noise[4]/F");
+    newTree->Branch("hits", trendHits, "hits[4]/S");
+    newTree->Branch("noisyHits", trendNoisyHits, "noisyHits[4]/I");
+    newTree->Branch("deltaThresh", &deltaThresh, "deltaThresh/F");
+    newTree->Branch("deltaNoise", &deltaNoise, "deltaNoise/F");
+    newTree->Branch("degradFlags", &degradFlags, "degradFlags/b");
+    newTree->Branch("degradStage", &degradStage, "degradStage/B");
+  }
+
+  return newTree;
+}
+
+void SetTrendMemory(const Long64_t mbytes)
+{
+//
+// Sets the memory budget of the trend join: the chips of a HIC whose
+// records do not fit in it all together are joined a few at a time
+//
+// Inputs:
+//          mbytes : the memory budget in MB
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  trendMemory = mbytes << 20;
+}
+
+void TrendDegrade(const UChar_t flag, const Int_t stage)
+{
+//
+// Marks the current pixel as degraded
+//
+// Inputs:
+//          flag  : the way it degraded (one of TRENDDEGR_*)
+//          stage : the stage where it was found degraded
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  degradFlags |= flag;
+  if (degradStage < 0 || stage < degradStage)
+    degradStage = stage;
+}
+
+void TrendFillChip(TTree *chiptree)
+{
+//
+// Fills the per-chip statistics of the current chip and resets them
+//
+// Inputs:
+//          chiptree : the per-chip tree
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (numPixels > 0) {
+    meanDeltaThresh = sumDThresh/numPixels;
+    meanDeltaNoise = sumDNoise/numPixels;
+    rmsDeltaThresh = TMath::Sqrt(TMath::Max(0., sumDThresh2/numPixels - meanDeltaThresh*meanDeltaThresh));
+    rmsDeltaNoise = TMath::Sqrt(TMath::Max(0., sumDNoise2/numPixels - meanDeltaNoise*meanDeltaNoise));
+  } else {
+    meanDeltaThresh = 0;
+    meanDeltaNoise = 0;
+    rmsDeltaThresh = 0;
+    rmsDeltaNoise = 0;
+  }
+  chiptree->Fill();
+
+  numPixels = 0;
+  sumDThresh = sumDThresh2 = sumDNoise = sumDNoise2 = 0;
+  for (Int_t i = 0; i < TRENDNDEGR; i++)
+    numDegraded[i] = 0;
+}
+
+void TrendFillPixel(TTree *pixtree, TTree *degrtree)
+{
+//
+// Computes the changes of the current pixel across the stages and
+// fills the trees with it, if it has data in at least two stages
+//
+// Inputs:
+//          pixtree  : the per-pixel tree
+//          degrtree : the tree of the degraded pixels
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  Int_t nstages = 0;
+  for (Int_t istage = 0; istage < TRENDNSTAGES; istage++)
+    if (stageMask & (1 << istage)) nstages++;
+  if (nstages < 2) return;
+
+  // A pixel is degraded if it was good in a stage and bad in a later one
+  Bool_t digiGood = kFALSE, noiseGood = kFALSE;
+  Int_t firstThresh = -1, nthresh = 0;
+  deltaThresh = 0;
+  deltaNoise = 0;
+  degradFlags = 0;
+  degradStage = -1;
+  for (Int_t istage = 0; istage < TRENDNSTAGES; istage++) {
+    if (trendHits[istage] >= 0) {
+      if (trendHits[istage] == DIGMAP_NINJ)
+        digiGood = kTRUE;
+      else if (digiGood)
+        TrendDegrade(TRENDDEGR_DIGITAL, istage);
+    }
+    if (trendNoisyHits[istage] >= 0) {
+      if (trendNoisyHits[istage] == 0)
+        noiseGood = kTRUE;
+      else if (noiseGood)
+        TrendDegrade(TRENDDEGR_NOISY, istage);
+    }
+    if (trendThresh[istage] >= 0) {
+      nthresh++;
+      if (firstThresh < 0)
+        firstThresh = istage;
+      else {
+        deltaThresh = trendThresh[istage] - trendThresh[firstThresh];
+        deltaNoise = trendNoise[istage] - trendNoise[firstThresh];
+        if (TMath::Abs(deltaThresh) > TRENDMAXDTHRESH)
+          TrendDegrade(TRENDDEGR_THRESH, istage);
+        if (deltaNoise > TRENDMAXDNOISE)
+          TrendDegrade(TRENDDEGR_NOISE, istage);
+      }
+    }
+  }
+
+  pixtree->Fill();
+
+  if (nthresh > 1) {
+    numPixels++;
+    sumDThresh += deltaThresh;
+    sumDThresh2 += deltaThresh*deltaThresh;
+    sumDNoise += deltaNoise;
+    sumDNoise2 += deltaNoise*deltaNoise;
+  }
+
+  if (degradFlags) {
+    degrtree->Fill();
+    for (Int_t i = 0; i < TRENDNDEGR; i++)
+      if (degradFlags & (1 << i)) numDegraded[i]++;
+  }
+}
+
+void TrendIndexChips(TTrendInput &input, const TTrendRange &range, std::map<Int_t, Long64_t> &records)
+{
+//
+// Indexes the entries of each chip of a HIC in a pixel tree, reading
+// only the chip number (and the number of pixels of packed trees):
+// the entries of a chip are usually contiguous, otherwise it has more
+// runs of entries
+//
+// Inputs:
+//          input   : the pixel tree
+//          range   : the entries of the HIC
+//
+// Outputs:
+//          input   : the runs of entries of each chip
+//          records : the records of each chip, incremented (an upper
+//                    bound: the entries of all conditions are counted)
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  input.chips.clear();
+
+  TBranch *chipBranch = input.tree->GetBranch("chipNum");
+  TBranch *pixBranch = input.tree->GetBranch("pixNum"); // Packed trees only
+  if (!chipBranch) return;
+
+  // Read into local variables, then give the branches back
+  // to the tree variables of the analysis library
+  char *chipAddr = chipBranch->GetAddress();
+  char *pixAddr = pixBranch ? pixBranch->GetAddress() : 0;
+
+  UChar_t chip = 0;
+  Int_t npix = 1;
+  chipBranch->SetAddress(&chip);
+  if (pixBranch) pixBranch->SetAddress(&npix);
+
+  Int_t lastchip = -1;
+  TTrendRange run;
+  run.first = -1;
+  for (Long64_t j = range.first; j < range.last; j++) {
+    chipBranch->GetEntry(j);
+    if (pixBranch) pixBranch->GetEntry(j);
+    if (run.first < 0 || chip != lastchip) {
+      if (run.first >= 0) {
+        run.last = j;
+        input.chips[lastchip].push_back(run);
+      }
+      run.first = j;
+      lastchip = chip;
+    }
+    records[chip] += npix;
+  }
+  if (run.first >= 0) {
+    run.last = range.last;
+    input.chips[lastchip].push_back(run);
+  }
+
+  chipBranch->SetAddress(chipAddr);
+  if (pixBranch) pixBranch->SetAddress(pixAddr);
+}
+
+void TrendIndexTree(TTree *tree, std::map<UInt_t, TTrendRange> &hics, std::map<UInt_t, string> &names)
+{
+//
+// Indexes a pixel tree by HIC, reading only the HIC and activity Id
+// (the activities are contiguous in the trees: if a HIC has more
+// activities in the same tree the last one is kept)
+//
+// Inputs:
+//          tree  : the pixel tree (read from file)
+//
+// Outputs:
+//          hics  : the entries of each HIC
+//          names : the name of each HIC, added if not yet there
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TBranch *hicBranch = tree->GetBranch("hicID");
+  TBranch *actBranch = tree->GetBranch("actID");
+  TBranch *nameBranch = tree->GetBranch("hicName");
+  if (!hicBranch || !actBranch || !nameBranch) return;
+
+  // Read into local variables, then give the branches back
+  // to the tree variables of the analysis library
+  char *hicAddr = hicBranch->GetAddress();
+  char *actAddr = actBranch->GetAddress();
+  char *nameAddr = nameBranch->GetAddress();
+
+  UInt_t hicid = 0, actid = 0, lasthic = 0, lastact = 0;
+  Char_t name[HICNAMELEN];
+  hicBranch->SetAddress(&hicid);
+  actBranch->SetAddress(&actid);
+  nameBranch->SetAddress(name);
+
+  Long64_t nentries = tree->GetEntries();
+  TTrendRange range;
+  range.first = -1;
+  for (Long64_t j = 0; j < nentries; j++) {
+    hicBranch->GetEntry(j);
+    actBranch->GetEntry(j);
+    if (range.first < 0 || hicid != lasthic || actid != lastact) {
+      if (range.first >= 0) {
+        range.last = j;
+        hics[lasthic] = range;
+      }
+      range.first = j;
+      lasthic = hicid;
+      lastact = actid;
+      if (names.find(hicid) == names.end()) {
+        nameBranch->GetEntry(j);
+        name[HICNAMELEN-1] = '\0';
+        names[hicid] = name;
+      }
+    }
+  }
+  if (range.first >= 0) {
+    range.last = nentries;
+    hics[lasthic] = range;
+  }
+
+  hicBranch->SetAddress(hicAddr);
+  actBranch->SetAddress(actAddr);
+  nameBranch->SetAddress(nameAddr);
+}
+
+void TrendJoinChips(const Int_t firstchip, const Int_t lastchip, std::vector<TTrendInput> &inputs, const Bool_t present[][TRENDNSTAGES], TTree *pixtree, TTree *degrtree, TTree *chiptree)
+{
+//
+// Joins the per-pixel data of some chips of a HIC across all stages and
+// sources: the records of each tree are sorted on the pixel key (they
+// usually already are, in file order) and merged, then each pixel is
+// filled
+//
+// Inputs:
+//          firstchip : the first chip to join
+//          lastchip  : the last chip to join
+//          inputs    : the pixel trees, with the chips of the HIC indexed
+//          present   : whether each source and stage has the HIC
+//          pixtree   : the per-pixel tree
+//          degrtree  : the tree of the degraded pixels
+//          chiptree  : the per-chip tree
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  std::vector< std::vector<TTrendRecord> > streams;
+
+  for (UInt_t i = 0; i < inputs.size(); i++) {
+    if (inputs[i].chips.empty()) continue;
+
+    streams.push_back(std::vector<TTrendRecord>());
+    std::vector<TTrendRecord> &records = streams.back();
+    std::map<Int_t, std::vector<TTrendRange> >::iterator it;
+    for (it = inputs[i].chips.lower_bound(firstchip);
+         it != inputs[i].chips.end() && it->first <= lastchip; it++) {
+      for (UInt_t r = 0; r < it->second.size(); r++) {
+        const TTrendRange &run = it->second[r];
+        switch (inputs[i].source) {
+          case TRENDSRC_THRESH:
+            GetThreScanTrendRecords(inputs[i].tree, run.first, run.last, inputs[i].stage, records);
+            break;
+          case TRENDSRC_DIGITAL:
+            GetDigScanTrendRecords(inputs[i].tree, run.first, run.last, inputs[i].stage, records);
+            break;
+          case TRENDSRC_NOISE:
+            GetNoiseScanTrendRecords(inputs[i].tree, run.first, run.last, inputs[i].stage, records);
+            break;
+        }
+      }
+    }
+    if (!std::is_sorted(records.begin(), records.end(), TrendRecordLess))
+      std::stable_sort(records.begin(), records.end(), TrendRecordLess);
+  }
+
+  // The k-way merge: the smallest current key of all streams is joined
+  std::priority_queue<TTrendHead, std::vector<TTrendHead>, std::greater<TTrendHead> > heads;
+  std::vector<UInt_t> pos(streams.size(), 0);
+  TTrendHead head;
+  for (UInt_t s = 0; s < streams.size(); s++)
+    if (streams[s].size() > 0) {
+      head.pixel = streams[s][0].pixel;
+      head.stream = s;
+      heads.push(head);
+    }
+
+  Int_t currChip = -1;
+  while (!heads.empty()) {
+    const UInt_t pixel = heads.top().pixel;
+
+    // Pixels not in the Digital or Noise Scan trees of a stage
+    // which has them were good (all hits, no noise)
+    stageMask = 0;
+    for (Int_t istage = 0; istage < TRENDNSTAGES; istage++) {
+      trendThresh[istage] = -1;
+      trendNoise[istage] = -1;
+      trendHits[istage] = present[TRENDSRC_DIGITAL][istage] ? DIGMAP_NINJ : -1;
+      trendNoisyHits[istage] = present[TRENDSRC_NOISE][istage] ? 0 : -1;
+      if (present[TRENDSRC_DIGITAL][istage] || present[TRENDSRC_NOISE][istage])
+        stageMask |= (1 << istage);
+    }
+
+    while (!heads.empty() && heads.top().pixel == pixel) {
+      head = heads.top();
+      heads.pop();
+      const TTrendRecord &rec = streams[head.stream][pos[head.stream]];
+      switch (rec.source) {
+        case TRENDSRC_THRESH:
+          if (rec.value > 0) { // No threshold if 0
+            trendThresh[rec.stage] = rec.value/100.;
+            trendNoise[rec.stage] = rec.value2/100.;
+            stageMask |= (1 << rec.stage);
+          }
+          break;
+        case TRENDSRC_DIGITAL:
+          trendHits[rec.stage] = TMath::Min(rec.value, (UInt_t)32767);
+          break;
+        case TRENDSRC_NOISE:
+          trendNoisyHits[rec.stage] = rec.value;
+          break;
+      }
+      if (++pos[head.stream] < streams[head.stream].size()) {
+        head.pixel = streams[head.stream][pos[head.stream]].pixel;
+        heads.push(head);
+      }
+    }
+
+    if ((Int_t)(pixel >> 19) != currChip) {
+      if (currChip >= 0) TrendFillChip(chiptree);
+      currChip = pixel >> 19;
+    }
+    chipNum = currChip;
+    rowNum = (pixel >> 10) & 0x1ff;
+    colNum = pixel & 0x3ff;
+    TrendFillPixel(pixtree, degrtree);
+  }
+
+  if (currChip >= 0) {
+    chipNum = currChip;
+    TrendFillChip(chiptree);
+  }
+}
+
+void TrendJoinHic(const UInt_t hicid, std::vector<TTrendInput> &inputs, TTree *pixtree, TTree *degrtree, TTree *chiptree)
+{
+//
+// Joins the per-pixel data of a HIC across all stages and sources:
+// the entries of each chip in all trees are indexed, then the chips are
+// joined in groups whose records fit in the memory budget (usually the
+// whole HIC at once, at least one chip at a time)
+//
+// Inputs:
+//          hicid    : the HIC Id
+//          inputs   : the indexed pixel trees
+//          pixtree  : the per-pixel tree
+//          degrtree : the tree of the degraded pixels
+//          chiptree : the per-chip tree
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  Bool_t present[TRENDNSOURCES][TRENDNSTAGES];
+  memset(present, 0, sizeof(present));
+  std::map<Int_t, Long64_t> records; // Records of each chip, all trees
+
+  for (UInt_t i = 0; i < inputs.size(); i++) {
+    std::map<UInt_t, TTrendRange>::iterator it = inputs[i].hics.find(hicid);
+    if (it == inputs[i].hics.end()) {
+      inputs[i].chips.clear();
+      continue;
+    }
+
+    present[inputs[i].source][inputs[i].stage] = kTRUE;
+    TrendIndexChips(inputs[i], it->second, records);
+  }
+
+  const Long64_t recordSize = sizeof(TTrendRecord);
+  std::map<Int_t, Long64_t>::iterator ic = records.begin();
+  while (ic != records.end()) {
+    const Int_t firstChip = ic->first;
+    Int_t lastChip;
+    Long64_t bytes = 0;
+    do {
+      lastChip = ic->first;
+      bytes += ic->second*recordSize;
+      ic++;
+    } while (ic != records.end() && bytes + ic->second*recordSize <= trendMemory);
+
+    TrendJoinChips(firstChip, lastChip, inputs, present, pixtree, degrtree, chiptree);
+  }
+}
+
+TTree* TrendReadTree(TFile *rootfile, const Int_t source, const Int_t stage)
+{
+//
+// Reads a pixel tree of a given source and stage from file
+//
+// Inputs:
+//          rootfile : the (already opened) Root file of the source
+//          source   : the source (one of TRENDSRC_*)
+//          stage    : the stage (one of TRENDSTAGE_*)
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the read ROOT tree (0 if not there)
+//
+// Created:      19 Oct 2026
+//
+
+  if (!rootfile->Get(trendTreeNames[source][stage])) return 0;
+
+  switch (source) {
+    case TRENDSRC_THRESH:
+      return ReadThreScanTree(trendTreeNames[source][stage], rootfile);
+    case TRENDSRC_DIGITAL:
+      return ReadDigScanTree(trendTreeNames[source][stage], rootfile);
+    case TRENDSRC_NOISE:
+      return ReadNoiseScanTree(trendTreeNames[source][stage], rootfile);
+    default:
+      return 0;
+  }
+}
+
+bool TrendRecordLess(const TTrendRecord &rec1, const TTrendRecord &rec2)
+{
+//
+// Orders the records on the pixel key
+//
+// Created:      19 Oct 2026
+//
+
+  return rec1.pixel < rec2.pixel;
+}
@@ -0,0 +1,101 @@
+#ifndef TRENDLIB_H
+#define TRENDLIB_H
+
+#include <Rtypes.h>
+#include <TBranch.h>
+#include <TFile.h>
+#include <TMath.h>
+#include <TString.h>
+#include <TTree.h>
+
+#include "DBHelpers.h"
+
+#include <map>
+#include <queue>
+#include <set>
+#include <stdio.h>
+#include <vector>
+
+// The test stages, in the order the HICs go through them
+#define TRENDSTAGE_QUALIF 0
+#define TRENDSTAGE_RECEPT 1
+#define TRENDSTAGE_HALFST 2
+#define TRENDSTAGE_STAVE  3
+#define TRENDNSTAGES      4
+
+// The sources of the per-pixel data
+#define TRENDSRC_THRESH  0  // Threshold Scan: threshold and noise
+#define TRENDSRC_DIGITAL 1  // Digital Scan: number of hits
+#define TRENDSRC_NOISE   2  // Noise Scan: number of noise hits
+#define TRENDNSOURCES    3
+
+// The conditions (condVB) compared across the stages
+#define TRENDCOND_THRESH  200 // Tuned thresholds, no back bias
+#define TRENDCOND_DIGITAL 100 // Nominal voltage, no back bias
+#define TRENDCOND_NOISE   100 // Unmasked, no back bias
+
+// The ways a pixel can degrade from a stage to a later one
+#define TRENDDEGR_DIGITAL 0x01 // Good in Digital Scan, then dead/ineff/noisy
+#define TRENDDEGR_NOISY   0x02 // Not noisy, then noisy in Noise Scan
+#define TRENDDEGR_THRESH  0x04 // Threshold changed more than TRENDMAXDTHRESH
+#define TRENDDEGR_NOISE   0x08 // Noise increased more than TRENDMAXDNOISE
+#define TRENDNDEGR        4
+
+#define TRENDMAXDTHRESH 20.  // Same units as the Threshold Scan files
+#define TRENDMAXDNOISE  3.
+
+#define TRENDMEMORYDEF 256 // Default memory budget of the join of a HIC in MB
+
+// The key of a pixel of a HIC: the records are joined on it, so they
+// are sorted by chip, then row, then column (as in the data files)
+#define TRENDPIXEL(chip, col, row) ((UInt_t(chip) << 19) | (UInt_t(row) << 10) | UInt_t(col))
+
+// A value of a pixel in a given stage, from one of the sources
+struct TTrendRecord {
+  UInt_t   pixel;   // the pixel key (see TRENDPIXEL)
+  UInt_t   value;   // threshold*100, or number of hits
+  UShort_t value2;  // noise*100 (Threshold Scan only)
+  UChar_t  stage;   // one of TRENDSTAGE_*
+  UChar_t  source;  // one of TRENDSRC_*
+};
+
+// The entries of the activity of a HIC in a pixel tree
+// (the last one if the HIC has more of them in the same stage)
+struct TTrendRange {
+  Long64_t first;
+  Long64_t last;   // the entry after the last one
+};
+
+// A pixel tree of a given source and stage, with its index by HIC
+// and the index by chip of the HIC being joined
+struct TTrendInput {
+  TTree   *tree;
+  UChar_t  source;
+  UChar_t  stage;
+  std::map<UInt_t, TTrendRange> hics;
+  std::map<Int_t, std::vector<TTrendRange> > chips;
+};
+
+// The current record of a sorted stream, in the k-way merge
+struct TTrendHead {
+  UInt_t pixel;
+  Int_t  stream;
+  bool operator>(const TTrendHead &other) const { return pixel > other.pixel; }
+};
+
+void analyzeAllPixelTrends(const THicType hicType);
+TTree* CreateTreeChipTrend(TString treeName, TString treeTitle);
+TTree* CreateTreePixelDegraded(TString treeName, TString treeTitle);
+TTree* CreateTreePixelTrend(TString treeName, TString treeTitle);
+void SetTrendMemory(const Long64_t mbytes);
+void TrendDegrade(const UChar_t flag, const Int_t stage);
+void TrendFillChip(TTree *chiptree);
+void TrendFillPixel(TTree *pixtree, TTree *degrtree);
+void TrendIndexChips(TTrendInput &input, const TTrendRange &range, std::map<Int_t, Long64_t> &records);
+void TrendIndexTree(TTree *tree, std::map<UInt_t, TTrendRange> &hics, std::map<UInt_t, string> &names);
+void TrendJoinChips(const Int_t firstchip, const Int_t lastchip, std::vector<TTrendInput> &inputs, const Bool_t present[][TRENDNSTAGES], TTree *pixtree, TTree *degrtree, TTree *chiptree);
+void TrendJoinHic(const UInt_t hicid, std::vector<TTrendInput> &inputs, TTree *pixtree, TTree *degrtree, TTree *chiptree);
+TTree* TrendReadTree(TFile *rootfile, const Int_t source, const Int_t stage);
+bool TrendRecordLess(const TTrendRecord &rec1, const TTrendRecord &rec2);
+
+#endif // TRENDLIB_H
@@ -1,5 +1,299 @@
 #include "utillib.h"
 #include "menulib.h"
+#include "perflib.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+// The shard of the HIC list processed by this job (see SetShardNumber)
+static Int_t shardIndex = 0;
+static Int_t shardTotal = 1;
+
+// If true, existing ROOT files are always updated in place
+static Bool_t alwaysAppend = kFALSE;
+
+// If true, existing ROOT files are always rewritten copying from the old
+// file (see SetCopyMode), and the activities found changed in a file
+// being updated in place (see AddChangedActivity)
+static Bool_t alwaysCopy = kFALSE;
+static Int_t changedActivities = 0;
+
+// The activity lists of the HICs at the last poll in watch mode and the
+// polls done so far (see WatchHicChanged)
+static Bool_t watchPolling = kFALSE;
+static Int_t watchPolls = 0;
+static std::map<Int_t, ULong64_t> watchHicLists;
+
+// If true, new pixel trees hold one entry per chip (see SetPackedPixelTrees)
+static Bool_t packedPixelTrees = kFALSE;
+
+// If true, the all-HICs runs resume from their last checkpoint
+static Bool_t resumeRun = kFALSE;
+
+// The file and trees being checkpointed (see CheckpointBegin)
+static TFile *ckptFile = 0;
+static std::vector<TTree*> ckptTrees;
+static time_t ckptTime = 0;
+
+// The file of all analyses of a single HIC and the directory in it of the
+// analysis being run (see OpenHicRootFile)
+static TFile *hicRootFile = 0;
+static TDirectory *hicRootDir = 0;
+
+// The wafer maps of the HICs seen so far (see GetHicWaferMap)
+static std::map<Int_t, TWaferMap> hicWaferMaps;
+
+// The names of the activity parameters (see ACTPAR_*)
+static const char *actParNames[ACTPARNUM] = {
+  "Classification Version",
+  "Number of Working Chips",
+  "Classification Power Test",
+  "Classification Digital Scan BB 0",
+  "Classification Digital Scan BB 3",
+  "Classification Digital Scan BB 0, V -10%",
+  "Classification Digital Scan BB 0, V +10%",
+  "Classification Threshold Scan 0.0 V",
+  "Classification Threshold Scan 3.0 V",
+  "Classification Noise Occupancy 0.0 V",
+  "Classification Noise Occupancy 3.0 V",
+  "Classification Noise Occupancy 0.0 V, masked",
+  "Classification Noise Occupancy 3.0 V, masked",
+  "Classification Dctrl Measurement"
+};
+
+// The parameters of the last activity looked up (see GetActParameters)
+static TActParameters actParameters = {-1, {0}, {0}};
+
+// The string arena of the current activity (see ArenaJoinPath): the
+// blocks are kept when it is reset, so they are reused by the next one
+struct TArenaBlock {
+  char  *buf;
+  size_t size;
+};
+static std::vector<TArenaBlock> arenaBlocks;
+static size_t arenaBlock = 0;
+static size_t arenaUsed = 0;
+
+static void ActivityDBData(const ActivityDB::activityLong &actlong, std::ostringstream &data)
+{
+//
+// Writes the DB data of an activity the analysis depends on into a stream
+// (see ActivityDBFingerprint and ActivityFingerprint)
+//
+// Created:      19 Oct 2026
+//
+
+  data << actlong.Result.Name << '|' << actlong.Status.Name << '|'
+       << actlong.StartDate << '|' << actlong.EndDate << '|';
+
+  std::vector<ActivityDB::actParameter>::const_iterator par;
+  for(par = actlong.Parameters.begin(); par != actlong.Parameters.end(); par++)
+    data << par->Type.Parameter.Name << '=' << par->Value << '|';
+
+  std::vector<ActivityDB::attachment>::const_iterator att;
+  for(att = actlong.Attachments.begin(); att != actlong.Attachments.end(); att++)
+    data << att->FileName << '|';
+}
+
+static ULong64_t FingerprintHash(const string &bytes)
+{
+//
+// Computes the 64 bit FNV-1a hash of a string
+// (zero is reserved for unknown fingerprints)
+//
+// Created:      19 Oct 2026
+//
+
+  ULong64_t hash = 14695981039346656037ULL;
+  for(UInt_t i = 0; i < bytes.length(); i++) {
+    hash ^= (UChar_t)bytes[i];
+    hash *= 1099511628211ULL;
+  }
+
+  if(hash == 0) hash = 1;
+
+  return hash;
+}
+
+void AddChangedActivity(void)
+{
+//
+// Counts an activity found changed in a file being updated in place:
+// since its entries cannot be replaced in the trees, the file has to be
+// rewritten in copy mode (see SetCopyMode)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  changedActivities++;
+}
+
+ULong64_t ActivityDBFingerprint(const ActivityDB::activityLong &actlong)
+{
+//
+// Computes a fingerprint of the DB data of an activity only (result,
+// status, parameters - including the classification version - and
+// attachments): cheap to get, since no file on EOS is looked at
+//
+// Inputs:
+//          actlong : the activityLong
+//
+// Outputs:
+//
+// Return:
+//          the fingerprint (64 bit FNV-1a hash)
+//
+// Created:      19 Oct 2026
+//
+
+  std::ostringstream data;
+
+  ActivityDBData(actlong, data);
+
+  return FingerprintHash(data.str());
+}
+
+ULong64_t ActivityFingerprint(const ActivityDB::activityLong &actlong, const string &eospath)
+{
+//
+// Computes a fingerprint of an activity, i.e. a hash of the DB data
+// the analysis depends on (result, status, parameters - including the
+// classification version - and attachments) and of the name, size and
+// modification time of all files in the EOS directory of the activity
+// (used to detect activities changed since they were last analyzed)
+//
+// Inputs:
+//          actlong : the activityLong
+//          eospath : the EOS path of the activity (can be empty)
+//
+// Outputs:
+//
+// Return:
+//          the fingerprint (64 bit FNV-1a hash)
+//
+// Created:      19 Oct 2026
+//
+
+  std::ostringstream data;
+
+  ActivityDBData(actlong, data);
+
+  // Sort the file names: the directory order is not guaranteed
+  if(eospath.length() > 0) {
+    std::vector<string> files;
+    DIR *dir = opendir(eospath.c_str());
+    if(dir) {
+      struct dirent *entry;
+      while((entry = readdir(dir)))
+        if(entry->d_name[0] != '.')
+          files.push_back(entry->d_name);
+      closedir(dir);
+    }
+    std::sort(files.begin(), files.end());
+
+    struct stat fileStat;
+    for(UInt_t i = 0; i < files.size(); i++) {
+      string fullName = eospath + "/" + files[i];
+      if(stat(fullName.c_str(), &fileStat) == 0)
+        data << files[i] << ':' << (Long64_t)fileStat.st_size
+             << ':' << (Long64_t)fileStat.st_mtime << '|';
+    }
+  }
+
+  return FingerprintHash(data.str());
+}
+
+ULong64_t ActivityKey(const UInt_t hicid, const UInt_t actid)
+{
+//
+// Packs the HIC and Activity Ids into a single key
+// (used to index the activities already present in a file)
+//
+// Inputs:
+//          hicid : the HIC Id
+//          actid : the Activity Id
+//
+// Outputs:
+//
+// Return:
+//          the key
+//
+// Created:      19 Oct 2026
+//
+
+  return (((ULong64_t)hicid) << 32) | actid;
+}
+
+const char* ArenaJoinPath(const string &path, const string &file)
+{
+//
+// Builds the full name of a file in the string arena of the current
+// activity: the name stays valid until the next ArenaReset, and once
+// the arena is large enough no memory is allocated any more
+//
+// Inputs:
+//          path : the directory
+//          file : the file name
+//
+// Outputs:
+//
+// Return:
+//          the full name path/file
+//
+// Created:      19 Oct 2026
+//
+
+  size_t len = path.length() + file.length() + 2;
+
+  while (arenaBlock < arenaBlocks.size() &&
+         arenaUsed + len > arenaBlocks[arenaBlock].size) {
+    arenaBlock++;
+    arenaUsed = 0;
+  }
+
+  if (arenaBlock == arenaBlocks.size()) {
+    TArenaBlock block;
+    block.size = std::max(len, (size_t)ARENABLOCKSIZE);
+    block.buf = new char[block.size];
+    arenaBlocks.push_back(block);
+    arenaUsed = 0;
+  }
+
+  char *name = arenaBlocks[arenaBlock].buf + arenaUsed;
+  memcpy(name, path.data(), path.length());
+  name[path.length()] = '/';
+  memcpy(name + path.length() + 1, file.data(), file.length());
+  name[len - 1] = '\0';
+  arenaUsed += len;
+
+  return name;
+}
+
+void ArenaReset(void)
+{
+//
+// Releases all strings of the arena: called at the start of each
+// activity, the memory is kept for the next one
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  arenaBlock = 0;
+  arenaUsed = 0;
+}
 
 Int_t AskUserRedoScan(void)
 {
@@ -15,21 +309,27 @@ Int_t AskUserRedoScan(void)
 //          the chosen option
 //
 // Created:      17 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  Append in place and resume modes added
 //
 
+  if (alwaysCopy) return 2; // No question asked (changed activities replaced)
+  if (alwaysAppend || resumeRun) return 3; // No question asked (e.g. in watch mode)
+
 #ifdef USENCURSES
   mvprintw(3, 1, "Root file already exists. Do you want to: ");
   mvprintw(5, 1, "1 - Re-analyze all HICs/Activities");
   mvprintw(6, 1, "2 - Add missing HICs/Activities to present file");
+  mvprintw(7, 1, "3 - Append new HICs/Activities to present file (no copy)");
 #else
   printf("\n\n Root file already exists. Do you want to: ");
   printf("\n 1 - Re-analyze all HICs/Activities\n");
   printf(" 2 - Add missing HICs/Activities to present file\n");
+  printf(" 3 - Append new HICs/Activities to present file (no copy)\n");
 #endif
 
   Char_t line[80];
   Int_t choice = 0;
-  while(choice < 1 || choice > 2) {
+  while(choice < 1 || choice > 3) {
 #ifdef USENCURSES
     echo();
     getstr(line);
@@ -68,7 +368,205 @@ Bool_t CheckRootFileExists(TString name)
 
 }
 
-Int_t ChipPositionMAM2Test(const THicType hicType, const string position)
+Bool_t CheckShardNumber(const Int_t hicid)
+{
+//
+// Checks whether a given HIC belongs to the shard processed by this job
+// The HIC is assigned to a shard using its DB Id, so that the assignment
+// does not depend on the order or length of the component list returned
+// by the DB (new HICs can appear between two jobs of the same campaign)
+//
+// Inputs:
+//          hicid : the HIC Id
+//
+// Outputs:
+//
+// Return:
+//          true if the HIC has to be processed by this job
+//
+// Created:      19 Oct 2026
+//
+
+  if (shardTotal <= 1) return kTRUE;
+
+  return ((hicid % shardTotal) == shardIndex);
+}
+
+static void CheckpointSave(const Int_t hicid)
+{
+//
+// Saves the checkpointed trees and then the HIC they are complete up to
+// (a crash in between at worst makes the next run redo a few HICs)
+//
+// Inputs:
+//          hicid : the Id of the last HIC saved (-1 if none)
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  for (UInt_t i = 0; i < ckptTrees.size(); i++)
+    ckptTrees[i]->AutoSave("SaveSelf");
+
+  TParameter<Int_t> cursor(CHECKPOINTNAME, hicid);
+  ckptFile->cd();
+  cursor.Write("", TObject::kOverwrite);
+  ckptFile->SaveSelf(kTRUE);
+
+  ckptTime = time(0);
+}
+
+UInt_t CheckpointBegin(TFile *rootfile, TTree **trees, const Int_t ntrees, const std::vector<ComponentDB::componentShort> &componentList, const TString &oldfilename)
+{
+//
+// Starts the checkpoints of an all-HICs file: from now on the trees are
+// only saved together (see CheckpointCommit), so that the file is always
+// consistent. In resume mode the HICs up to the last one saved by the
+// previous run are skipped (their activities are already in the file).
+// The old file the activities are copied from is recorded as well, so
+// that a resumed run goes on copying from it (see CheckpointOldFile)
+//
+// Inputs:
+//          rootfile      : the (already opened) file
+//          trees         : the trees of the file
+//          ntrees        : the number of trees
+//          componentList : the list of all HICs to be analyzed
+//          oldfilename   : the old file the activities are copied from
+//                          (empty if none)
+//
+// Outputs:
+//
+// Return:
+//          the index in componentList of the first HIC to analyze
+//
+// Created:      19 Oct 2026
+//
+
+  ckptFile = rootfile;
+  ckptTrees.assign(trees, trees + ntrees);
+  for (UInt_t i = 0; i < ckptTrees.size(); i++)
+    ckptTrees[i]->SetAutoSave(0); // Only saved at the checkpoints
+
+  Int_t lastHic = -1;
+  UInt_t first = 0;
+  if (resumeRun) {
+    TParameter<Int_t> *cursor = (TParameter<Int_t>*)rootfile->Get(CHECKPOINTNAME);
+    if (cursor) lastHic = cursor->GetVal();
+    for (UInt_t i = 0; i < componentList.size(); i++)
+      if (componentList.at(i).ID == lastHic) {
+        first = i + 1;
+        break;
+      }
+    if (first > 0)
+      cout << "Resuming after HIC " << componentList.at(first-1).ComponentID
+           << " (" << first << " HIC already in file)" << endl;
+  }
+
+  rootfile->cd();
+  if (oldfilename.Length() > 0) {
+    TNamed oldFile(CHECKPOINTOLD, oldfilename.Data());
+    oldFile.Write("", TObject::kOverwrite);
+  } else
+    rootfile->Delete(CHECKPOINTOLD ";*");
+
+  // The new trees are saved at once, so that the file can be resumed
+  // even if the run breaks before the first checkpoint
+  CheckpointSave(first > 0 ? lastHic : -1);
+
+  return first;
+}
+
+void CheckpointCommit(const Int_t hicid)
+{
+//
+// Marks a HIC as done: if CHECKPOINTMIN minutes passed since the last
+// checkpoint, the trees are saved and the HIC is recorded as the point
+// to resume from
+//
+// Inputs:
+//          hicid : the Id of the HIC just analyzed
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!ckptFile) return;
+
+  if (difftime(time(0), ckptTime) >= CHECKPOINTMIN*60)
+    CheckpointSave(hicid);
+}
+
+void CheckpointEnd(void)
+{
+//
+// Ends the checkpoints of a file when all HICs were analyzed: the point
+// to resume from is removed, the next run starts from the first HIC
+// (the trees are then written as usual by the caller)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!ckptFile) return;
+
+  ckptFile->Delete(CHECKPOINTNAME ";*");
+  ckptFile->Delete(CHECKPOINTOLD ";*");
+
+  ckptFile = 0;
+  ckptTrees.clear();
+}
+
+Bool_t CheckpointOldFile(TString rootfilename, TString &oldfilename)
+{
+//
+// Tells whether the run being resumed (in resume mode only) was copying
+// the activities from an old file, as recorded by CheckpointBegin: if
+// so the resumed run has to copy them from the same file
+//
+// Inputs:
+//          rootfilename : the all-HICs file being resumed
+//
+// Outputs:
+//          oldfilename  : the old file (empty if none)
+//
+// Return:
+//          kTRUE if the activities are copied from the old file
+//
+// Created:      19 Oct 2026
+//
+
+  oldfilename = "";
+  if (!resumeRun) return kFALSE;
+
+  TFile *rootFile = OpenRootFile(rootfilename);
+  if (!rootFile) return kFALSE;
+  TNamed *oldFile = (TNamed*)rootFile->Get(CHECKPOINTOLD);
+  if (oldFile) oldfilename = oldFile->GetTitle();
+  CloseRootFile(rootFile);
+
+  if (oldfilename.Length() == 0) return kFALSE;
+
+  if (!CheckRootFileExists(oldfilename)) {
+    printMessage("\nCheckpointOldFile","Warning: missing old file, activities read again",oldfilename.Data(), LOG_WARNING);
+    oldfilename = "";
+    return kFALSE;
+  }
+
+  return kTRUE;
+}
+
+Int_t ChipPositionMAM2Test(const THicType hicType, const string &position)
 {
 //
 // Converts the chip position from MAM numbering to Test numbering
@@ -92,42 +590,27 @@ Int_t ChipPositionMAM2Test(const THicType hicType, const string position)
 //          the chip position in Test convention (-1 in case of error)
 //
 // Created:      05 Jul 2019  Mario Sitta
+// Updated:      19 Oct 2026  Use the chip numbering tables
 //
 
   Int_t posTest = -1;
 
-  if(position.length() != 3) {
-    printMessage("\nChipPositionMAM2Test", "Wrong chip position (MAM) ", position.c_str());
+  if(hicType != HIC_IB && hicType != HIC_OB) {
+    printMessage("\nChipPositionMAM2Test", "Wrong HIC type ", to_string(hicType).c_str(), LOG_ERROR);
     return posTest;
   }
 
-  switch(hicType) {
-    case HIC_IB:
-      if(position.substr(0,2) != "HA")
-	printMessage("\nChipPositionMAM2Test", "Wrong IB chip position (MAM) ", position.c_str());
-      else
-	posTest = atoi(position.substr(2,1).c_str()); // Should test if 9...
-      break;
-    case HIC_OB:
-      if(position.substr(0,2) != "HA" && position.substr(0,2) != "HB")
-	printMessage("\nChipPositionMAM2Test", "Wrong OB chip position (MAM) ", position.c_str());
-      else {
-	Int_t pos = atoi(position.substr(2,1).c_str());
-	if(pos == 0 && pos > 7)
-	  printMessage("\nChipPositionMAM2Test", "Wrong OB chip position (MAM) ", position.c_str());
-	else {
-	  if(position.substr(0,2) == "HA")
-	    posTest = 7 - pos;
-	  else
-	    posTest = 7 + pos;
-	}
-      }
-      break;
-    default:
-      printMessage("\nChipPositionMAM2Test", "Wrong HIC type ", to_string(hicType).c_str());
-      break;
+  if(position.length() != 3 || position[0] != 'H' ||
+     (position[1] != 'A' && position[1] != 'B') ||
+     position[2] < '0' || position[2] > '9') {
+    printMessage("\nChipPositionMAM2Test", "Wrong chip position (MAM) ", position.c_str(), LOG_ERROR);
+    return posTest;
   }
 
+  posTest = GetHicChipMap(hicType)->posMAM[position[1] - 'A'][position[2] - '0'];
+  if(posTest < 0)
+    printMessage("\nChipPositionMAM2Test", "Wrong chip position (MAM) ", position.c_str(), LOG_ERROR);
+
   return posTest;
 }
 
@@ -155,40 +638,53 @@ string ChipPositionTest2MAM(const THicType hicType, const Int_t position)
 //          the chip position in MAM convention (empty string in case of error)
 //
 // Created:      05 Jul 2019  Mario Sitta
+// Updated:      19 Oct 2026  Use the chip numbering tables
 //
 
   string posMAM = "";
 
-  if(position < 0) {
-    printMessage("\nChipPositionMAM2Test", "Wrong chip position (Test) ", to_string(position).c_str());
+  if(hicType != HIC_IB && hicType != HIC_OB) {
+    printMessage("\nChipPositionTest2MAM", "Wrong HIC type ", to_string(hicType).c_str(), LOG_ERROR);
     return posMAM;
   }
 
-  switch(hicType) {
-    case HIC_IB:
-      if(position > 8)
-	printMessage("\nChipPositionMAM2Test", "Wrong IB chip position (Test) ", to_string(position).c_str());
-      else
-	posMAM = "HA" + position;
-      break;
-    case HIC_OB:
-      if(position == 7 || position > 14)
-	printMessage("\nChipPositionMAM2Test", "Wrong IB chip position (Test) ", to_string(position).c_str());
-      else {
-	if(position < 7)
-	  posMAM = "HA" + (7 - position);
-	else
-	  posMAM = "HB" + (position - 7);
-      }
-      break;
-    default:
-      printMessage("\nChipPositionMAM2Test", "Wrong HIC type ", to_string(hicType).c_str());
-      break;
+  if(CHIPNUM(GetHicChipMap(hicType), position) < 0) {
+    printMessage("\nChipPositionTest2MAM", "Wrong chip position (Test) ", to_string(position).c_str(), LOG_ERROR);
+    return posMAM;
   }
 
+  if(hicType == HIC_IB)
+    posMAM = string("HA") + char('0' + position);
+  else if(position < 7)
+    posMAM = string("HA") + char('0' + 7 - position);
+  else
+    posMAM = string("HB") + char('0' + position - 7);
+
   return posMAM;
 }
 
+void CloseHicRootFile(void)
+{
+//
+// Closes the file of all analyses of a single HIC (see OpenHicRootFile)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (!hicRootFile) return;
+
+  hicRootFile->Close();
+  delete hicRootFile;
+  hicRootFile = 0;
+  hicRootDir = 0;
+}
+
 void CloseRootFile(TFile *rootfile)
 {
 //
@@ -203,13 +699,23 @@ void CloseRootFile(TFile *rootfile)
 //
 // Created:      18 Sep 2018  Mario Sitta
 // Updated:      08 Oct 2018  Mario Sitta
+// Updated:      19 Oct 2026  Directories of the HIC file
 //
 
+  // The directory of an analysis in the HIC file: its trees are
+  // already written, they are only dropped from memory
+  if (rootfile == hicRootFile) {
+    if (hicRootDir) hicRootDir->GetList()->Delete();
+    hicRootDir = 0;
+    hicRootFile->cd();
+    return;
+  }
+
   rootfile->Close();
 
 }
 
-Char_t ConvertTestResult(const string result)
+Char_t ConvertTestResult(const string &result)
 {
 //
 // Converts the test result into a number to be saved in the trees
@@ -249,28 +755,121 @@ Char_t ConvertTestResult(const string result)
   return 0;
 }
 
-string FindEOSPath(ActivityDB::activityLong actlong, const THicType hicType)
+Bool_t CopyOldActivity(const ActivityDB::activityLong &actlong, const THicType hicType, const Bool_t inoldfile, ULong64_t &dbfinger, ULong64_t &finger, string &eospath)
 {
 //
-// Finds the correct EOS path for the given activity
+// Decides whether an activity already in the old ROOT file is copied
+// from it or reprocessed, looking for its EOS directory only if needed:
+// the cheap fingerprint of the DB data is checked first, the one of the
+// EOS files only if it changed or is unknown (files written before it
+// was introduced). An activity whose EOS directory cannot be found is
+// copied even if it changed: better the old entries than none
 //
 // Inputs:
-//          actlong : the activityLong for which the path has to be found
-//          hicType : the HIC type (IB or OB)
+//          actlong   : the activityLong
+//          hicType   : the HIC type (IB or OB)
+//          inoldfile : true if the activity is in the old ROOT file
+//          dbfinger  : the DB data fingerprint stored in the old file
+//          finger    : the fingerprint stored in the old file
 //
 // Outputs:
+//          dbfinger  : the DB data fingerprint to store in the new file
+//          finger    : the fingerprint to store in the new file
+//          eospath   : the EOS path of the activity (empty if not found
+//                      or not needed)
 //
 // Return:
-//          the EOS path as a string
+//          true if the old entries are to be copied
 //
-// Created:      09 Oct 2018  Mario Sitta
-// Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Created:      19 Oct 2026
 //
 
-  FixActName(actlong, hicType);
+  eospath = "";
 
-  string eosPathSingle = GetEosPath(actlong, hicType, false);
-  string eosPathDouble = GetEosPath(actlong, hicType, true);
+  ULong64_t newDbFinger = ActivityDBFingerprint(actlong);
+  if(inoldfile && dbfinger != 0 && dbfinger == newDbFinger)
+    return kTRUE;
+
+  Double_t perfStart = PerfNow();
+  eospath = FindEOSPath(actlong, hicType);
+  PerfAddSample(PERF_EOSPATH, PerfNow() - perfStart);
+
+  ULong64_t newFinger = ActivityFingerprint(actlong, eospath);
+
+  if(inoldfile) {
+    // A zero fingerprint is unknown: trust the stored data as before
+    if(dbfinger == 0 && (finger == 0 || finger == newFinger)) {
+      dbfinger = newDbFinger;
+      finger = newFinger;
+      return kTRUE;
+    }
+
+    // The stored fingerprints are kept, so it is checked again next time
+    if(eospath.length() == 0) {
+      printMessage("\nCopyOldActivity", "Activity changed but EOS path not found, copying old data", actlong.Name.c_str(), LOG_WARNING);
+      return kTRUE;
+    }
+
+    printMessage("\nCopyOldActivity", "Activity changed since last run, reprocessing");
+  }
+
+  dbfinger = newDbFinger;
+  finger = newFinger;
+
+  return kFALSE;
+}
+
+void DecodeAlpideAddress(const Int_t region, const Int_t doublecol, const Int_t address, Int_t &col, Int_t &row)
+{
+//
+// Decodes the position of an ALPIDE pixel given as region, double
+// column and address (as in the NoisyPixels files) into column and row
+//
+// Inputs:
+//          region    : the region (0-31)
+//          doublecol : the double column in the region (0-15)
+//          address   : the pixel address in the double column (0-1023)
+//
+// Outputs:
+//          col : the pixel column (0-1023)
+//          row : the pixel row (0-511)
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  // Pixels are read in a zig-zag along the double column:
+  // addresses 1 and 2 (modulo 4) are on its right column
+  Int_t leftRight = ((address%4 == 1) || (address%4 == 2)) ? 1 : 0;
+
+  col = region*32 + doublecol*2 + leftRight;
+  row = address/2;
+}
+
+string FindEOSPath(ActivityDB::activityLong actlong, const THicType hicType)
+{
+//
+// Finds the correct EOS path for the given activity
+//
+// Inputs:
+//          actlong : the activityLong for which the path has to be found
+//          hicType : the HIC type (IB or OB)
+//
+// Outputs:
+//
+// Return:
+//          the EOS path as a string
+//
+// Created:      09 Oct 2018  Mario Sitta
+// Updated:      26 Feb 2019  Mario Sitta  HIC type added
+// Updated:      19 Oct 2026  Local EOS copy supported
+//
+
+  FixActName(actlong, hicType);
+
+  string eosPathSingle = DbLibMapEosPath(GetEosPath(actlong, hicType, false));
+  string eosPathDouble = DbLibMapEosPath(GetEosPath(actlong, hicType, true));
 
   string eosPath = "";
   struct stat eosStat;
@@ -344,148 +943,1143 @@ void FixActName(ActivityDB::activityLong &actlong, const THicType hicType)
   }
 }
 
-TFile* OpenRootFile(TString name, Bool_t recreate)
+Int_t GetChangedActivities(void)
 {
 //
-// Opens the ROOT file
+// Returns the activities found changed since ResetChangedActivities
+// in the files updated in place (see AddChangedActivity)
 //
 // Inputs:
-//          name  : the file name
-//          recreate  : if true, open file in RECREATE mode
 //
 // Outputs:
 //
 // Return:
-//          a pointer to the created ROOT file
+//          the number of changed activities
 //
-// Created:      18 Sep 2018  Mario Sitta
-// Updated:      08 Oct 2018  Mario Sitta
-// Updated:      27 Nov 2018  Mario Sitta/
-// Updated:      17 Jan 2019  Mario Sitta
+// Created:      19 Oct 2026
 //
 
-  TFile *rootfile = 0;
+  return changedActivities;
+}
 
-  if (recreate)
-    rootfile = new TFile(name.Data(),"RECREATE");
-  else
-    rootfile = new TFile(name.Data());
+const TActParameters* GetActParameters(const ActivityDB::activityLong &actlong)
+{
+//
+// Returns the parameters of an activity used by the analyses, indexed
+// by ACTPAR_*: the names are resolved once per activity (the Result
+// parsers of all conditions of the activity then share the table) and
+// the index of each name once per run
+//
+// Inputs:
+//          actlong : the activityLong
+//
+// Outputs:
+//
+// Return:
+//          the parameters of the activity (see TActParameters)
+//
+// Created:      19 Oct 2026
+//
 
-  return rootfile;
+  static std::map<string, Int_t> actParIndex;
+
+  if (actParIndex.size() == 0)
+    for (Int_t i = 0; i < ACTPARNUM; i++)
+      actParIndex[actParNames[i]] = i;
+
+  if (actParameters.actID == actlong.ID) return &actParameters;
+
+  actParameters.actID = actlong.ID;
+  for (Int_t i = 0; i < ACTPARNUM; i++) {
+    actParameters.found[i] = kFALSE;
+    actParameters.value[i] = 0;
+  }
+
+  // If a parameter is there more than once the last one wins
+  std::vector<ActivityDB::actParameter>::const_iterator par;
+  for (par = actlong.Parameters.begin(); par != actlong.Parameters.end(); par++) {
+    std::map<string, Int_t>::const_iterator it = actParIndex.find(par->Type.Parameter.Name);
+    if (it == actParIndex.end()) continue;
+    actParameters.found[it->second] = kTRUE;
+    actParameters.value[it->second] = par->Value;
+  }
+
+  return &actParameters;
 }
 
-Bool_t RenameExistingRootFile(TString oldname, TString mod, TString &newname)
+const THicChipMap* GetHicChipMap(const THicType hicType)
 {
 //
-// Rename the existing ROOT file
-// WARNING: for sake of simplicity, we assume the file name is always
-// in the form whateverstring.root (i.e. it terminates with ".root")
+// Returns the chip numbering of a HIC type, so that the loops on the
+// chips and the lines of the result files need no test on the HIC type
 //
 // Inputs:
-//          oldname : the old file name
-//          mod     : the string to be appended to the old name
+//          hicType : the HIC type (IB or OB)
 //
 // Outputs:
-//          newname : the new file name
 //
 // Return:
-//          kTRUE if rename successful, otherwise kFALSE
+//          the chip numbering of the HIC type (see THicChipMap)
 //
-// Created:      17 Jan 2019  Mario Sitta
+// Created:      19 Oct 2026
 //
 
-  TString cmd;
+  return (hicType == HIC_OB) ? &hicChipMapOB : &hicChipMapIB;
+}
 
-  newname = "";
+const TWaferMap* GetHicWaferMap(const Int_t hicid, const THicType hicType, const std::vector<TChild> &children)
+{
+//
+// Returns the wafer number and chip position in the wafer of all chips
+// of a HIC: the map is built from the HIC children the first time it is
+// asked for, then kept for all later activities and analyses of the HIC
+//
+// Inputs:
+//          hicid    : the HIC Id
+//          hicType  : the HIC type (IB or OB)
+//          children : vector of all HIC children
+//
+// Outputs:
+//
+// Return:
+//          the wafer map of the HIC (see TWaferMap)
+//
+// Created:      19 Oct 2026
+//
 
-  Ssiz_t lastDot = oldname.Last('.');
-  if(lastDot == kNPOS) return kFALSE; // Should never happen given the file name
+  std::map<Int_t, TWaferMap>::iterator it = hicWaferMaps.find(hicid);
+  if (it != hicWaferMaps.end()) return &(it->second);
 
-//  newname = oldname(0,lastDot-1) + mod + ".root";
-  newname = oldname(0,lastDot) + mod + ".root";
+  TWaferMap &waferMap = hicWaferMaps[hicid];
+  memset(waferMap.waferNum, -1, sizeof(waferMap.waferNum));
+  memset(waferMap.waferPos, -1, sizeof(waferMap.waferPos));
 
-  cmd.Form("mv -f %s %s",oldname.Data(),newname.Data());
-  if(gSystem->Exec(cmd.Data()) != 0) {
-    newname = "";
-    return kFALSE;
-  } else
-    return kTRUE;
+  const THicChipMap *chipMap = GetHicChipMap(hicType);
+  Int_t faund, wn, wp;
+
+  for (UInt_t i = 0; i < children.size(); i++) {
+    Int_t chip = CHIPNUM(chipMap, ChipPositionMAM2Test(hicType, children[i].Position));
+    if (chip < 0) continue;
+    if (sscanf(children[i].Name.c_str(), "T%dW%02dR%02d", &faund, &wn, &wp) == 3) {
+      waferMap.waferNum[chip] = wn;
+      waferMap.waferPos[chip] = wp;
+    }
+  }
+
+  return &waferMap;
 }
 
-TFile* SetupRootFile(TString filename, Bool_t &redo)
+Int_t GetNumberOfShards(void)
 {
 //
-// Checks whether the Root file already exists: if not, create a new one,
-// if yes, try to open it
+// Returns the total number of shards the HIC list is split into
 //
 // Inputs:
-//          filename : the file name
 //
 // Outputs:
-//          redo : true if user chose to redo the analysis
 //
 // Return:
-//          a pointer to the created ROOT file
+//          the number of shards (1 if no sharding was requested)
 //
-// Created:      28 Nov 2018  Mario Sitta
-// Updated:      09 Jan 2019  Mario Sitta
-// Updated:      17 Jan 2019  Mario Sitta
+// Created:      19 Oct 2026
 //
 
-  TFile *newfile = 0;
+  return shardTotal;
+}
 
-  redo = kTRUE;
+Bool_t GetPackedPixelTrees(void)
+{
+//
+// Returns whether new pixel trees are created in the packed layout
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the packed layout is used, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
 
-  if (CheckRootFileExists(filename))
-    if(AskUserRedoScan() == 2) redo = kFALSE;
+  return packedPixelTrees;
+}
 
-  if(redo)
-    newfile = OpenRootFile(filename, kTRUE);
-  else
-    newfile = OpenRootFile(filename, kFALSE);
+Bool_t GetResumeMode(void)
+{
+//
+// Returns whether the all-HICs runs resume from their last checkpoint
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if in resume mode, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
 
-  return newfile;
+  return resumeRun;
 }
 
-void WaferNumAndPos(const THicType hicType, std::vector<TChild> children, const Int_t chipNum, Char_t &waferNum, Char_t &waferPos)
+Bool_t IsPackedPixelTree(TTree *tree)
 {
 //
-// Returns the wafer number and chip position in the wafer for a given chip
+// Checks whether a pixel tree has the packed layout, i.e. one entry
+// per chip with the pixel variables stored as arrays of pixNum values
 //
 // Inputs:
-//          hicType : the HIC type (IB or OB)
-//          children : vector of all HIC children
-//          chipNum : the chip number in the HIC (Test convention)
+//          tree : the pixel tree
 //
 // Outputs:
-//          waferNum : the wafer number
-//          waferPos : the chip position in the wafer
 //
 // Return:
+//          kTRUE if the tree is packed, otherwise kFALSE
 //
-// Created:      05 Jul 2019  Mario Sitta
-// Updated:      18 Sep 2019  Mario Sitta  Bug fix: reading int instead of char
+// Created:      19 Oct 2026
 //
 
-  Int_t faund;
-  Int_t wn, wp;
+  return (tree && tree->GetBranch("pixNum") != 0);
+}
+
+void MatchPackedPixelTrees(TTree *tree)
+{
+//
+// Makes the layout of new pixel trees follow the one of a tree read
+// from an existing file: old and new trees share the same variables,
+// so activities can be copied from one to the other only if they have
+// the same layout
+//
+// Inputs:
+//          tree : the pixel tree read from file
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
 
-  waferNum = -1;
-  waferPos = -1;
+  if (!tree) return;
 
-  if (children.size() > 0) {
-    std::vector<TChild>::iterator ich;
-    for(ich = children.begin(); ich != children.end(); ich++) {
-      TChild child = *ich;
+  Bool_t packed = IsPackedPixelTree(tree);
+  if (packed != packedPixelTrees) {
+    printMessage("MatchPackedPixelTrees","Warning: using the pixel tree layout of the existing file",
+                 packed ? "(packed)" : "(one entry per pixel)", LOG_WARNING);
+    packedPixelTrees = packed;
+  }
+}
 
-      if (ChipPositionMAM2Test(hicType, child.Position) == chipNum) {
-        sscanf(child.Name.c_str(), "T%dW%02dR%02d", &faund, &wn, &wp);
-        waferNum = wn;
-        waferPos = wp;
-        break;
+void MergeAllShardFiles(const char *analysis, const int nshards, const THicType hicType,
+                        const TActTreeNames *treenames, const Int_t ntypes,
+                        const char **extranames, const Int_t nextra)
+{
+//
+// Steering routine to merge the files produced by the shard jobs of an
+// analysis into its usual all-HICs file (see MergeShardRootFiles)
+//
+// Inputs:
+//          analysis   : the analysis, as in the file name (e.g. "PowerTest")
+//          nshards    : the number of shards
+//          hicType    : the HIC type (IB or OB)
+//          treenames  : the names of the trees for each activity type
+//          ntypes     : the number of activity types
+//          extranames : the names of other trees to be merged
+//          nextra     : the number of other trees
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  TString rootFileName = Form("%sHIC_%s_AllHICs.root", (hicType == HIC_IB) ? "IB" : "OB", analysis);
+
+  if (MergeShardRootFiles(rootFileName, nshards, treenames, ntypes, extranames, nextra)) {
+#ifdef USENCURSES
+    mvprintw(LINES-4, 0, "\n ROOT file %s merged from %d shards\n", rootFileName.Data(), nshards);
+#else
+    printf("\n\n ROOT file %s merged from %d shards\n", rootFileName.Data(), nshards);
+#endif
+  } else
+    printMessage("\nMergeAllShardFiles","Error: error merging the shard files", 0, LOG_ERROR);
+
+  f12ToExit();
+}
+
+static void CloseRootFiles(std::vector<TFile*> &rootfiles)
+{
+//
+// Closes and deletes a list of ROOT files
+//
+// Inputs:
+//          rootfiles : the files
+//
+// Outputs:
+//          rootfiles : the list, emptied
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  for (UInt_t i = 0; i < rootfiles.size(); i++) {
+    CloseRootFile(rootfiles[i]);
+    delete rootfiles[i];
+  }
+  rootfiles.clear();
+}
+
+static void MergeShardFailed(TString rootfilename, TString oldrootfilename, TFile *mergedfile, std::vector<TFile*> &shardfiles)
+{
+//
+// Cleans up after a failed merge: all files are closed, the partial
+// merged file is removed and the existing file (if any) is put back
+//
+// Inputs:
+//          rootfilename    : the name of the merged file
+//          oldrootfilename : the name the existing file was renamed to
+//                            ("" if none)
+//          mergedfile      : the merged file (0 if not opened)
+//          shardfiles      : the shard files
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  if (mergedfile) {
+    CloseRootFile(mergedfile);
+    delete mergedfile;
+  }
+  CloseRootFiles(shardfiles);
+
+  remove(rootfilename.Data());
+  if (oldrootfilename.Length() > 0)
+    rename(oldrootfilename.Data(), rootfilename.Data());
+}
+
+Bool_t MergeShardRootFiles(TString rootfilename, const Int_t nshards,
+                           const TActTreeNames *treenames, const Int_t ntypes,
+                           const char **extranames, const Int_t nextra)
+{
+//
+// Merges the ROOT files produced by the shard jobs into a single file
+// All trees are concatenated in shard order, while the offsets stored
+// in the actFastListTree are shifted by the number of entries that the
+// preceding shards have in the corresponding tree (a plain hadd would
+// keep the offsets local to each shard file). An existing file with the
+// same name is renamed with an "_old" suffix (and put back if the merge
+// fails)
+//
+// Inputs:
+//          rootfilename : the name of the merged file (shard files names
+//                         are derived from it with ShardRootFileName)
+//          nshards      : the number of shards
+//          treenames    : the names of the trees for each activity type
+//          ntypes       : the number of activity types
+//          extranames   : the names of other trees to be merged, which
+//                         have no offsets in the actFastListTree
+//          nextra       : the number of other trees
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the files were successfully merged, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  // Open all shard files: a missing shard would silently produce
+  // an incomplete file, so we stop here if any of them is missing
+  std::vector<TFile*> shardFiles;
+  for (Int_t ishard = 0; ishard < nshards; ishard++) {
+    TString shardName = ShardRootFileName(rootfilename, ishard, nshards);
+    if (!CheckRootFileExists(shardName)) {
+      printMessage("\nMergeShardRootFiles","Error: missing shard file",shardName.Data(), LOG_ERROR);
+      CloseRootFiles(shardFiles);
+      return kFALSE;
+    }
+    TFile *shardFile = OpenRootFile(shardName);
+    if (!shardFile || shardFile->IsZombie()) {
+      printMessage("\nMergeShardRootFiles","Error: cannot open shard file",shardName.Data(), LOG_ERROR);
+      delete shardFile;
+      CloseRootFiles(shardFiles);
+      return kFALSE;
+    }
+    shardFiles.push_back(shardFile);
+  }
+
+  // Do not overwrite the file of a previous (e.g. full) run
+  TString oldRootFileName = "";
+  if (CheckRootFileExists(rootfilename)) {
+    if (!RenameExistingRootFile(rootfilename, "_old", oldRootFileName)) {
+      printMessage("\nMergeShardRootFiles","Error: error renaming existing ROOT file",rootfilename.Data(), LOG_ERROR);
+      CloseRootFiles(shardFiles);
+      return kFALSE;
+    }
+    printMessage("\nMergeShardRootFiles","Existing file renamed to",oldRootFileName.Data());
+  }
+
+  TFile *mergedFile = OpenRootFile(rootfilename, kTRUE);
+  if (!mergedFile || mergedFile->IsZombie()) {
+    printMessage("\nMergeShardRootFiles","Error: cannot open merged file",rootfilename.Data(), LOG_ERROR);
+    delete mergedFile;
+    MergeShardFailed(rootfilename, oldRootFileName, 0, shardFiles);
+    return kFALSE;
+  }
+
+  // Merge the data trees, keeping track of where each shard begins
+  // (offsets[ishard][itree] is the first entry of the shard in the tree)
+  std::vector<const char*> treeList;
+  for (Int_t itype = 0; itype < ntypes; itype++) {
+    treeList.push_back(treenames[itype].testTree);
+    if (treenames[itype].tuneTree)
+      treeList.push_back(treenames[itype].tuneTree);
+    treeList.push_back(treenames[itype].resTree);
+  }
+  for (Int_t iextra = 0; iextra < nextra; iextra++)
+    treeList.push_back(extranames[iextra]);
+
+  const Int_t ntrees = treeList.size();
+  std::vector< std::vector<Long64_t> > offsets(nshards, std::vector<Long64_t>(ntrees, 0));
+
+  for (Int_t itree = 0; itree < ntrees; itree++) {
+    TList shardTrees;
+    Long64_t nEntries = 0;
+    for (Int_t ishard = 0; ishard < nshards; ishard++) {
+      offsets[ishard][itree] = nEntries;
+      TTree *tree = (TTree*)shardFiles[ishard]->Get(treeList[itree]);
+      if (!tree) continue; // Tree can be missing if never written
+      if (shardTrees.GetSize() > 0 &&
+          IsPackedPixelTree(tree) != IsPackedPixelTree((TTree*)shardTrees.First())) {
+        printMessage("\nMergeShardRootFiles","Error: shards have different pixel tree layouts",treeList[itree], LOG_ERROR);
+        MergeShardFailed(rootfilename, oldRootFileName, mergedFile, shardFiles);
+        return kFALSE;
       }
+      nEntries += tree->GetEntries();
+      shardTrees.Add(tree);
     }
+
+    if (shardTrees.GetSize() == 0) continue;
+
+    mergedFile->cd();
+    TTree *mergedTree = TTree::MergeTrees(&shardTrees);
+    if (!mergedTree) {
+      printMessage("\nMergeShardRootFiles","Error: cannot merge tree",treeList[itree], LOG_ERROR);
+      MergeShardFailed(rootfilename, oldRootFileName, mergedFile, shardFiles);
+      return kFALSE;
+    }
+    mergedTree->Write();
   }
 
-}
+  // Now rebuild the fast list tree with the shifted offsets
+  UInt_t   listHicID, listActID;
+  UShort_t listActMask;
+  Long64_t listOffs, listTunOff, listResOff;
+  ULong64_t listFinger, listDbFinger;
+
+  Bool_t hasTune = kFALSE;
+  for (Int_t itype = 0; itype < ntypes; itype++)
+    if (treenames[itype].tuneTree) hasTune = kTRUE;
+
+  mergedFile->cd();
+  TTree *mergedList = new TTree("actFastListTree", "HicActFastListTree");
+  mergedList->Branch("hicID", &listHicID, "hicID/i");
+  mergedList->Branch("actID", &listActID, "actID/i");
+  mergedList->Branch("actMask", &listActMask, "actMask/s");
+  mergedList->Branch("actOffs", &listOffs, "testOffset/L");
+  if (hasTune)
+    mergedList->Branch("actTunOff", &listTunOff, "testTunOffset/L");
+  mergedList->Branch("actResOff", &listResOff, "testResOffset/L");
+  mergedList->Branch("actFinger", &listFinger, "actFingerprint/l");
+  mergedList->Branch("actDbFinger", &listDbFinger, "actDbFingerprint/l");
+
+  for (Int_t ishard = 0; ishard < nshards; ishard++) {
+    TTree *shardList = (TTree*)shardFiles[ishard]->Get("actFastListTree");
+    if (!shardList) continue;
+
+    shardList->SetBranchAddress("hicID", &listHicID);
+    shardList->SetBranchAddress("actID", &listActID);
+    shardList->SetBranchAddress("actMask", &listActMask);
+    shardList->SetBranchAddress("actOffs", &listOffs);
+    if (hasTune)
+      shardList->SetBranchAddress("actTunOff", &listTunOff);
+    shardList->SetBranchAddress("actResOff", &listResOff);
+    listFinger = 0; // Unknown if the shard has no fingerprints
+    if (shardList->GetBranch("actFinger"))
+      shardList->SetBranchAddress("actFinger", &listFinger);
+    listDbFinger = 0;
+    if (shardList->GetBranch("actDbFinger"))
+      shardList->SetBranchAddress("actDbFinger", &listDbFinger);
 
+    Long64_t nEntries = shardList->GetEntries();
+    for (Long64_t j = 0; j < nEntries; j++) {
+      shardList->GetEntry(j);
+
+      // Find the trees of this activity type: their position
+      // in treeList follows the same order used to fill it
+      Int_t itree = 0;
+      for (Int_t itype = 0; itype < ntypes; itype++) {
+        if (treenames[itype].actMask == listActMask) {
+          listOffs += offsets[ishard][itree++];
+          if (treenames[itype].tuneTree)
+            listTunOff += offsets[ishard][itree++];
+          listResOff += offsets[ishard][itree];
+          break;
+        }
+        itree += (treenames[itype].tuneTree ? 3 : 2);
+      }
+
+      mergedList->Fill();
+    }
+  }
+
+  mergedList->Write();
+  CloseRootFile(mergedFile);
+  delete mergedFile;
+
+  CloseRootFiles(shardFiles);
+
+  return kTRUE;
+}
+
+Bool_t OpenHicRootFile(TString name)
+{
+//
+// Opens a single file for all analyses of a single HIC: until it is
+// closed (CloseHicRootFile) the files the analyses create are instead
+// directories in it, each named after the file (see OpenRootFile)
+//
+// Inputs:
+//          name : the file name
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the file was opened, otherwise kFALSE
+//
+// Created:      19 Oct 2026
+//
+
+  CloseHicRootFile();
+
+  hicRootFile = OpenRootFile(name, kTRUE);
+  if (!hicRootFile || hicRootFile->IsZombie()) {
+    delete hicRootFile;
+    hicRootFile = 0;
+    return kFALSE;
+  }
+
+  return kTRUE;
+}
+
+TFile* OpenRootFile(TString name, Bool_t recreate, Bool_t update)
+{
+//
+// Opens the ROOT file
+//
+// Inputs:
+//          name  : the file name
+//          recreate  : if true, open file in RECREATE mode
+//          update    : if true, open file in UPDATE mode
+//
+// Outputs:
+//
+// Return:
+//          a pointer to the created ROOT file
+//
+// Created:      18 Sep 2018  Mario Sitta
+// Updated:      08 Oct 2018  Mario Sitta
+// Updated:      27 Nov 2018  Mario Sitta/
+// Updated:      17 Jan 2019  Mario Sitta
+// Updated:      19 Oct 2026  UPDATE mode, directories of the HIC file
+//
+
+  // While the file of a HIC is open, each new file is a directory in it
+  // named after the file (see OpenHicRootFile)
+  if (hicRootFile && recreate) {
+    TString dirName = name;
+    dirName.ReplaceAll(".root", "");
+    TString uniqueName = dirName;
+    for (Int_t n = 2; hicRootFile->GetDirectory(uniqueName.Data()); n++)
+      uniqueName = Form("%s_%d", dirName.Data(), n);
+    hicRootDir = hicRootFile->mkdir(uniqueName.Data());
+    if (!hicRootDir) return 0;
+    hicRootDir->cd();
+    return hicRootFile;
+  }
+
+  TFile *rootfile = 0;
+
+  if (recreate)
+    rootfile = new TFile(name.Data(),"RECREATE");
+  else if (update)
+    rootfile = new TFile(name.Data(),"UPDATE");
+  else
+    rootfile = new TFile(name.Data());
+
+  return rootfile;
+}
+
+Long64_t ReadWholeFile(const char *filename, std::vector<char> &buffer)
+{
+//
+// Reads a whole file in memory, so that it can be scanned in bulk
+// (see SanitizeDecimalCommas and ScanIntField/ScanFloatField)
+//
+// Inputs:
+//          filename : the file name
+//
+// Outputs:
+//          buffer   : the file content, terminated by a null character
+//
+// Return:
+//          the number of bytes read, or -1 if the file cannot be opened
+//
+// Created:      19 Oct 2026
+//
+
+  FILE *infile = fopen(filename, "rb");
+  if (!infile) return -1;
+
+  struct stat fileStat;
+  Long64_t size = 0;
+  if (fstat(fileno(infile), &fileStat) == 0 && fileStat.st_size > 0)
+    size = fileStat.st_size;
+
+  buffer.resize(size + 1);
+  Long64_t nread = fread(&buffer[0], 1, size, infile);
+
+  // The file may have grown (or be a pipe): read what is left
+  char chunk[65536];
+  size_t nchunk;
+  buffer.resize(nread);
+  while ((nchunk = fread(chunk, 1, sizeof(chunk), infile)) > 0)
+    buffer.insert(buffer.end(), chunk, chunk + nchunk);
+  fclose(infile);
+
+  nread = buffer.size();
+  buffer.push_back('\0');
+
+  return nread;
+}
+
+void ResetChangedActivities(void)
+{
+//
+// Restarts the count of the changed activities (see AddChangedActivity)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  changedActivities = 0;
+}
+
+Bool_t RenameExistingRootFile(TString oldname, TString mod, TString &newname)
+{
+//
+// Rename the existing ROOT file
+// WARNING: for sake of simplicity, we assume the file name is always
+// in the form whateverstring.root (i.e. it terminates with ".root")
+//
+// Inputs:
+//          oldname : the old file name
+//          mod     : the string to be appended to the old name
+//
+// Outputs:
+//          newname : the new file name
+//
+// Return:
+//          kTRUE if rename successful, otherwise kFALSE
+//
+// Created:      17 Jan 2019  Mario Sitta
+//
+
+  TString cmd;
+
+  newname = "";
+
+  Ssiz_t lastDot = oldname.Last('.');
+  if(lastDot == kNPOS) return kFALSE; // Should never happen given the file name
+
+//  newname = oldname(0,lastDot-1) + mod + ".root";
+  newname = oldname(0,lastDot) + mod + ".root";
+
+  cmd.Form("mv -f %s %s",oldname.Data(),newname.Data());
+  if(gSystem->Exec(cmd.Data()) != 0) {
+    newname = "";
+    return kFALSE;
+  } else
+    return kTRUE;
+}
+
+//
+// The kernels of SanitizeDecimalCommas: the vector ones are compiled
+// for their instruction set and only called if the CPU supports it
+//
+
+static void SanitizeDecimalCommasScalar(char *buffer, const Long64_t length)
+{
+  for (Long64_t j = 0; j < length; j++)
+    if (buffer[j] == ',') buffer[j] = '.';
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+static void SanitizeDecimalCommasSSE2(char *buffer, const Long64_t length)
+{
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i delta = _mm_set1_epi8('.' - ',');
+
+  Long64_t j = 0;
+  for (; j + 16 <= length; j += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)(buffer + j));
+    __m128i found = _mm_cmpeq_epi8(chunk, comma);
+    if (_mm_movemask_epi8(found) == 0) continue; // The most common case
+    chunk = _mm_add_epi8(chunk, _mm_and_si128(found, delta));
+    _mm_storeu_si128((__m128i*)(buffer + j), chunk);
+  }
+
+  SanitizeDecimalCommasScalar(buffer + j, length - j);
+}
+
+__attribute__((target("avx2")))
+static void SanitizeDecimalCommasAVX2(char *buffer, const Long64_t length)
+{
+  const __m256i comma = _mm256_set1_epi8(',');
+  const __m256i delta = _mm256_set1_epi8('.' - ',');
+
+  Long64_t j = 0;
+  for (; j + 32 <= length; j += 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i*)(buffer + j));
+    __m256i found = _mm256_cmpeq_epi8(chunk, comma);
+    if (_mm256_movemask_epi8(found) == 0) continue; // The most common case
+    chunk = _mm256_add_epi8(chunk, _mm256_and_si256(found, delta));
+    _mm256_storeu_si256((__m256i*)(buffer + j), chunk);
+  }
+
+  SanitizeDecimalCommasSSE2(buffer + j, length - j);
+}
+#endif
+
+static void (*SanitizeDecimalCommasKernel(void))(char*, const Long64_t)
+{
+//
+// Returns the widest kernel of SanitizeDecimalCommas supported by the CPU
+//
+// Created:      19 Oct 2026
+//
+
+#if defined(__x86_64__) && defined(__GNUC__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return SanitizeDecimalCommasAVX2;
+  return SanitizeDecimalCommasSSE2; // Always present on x86-64
+#else
+  return SanitizeDecimalCommasScalar;
+#endif
+}
+
+void SanitizeDecimalCommas(char *buffer, const Long64_t length)
+{
+//
+// Replaces all commas with dots in a buffer (some sites write
+// the decimal separator as a comma). The widest vector kernel
+// supported by the CPU is chosen at the first call
+//
+// Inputs:
+//          buffer : the buffer
+//          length : the number of bytes to process
+//
+// Outputs:
+//          buffer : the buffer with dots in place of commas
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  // Chosen once, even if the first calls come from several threads
+  static void (*kernel)(char*, const Long64_t) = SanitizeDecimalCommasKernel();
+
+  kernel(buffer, length);
+}
+
+const char* ScanFloatField(const char *p, Float_t &value)
+{
+//
+// Reads a floating point number from a text line, like "%f" in sscanf
+// but without crossing the end of the line. Plain decimal numbers of
+// up to 7 significant digits are converted directly (exactly, as the
+// division is done in single precision); anything else goes to strtof
+//
+// Inputs:
+//          p     : pointer to the text (leading blanks are skipped)
+//
+// Outputs:
+//          value : the number (unchanged if no number is found)
+//
+// Return:
+//          pointer to the first character after the number,
+//          or 0 if no number is found
+//
+// Created:      19 Oct 2026
+//
+
+  static const Float_t pow10[8] = {1e0f, 1e1f, 1e2f, 1e3f,
+                                   1e4f, 1e5f, 1e6f, 1e7f};
+
+  while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+
+  const char *start = p;
+  Bool_t negative = (*p == '-');
+  if (*p == '-' || *p == '+') p++;
+
+  UInt_t mantissa = 0;
+  Int_t ndigits = 0, nfract = 0;
+  for (; *p >= '0' && *p <= '9'; p++, ndigits++)
+    mantissa = mantissa*10 + (*p - '0');
+  if (*p == '.')
+    for (p++; *p >= '0' && *p <= '9'; p++, ndigits++, nfract++)
+      mantissa = mantissa*10 + (*p - '0');
+
+  // Anything unusual (no digits, exponent, too many digits, trailing
+  // characters) is left to strtof, which stops where sscanf would
+  if (ndigits == 0 || ndigits > 7 || (*p != '\0' && *p != '\n' &&
+      *p != ' ' && *p != '\t' && *p != '\r')) {
+    if (*start == '\0' || *start == '\n') return 0;
+    char *end;
+    Float_t val = strtof(start, &end);
+    if (end == start) return 0;
+    value = val;
+    return end;
+  }
+
+  // Both terms are exact in single precision: the result is correctly rounded
+  value = (Float_t)mantissa / pow10[nfract];
+  if (negative) value = -value;
+
+  return p;
+}
+
+const char* ScanIntField(const char *p, Int_t &value)
+{
+//
+// Reads an integer number from a text line, like "%d" in sscanf
+// but without crossing the end of the line
+//
+// Inputs:
+//          p     : pointer to the text (leading blanks are skipped)
+//
+// Outputs:
+//          value : the number (unchanged if no number is found)
+//
+// Return:
+//          pointer to the first character after the number,
+//          or 0 if no number is found
+//
+// Created:      19 Oct 2026
+//
+
+  while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+
+  Bool_t negative = (*p == '-');
+  if (*p == '-' || *p == '+') p++;
+
+  if (*p < '0' || *p > '9') return 0;
+
+  Long64_t number = 0;
+  for (; *p >= '0' && *p <= '9'; p++)
+    if (number < 0x80000000LL) number = number*10 + (*p - '0');
+
+  value = (Int_t)(negative ? -number : number);
+
+  return p;
+}
+
+void SetAppendMode(const Bool_t append)
+{
+//
+// Sets whether existing ROOT files are always updated in place,
+// without asking the user (see AskUserRedoScan)
+//
+// Inputs:
+//          append : if true, always append to existing files
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  alwaysAppend = append;
+}
+
+void SetCopyMode(const Bool_t copy)
+{
+//
+// Sets whether existing ROOT files are always rewritten, copying the
+// unchanged activities from the old file and analyzing the others again
+// (as with answer 2 in AskUserRedoScan), without asking the user
+//
+// Inputs:
+//          copy : if true, always rewrite the existing files
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  alwaysCopy = copy;
+}
+
+void SetPackedPixelTrees(const Bool_t packed)
+{
+//
+// Sets the layout of the new pixel trees (Digital and Threshold Scan):
+// either one entry per pixel or one entry per chip (packed), holding
+// all its pixels as arrays of pixNum values which are written at once
+// The branch names are the same, so TTree::Draw and Scan expressions
+// work unchanged on both layouts
+//
+// Inputs:
+//          packed : if true, use the packed layout
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  packedPixelTrees = packed;
+}
+
+void SetResumeMode(const Bool_t resume)
+{
+//
+// Sets whether the all-HICs runs resume from the last checkpoint of an
+// existing file (see CheckpointBegin): the file is then always updated
+// in place, without asking the user
+//
+// Inputs:
+//          resume : if true, resume from the last checkpoint
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  resumeRun = resume;
+}
+
+Bool_t SetRootThreads(const Int_t nthreads)
+{
+//
+// Enables ROOT implicit multithreading: the baskets of the branches
+// of a tree are then compressed and written by a pool of threads each
+// time the tree is flushed (every AutoFlush entries while filling, and
+// at Write) instead of one after the other on the thread parsing the
+// input files
+//
+// Inputs:
+//          nthreads : the size of the thread pool (0 = number of cores)
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if multithreading was enabled, kFALSE if ROOT was built
+//          without it
+//
+// Created:      19 Oct 2026
+//
+
+#ifdef R__USE_IMT
+  ROOT::EnableImplicitMT(nthreads);
+  return ROOT::IsImplicitMTEnabled();
+#else
+  (void)nthreads;
+  return kFALSE;
+#endif
+}
+
+void SetShardNumber(const Int_t index, const Int_t total)
+{
+//
+// Sets the shard of the HIC list to be processed by this job
+//
+// Inputs:
+//          index : the shard index (0 to total-1)
+//          total : the total number of shards
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  shardIndex = index;
+  shardTotal = total;
+}
+
+TFile* SetupRootFile(TString filename, Bool_t &redo)
+{
+//
+// Checks whether the Root file already exists: if not, create a new one,
+// if yes, try to open it
+//
+// Inputs:
+//          filename : the file name
+//
+// Outputs:
+//          redo : true if user chose to redo the analysis
+//
+// Return:
+//          a pointer to the created ROOT file
+//
+// Created:      28 Nov 2018  Mario Sitta
+// Updated:      09 Jan 2019  Mario Sitta
+// Updated:      17 Jan 2019  Mario Sitta
+//
+
+  TFile *newfile = 0;
+
+  redo = kTRUE;
+
+  if (CheckRootFileExists(filename))
+    if(AskUserRedoScan() == 2) redo = kFALSE;
+
+  if(redo)
+    newfile = OpenRootFile(filename, kTRUE);
+  else
+    newfile = OpenRootFile(filename, kFALSE);
+
+  return newfile;
+}
+
+TString ShardRootFileName(TString name)
+{
+//
+// Returns the name of the ROOT file for the shard processed by this job
+//
+// Inputs:
+//          name : the ROOT file name with no sharding
+//
+// Outputs:
+//
+// Return:
+//          the ROOT file name for the current shard
+//
+// Created:      19 Oct 2026
+//
+
+  return ShardRootFileName(name, shardIndex, shardTotal);
+}
+
+TString ShardRootFileName(TString name, const Int_t index, const Int_t total)
+{
+//
+// Returns the name of the ROOT file for a given shard
+// WARNING: as in RenameExistingRootFile, we assume the file name is
+// always in the form whateverstring.root
+//
+// Inputs:
+//          name  : the ROOT file name with no sharding
+//          index : the shard index
+//          total : the total number of shards
+//
+// Outputs:
+//
+// Return:
+//          the ROOT file name for the shard, e.g. for shard 2 of 8
+//          whateverstring_shard02of08.root (unchanged if total <= 1)
+//
+// Created:      19 Oct 2026
+//
+
+  if (total <= 1) return name;
+
+  Ssiz_t lastDot = name.Last('.');
+  if(lastDot == kNPOS) return name; // Should never happen given the file name
+
+  TString shardName;
+  shardName.Form("%s_shard%02dof%02d.root", TString(name(0,lastDot)).Data(), index, total);
+
+  return shardName;
+}
+
+void WatchBeginPoll(void)
+{
+//
+// Starts a poll in watch mode: from now on the HICs whose activity list
+// did not change since the last poll are skipped (see WatchHicChanged),
+// except every WATCHFULLPOLLS polls, when all HICs are looked at again
+// (a new classification only changes the activity parameters)
+//
+// Inputs:
+//
+// Outputs:
+//
+// Return:
+//
+// Created:      19 Oct 2026
+//
+
+  watchPolling = kTRUE;
+  if (watchPolls++ % WATCHFULLPOLLS == 0)
+    watchHicLists.clear();
+}
+
+Bool_t WatchHicChanged(const Int_t hicid, const std::vector<ComponentDB::compActivity> &tests)
+{
+//
+// Tells whether the activity list of a HIC (the activities, their end
+// date, result and status) changed since the last poll in watch mode,
+// and records it for the next one: if not, the HIC can be skipped
+// without reading its children and activities
+//
+// Inputs:
+//          hicid : the HIC Id
+//          tests : the activities of the HIC, as read from the DB
+//
+// Outputs:
+//
+// Return:
+//          kTRUE if the HIC has to be analyzed (always if not in watch
+//          mode or if the file is being rewritten)
+//
+// Created:      19 Oct 2026
+//
+
+  if (!watchPolling || alwaysCopy) return kTRUE;
+
+  std::ostringstream data;
+  std::vector<ComponentDB::compActivity>::const_iterator act;
+  for(act = tests.begin(); act != tests.end(); act++)
+    data << act->ID << '|' << act->EndDate << '|' << act->Result.Name << '|'
+         << act->Status.Name << '|';
+  ULong64_t hash = FingerprintHash(data.str());
+
+  std::map<Int_t, ULong64_t>::iterator seen = watchHicLists.find(hicid);
+  if (seen != watchHicLists.end() && seen->second == hash) return kFALSE;
+
+  watchHicLists[hicid] = hash;
+
+  return kTRUE;
+}
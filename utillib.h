@@ -10,13 +10,17 @@
 #include <TLatex.h>
 #include <TLegend.h>
 #include <TMath.h>
+#include <TNamed.h>
 #include <TPaveStats.h>
 #include <TPaveText.h>
+#include <TParameter.h>
 #include <TProfile.h>
+#include <TROOT.h>
 #include <TString.h>
 #include <TStyle.h>
 #include <TSystem.h>
 #include <TTree.h>
+#include <TList.h>
 
 #include "DBHelpers.h"
 #include "AlpideDB.h"
@@ -24,10 +28,19 @@
 #include "THIC.h"
 #include "TScanFactory.h"
 #include "TScanAnalysis.h"
+#include "dblib.h"
 
+#include <algorithm>
+#include <dirent.h>
 #include <iostream>
+#include <map>
+#include <sstream>
+#include <set>
 #include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
+#include <time.h>
+#include <vector>
 
 #define ACTMASK_QUALIF 1
 #define ACTMASK_RECEPT 2
@@ -35,19 +48,145 @@
 #define ACTMASK_STAVET 8
 #define ACTMASK_STVREC 16
 
+// The activity parameters used by the analyses (see GetActParameters)
+#define ACTPAR_VERSION   0   // Classification Version
+#define ACTPAR_WORKCHIPS 1   // Number of Working Chips
+#define ACTPAR_POWER     2   // Classification Power Test
+#define ACTPAR_DIGI0     3   // Classification Digital Scan BB 0
+#define ACTPAR_DIGI3     4   // Classification Digital Scan BB 3
+#define ACTPAR_DIGIM10   5   // Classification Digital Scan BB 0, V -10%
+#define ACTPAR_DIGIP10   6   // Classification Digital Scan BB 0, V +10%
+#define ACTPAR_THRESH0   7   // Classification Threshold Scan 0.0 V
+#define ACTPAR_THRESH3   8   // Classification Threshold Scan 3.0 V
+#define ACTPAR_NOISE0    9   // Classification Noise Occupancy 0.0 V
+#define ACTPAR_NOISE3    10  // Classification Noise Occupancy 3.0 V
+#define ACTPAR_NOISE0M   11  // Classification Noise Occupancy 0.0 V, masked
+#define ACTPAR_NOISE3M   12  // Classification Noise Occupancy 3.0 V, masked
+#define ACTPAR_DCTRL     13  // Classification Dctrl Measurement
+#define ACTPARNUM        14
 
+// The values of the parameters of an activity, indexed by ACTPAR_*
+struct TActParameters {
+  Int_t   actID;               // the activity Id
+  Bool_t  found[ACTPARNUM];    // kTRUE if the activity has the parameter
+  Float_t value[ACTPARNUM];    // the parameter value (0 if not found)
+};
+
+// The checkpoints of the all-HICs files (see CheckpointBegin)
+#define CHECKPOINTMIN  5                  // Minutes between two checkpoints
+#define CHECKPOINTNAME "checkpointHicID"  // The last HIC saved in the file
+#define CHECKPOINTOLD  "checkpointOldFile" // The old file copied from, if any
+
+// Polls in watch mode between two looks at all HICs (see WatchBeginPoll)
+#define WATCHFULLPOLLS 24
+
+// Size of the blocks of the string arena of an activity
+#define ARENABLOCKSIZE 65536
+
+// Maximum number of pixels in an entry of a packed pixel tree (a chip)
+#define PIXPACKSIZE 524288
+
+// The chip numbering of a HIC type, known at compile time: the number
+// of chips, the chip Id in the test files (the lower 4 bits of the
+// Alpide Id, also the Test position) of each chip in the trees, the
+// chip of each chip Id and the Test position of each MAM position
+#define CHIPIDMAX  16
+#define CHIPMAXNUM 14
+
+struct THicChipMap {
+  Int_t  numChips;              // the number of chips
+  Char_t chipId[CHIPMAXNUM];    // the chip Id of each chip
+  Char_t chipNum[CHIPIDMAX];    // the chip of each chip Id (-1 if none)
+  Char_t posMAM[2][10];         // the Test position of HAn and HBn (-1 if none)
+};
+
+static constexpr THicChipMap hicChipMapIB = {
+  9,
+  { 0,  1,  2,  3,  4,  5,  6,  7,  8, -1, -1, -1, -1, -1},
+  { 0,  1,  2,  3,  4,  5,  6,  7,  8, -1, -1, -1, -1, -1, -1, -1},
+  {{ 0,  1,  2,  3,  4,  5,  6,  7,  8, -1},
+   {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1}}
+};
+
+static constexpr THicChipMap hicChipMapOB = {
+  14,
+  { 0,  1,  2,  3,  4,  5,  6,  8,  9, 10, 11, 12, 13, 14},
+  { 0,  1,  2,  3,  4,  5,  6, -1,  7,  8,  9, 10, 11, 12, 13, -1},
+  {{-1,  6,  5,  4,  3,  2,  1,  0, -1, -1},
+   {-1,  8,  9, 10, 11, 12, 13, 14, -1, -1}}
+};
+
+// The chip of a chip Id read from a file (-1 if none)
+#define CHIPNUM(map, id) ((UInt_t)(id) < CHIPIDMAX ? Int_t((map)->chipNum[id]) : -1)
+
+// The wafer number and position of the chips of a HIC, in the order of
+// the chips in the trees (-1 if not known)
+struct TWaferMap {
+  Char_t waferNum[CHIPMAXNUM];
+  Char_t waferPos[CHIPMAXNUM];
+};
+
+// Names of the trees holding the data of a given activity type
+// (used to rebuild the actFastListTree offsets when merging shards)
+struct TActTreeNames {
+  UShort_t    actMask;   // the activity mask
+  const char *testTree;  // the test tree
+  const char *tuneTree;  // the tuning tree (0 if none)
+  const char *resTree;   // the result tree
+};
+
+void AddChangedActivity(void);
+ULong64_t ActivityDBFingerprint(const ActivityDB::activityLong &actlong);
+ULong64_t ActivityFingerprint(const ActivityDB::activityLong &actlong, const string &eospath);
+ULong64_t ActivityKey(const UInt_t hicid, const UInt_t actid);
+const char* ArenaJoinPath(const string &path, const string &file);
+void ArenaReset(void);
 Int_t AskUserRedoScan(void);
 Bool_t CheckRootFileExists(TString name);
-Int_t ChipPositionMAM2Test(const THicType hicType, const string position);
+Bool_t CheckShardNumber(const Int_t hicid);
+UInt_t CheckpointBegin(TFile *rootfile, TTree **trees, const Int_t ntrees, const std::vector<ComponentDB::componentShort> &componentList, const TString &oldfilename);
+void CheckpointCommit(const Int_t hicid);
+void CheckpointEnd(void);
+Bool_t CheckpointOldFile(TString rootfilename, TString &oldfilename);
+Int_t ChipPositionMAM2Test(const THicType hicType, const string &position);
 string ChipPositionTest2MAM(const THicType hicType, const Int_t position);
+void CloseHicRootFile(void);
 void CloseRootFile(TFile *rootfile);
-Char_t ConvertTestResult(const string result);
+Char_t ConvertTestResult(const string &result);
+Bool_t CopyOldActivity(const ActivityDB::activityLong &actlong, const THicType hicType, const Bool_t inoldfile, ULong64_t &dbfinger, ULong64_t &finger, string &eospath);
+void DecodeAlpideAddress(const Int_t region, const Int_t doublecol, const Int_t address, Int_t &col, Int_t &row);
 string FindEOSPath(ActivityDB::activityLong actlong, const THicType hicType);
 void FixActName(ActivityDB::activityLong &actlong, const THicType hicType);
-TFile* OpenRootFile(TString name, Bool_t recreate=kFALSE);
+Int_t GetChangedActivities(void);
+const TActParameters* GetActParameters(const ActivityDB::activityLong &actlong);
+const THicChipMap* GetHicChipMap(const THicType hicType);
+const TWaferMap* GetHicWaferMap(const Int_t hicid, const THicType hicType, const std::vector<TChild> &children);
+Int_t GetNumberOfShards(void);
+Bool_t GetPackedPixelTrees(void);
+Bool_t GetResumeMode(void);
+Bool_t IsPackedPixelTree(TTree *tree);
+void MatchPackedPixelTrees(TTree *tree);
+void MergeAllShardFiles(const char *analysis, const int nshards, const THicType hicType, const TActTreeNames *treenames, const Int_t ntypes, const char **extranames=0, const Int_t nextra=0);
+Bool_t MergeShardRootFiles(TString rootfilename, const Int_t nshards, const TActTreeNames *treenames, const Int_t ntypes, const char **extranames=0, const Int_t nextra=0);
+Bool_t OpenHicRootFile(TString name);
+TFile* OpenRootFile(TString name, Bool_t recreate=kFALSE, Bool_t update=kFALSE);
+Long64_t ReadWholeFile(const char *filename, std::vector<char> &buffer);
+void ResetChangedActivities(void);
 Bool_t RenameExistingRootFile(TString oldname, TString mod, TString &newname);
+void SanitizeDecimalCommas(char *buffer, const Long64_t length);
+const char* ScanFloatField(const char *p, Float_t &value);
+const char* ScanIntField(const char *p, Int_t &value);
+void SetAppendMode(const Bool_t append);
+void SetCopyMode(const Bool_t copy);
+void SetPackedPixelTrees(const Bool_t packed);
+void SetResumeMode(const Bool_t resume);
+Bool_t SetRootThreads(const Int_t nthreads);
+void SetShardNumber(const Int_t index, const Int_t total);
 TFile* SetupRootFile(TString name, Bool_t &redo);
-void WaferNumAndPos(const THicType hicType, std::vector<TChild> children, const Int_t chipNum, Char_t &waferNum, Char_t &waferPos);
+TString ShardRootFileName(TString name);
+TString ShardRootFileName(TString name, const Int_t index, const Int_t total);
+void WatchBeginPoll(void);
+Bool_t WatchHicChanged(const Int_t hicid, const std::vector<ComponentDB::compActivity> &tests);
 
 
 #endif // UTILLIB_H